@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+生成QSPI Flash资源包 (bsp_asset.c)，烧录到QSPI Flash地址0 (内存映射地址 0x90000000)
+
+    python asset_pack.py assets.bin logo.png font16.bin
+    python asset_pack.py assets.bin bg=background.png --raw font16.bin --hex assets.hex
+    python asset_pack.py assets.bin --bench
+    python asset_pack.py assets.bin --jpeg photo.jpg
+
+参数:
+    name=path   指定资源名，默认使用文件名
+    --raw       其后的文件不压缩
+    --lz4       其后的文件LZ4压缩(默认)
+    --jpeg      其后的 .jpg 文件保持JPEG格式、不压缩，由 bsp_jpeg.c 硬件解码，只支持基线YCbCr图像
+    --bench     加入 bench_raw / bench_lz4 两个1024x600 RGB565测试图片，供 shell 命令 asset bench 使用
+    --hex       同时输出以 0x90000000 为起始地址的Intel HEX，供外部Flash下载算法使用
+
+.png/.bmp/.jpg 图片转换为RGB565，需要 pip install pillow，索引中记录宽、高和像素格式。
+资源包格式见 bsp_asset.c，分块大小等参数必须与 bsp_asset.h 一致。
+"""
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+ASSET_MAGIC = 0x304B5041  # "APK0"
+ASSET_VERSION = 1
+ASSET_NAME_MAX = 32
+ASSET_ALIGN = 4096
+ASSET_BLOCK_SIZE = 16 * 1024
+ASSET_BLOCK_MAX = 512
+ASSET_FLASH_SIZE = 16 * 1024 * 1024
+ASSET_BLOCK_RAW = 0x80000000
+
+METHOD_RAW = 0
+METHOD_LZ4 = 1
+
+LTDC_PIXEL_FORMAT_RGB565 = 2
+ASSET_FMT_JPEG = 0x100
+HEX_BASE = 0x90000000
+
+
+def lz4_compress(src):
+    """LZ4 block 格式压缩，贪心匹配。末尾5字节为字面量，最后12字节内不开始匹配"""
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    limit = n - 12
+
+    def put_len(v):
+        while v >= 255:
+            out.append(255)
+            v -= 255
+        out.append(v)
+
+    while i < limit:
+        key = src[i:i + 4]
+        ref = table.get(key, -1)
+        table[key] = i
+        if ref < 0 or i - ref > 0xFFFF:
+            i += 1
+            continue
+
+        mlen = 4
+        mmax = n - 5 - i
+        while mlen < mmax and src[ref + mlen] == src[i + mlen]:
+            mlen += 1
+
+        lit = i - anchor
+        ml = mlen - 4
+        out.append((min(lit, 15) << 4) | min(ml, 15))
+        if lit >= 15:
+            put_len(lit - 15)
+        out += src[anchor:i]
+        out += struct.pack("<H", i - ref)
+        if ml >= 15:
+            put_len(ml - 15)
+
+        i += mlen
+        anchor = i
+        if i - 2 > ref:
+            table[src[i - 2:i + 2]] = i - 2
+
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        put_len(lit - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def lz4_decompress(src, size):
+    """解压一个块，用于打包后自检，与 Asset_LZ4Decode 相同"""
+    out = bytearray()
+    i = 0
+    while i < len(src):
+        token = src[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += src[i:i + lit]
+        i += lit
+        if i >= len(src):
+            break
+        off = src[i] | (src[i + 1] << 8)
+        i += 2
+        ml = token & 15
+        if ml == 15:
+            while True:
+                b = src[i]
+                i += 1
+                ml += b
+                if b != 255:
+                    break
+        ml += 4
+        for _ in range(ml):
+            out.append(out[-off])
+    if len(out) != size:
+        raise ValueError("lz4 self check failed")
+    return bytes(out)
+
+
+def pack_lz4(data):
+    """分块压缩: 分块表 + 各块数据(4字节对齐)，压缩后不变小的块原样存放"""
+    blocks = [data[i:i + ASSET_BLOCK_SIZE] for i in range(0, len(data), ASSET_BLOCK_SIZE)]
+    if len(blocks) > ASSET_BLOCK_MAX:
+        raise ValueError("asset too large for lz4: %d bytes" % len(data))
+    table = []
+    body = bytearray()
+    for raw in blocks:
+        comp = lz4_compress(raw)
+        if len(comp) < len(raw):
+            lz4_decompress(comp, len(raw))
+            table.append(len(comp))
+            body += comp
+        else:
+            table.append(len(raw) | ASSET_BLOCK_RAW)
+            body += raw
+        body += b"\x00" * (-len(body) & 3)
+    return struct.pack("<%dI" % len(table), *table) + bytes(body)
+
+
+def load_image(path):
+    """图片转换为RGB565，返回 (数据, 宽, 高)"""
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("pip install pillow to convert " + path)
+    img = Image.open(path).convert("RGB")
+    w, h = img.size
+    out = bytearray()
+    for r, g, b in img.getdata():
+        out += struct.pack("<H", ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+    return bytes(out), w, h
+
+
+def jpeg_info(path, data):
+    """读取JPEG的宽、高。硬件解码器只支持基线(SOF0/SOF1)、3个分量的YCbCr图像"""
+    if data[:2] != b"\xFF\xD8":
+        sys.exit(path + ": not a JPEG file")
+    i = 2
+    while i + 4 <= len(data):
+        if data[i] != 0xFF:
+            sys.exit(path + ": bad marker at %d" % i)
+        marker = data[i + 1]
+        if marker == 0xFF:
+            i += 1
+            continue
+        length = struct.unpack(">H", data[i + 2:i + 4])[0]
+        if marker in (0xC0, 0xC1):
+            h, w, n = struct.unpack(">HHB", data[i + 5:i + 10])
+            if n != 3:
+                sys.exit(path + ": only YCbCr JPEG is supported, %d components" % n)
+            return w, h
+        if 0xC2 <= marker <= 0xCF and marker not in (0xC4, 0xC8, 0xCC):
+            sys.exit(path + ": progressive/lossless JPEG is not supported")
+        i += 2 + length
+    sys.exit(path + ": no SOF marker")
+
+
+def bench_image(w=1024, h=600):
+    """生成类似界面截图的测试图片: 渐变背景、纯色面板、细节纹理区域"""
+    out = bytearray(w * h * 2)
+    for y in range(h):
+        row = bytearray()
+        for x in range(w):
+            if 40 <= y < 120 and 40 <= x < w - 40:
+                c = 0x2945  # 标题栏
+            elif 160 <= y < 560 and 40 <= x < 480:
+                c = 0xFFFF if ((x // 8) + (y // 16)) % 7 else 0x0000  # 文本区
+            elif 160 <= y < 560 and 520 <= x < w - 40:
+                c = ((x * 7 + y * 13) ^ (x * y >> 6)) & 0xFFFF  # 图片区
+            else:
+                c = ((y * 31 // h) << 11) | ((x * 63 // w) << 5) | 0x10  # 渐变背景
+            row += struct.pack("<H", c)
+        out[y * w * 2:(y + 1) * w * 2] = row
+    return bytes(out), w, h
+
+
+def make_entry(name, offset, stored, data, method, param):
+    if len(name.encode()) >= ASSET_NAME_MAX:
+        raise ValueError("name too long: " + name)
+    return struct.pack("<32s4IB3x3I", name.encode(), offset, len(stored), len(data),
+                       zlib.crc32(data) & 0xFFFFFFFF, method, *param)
+
+
+def write_hex(path, data, base):
+    with open(path, "w") as f:
+        upper = -1
+        for off in range(0, len(data), 16):
+            addr = base + off
+            if (addr >> 16) != upper:
+                upper = addr >> 16
+                rec = bytes([2, 0, 0, 4, upper >> 8, upper & 0xFF])
+                f.write(":%s%02X\n" % (rec.hex().upper(), -sum(rec) & 0xFF))
+            chunk = data[off:off + 16]
+            rec = bytes([len(chunk), (addr >> 8) & 0xFF, addr & 0xFF, 0]) + chunk
+            f.write(":%s%02X\n" % (rec.hex().upper(), -sum(rec) & 0xFF))
+        f.write(":00000001FF\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="pack assets for bsp_asset.c")
+    ap.add_argument("output")
+    ap.add_argument("--hex", help="also write Intel HEX at 0x%08X" % HEX_BASE)
+    ap.add_argument("--bench", action="store_true", help="add bench_raw and bench_lz4")
+    args, rest = ap.parse_known_args()
+
+    items = []  # (name, data, method, param)
+    method = METHOD_LZ4
+    jpeg = False
+    for arg in rest:
+        if arg == "--raw":
+            method = METHOD_RAW
+            continue
+        if arg == "--lz4":
+            method = METHOD_LZ4
+            continue
+        if arg == "--jpeg":
+            jpeg = True
+            continue
+        name, _, path = arg.rpartition("=")
+        if not name:
+            name = os.path.basename(path)
+        ext = os.path.splitext(path)[1].lower()
+        if jpeg and ext in (".jpg", ".jpeg"):
+            with open(path, "rb") as f:
+                data = f.read()
+            w, h = jpeg_info(path, data)
+            items.append((name, data, METHOD_RAW, (w, h, ASSET_FMT_JPEG)))
+            continue
+        if ext in (".png", ".bmp", ".jpg", ".jpeg"):
+            data, w, h = load_image(path)
+            param = (w, h, LTDC_PIXEL_FORMAT_RGB565)
+        else:
+            with open(path, "rb") as f:
+                data = f.read()
+            param = (0, 0, 0)
+        items.append((name, data, method, param))
+
+    if args.bench:
+        data, w, h = bench_image()
+        items.append(("bench_raw", data, METHOD_RAW, (w, h, LTDC_PIXEL_FORMAT_RGB565)))
+        items.append(("bench_lz4", data, METHOD_LZ4, (w, h, LTDC_PIXEL_FORMAT_RGB565)))
+
+    if not items:
+        ap.error("no assets")
+
+    head_size = 32 + 64 * len(items)
+    offset = (head_size + ASSET_ALIGN - 1) & ~(ASSET_ALIGN - 1)
+    index = bytearray()
+    body = bytearray()
+    for name, data, method, param in items:
+        stored = pack_lz4(data) if method == METHOD_LZ4 else data
+        index += make_entry(name, offset, stored, data, method, param)
+        body += stored
+        body += b"\xFF" * (-len(body) & (ASSET_ALIGN - 1))
+        print("%-32s %s %8d -> %8d" % (name, "lz4" if method == METHOD_LZ4 else "raw", len(data), len(stored)))
+        offset = ((head_size + ASSET_ALIGN - 1) & ~(ASSET_ALIGN - 1)) + len(body)
+
+    total = offset
+    if total > ASSET_FLASH_SIZE:
+        sys.exit("archive too large: %d bytes" % total)
+    head = struct.pack("<5I12x", ASSET_MAGIC, ASSET_VERSION, len(items), zlib.crc32(index) & 0xFFFFFFFF, total)
+    image = head + bytes(index)
+    image += b"\xFF" * (-len(image) & (ASSET_ALIGN - 1))
+    image += bytes(body)
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+    if args.hex:
+        write_hex(args.hex, image, HEX_BASE)
+    print("%d assets, %d bytes" % (len(items), len(image)))
+
+
+if __name__ == "__main__":
+    main()
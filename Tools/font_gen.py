@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+TTF/OTF字体生成抗锯齿字库 (bsp_font.c)，再用 asset_pack.py --raw 打包到QSPI Flash资源包
+
+    python font_gen.py simhei.ttf 24 font24.fnt
+    python font_gen.py simhei.ttf 16 font16.fnt --bpp 8 --charset ascii
+    python font_gen.py simhei.ttf 32 title.fnt --charset title.txt
+    python asset_pack.py assets.bin --raw font24=font24.fnt
+
+参数:
+    --bpp       4 (默认) 或 8，点阵为DMA2D A4或A8格式
+    --charset   gb2312 (默认，ASCII + GB2312全部字符)、ascii，或文本文件(ASCII + 文件中出现的字符)
+
+需要 pip install pillow。文件格式与 bsp_font.h 一致:
+    FONT_HEAD_T  32字节
+    FONT_GLYPH_T 16字节 * num，按Unicode编码从小到大排列
+    点阵数据     每个字形 h 行；A8每行 w 字节，A4每行按偶数个像素存储，低4位是左边的像素
+"""
+import argparse
+import struct
+import sys
+
+FONT_MAGIC = 0x30544E46  # "FNT0"
+FONT_VERSION = 1
+HEAD_SIZE = 32
+
+
+def gb2312_chars():
+    """GB2312 一区到八十七区的全部字符"""
+    out = []
+    for hi in range(0xA1, 0xF8):
+        for lo in range(0xA1, 0xFF):
+            try:
+                out.append(bytes([hi, lo]).decode("gb2312"))
+            except UnicodeDecodeError:
+                pass
+    return out
+
+
+def load_charset(spec):
+    chars = set(chr(c) for c in range(0x20, 0x7F))
+    if spec == "gb2312":
+        chars.update(gb2312_chars())
+    elif spec != "ascii":
+        with open(spec, encoding="utf-8") as f:
+            chars.update(c for c in f.read() if ord(c) >= 0x20)
+    return sorted(chars, key=ord)
+
+
+def render(font, ch, ascent, bpp):
+    """返回 (点阵, w, h, left, top, advance)"""
+    from PIL import Image, ImageDraw
+
+    left, top, right, bottom = font.getbbox(ch)
+    advance = int(round(font.getlength(ch)))
+    w, h = right - left, bottom - top
+    if w <= 0 or h <= 0:
+        return b"", 0, 0, 0, 0, advance
+    if w > 255 or h > 255:
+        sys.exit("glyph too large: U+%04X" % ord(ch))
+
+    # 默认锚点为左上(上伸线)，top是相对上伸线的距离，换算为基线以上的高度
+    img = Image.new("L", (w, h), 0)
+    ImageDraw.Draw(img).text((-left, -top), ch, font=font, fill=255)
+    pix = img.tobytes()
+
+    if bpp == 8:
+        data = pix
+    else:
+        pitch = (w + 1) & ~1
+        data = bytearray(pitch * h // 2)
+        for y in range(h):
+            for x in range(w):
+                v = (pix[y * w + x] * 15 + 127) // 255
+                data[(y * pitch + x) // 2] |= v << (4 * (x & 1))
+    return bytes(data), w, h, left, ascent - top, advance
+
+
+def main():
+    ap = argparse.ArgumentParser(description="convert TTF to bsp_font.c glyph atlas")
+    ap.add_argument("ttf")
+    ap.add_argument("size", type=int, help="pixel size")
+    ap.add_argument("output")
+    ap.add_argument("--bpp", type=int, choices=(4, 8), default=4)
+    ap.add_argument("--charset", default="gb2312")
+    args = ap.parse_args()
+
+    try:
+        from PIL import ImageFont
+    except ImportError:
+        sys.exit("pip install pillow")
+
+    font = ImageFont.truetype(args.ttf, args.size)
+    ascent, descent = font.getmetrics()
+    chars = load_charset(args.charset)
+
+    index = bytearray()
+    body = bytearray()
+    max_w = max_h = 0
+    for ch in chars:
+        data, w, h, left, top, advance = render(font, ch, ascent, args.bpp)
+        if not -128 <= left < 128 or not -128 <= top < 128 or advance > 255:
+            sys.exit("glyph metrics out of range: U+%04X" % ord(ch))
+        index += struct.pack("<IIBBbbB3x", ord(ch), len(body), w, h, left, top, advance)
+        body += data
+        max_w = max(max_w, w)
+        max_h = max(max_h, h)
+
+    data_offset = HEAD_SIZE + len(index)
+    head = struct.pack("<IHBBhhHBBII8x", FONT_MAGIC, FONT_VERSION, args.bpp, args.size, ascent, descent,
+                       ascent + descent, max_w, max_h, len(chars), data_offset)
+    with open(args.output, "wb") as f:
+        f.write(head + bytes(index) + bytes(body))
+
+    print("%d glyphs, %dx%d max, A%d, %d bytes" % (len(chars), max_w, max_h, args.bpp,
+                                                    data_offset + len(body)))
+
+
+if __name__ == "__main__":
+    main()
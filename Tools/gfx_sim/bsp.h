@@ -0,0 +1,29 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA2D 模拟器
+*    文件名称 : bsp.h
+*    版    本 : V1.0
+*    说    明 : 只用于在PC上编译 bsp_gfx_draw.c，代替 User/bsp/bsp.h，不包含HAL。
+*               没有定义 __SHELL_H__，不编译shell命令
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#ifndef _BSP_H_
+#define _BSP_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_gfx.h"
+
+#define RAM_FUNC /* PC上不区分ITCM */
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,436 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA2D 模拟器
+*    文件名称 : gfx_sim.c
+*    版    本 : V1.0
+*    说    明 : 在PC上模拟DMA2D填充和Write back区域的D-Cache，实现 bsp_gfx.h 中矢量绘图模块用到的接口，
+*               用于测试 bsp_gfx_draw.c。只模拟一个图像。
+*               1. 图像分为两份: CPU看到的内容(Cache)和显存中的内容(LTDC、DMA2D看到的)。CPU直接读写前者，
+*                  写回D-Cache时复制到后者，按32字节Cache行处理
+*               2. GFX_FillRect 与 bsp_gfx.c 相同，提交前写回并作废目标区域的D-Cache，命令放入队列，
+*                  GFX_Wait 或队列满时才执行。命令执行期间图像设为不可访问，CPU读写时报错退出
+*               3. DMA2D只写入显存。执行期间Cache可能预取了目标行的旧数据，这些Cache行标记为过期，
+*                  作废前CPU写入过期的Cache行时报错(换出时会覆盖DMA2D的结果)
+*               4. 图像上下各有 SIM_GUARD_ROWS 行保护区，每行 pitch 超出 width 的部分也是保护区，
+*                  裁剪错误时保护区被改写
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "bsp_gfx.h"
+#include "gfx_sim.h"
+
+#define SIM_GUARD_ROWS 4    /* 图像上下的保护区行数 */
+#define SIM_GUARD_BYTE 0xA5 /* 保护区的内容 */
+#define SIM_LINE 32         /* Cache行大小 */
+
+/* 排队的填充命令 */
+typedef struct
+{
+    int32_t x, y, w, h;
+    uint32_t pix;
+} SIM_FILL_T;
+
+static const uint8_t s_ucBits[GFX_FMT_NUM] = {32, 24, 16, 16, 16, 8, 8, 16, 4, 8, 4};
+
+static GFX_SURFACE_T s_tSurf;
+static uint8_t *s_pBase = NULL;  /* CPU看到的内容，包括保护区，mmap到4GB以下 */
+static uint8_t *s_pMem = NULL;   /* 显存中的内容 */
+static uint8_t *s_pStale = NULL; /* 过期Cache行的内容 */
+static uint8_t *s_pFlag = NULL;  /* 每个Cache行1字节，1表示过期 */
+static size_t s_uiSize = 0;
+static SIM_FILL_T s_tQueue[GFX_QUEUE_SIZE];
+static uint16_t s_usQueue = 0;
+static uint32_t s_uiError = 0;
+static GFX_SIM_STAT_T s_tStat;
+
+/* 命令执行期间CPU访问图像 */
+static void SimSegv(int _sig, siginfo_t *_pInfo, void *_pCtx)
+{
+    static const char msg[] = "gfx_sim: CPU access while DMA2D busy\n";
+    uint8_t *p = (uint8_t *)_pInfo->si_addr;
+
+    (void)_pCtx;
+    if (s_pBase != NULL && p >= s_pBase && p < s_pBase + s_uiSize && s_usQueue != 0)
+    {
+        write(2, msg, sizeof(msg) - 1);
+        _exit(2);
+    }
+    signal(_sig, SIG_DFL);
+}
+
+/* 命令执行期间图像不可访问 */
+static void SimProtect(uint8_t _ucOn)
+{
+    mprotect(s_pBase, s_uiSize, _ucOn ? PROT_NONE : PROT_READ | PROT_WRITE);
+}
+
+/* 像素(x, y)相对图像缓冲区开始的偏移，与 bsp_gfx.c 的 GFX_PixelAddr 相同 */
+static size_t SimOffset(int32_t _x, int32_t _y)
+{
+    return (size_t)(s_tSurf.addr - (uint32_t)(uintptr_t)s_pBase) +
+           ((uint32_t)_y * s_tSurf.pitch + _x) * s_ucBits[s_tSurf.format] / 8;
+}
+
+/* 偏移所在的行号，保护区为负数或不小于图像高度 */
+static int SimRow(size_t _uiOff)
+{
+    return (int)(((long)_uiOff - (long)SimOffset(0, 0)) / (long)(SimOffset(0, 1) - SimOffset(0, 0)));
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SimFlush
+*    功能说明: 写回并作废 [_uiStart, _uiEnd) 所在的Cache行，与 SCB_CleanInvalidateDCache_by_Addr 相同
+*    形    参: _uiStart, _uiEnd : 相对图像缓冲区开始的偏移
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SimFlush(size_t _uiStart, size_t _uiEnd)
+{
+    size_t line, off;
+
+    for (line = _uiStart / SIM_LINE; line * SIM_LINE < _uiEnd; line++)
+    {
+        off = line * SIM_LINE;
+        if (s_pFlag[line])
+        {
+            /* 过期的Cache行没有被CPU改写时直接作废 */
+            if (memcmp(&s_pBase[off], &s_pStale[off], SIM_LINE) != 0)
+            {
+                if (s_uiError++ == 0)
+                {
+                    fprintf(stderr, "gfx_sim: CPU wrote a stale cache line at row %d\n", SimRow(off));
+                }
+            }
+            memcpy(&s_pBase[off], &s_pMem[off], SIM_LINE);
+            s_pFlag[line] = 0;
+        }
+        else
+        {
+            memcpy(&s_pMem[off], &s_pBase[off], SIM_LINE);
+        }
+        s_tStat.flushes++;
+    }
+}
+
+/* 执行队列中的填充命令，DMA2D只写显存，目标Cache行标记为过期 */
+static void SimRun(void)
+{
+    SIM_FILL_T *f;
+    size_t off, line, end;
+    uint8_t bytes = s_ucBits[s_tSurf.format] / 8;
+    int32_t i, j;
+
+    if (s_usQueue == 0)
+    {
+        return;
+    }
+    SimProtect(0);
+    for (i = 0; i < s_usQueue; i++)
+    {
+        f = &s_tQueue[i];
+        for (j = 0; j < f->h; j++)
+        {
+            off = SimOffset(f->x, f->y + j);
+            end = off + (size_t)f->w * bytes;
+            for (line = off / SIM_LINE; line * SIM_LINE < end; line++)
+            {
+                if (!s_pFlag[line])
+                {
+                    memcpy(&s_pStale[line * SIM_LINE], &s_pBase[line * SIM_LINE], SIM_LINE);
+                    s_pFlag[line] = 1;
+                }
+            }
+            for (; off < end; off += bytes)
+            {
+                memcpy(&s_pMem[off], &f->pix, bytes);
+            }
+        }
+    }
+    s_usQueue = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_SimOpen
+*    功能说明: 分配模拟的图像，内容和保护区都填充 SIM_GUARD_BYTE
+*    形    参: _pSurf : 返回图像描述
+*              _usWidth, _usHeight : 宽度和高度
+*              _usPitch : 每行的像素数，大于宽度时每行末尾有保护区
+*              _fmt : 像素格式
+*    返 回 值: 0 表示成功
+*********************************************************************************************************
+*/
+int GFX_SimOpen(GFX_SURFACE_T *_pSurf, uint16_t _usWidth, uint16_t _usHeight, uint16_t _usPitch, GFX_FMT_E _fmt)
+{
+    struct sigaction sa;
+    size_t row = (size_t)_usPitch * s_ucBits[_fmt] / 8;
+    long page = sysconf(_SC_PAGESIZE);
+
+    GFX_SimClose();
+    s_uiSize = (row * (_usHeight + 2 * SIM_GUARD_ROWS) + page - 1) / page * page;
+
+    /* GFX_SURFACE_T 的地址是32位 */
+    s_pBase = mmap(NULL, s_uiSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (s_pBase == MAP_FAILED)
+    {
+        s_pBase = NULL;
+        return -1;
+    }
+    s_pMem = malloc(s_uiSize);
+    s_pStale = malloc(s_uiSize);
+    s_pFlag = calloc(s_uiSize / SIM_LINE, 1);
+    memset(s_pBase, SIM_GUARD_BYTE, s_uiSize);
+    memset(s_pMem, SIM_GUARD_BYTE, s_uiSize);
+
+    GFX_InitSurface(&s_tSurf, (uint32_t)(uintptr_t)s_pBase + row * SIM_GUARD_ROWS, _usWidth, _usHeight, _fmt);
+    s_tSurf.pitch = _usPitch;
+    *_pSurf = s_tSurf;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = SimSegv;
+    sa.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &sa, NULL);
+
+    memset(&s_tStat, 0, sizeof(s_tStat));
+    s_uiError = 0;
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_SimClose
+*    功能说明: 释放模拟的图像，丢弃队列中的命令
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_SimClose(void)
+{
+    if (s_pBase != NULL)
+    {
+        munmap(s_pBase, s_uiSize);
+        free(s_pMem);
+        free(s_pStale);
+        free(s_pFlag);
+        s_pBase = NULL;
+    }
+    s_usQueue = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_SimMem
+*    功能说明: 显存中像素(x, y)的地址，即LTDC显示的内容。坐标可以在保护区内
+*    形    参: _x, _y : 坐标
+*    返 回 值: 地址
+*********************************************************************************************************
+*/
+const uint8_t *GFX_SimMem(int32_t _x, int32_t _y)
+{
+    return &s_pMem[SimOffset(_x, _y)];
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_SimCheck
+*    功能说明: 在 GFX_Wait 之后检查: CPU写入的内容都已写回显存，没有写入过期的Cache行，保护区没有改变
+*    形    参: 无
+*    返 回 值: 错误个数，0 表示正常
+*********************************************************************************************************
+*/
+uint32_t GFX_SimCheck(void)
+{
+    size_t line, off, start = SimOffset(0, 0), end = SimOffset(0, s_tSurf.height);
+    size_t row = SimOffset(0, 1) - start, vis = (size_t)s_tSurf.width * s_ucBits[s_tSurf.format] / 8;
+    uint32_t err = s_uiError;
+
+    if (s_usQueue != 0)
+    {
+        fprintf(stderr, "gfx_sim: check while DMA2D busy\n");
+        return err + 1;
+    }
+    for (line = 0; line < s_uiSize / SIM_LINE; line++)
+    {
+        off = line * SIM_LINE;
+        if (memcmp(&s_pBase[off], s_pFlag[line] ? &s_pStale[off] : &s_pMem[off], SIM_LINE) != 0)
+        {
+            fprintf(stderr, "gfx_sim: %s at row %d\n", s_pFlag[line] ? "CPU wrote a stale cache line" : "D-Cache not cleaned",
+                    SimRow(off));
+            err++;
+            break;
+        }
+    }
+    for (off = 0; off < s_uiSize; off++)
+    {
+        if ((off < start || off >= end || (off - start) % row >= vis) && s_pMem[off] != SIM_GUARD_BYTE)
+        {
+            fprintf(stderr, "gfx_sim: guard band written at row %d\n", SimRow(off));
+            err++;
+            break;
+        }
+    }
+    s_uiError = 0;
+    return err;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_SimGetStat
+*    功能说明: 读取统计信息
+*    形    参: _pStat : 统计信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_SimGetStat(GFX_SIM_STAT_T *_pStat)
+{
+    *_pStat = s_tStat;
+}
+
+/* 以下实现 bsp_gfx.h 的接口，与 bsp_gfx.c 相同 */
+
+void GFX_InitSurface(GFX_SURFACE_T *_pSurf, uint32_t _addr, uint16_t _usWidth, uint16_t _usHeight, GFX_FMT_E _fmt)
+{
+    _pSurf->addr = _addr;
+    _pSurf->width = _usWidth;
+    _pSurf->height = _usHeight;
+    _pSurf->pitch = _usWidth;
+    _pSurf->format = _fmt;
+    _pSurf->clut = NULL;
+    _pSurf->clut_num = 0;
+}
+
+uint8_t GFX_BitsPerPixel(GFX_FMT_E _fmt)
+{
+    return (_fmt < GFX_FMT_NUM) ? s_ucBits[_fmt] : 0;
+}
+
+uint32_t GFX_ColorFromARGB(GFX_FMT_E _fmt, uint32_t _argb)
+{
+    uint32_t a = _argb >> 24;
+    uint32_t r = (_argb >> 16) & 0xFF;
+    uint32_t g = (_argb >> 8) & 0xFF;
+    uint32_t b = _argb & 0xFF;
+
+    switch (_fmt)
+    {
+    case GFX_RGB888:
+        return _argb & 0xFFFFFF;
+
+    case GFX_RGB565:
+        return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+
+    case GFX_ARGB1555:
+        return ((a >> 7) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+
+    case GFX_ARGB4444:
+        return ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+
+    case GFX_L8:
+        return b;
+
+    case GFX_AL44:
+        return ((a >> 4) << 4) | (b & 0x0F);
+
+    case GFX_A8:
+        return a;
+
+    default:
+        return _argb;
+    }
+}
+
+/* 按图像大小裁剪，与 bsp_gfx.c 的 GFX_Clip 相同(没有源图像) */
+static uint8_t SimClip(const GFX_SURFACE_T *_pDst, int32_t *_x, int32_t *_y, int32_t *_w, int32_t *_h)
+{
+    if (*_x < 0)
+    {
+        *_w += *_x;
+        *_x = 0;
+    }
+    if (*_y < 0)
+    {
+        *_h += *_y;
+        *_y = 0;
+    }
+    if (*_x + *_w > _pDst->width)
+    {
+        *_w = _pDst->width - *_x;
+    }
+    if (*_y + *_h > _pDst->height)
+    {
+        *_h = _pDst->height - *_y;
+    }
+
+    return (*_w > 0 && *_h > 0);
+}
+
+void GFX_FlushCache(const GFX_SURFACE_T *_pSurf, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h)
+{
+    int32_t x = _x, y = _y, w = _w, h = _h;
+
+    if (SimClip(_pSurf, &x, &y, &w, &h))
+    {
+        if (s_usQueue != 0)
+        {
+            SimProtect(0);
+        }
+        SimFlush(SimOffset(x, y) & ~(size_t)(SIM_LINE - 1), SimOffset(x + w, y + h - 1));
+        if (s_usQueue != 0)
+        {
+            SimProtect(1);
+        }
+    }
+}
+
+/* 只模拟DMA2D能输出的格式 */
+void GFX_FillRect(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h, uint32_t _argb)
+{
+    int32_t x = _x, y = _y, w = _w, h = _h;
+
+    if (_pDst->format > GFX_ARGB4444 || !SimClip(_pDst, &x, &y, &w, &h))
+    {
+        return;
+    }
+    if (s_usQueue == GFX_QUEUE_SIZE)
+    {
+        SimRun();
+    }
+    GFX_FlushCache(_pDst, x, y, w, h);
+
+    s_tQueue[s_usQueue].x = x;
+    s_tQueue[s_usQueue].y = y;
+    s_tQueue[s_usQueue].w = w;
+    s_tQueue[s_usQueue].h = h;
+    s_tQueue[s_usQueue].pix = GFX_ColorFromARGB((GFX_FMT_E)_pDst->format, _argb);
+    s_usQueue++;
+    s_tStat.fills++;
+    SimProtect(1);
+}
+
+uint8_t GFX_Busy(void)
+{
+    return s_usQueue != 0;
+}
+
+void GFX_Wait(void)
+{
+    if (s_usQueue != 0)
+    {
+        s_tStat.waits++;
+    }
+    SimRun();
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
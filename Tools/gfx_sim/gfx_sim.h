@@ -0,0 +1,38 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA2D 模拟器
+*    文件名称 : gfx_sim.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _GFX_SIM_H
+#define _GFX_SIM_H
+
+#include <stdint.h>
+#include "bsp_gfx.h"
+
+/* 统计信息 */
+typedef struct
+{
+    uint32_t fills;   /* DMA2D填充次数 */
+    uint32_t flushes; /* 写回并作废D-Cache的Cache行数 */
+    uint32_t waits;   /* 等待DMA2D完成的次数 */
+} GFX_SIM_STAT_T;
+
+int GFX_SimOpen(GFX_SURFACE_T *_pSurf, uint16_t _usWidth, uint16_t _usHeight, uint16_t _usPitch, GFX_FMT_E _fmt);
+void GFX_SimClose(void);
+const uint8_t *GFX_SimMem(int32_t _x, int32_t _y);
+uint32_t GFX_SimCheck(void);
+void GFX_SimGetStat(GFX_SIM_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
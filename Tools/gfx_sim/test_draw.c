@@ -0,0 +1,367 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 矢量绘图模块测试
+*    文件名称 : test_draw.c
+*    版    本 : V1.0
+*    说    明 : 在PC上用 gfx_sim 测试 bsp_gfx_draw.c:
+*               1. 固定场景(仪表盘、曲线、多边形，部分超出图像)的CRC32与基准值相同
+*               2. DMA2D+CPU 与只用CPU绘制的结果相同，每次绘制后CPU写入的行都已写回D-Cache
+*               3. 相邻多边形的公共边既不重复也不遗漏
+*               4. 超出图像很远的图形不改写保护区
+*               ./test_draw [--dump]    --dump 把场景保存为 draw_<格式>.ppm
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gfx_sim.h"
+
+/* 直接包含被测文件，测试时修改 s_usDmaMin */
+#include "bsp_gfx_draw.c"
+
+#define W 320
+#define H 240
+#define PITCH (W + 13) /* 奇数，RGB565的行首交替2字节和4字节对齐 */
+
+#define CHECK(x)                                                  \
+    do                                                            \
+    {                                                             \
+        if (!(x))                                                 \
+        {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            exit(1);                                              \
+        }                                                         \
+    } while (0)
+
+/* 场景的基准CRC32，用 --dump 输出的图片检查后更新 */
+static const struct
+{
+    GFX_FMT_E fmt;
+    const char *name;
+    uint32_t crc;
+} s_tGolden[] = {
+    {GFX_ARGB8888, "argb8888", 0x27546884},
+    {GFX_RGB888, "rgb888", 0x7A048FA8},
+    {GFX_RGB565, "rgb565", 0xA4F557D7},
+};
+
+static GFX_SURFACE_T s_tSurf;
+static uint8_t s_ucStep; /* 1: 每次绘制后等待并检查 */
+
+static uint32_t crc32(uint32_t _crc, const uint8_t *_p, uint32_t _len)
+{
+    _crc = ~_crc;
+    while (_len--)
+    {
+        _crc ^= *_p++;
+        for (int k = 0; k < 8; k++)
+        {
+            _crc = (_crc >> 1) ^ (0xEDB88320 & -(_crc & 1));
+        }
+    }
+    return ~_crc;
+}
+
+/* 显存中图像内容的CRC32 */
+static uint32_t surface_crc(void)
+{
+    uint32_t crc = 0;
+
+    GFX_Wait();
+    for (int y = 0; y < H; y++)
+    {
+        crc = crc32(crc, GFX_SimMem(0, y), W * GFX_BitsPerPixel((GFX_FMT_E)s_tSurf.format) / 8);
+    }
+    return crc;
+}
+
+/* 显存中像素(x, y)转换为ARGB8888 */
+static uint32_t surface_pixel(int _x, int _y)
+{
+    const uint8_t *p = GFX_SimMem(_x, _y);
+    uint32_t pix = 0;
+
+    memcpy(&pix, p, GFX_BitsPerPixel((GFX_FMT_E)s_tSurf.format) / 8);
+    return DRAW_ToARGB(s_tSurf.format, pix);
+}
+
+static void dump_ppm(const char *_name)
+{
+    char path[64];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "draw_%s.ppm", _name);
+    fp = fopen(path, "wb");
+    CHECK(fp != NULL);
+    fprintf(fp, "P6\n%d %d\n255\n", W, H);
+    for (int y = 0; y < H; y++)
+    {
+        for (int x = 0; x < W; x++)
+        {
+            uint32_t c = surface_pixel(x, y);
+
+            fputc(c >> 16, fp);
+            fputc(c >> 8, fp);
+            fputc(c, fp);
+        }
+    }
+    fclose(fp);
+    printf("  %s saved\n", path);
+}
+
+/* 单步模式下每次绘制后等待DMA2D，检查D-Cache和保护区 */
+static void step(void)
+{
+    if (s_ucStep)
+    {
+        GFX_Wait();
+        CHECK(GFX_SimCheck() == 0);
+    }
+}
+
+static void star(GFX_POINT_T *_pPts, int16_t _cx, int16_t _cy, int16_t _r)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        _pPts[i].x = _cx + (int16_t)lround(_r * cos((i * 144 - 90) * 3.14159265358979 / 180));
+        _pPts[i].y = _cy + (int16_t)lround(_r * sin((i * 144 - 90) * 3.14159265358979 / 180));
+    }
+}
+
+/* 固定场景，包含 DMA2D 和 CPU 交替写入的水平线、读取目标的抗锯齿直线和超出图像的图形 */
+static void draw_scene(void)
+{
+    const GFX_SURFACE_T *s = &s_tSurf;
+    GFX_POINT_T pts[5];
+    GFX_POINT_T tri[3] = {{250, 150}, {340, 200}, {200, 260}};
+    int16_t last = 0, v;
+
+    GFX_FillRect(s, 0, 0, W, H, GFX_RGB(16, 24, 32));
+    step();
+
+    /* 仪表盘，左侧超出图像 */
+    GFX_DrawArc(s, 70, 110, 90, 14, 135, 405, GFX_RGB(64, 64, 64));
+    step();
+    GFX_DrawArc(s, 70, 110, 90, 14, 135, 315, GFX_RGB(0, 200, 255));
+    step();
+    for (int i = 0; i <= 10; i++)
+    {
+        double a = (135 + i * 27) * 3.14159265358979 / 180;
+
+        GFX_DrawLineAA(s, 70 + (int16_t)(72 * cos(a)), 110 + (int16_t)(72 * sin(a)),
+                       70 + (int16_t)(60 * cos(a)), 110 + (int16_t)(60 * sin(a)), GFX_RGB(255, 255, 255));
+        step();
+    }
+    GFX_DrawLineAA(s, 70, 110, 120, 60, GFX_RGB(255, 64, 64));
+    step();
+    GFX_FillCircle(s, 70, 110, 8, GFX_RGB(255, 64, 64));
+    step();
+    GFX_DrawCircle(s, 70, 110, 100, GFX_RGB(128, 128, 128));
+    step();
+    GFX_FillCircle(s, 70, 110, 40, GFX_ARGB(255, 40, 80, 40));
+    step();
+
+    /* 曲线图: 网格、长短垂直线和抗锯齿折线 */
+    for (int i = 0; i <= 4; i++)
+    {
+        GFX_DrawHLine(s, 170, 20 + i * 20, 140, GFX_RGB(48, 64, 80));
+        step();
+        GFX_DrawVLine(s, 170 + i * 35, 20, (i & 1) ? 80 : 30, GFX_RGB(48, 64, 80));
+        step();
+    }
+    for (int i = 0; i <= 140; i += 4)
+    {
+        v = 60 - (int16_t)(35 * sin(i / 20.0) * cos(i / 57.0));
+        if (i != 0)
+        {
+            GFX_DrawLineAA(s, 170 + i - 4, last, 170 + i, v, GFX_ARGB(200, 255, 200, 0));
+            step();
+        }
+        last = v;
+    }
+
+    /* 多边形: 自相交的五角星，超出底边的三角形和轮廓 */
+    star(pts, 200, 180, 55);
+    GFX_FillPolygon(s, pts, 5, GFX_RGB(64, 220, 64));
+    step();
+    GFX_FillPolygon(s, tri, 3, GFX_RGB(220, 64, 220));
+    step();
+    star(pts, 290, 180, 45);
+    GFX_DrawPolygon(s, pts, 5, GFX_RGB(255, 255, 255));
+    step();
+
+    /* 直线: 在图像内的、穿过图像的和水平、垂直的 */
+    GFX_DrawLine(s, 5, 235, 150, 140, GFX_RGB(255, 255, 0));
+    step();
+    GFX_DrawLine(s, -50, 300, 400, -20, GFX_RGB(0, 255, 255));
+    step();
+    GFX_DrawLine(s, -10, 5, 330, 5, GFX_RGB(255, 128, 0));
+    step();
+    GFX_DrawLine(s, 315, -10, 315, 250, GFX_RGB(255, 128, 0));
+    step();
+
+    /* 右边超出图像的圆弧，半透明抗锯齿直线跨过DMA2D填充的区域 */
+    GFX_DrawArc(s, 300, 60, 50, 50, -90, 90, GFX_RGB(200, 100, 0));
+    step();
+    GFX_DrawLineAA(s, 260, 10, 319, 120, GFX_ARGB(128, 0, 128, 255));
+    step();
+}
+
+/* 固定场景: 逐步检查和连续绘制、DMA2D+CPU 和只用CPU 的结果相同，与基准CRC相同 */
+static void test_scene(uint8_t _ucDump)
+{
+    GFX_SIM_STAT_T st;
+    uint32_t crc[3];
+
+    for (uint32_t f = 0; f < sizeof(s_tGolden) / sizeof(s_tGolden[0]); f++)
+    {
+        CHECK(GFX_SimOpen(&s_tSurf, W, H, PITCH, s_tGolden[f].fmt) == 0);
+
+        s_usDmaMin = DRAW_DMA2D_MIN;
+        s_ucStep = 1;
+        draw_scene();
+        crc[0] = surface_crc();
+        CHECK(GFX_SimCheck() == 0);
+        GFX_SimGetStat(&st);
+        CHECK(st.fills > 10);
+        if (_ucDump)
+        {
+            dump_ppm(s_tGolden[f].name);
+        }
+
+        s_ucStep = 0;
+        draw_scene();
+        crc[1] = surface_crc();
+        CHECK(GFX_SimCheck() == 0);
+
+        s_usDmaMin = 0;
+        draw_scene();
+        crc[2] = surface_crc();
+        CHECK(GFX_SimCheck() == 0);
+        s_usDmaMin = DRAW_DMA2D_MIN;
+
+        printf("scene %-8s crc %08X, %u fills, %u waits, %u cache lines flushed\n", s_tGolden[f].name, crc[0],
+               st.fills, st.waits, st.flushes);
+        CHECK(crc[1] == crc[0]);
+        CHECK(crc[2] == crc[0]);
+        CHECK(_ucDump || crc[0] == s_tGolden[f].crc);
+    }
+}
+
+/* 统计等于颜色的像素个数 */
+static uint32_t count_color(uint32_t _argb)
+{
+    uint32_t n = 0;
+
+    GFX_Wait();
+    for (int y = 0; y < H; y++)
+    {
+        for (int x = 0; x < W; x++)
+        {
+            n += (surface_pixel(x, y) == _argb);
+        }
+    }
+    return n;
+}
+
+/* 六边形分为6个三角形，三角形覆盖的像素与整个六边形相同(没有遗漏)，像素数之和也相同(没有重叠) */
+static void test_shared_edges(void)
+{
+    GFX_POINT_T hex[6], tri[3] = {{161, 117}};
+    uint32_t sum = 0, all;
+
+    CHECK(GFX_SimOpen(&s_tSurf, W, H, PITCH, GFX_ARGB8888) == 0);
+    for (int i = 0; i < 6; i++)
+    {
+        hex[i].x = 160 + (int16_t)lround(100 * cos((i * 60 + 7) * 3.14159265358979 / 180));
+        hex[i].y = 120 + (int16_t)lround(100 * sin((i * 60 + 7) * 3.14159265358979 / 180));
+    }
+
+    GFX_FillRect(&s_tSurf, 0, 0, W, H, 0xFF000000);
+    CHECK(GFX_FillPolygon(&s_tSurf, hex, 6, 0xFFFFFFFF) == 0);
+    all = count_color(0xFFFFFFFF);
+
+    /* 颜色各不相同，画完一个统计一次，重叠的像素会被计算两次 */
+    GFX_FillRect(&s_tSurf, 0, 0, W, H, 0xFF000000);
+    for (int i = 0; i < 6; i++)
+    {
+        tri[1] = hex[i];
+        tri[2] = hex[(i + 1) % 6];
+        CHECK(GFX_FillPolygon(&s_tSurf, tri, 3, 0xFF000010 + i) == 0);
+        sum += count_color(0xFF000010 + i);
+    }
+    CHECK(GFX_SimCheck() == 0);
+    CHECK(count_color(0xFF000000) == W * H - all);
+    CHECK(sum == all);
+
+    printf("shared edges ok, %u pixels\n", all);
+}
+
+/* 远超出图像的图形只画图像内的部分 */
+static void test_clip(void)
+{
+    GFX_POINT_T poly[4] = {{-30000, -30000}, {30000, -20000}, {160, 30000}, {-200, 120}};
+
+    CHECK(GFX_SimOpen(&s_tSurf, W, H, PITCH, GFX_RGB565) == 0);
+    s_ucStep = 1;
+    GFX_FillRect(&s_tSurf, -100, -100, 1000, 1000, GFX_RGB(0, 0, 0));
+    step();
+    GFX_DrawHLine(&s_tSurf, -32000, 0, 65000, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawHLine(&s_tSurf, 0, -1, W, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawHLine(&s_tSurf, 0, H, W, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawVLine(&s_tSurf, W - 1, -32000, 65000, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawVLine(&s_tSurf, W, 0, 10, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawVLine(&s_tSurf, 3, H - 5, 10, GFX_RGB(255, 0, 0));
+    step();
+    GFX_DrawLine(&s_tSurf, -32000, -31000, 32000, 31000, GFX_RGB(0, 255, 0));
+    step();
+    GFX_DrawLine(&s_tSurf, W - 3, -5, W + 3, H + 5, GFX_RGB(0, 255, 0));
+    step();
+    GFX_DrawLineAA(&s_tSurf, -5000, 200, 5000, -100, GFX_RGB(0, 255, 0));
+    step();
+    GFX_DrawLineAA(&s_tSurf, -3, -3, W + 2, H + 2, GFX_RGB(0, 255, 0));
+    step();
+    GFX_DrawCircle(&s_tSurf, 160, 120, 200, GFX_RGB(0, 0, 255));
+    step();
+    GFX_FillCircle(&s_tSurf, 0, H, 30000, GFX_RGB(0, 0, 255));
+    step();
+    GFX_FillCircle(&s_tSurf, W + 5, 10, 10, GFX_RGB(0, 0, 255));
+    step();
+    GFX_DrawArc(&s_tSurf, 160, 120, 2000, 1900, 0, 360, GFX_RGB(255, 255, 0));
+    step();
+    GFX_DrawArc(&s_tSurf, -10, -10, 100, 20, 0, 90, GFX_RGB(255, 255, 0));
+    step();
+    CHECK(GFX_FillPolygon(&s_tSurf, poly, 4, GFX_RGB(255, 0, 255)) == 0);
+    step();
+    GFX_DrawPolygon(&s_tSurf, poly, 4, GFX_RGB(255, 0, 255));
+    step();
+    s_ucStep = 0;
+
+    printf("clip ok\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t dump = (argc > 1 && strcmp(argv[1], "--dump") == 0);
+
+    test_scene(dump);
+    test_shared_edges();
+    test_clip();
+    GFX_SimClose();
+
+    return 0;
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+通过串口发送固件给开发板 (shell 命令 ota recv / ota install)
+
+    python ota_send.py COM3 "..\\output(mdk).hex"
+    python ota_send.py COM3 project.bin --baud 115200 --fast 921600 --install
+
+流程:
+    1. 以 shell 波特率发送 "ota recv <size> <crc32> <fast>"
+    2. 开发板擦除暂存区后回复 "OTA READY <fast>" 并切换波特率
+    3. 以 fast 波特率发送原始镜像，等待 "OTA OK" 或 "OTA ERROR"
+    4. 切回 shell 波特率，可选发送 "ota install"
+
+依赖: pip install pyserial
+"""
+import argparse
+import sys
+import time
+import zlib
+
+import serial
+
+FLASH_BASE = 0x08000000
+IMAGE_MAX = 1024 * 1024
+
+
+def load_hex(path):
+    """Intel HEX 转为从 FLASH_BASE 开始的连续镜像，空隙填 0xFF"""
+    data = {}
+    upper = 0
+    with open(path, "r") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(":"):
+                continue
+            rec = bytes.fromhex(line[1:])
+            if (sum(rec) & 0xFF) != 0:
+                raise ValueError("hex checksum error: " + line)
+            count, addr, rtype = rec[0], (rec[1] << 8) | rec[2], rec[3]
+            payload = rec[4:4 + count]
+            if rtype == 0x00:
+                base = upper + addr
+                for i, b in enumerate(payload):
+                    data[base + i] = b
+            elif rtype == 0x04:
+                upper = ((payload[0] << 8) | payload[1]) << 16
+            elif rtype == 0x02:
+                upper = ((payload[0] << 8) | payload[1]) << 4
+            elif rtype == 0x01:
+                break
+    if not data:
+        raise ValueError("empty hex file")
+    start, end = min(data), max(data) + 1
+    if start != FLASH_BASE:
+        raise ValueError("image must start at 0x%08X" % FLASH_BASE)
+    image = bytearray(b"\xFF" * (end - start))
+    for a, b in data.items():
+        image[a - start] = b
+    return bytes(image)
+
+
+def wait_line(port, prefix, timeout):
+    """读取串口直到出现以 prefix 开头的行"""
+    end = time.time() + timeout
+    buf = b""
+    while time.time() < end:
+        buf += port.read(port.in_waiting or 1)
+        while b"\n" in buf:
+            line, buf = buf.split(b"\n", 1)
+            text = line.decode("ascii", "replace").strip()
+            if text.startswith(prefix):
+                return text
+    raise TimeoutError("waiting for '%s' timeout" % prefix)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="send firmware over COM1")
+    ap.add_argument("port")
+    ap.add_argument("file", help=".bin or .hex")
+    ap.add_argument("--baud", type=int, default=115200, help="shell baud rate")
+    ap.add_argument("--fast", type=int, default=921600, help="transfer baud rate")
+    ap.add_argument("--install", action="store_true", help="install and reboot after transfer")
+    args = ap.parse_args()
+
+    if args.file.lower().endswith(".hex"):
+        image = load_hex(args.file)
+    else:
+        with open(args.file, "rb") as f:
+            image = f.read()
+    if len(image) > IMAGE_MAX:
+        sys.exit("image too large: %d bytes" % len(image))
+    crc = zlib.crc32(image) & 0xFFFFFFFF
+    print("image %d bytes crc32 0x%08X" % (len(image), crc))
+
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    port.reset_input_buffer()
+    port.write(b"ota recv %d 0x%08X %d\r\n" % (len(image), crc, args.fast))
+    print(wait_line(port, "OTA READY", 30))
+
+    if args.fast != args.baud:
+        time.sleep(0.05)
+        port.baudrate = args.fast
+    port.reset_input_buffer()
+
+    start = time.time()
+    port.write(image)
+    port.flush()
+    result = wait_line(port, "OTA ", 10)
+    elapsed = time.time() - start
+    print("%s (%.1f s, %.1f KB/s)" % (result, elapsed, len(image) / 1024 / elapsed))
+
+    time.sleep(0.05)
+    port.baudrate = args.baud
+    if not result.startswith("OTA OK"):
+        sys.exit(1)
+
+    if args.install:
+        port.reset_input_buffer()
+        port.write(b"ota install\r\n")
+        print(wait_line(port, "OTA", 60))
+
+
+if __name__ == "__main__":
+    main()
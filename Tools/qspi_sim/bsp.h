@@ -0,0 +1,30 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 模拟器
+*    文件名称 : bsp.h
+*    版    本 : V1.0
+*    说    明 : 只用于在PC上编译 bsp_user_lib.c(CRC16_Modbus、CRC32_Update)，代替 User/bsp/bsp.h，
+*               不包含HAL。被测模块 bsp_qspi_kv.c、bsp_qspi_ftl.c 本身不包含 bsp.h。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#ifndef _BSP_H_
+#define _BSP_H_
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_user_lib.h"
+
+#define RAM_FUNC /* PC上不区分ITCM */
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,317 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 模拟器
+*    文件名称 : qspi_sim.c
+*    版    本 : V1.0
+*    说    明 : 在PC上用文件模拟QSPI Flash，实现 bsp_qspi.h 的读、页编程和擦除接口，用于测试KV、FTL模块。
+*               1. 镜像文件映射到内存，新文件填充0xFF。编程只能把1改为0，与NOR Flash相同
+*               2. 编程和擦除发出后并不立即完成，下一次访问Flash或 QSPI_WaitBusy 时才完成，
+*                  与实际Flash的BUSY状态一致。返回前没有等待BUSY的写入在掉电后可能残缺
+*               3. QSPI_SimCutAfter 设置在第n次编程/擦除时掉电: 该操作只完成一部分，然后 longjmp
+*                  到 g_SimPowerLoss；QSPI_SimPowerOff 模拟调用返回后立即掉电
+*               4. 残缺的编程和擦除按字节随机处理: 完成、未改变或部分位改变
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "bsp_qspi.h"
+#include "qspi_sim.h"
+
+#define SIM_OP_NONE 0
+#define SIM_OP_PROGRAM 1
+#define SIM_OP_ERASE 2
+
+/* 进行中的编程或擦除 */
+typedef struct
+{
+    uint8_t type;
+    uint32_t addr;
+    uint32_t size;
+    uint8_t data[QSPI_PAGE_SIZE];
+} SIM_OP_T;
+
+jmp_buf g_SimPowerLoss;
+
+static uint8_t *s_pMem = NULL;
+static int s_iFd = -1;
+static SIM_OP_T s_tOp;
+static uint32_t s_uiCutAfter = 0; /* 0 表示不掉电 */
+static uint32_t s_uiRand = 1;
+static QSPI_SIM_STAT_T s_tStat;
+
+/* xorshift32 随机数，种子相同时结果可复现 */
+uint32_t QSPI_SimRand(void)
+{
+    s_uiRand ^= s_uiRand << 13;
+    s_uiRand ^= s_uiRand >> 17;
+    s_uiRand ^= s_uiRand << 5;
+
+    return s_uiRand;
+}
+
+/* 检查地址范围，越界说明被测模块有错误 */
+static void SimCheck(uint32_t _uiAddr, uint32_t _uiSize)
+{
+    if (s_pMem == NULL || _uiAddr >= QSPI_FLASH_SIZES || _uiSize > QSPI_FLASH_SIZES - _uiAddr)
+    {
+        fprintf(stderr, "qspi_sim: access 0x%08X + %u out of range\n", _uiAddr, _uiSize);
+        abort();
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SimFinish
+*    功能说明: 结束进行中的操作
+*    形    参: _ucTorn : 0 正常完成， 1 掉电，操作只完成一部分
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SimFinish(uint8_t _ucTorn)
+{
+    uint8_t *p = &s_pMem[s_tOp.addr];
+    uint32_t i;
+
+    for (i = 0; i < s_tOp.size; i++)
+    {
+        if (s_tOp.type == SIM_OP_PROGRAM)
+        {
+            switch (_ucTorn ? QSPI_SimRand() % 3 : 0)
+            {
+            case 0:
+                p[i] &= s_tOp.data[i];
+                break;
+
+            case 1:
+                break;
+
+            default:
+                p[i] &= s_tOp.data[i] | (uint8_t)QSPI_SimRand();
+                break;
+            }
+        }
+        else
+        {
+            switch (_ucTorn ? QSPI_SimRand() % 3 : 0)
+            {
+            case 0:
+                p[i] = 0xFF;
+                break;
+
+            case 1:
+                break;
+
+            default:
+                p[i] |= (uint8_t)QSPI_SimRand();
+                break;
+            }
+        }
+    }
+    s_tOp.type = SIM_OP_NONE;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SimStart
+*    功能说明: 发出编程或擦除。到达掉电点时操作残缺并 longjmp
+*    形    参: _ucType : SIM_OP_PROGRAM 或 SIM_OP_ERASE
+*              _uiAddr : 地址
+*              _pData : 编程数据
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SimStart(uint8_t _ucType, uint32_t _uiAddr, const uint8_t *_pData, uint32_t _uiSize)
+{
+    QSPI_WaitBusy();
+
+    s_tOp.type = _ucType;
+    s_tOp.addr = _uiAddr;
+    s_tOp.size = _uiSize;
+    if (_pData != NULL)
+    {
+        memcpy(s_tOp.data, _pData, _uiSize);
+    }
+
+    if (s_uiCutAfter != 0 && --s_uiCutAfter == 0)
+    {
+        SimFinish(1);
+        s_tStat.cuts++;
+        longjmp(g_SimPowerLoss, 1);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_SimOpen
+*    功能说明: 打开Flash镜像文件，不存在时创建并填充0xFF
+*    形    参: _path : 文件名
+*              _uiSeed : 随机数种子，决定掉电时的残缺内容
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int QSPI_SimOpen(const char *_path, uint32_t _uiSeed)
+{
+    off_t size;
+
+    QSPI_SimClose();
+    s_iFd = open(_path, O_RDWR | O_CREAT, 0644);
+    if (s_iFd < 0)
+    {
+        return -1;
+    }
+
+    size = lseek(s_iFd, 0, SEEK_END);
+    if (size != QSPI_FLASH_SIZES && ftruncate(s_iFd, QSPI_FLASH_SIZES) != 0)
+    {
+        QSPI_SimClose();
+        return -1;
+    }
+
+    s_pMem = mmap(NULL, QSPI_FLASH_SIZES, PROT_READ | PROT_WRITE, MAP_SHARED, s_iFd, 0);
+    if (s_pMem == MAP_FAILED)
+    {
+        s_pMem = NULL;
+        QSPI_SimClose();
+        return -1;
+    }
+    if (size != QSPI_FLASH_SIZES)
+    {
+        memset(s_pMem, 0xFF, QSPI_FLASH_SIZES);
+    }
+
+    memset(&s_tOp, 0, sizeof(s_tOp));
+    memset(&s_tStat, 0, sizeof(s_tStat));
+    s_uiCutAfter = 0;
+    s_uiRand = (_uiSeed != 0) ? _uiSeed : 1;
+
+    return 0;
+}
+
+/* 完成进行中的操作，关闭镜像文件 */
+void QSPI_SimClose(void)
+{
+    if (s_pMem != NULL)
+    {
+        QSPI_WaitBusy();
+        munmap(s_pMem, QSPI_FLASH_SIZES);
+        s_pMem = NULL;
+    }
+    if (s_iFd >= 0)
+    {
+        close(s_iFd);
+        s_iFd = -1;
+    }
+}
+
+/* 第 _uiOps 次编程/擦除时掉电，0 取消 */
+void QSPI_SimCutAfter(uint32_t _uiOps)
+{
+    s_uiCutAfter = _uiOps;
+}
+
+/* 立即掉电，进行中的操作残缺 */
+void QSPI_SimPowerOff(void)
+{
+    if (s_tOp.type != SIM_OP_NONE)
+    {
+        SimFinish(1);
+    }
+    s_uiCutAfter = 0;
+    s_tStat.cuts++;
+}
+
+/* 是否有进行中的编程或擦除，即Flash的BUSY位 */
+uint8_t QSPI_SimBusy(void)
+{
+    return s_tOp.type != SIM_OP_NONE;
+}
+
+/* Flash内容，测试程序直接检查或破坏数据 */
+uint8_t *QSPI_SimMem(uint32_t _uiAddr)
+{
+    SimCheck(_uiAddr, 0);
+
+    return &s_pMem[_uiAddr];
+}
+
+void QSPI_SimGetStat(QSPI_SIM_STAT_T *_pStat)
+{
+    *_pStat = s_tStat;
+}
+
+/*
+*********************************************************************************************************
+*    以下为 bsp_qspi.h 接口
+*********************************************************************************************************
+*/
+void QSPI_WaitBusy(void)
+{
+    if (s_tOp.type != SIM_OP_NONE)
+    {
+        SimFinish(0);
+    }
+}
+
+void QSPI_ReadBuffer(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize)
+{
+    SimCheck(_uiReadAddr, _uiSize);
+    QSPI_WaitBusy();
+    memcpy(_pBuf, &s_pMem[_uiReadAddr], _uiSize);
+    s_tStat.reads++;
+}
+
+void QSPI_WriteBuffer(uint8_t *_pBuf, uint32_t _uiWriteAddr, uint16_t _usWriteSize)
+{
+    uint32_t len;
+
+    SimCheck(_uiWriteAddr, _usWriteSize);
+    while (_usWriteSize > 0)
+    {
+        len = QSPI_PAGE_SIZE - (_uiWriteAddr & (QSPI_PAGE_SIZE - 1));
+        if (len > _usWriteSize)
+        {
+            len = _usWriteSize;
+        }
+        s_tStat.programs++;
+        SimStart(SIM_OP_PROGRAM, _uiWriteAddr, _pBuf, len);
+        _pBuf += len;
+        _uiWriteAddr += len;
+        _usWriteSize -= len;
+    }
+}
+
+void QSPI_EraseSector(uint32_t _uiSectorAddr)
+{
+    _uiSectorAddr &= ~(QSPI_SECTOR_SIZE - 1);
+    SimCheck(_uiSectorAddr, QSPI_SECTOR_SIZE);
+    s_tStat.erases++;
+    SimStart(SIM_OP_ERASE, _uiSectorAddr, NULL, QSPI_SECTOR_SIZE);
+}
+
+void QSPI_EraseBlock(uint32_t _uiBlockAddr)
+{
+    _uiBlockAddr &= ~(QSPI_BLOCK_SIZE - 1);
+    SimCheck(_uiBlockAddr, QSPI_BLOCK_SIZE);
+    s_tStat.erases++;
+    SimStart(SIM_OP_ERASE, _uiBlockAddr, NULL, QSPI_BLOCK_SIZE);
+}
+
+void QSPI_EraseChip(void)
+{
+    SimCheck(0, QSPI_FLASH_SIZES);
+    s_tStat.erases++;
+    SimStart(SIM_OP_ERASE, 0, NULL, QSPI_FLASH_SIZES);
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
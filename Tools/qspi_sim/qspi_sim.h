@@ -0,0 +1,45 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 模拟器
+*    文件名称 : qspi_sim.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _QSPI_SIM_H
+#define _QSPI_SIM_H
+
+#include <setjmp.h>
+#include <stdint.h>
+
+/* 测试程序 setjmp 到这里，模拟掉电时 longjmp 返回 1 */
+extern jmp_buf g_SimPowerLoss;
+
+/* 统计信息 */
+typedef struct
+{
+    uint32_t reads;    /* 读取次数 */
+    uint32_t programs; /* 页编程次数 */
+    uint32_t erases;   /* 扇区擦除次数 */
+    uint32_t cuts;     /* 模拟掉电次数 */
+} QSPI_SIM_STAT_T;
+
+int QSPI_SimOpen(const char *_path, uint32_t _uiSeed);
+void QSPI_SimClose(void);
+void QSPI_SimCutAfter(uint32_t _uiOps);
+void QSPI_SimPowerOff(void);
+uint8_t QSPI_SimBusy(void);
+uint8_t *QSPI_SimMem(uint32_t _uiAddr);
+uint32_t QSPI_SimRand(void);
+void QSPI_SimGetStat(QSPI_SIM_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,249 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : FTL块设备模块测试
+*    文件名称 : test_ftl.c
+*    版    本 : V1.0
+*    说    明 : 在PC上用 qspi_sim 测试 bsp_qspi_ftl.c: 读写、裁剪、扇区写缓存、日志写满后的检查点，
+*               以及随机掉电后的恢复。掉电时正在写入的块可以是旧数据或新数据，其它块必须不变；
+*               返回成功的写入 Flash 已不忙，立即掉电也不丢失。
+*               ./test_ftl [掉电次数] [随机数种子]
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_qspi.h"
+#include "bsp_qspi_ftl.h"
+#include "qspi_sim.h"
+
+#define IMAGE "test_ftl.bin"
+#define BLOCK_NUM 32 /* 测试使用的逻辑块个数 */
+
+#define CHECK(x)                                                              \
+    do                                                                        \
+    {                                                                         \
+        if (!(x))                                                             \
+        {                                                                     \
+            printf("%s:%d: CHECK(%s) failed, seed %u\n", __FILE__, __LINE__, \
+                   #x, s_uiSeed);                                             \
+            exit(1);                                                          \
+        }                                                                     \
+    } while (0)
+
+static uint8_t s_ucModel[BLOCK_NUM][FTL_BLOCK_SIZE]; /* 期望的内容 */
+static uint8_t s_ucPend[FTL_BLOCK_SIZE];             /* 掉电时正在写入的内容 */
+static int s_iPendBlock = -1;
+static uint32_t s_uiSeed = 1;
+static uint8_t s_ucBuf[FTL_BLOCK_SIZE];
+
+static void model_reset(void)
+{
+    memset(s_ucModel, 0xFF, sizeof(s_ucModel));
+}
+
+static void random_fill(uint8_t *_pBuf, uint32_t _uiSize)
+{
+    for (uint32_t i = 0; i < _uiSize; i += 4)
+    {
+        uint32_t x = QSPI_SimRand();
+
+        memcpy(&_pBuf[i], &x, 4);
+    }
+}
+
+/* 检查所有块与模型一致，掉电时正在写入的块可以是旧数据或新数据 */
+static void model_verify(void)
+{
+    for (int i = 0; i < BLOCK_NUM; i++)
+    {
+        CHECK(FTL_ReadBlock(i, s_ucBuf) == 0);
+        if (i == s_iPendBlock && memcmp(s_ucBuf, s_ucModel[i], FTL_BLOCK_SIZE) != 0)
+        {
+            CHECK(memcmp(s_ucBuf, s_ucPend, FTL_BLOCK_SIZE) == 0);
+            memcpy(s_ucModel[i], s_ucPend, FTL_BLOCK_SIZE);
+        }
+        CHECK(memcmp(s_ucBuf, s_ucModel[i], FTL_BLOCK_SIZE) == 0);
+    }
+    s_iPendBlock = -1;
+}
+
+/* 随机整块写入、扇区写入或裁剪一个块，成功后更新模型 */
+static void random_op(void)
+{
+    int i = QSPI_SimRand() % BLOCK_NUM;
+    uint32_t op = QSPI_SimRand() % 10;
+    uint32_t sector;
+    int ret;
+
+    memcpy(s_ucPend, s_ucModel[i], FTL_BLOCK_SIZE);
+    s_iPendBlock = i;
+    if (op == 0)
+    {
+        memset(s_ucPend, 0xFF, FTL_BLOCK_SIZE);
+        ret = FTL_Trim(i);
+    }
+    else if (op <= 2)
+    {
+        sector = QSPI_SimRand() % FTL_SECTOR_PER_BLOCK;
+        random_fill(&s_ucPend[sector * FTL_SECTOR_SIZE], FTL_SECTOR_SIZE);
+        ret = FTL_Write(&s_ucPend[sector * FTL_SECTOR_SIZE], i * FTL_SECTOR_PER_BLOCK + sector, 1);
+        if (ret == 0)
+        {
+            ret = FTL_Sync();
+        }
+    }
+    else
+    {
+        random_fill(s_ucPend, FTL_BLOCK_SIZE);
+        ret = FTL_WriteBlock(i, s_ucPend);
+    }
+    CHECK(ret == 0);
+
+    /* 返回时日志已写入Flash，没有进行中的编程 */
+    CHECK(QSPI_SimBusy() == 0);
+    memcpy(s_ucModel[i], s_ucPend, FTL_BLOCK_SIZE);
+    s_iPendBlock = -1;
+}
+
+/* 读写、裁剪、扇区写缓存 */
+static void test_basic(void)
+{
+    FTL_STAT_T stat;
+    static uint8_t sec[FTL_SECTOR_SIZE * 3];
+
+    bsp_InitFTL();
+    CHECK(FTL_Format() == 0);
+    model_reset();
+    model_verify();
+
+    random_fill(s_ucModel[0], FTL_BLOCK_SIZE);
+    CHECK(FTL_WriteBlock(0, s_ucModel[0]) == 0);
+    CHECK(FTL_WriteBlock(BLOCK_NUM, s_ucModel[0]) == 0);
+    CHECK(FTL_WriteBlock(FTL_BLOCK_NUM, s_ucModel[0]) == -1);
+
+    /* 跨块的扇区写入先合并到缓存，读取时返回缓存中的数据 */
+    random_fill(sec, sizeof(sec));
+    CHECK(FTL_Write(sec, 2 * FTL_SECTOR_PER_BLOCK - 1, 3) == 0);
+    memcpy(&s_ucModel[1][FTL_BLOCK_SIZE - FTL_SECTOR_SIZE], sec, FTL_SECTOR_SIZE);
+    memcpy(s_ucModel[2], &sec[FTL_SECTOR_SIZE], 2 * FTL_SECTOR_SIZE);
+    model_verify();
+    CHECK(FTL_Sync() == 0);
+
+    CHECK(FTL_Trim(BLOCK_NUM) == 0);
+    CHECK(FTL_ReadBlock(BLOCK_NUM, s_ucBuf) == 0 && s_ucBuf[0] == 0xFF && s_ucBuf[FTL_BLOCK_SIZE - 1] == 0xFF);
+
+    FTL_GetStat(&stat);
+    CHECK(stat.blocks == FTL_BLOCK_NUM && stat.used == 3 && stat.bad == 0);
+
+    /* 上电后内容不变 */
+    bsp_InitFTL();
+    model_verify();
+
+    printf("basic ok, %u blocks\n", FTL_BLOCK_NUM);
+}
+
+/* 写满日志区触发检查点，上电后映射不变 */
+static void test_journal(void)
+{
+    FTL_STAT_T stat;
+    uint32_t seq;
+
+    FTL_GetStat(&stat);
+    seq = stat.ckpt_seq;
+    for (int n = 0; n < 5000; n++)
+    {
+        random_op();
+    }
+    model_verify();
+
+    FTL_GetStat(&stat);
+    CHECK(stat.ckpt_seq > seq);
+    CHECK(stat.used <= BLOCK_NUM);
+
+    bsp_InitFTL();
+    model_verify();
+
+    printf("journal ok, checkpoint %u, journal %u, erase %u - %u\n", stat.ckpt_seq, stat.journal,
+           stat.erase_min, stat.erase_max);
+}
+
+/* 上电初始化，恢复过程中也可能再次掉电 */
+static void power_on(void)
+{
+    while (1)
+    {
+        QSPI_SimCutAfter((QSPI_SimRand() % 4 == 0) ? 1 + QSPI_SimRand() % 16 : 0);
+        if (setjmp(g_SimPowerLoss) == 0)
+        {
+            bsp_InitFTL();
+            QSPI_SimCutAfter(0);
+            return;
+        }
+    }
+}
+
+/* 随机掉电 */
+static void test_powercut(uint32_t _uiCuts)
+{
+    QSPI_SIM_STAT_T st;
+    FTL_STAT_T stat;
+    int i;
+
+    CHECK(FTL_Format() == 0);
+    model_reset();
+
+    for (uint32_t n = 0; n < _uiCuts; n++)
+    {
+        QSPI_SimCutAfter(1 + QSPI_SimRand() % 300);
+        if (setjmp(g_SimPowerLoss) == 0)
+        {
+            for (;;)
+            {
+                random_op();
+            }
+        }
+        power_on();
+        model_verify();
+
+        /* 返回成功后立即掉电，新数据不丢失 */
+        if (QSPI_SimRand() % 4 == 0)
+        {
+            i = QSPI_SimRand() % BLOCK_NUM;
+            random_fill(s_ucModel[i], FTL_BLOCK_SIZE);
+            CHECK(FTL_WriteBlock(i, s_ucModel[i]) == 0);
+            QSPI_SimPowerOff();
+            power_on();
+            model_verify();
+        }
+    }
+
+    QSPI_SimGetStat(&st);
+    FTL_GetStat(&stat);
+    printf("powercut ok, %u cuts, %u programs, %u erases, checkpoint %u\n", st.cuts, st.programs, st.erases,
+           stat.ckpt_seq);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t cuts = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+
+    s_uiSeed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+
+    remove(IMAGE);
+    CHECK(QSPI_SimOpen(IMAGE, s_uiSeed) == 0);
+    test_basic();
+    test_journal();
+    test_powercut(cuts);
+    QSPI_SimClose();
+    remove(IMAGE);
+
+    return 0;
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
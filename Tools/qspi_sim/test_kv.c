@@ -0,0 +1,351 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : KV参数存储模块测试
+*    文件名称 : test_kv.c
+*    版    本 : V1.0
+*    说    明 : 在PC上用 qspi_sim 测试 bsp_qspi_kv.c: 读写删除、垃圾回收、空间满，以及随机掉电后的恢复。
+*               掉电测试中，掉电时正在写入的键可以是旧值或新值，其它键必须不变；返回成功的写入掉电后不丢失。
+*               ./test_kv [掉电次数] [随机数种子]
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_qspi.h"
+#include "bsp_qspi_kv.h"
+#include "qspi_sim.h"
+
+#define IMAGE "test_kv.bin"
+#define KEY_NUM 64
+
+#define CHECK(x)                                                              \
+    do                                                                        \
+    {                                                                         \
+        if (!(x))                                                             \
+        {                                                                     \
+            printf("%s:%d: CHECK(%s) failed, seed %u\n", __FILE__, __LINE__, \
+                   #x, s_uiSeed);                                             \
+            exit(1);                                                          \
+        }                                                                     \
+    } while (0)
+
+/* 期望的内容，len < 0 表示不存在 */
+typedef struct
+{
+    int len;
+    uint8_t val[KV_VALUE_MAX];
+} MODEL_T;
+
+static MODEL_T s_tModel[KEY_NUM];
+static MODEL_T s_tPend; /* 掉电时正在写入的值 */
+static int s_iPendKey = -1;
+static uint32_t s_uiSeed = 1;
+static uint8_t s_ucBuf[KV_VALUE_MAX];
+
+static const char *key_name(int _i)
+{
+    static char name[16];
+
+    snprintf(name, sizeof(name), "key.%02d", _i);
+    return name;
+}
+
+static void model_reset(void)
+{
+    for (int i = 0; i < KEY_NUM; i++)
+    {
+        s_tModel[i].len = -1;
+    }
+}
+
+static int foreach_count(const char *_key, uint16_t _usLen, void *_pArg)
+{
+    (*(int *)_pArg)++;
+    return 0;
+}
+
+/* 比较一个键与期望值 */
+static int model_match(int _i, const MODEL_T *_pM)
+{
+    int len = KV_Get(key_name(_i), s_ucBuf, sizeof(s_ucBuf));
+
+    if (len != _pM->len)
+    {
+        return 0;
+    }
+    return len <= 0 || memcmp(s_ucBuf, _pM->val, len) == 0;
+}
+
+/* 检查所有键与模型一致，掉电时正在写入的键可以是旧值或新值 */
+static void model_verify(void)
+{
+    int num = 0, keys = 0;
+
+    for (int i = 0; i < KEY_NUM; i++)
+    {
+        if (i == s_iPendKey && !model_match(i, &s_tModel[i]))
+        {
+            CHECK(model_match(i, &s_tPend));
+            s_tModel[i] = s_tPend;
+        }
+        CHECK(model_match(i, &s_tModel[i]));
+        keys += (s_tModel[i].len >= 0);
+    }
+    s_iPendKey = -1;
+
+    KV_Foreach(foreach_count, &num);
+    CHECK(num == keys);
+}
+
+/* 随机写入或删除一个键，成功后更新模型 */
+static void random_op(uint16_t _usMaxLen)
+{
+    int i = QSPI_SimRand() % KEY_NUM;
+
+    s_tPend = s_tModel[i];
+    if (QSPI_SimRand() % 5 == 0)
+    {
+        s_tPend.len = -1;
+        s_iPendKey = i;
+        if (KV_Delete(key_name(i)) == 0)
+        {
+            s_tModel[i].len = -1;
+        }
+        else
+        {
+            CHECK(s_tModel[i].len < 0);
+        }
+    }
+    else
+    {
+        s_tPend.len = QSPI_SimRand() % (_usMaxLen + 1);
+        for (int j = 0; j < s_tPend.len; j++)
+        {
+            s_tPend.val[j] = QSPI_SimRand();
+        }
+        s_iPendKey = i;
+        if (KV_Set(key_name(i), s_tPend.val, s_tPend.len) == 0)
+        {
+            s_tModel[i] = s_tPend;
+        }
+    }
+    s_iPendKey = -1;
+}
+
+/* 读写、删除、计数器 */
+static void test_basic(void)
+{
+    QSPI_SIM_STAT_T st0, st1;
+    KV_STAT_T stat;
+    char key[KV_KEY_MAX + 2];
+    char lkey[256 + 2];
+
+    bsp_InitKV();
+    CHECK(KV_Format() == 0);
+
+    CHECK(KV_Get("none", s_ucBuf, sizeof(s_ucBuf)) == -1);
+    CHECK(KV_Set("name", "STM32H743", 9) == 0);
+    CHECK(KV_Get("name", s_ucBuf, sizeof(s_ucBuf)) == 9 && memcmp(s_ucBuf, "STM32H743", 9) == 0);
+    CHECK(KV_Get("name", NULL, 0) == 9);
+
+    /* 缓冲区不足时截断，返回实际长度 */
+    memset(s_ucBuf, 0, sizeof(s_ucBuf));
+    CHECK(KV_Get("name", s_ucBuf, 5) == 9 && memcmp(s_ucBuf, "STM32\0", 6) == 0);
+
+    CHECK(KV_Set("name", "H7", 2) == 0);
+    CHECK(KV_Get("name", s_ucBuf, sizeof(s_ucBuf)) == 2 && memcmp(s_ucBuf, "H7", 2) == 0);
+
+    /* 值不变时不写Flash */
+    QSPI_SimGetStat(&st0);
+    CHECK(KV_Set("name", "H7", 2) == 0);
+    QSPI_SimGetStat(&st1);
+    CHECK(st1.programs == st0.programs);
+
+    CHECK(KV_Set("empty", NULL, 0) == 0);
+    CHECK(KV_Get("empty", s_ucBuf, sizeof(s_ucBuf)) == 0);
+
+    CHECK(KV_Delete("name") == 0);
+    CHECK(KV_Get("name", s_ucBuf, sizeof(s_ucBuf)) == -1);
+    CHECK(KV_Delete("name") == -1);
+
+    CHECK(KV_GetU32("boot", 7) == 7);
+    CHECK(KV_AddU32("boot", 1) == 1);
+    CHECK(KV_AddU32("boot", 10) == 11);
+    CHECK(KV_SetU32("boot", 100) == 0 && KV_GetU32("boot", 0) == 100);
+
+    /* 键名长度 1 - KV_KEY_MAX，键值长度不超过 KV_VALUE_MAX */
+    memset(key, 'k', sizeof(key));
+    key[KV_KEY_MAX] = '\0';
+    CHECK(KV_Set(key, "x", 1) == 0);
+    key[KV_KEY_MAX] = 'k';
+    key[KV_KEY_MAX + 1] = '\0';
+    CHECK(KV_Set(key, "x", 1) == -1);
+    CHECK(KV_Set("", "x", 1) == -1);
+    CHECK(KV_Set("big", s_ucBuf, KV_VALUE_MAX) == 0);
+    CHECK(KV_Set("big", s_ucBuf, KV_VALUE_MAX + 1) == -1);
+
+    /* 257字节的键名按8位截断后是1，不能当作键 "k" */
+    memset(lkey, 'k', sizeof(lkey) - 1);
+    lkey[sizeof(lkey) - 1] = '\0';
+    CHECK(KV_Set("k", "y", 1) == 0);
+    CHECK(KV_Set(lkey, "x", 1) == -1);
+    CHECK(KV_Get(lkey, s_ucBuf, sizeof(s_ucBuf)) == -1);
+    CHECK(KV_Delete(lkey) == -1);
+    CHECK(KV_Get("k", s_ucBuf, sizeof(s_ucBuf)) == 1 && s_ucBuf[0] == 'y');
+    CHECK(KV_Delete("k") == 0);
+
+    /* 上电后内容不变 */
+    bsp_InitKV();
+    CHECK(KV_Get("name", s_ucBuf, sizeof(s_ucBuf)) == -1);
+    CHECK(KV_Get("empty", s_ucBuf, sizeof(s_ucBuf)) == 0);
+    CHECK(KV_GetU32("boot", 0) == 100);
+    key[KV_KEY_MAX] = '\0';
+    CHECK(KV_Get(key, s_ucBuf, sizeof(s_ucBuf)) == 1 && s_ucBuf[0] == 'x');
+    KV_GetStat(&stat);
+    CHECK(stat.keys == 4);
+
+    printf("basic ok\n");
+}
+
+/* 反复改写触发垃圾回收，扇区轮转，磨损均匀 */
+static void test_compact(void)
+{
+    KV_STAT_T stat;
+
+    CHECK(KV_Format() == 0);
+    model_reset();
+    for (int n = 0; n < 20000; n++)
+    {
+        random_op(256);
+    }
+    model_verify();
+
+    KV_GetStat(&stat);
+    CHECK(stat.gc_count > 0);
+    CHECK(stat.erase_max - stat.erase_min <= 2);
+
+    /* 手动回收后有效数据不变，空闲扇区增加 */
+    KV_Collect();
+    KV_GetStat(&stat);
+    CHECK(stat.used - stat.live < KV_SECTOR_SIZE);
+    model_verify();
+
+    bsp_InitKV();
+    model_verify();
+
+    printf("compact ok, gc %u, erase %u - %u\n", stat.gc_count, stat.erase_min, stat.erase_max);
+}
+
+/* 写满后失败，原有数据不受影响，删除后可以继续写入 */
+static void test_full(void)
+{
+    int n;
+
+    CHECK(KV_Format() == 0);
+    model_reset();
+    memset(s_ucBuf, 0x5A, sizeof(s_ucBuf));
+    for (n = 0; n < KEY_NUM; n++)
+    {
+        if (KV_Set(key_name(n), s_ucBuf, KV_VALUE_MAX) != 0)
+        {
+            break;
+        }
+        s_tModel[n].len = KV_VALUE_MAX;
+        memcpy(s_tModel[n].val, s_ucBuf, KV_VALUE_MAX);
+    }
+    CHECK(n > 0 && n < KEY_NUM);
+    model_verify();
+
+    CHECK(KV_Delete(key_name(0)) == 0);
+    s_tModel[0].len = -1;
+    CHECK(KV_Set(key_name(n), s_ucBuf, KV_VALUE_MAX) == 0);
+    s_tModel[n].len = KV_VALUE_MAX;
+    memcpy(s_tModel[n].val, s_ucBuf, KV_VALUE_MAX);
+
+    bsp_InitKV();
+    model_verify();
+
+    printf("full ok, %d keys of %d bytes\n", n, KV_VALUE_MAX);
+}
+
+/* 上电初始化，恢复过程中也可能再次掉电 */
+static void power_on(void)
+{
+    while (1)
+    {
+        QSPI_SimCutAfter((QSPI_SimRand() % 4 == 0) ? 1 + QSPI_SimRand() % 4 : 0);
+        if (setjmp(g_SimPowerLoss) == 0)
+        {
+            bsp_InitKV();
+            QSPI_SimCutAfter(0);
+            return;
+        }
+    }
+}
+
+/* 随机掉电 */
+static void test_powercut(uint32_t _uiCuts)
+{
+    QSPI_SIM_STAT_T st;
+    KV_STAT_T stat;
+    int i;
+
+    CHECK(KV_Format() == 0);
+    model_reset();
+
+    for (uint32_t n = 0; n < _uiCuts; n++)
+    {
+        QSPI_SimCutAfter(1 + QSPI_SimRand() % 200);
+        if (setjmp(g_SimPowerLoss) == 0)
+        {
+            for (;;)
+            {
+                random_op(1024);
+            }
+        }
+        power_on();
+        model_verify();
+
+        /* 返回成功后立即掉电，新值不丢失 */
+        if (QSPI_SimRand() % 4 == 0)
+        {
+            i = QSPI_SimRand() % KEY_NUM;
+            s_tModel[i].len = 1 + QSPI_SimRand() % 16;
+            memset(s_tModel[i].val, n, s_tModel[i].len);
+            CHECK(KV_Set(key_name(i), s_tModel[i].val, s_tModel[i].len) == 0);
+            QSPI_SimPowerOff();
+            power_on();
+            model_verify();
+        }
+    }
+
+    QSPI_SimGetStat(&st);
+    KV_GetStat(&stat);
+    printf("powercut ok, %u cuts, %u programs, %u erases, %u keys\n", st.cuts, st.programs, st.erases, stat.keys);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t cuts = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+
+    s_uiSeed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+
+    remove(IMAGE);
+    CHECK(QSPI_SimOpen(IMAGE, s_uiSeed) == 0);
+    test_basic();
+    test_compact();
+    test_full();
+    test_powercut(cuts);
+    QSPI_SimClose();
+    remove(IMAGE);
+
+    return 0;
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
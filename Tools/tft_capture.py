@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+通过串口截取开发板正在显示的画面，保存为PNG (shell 命令 tft capture)
+
+    python tft_capture.py COM3
+    python tft_capture.py COM3 screen.png --scale 2 --baud 115200 --fast 921600
+
+流程:
+    1. 以 shell 波特率发送 "tft capture <scale> <fast>"
+    2. 开发板用DMA2D合成两层后回复 "CAPTURE READY <fast> <w> <h>" 并切换波特率
+    3. 以 fast 波特率接收 16字节头部 + RLE压缩的RGB565像素 + 8字节尾部(字节数、CRC32)
+    4. 切回 shell 波特率，等待 "CAPTURE OK"
+
+数据格式与 bsp_tft_capture.h 一致。依赖: pip install pyserial
+"""
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+CAP_MAGIC = 0x30504143  # "CAP0"
+HEAD_SIZE = 16
+TAIL_SIZE = 8
+
+
+def wait_line(port, prefix, timeout):
+    """读取串口直到出现以 prefix 开头的行"""
+    end = time.time() + timeout
+    buf = b""
+    while time.time() < end:
+        buf += port.read(port.in_waiting or 1)
+        while b"\n" in buf:
+            line, buf = buf.split(b"\n", 1)
+            text = line.decode("ascii", "replace").strip()
+            if text.startswith(prefix):
+                return text
+    raise TimeoutError("waiting for '%s' timeout" % prefix)
+
+
+class Reader:
+    """按字节数读取串口，超时抛出异常"""
+
+    def __init__(self, port, timeout):
+        self.port = port
+        self.timeout = timeout
+
+    def read(self, n):
+        end = time.time() + self.timeout
+        data = b""
+        while len(data) < n:
+            chunk = self.port.read(n - len(data))
+            if chunk:
+                data += chunk
+                end = time.time() + self.timeout
+            elif time.time() > end:
+                raise TimeoutError("received %d/%d bytes" % (len(data), n))
+        return data
+
+    def find_head(self):
+        """跳过切换波特率期间的乱码，找到头部"""
+        magic = struct.pack("<I", CAP_MAGIC)
+        buf = b""
+        while not buf.endswith(magic):
+            buf = (buf + self.read(1))[-4:]
+        return magic + self.read(HEAD_SIZE - 4)
+
+
+def decode_rle(reader, count):
+    """读取并解压 count 个像素，返回 (像素列表, 压缩数据)"""
+    pixels = []
+    raw = bytearray()
+    while len(pixels) < count:
+        head = reader.read(1)
+        raw += head
+        n = (head[0] & 0x7F) + 1
+        if head[0] & 0x80:
+            data = reader.read(2)
+            pixels.extend(struct.unpack("<H", data) * n)
+        else:
+            data = reader.read(2 * n)
+            pixels.extend(struct.unpack("<%dH" % n, data))
+        raw += data
+    if len(pixels) != count:
+        raise ValueError("pixel count mismatch %d/%d" % (len(pixels), count))
+    return pixels, bytes(raw)
+
+
+def write_png(path, width, height, pixels):
+    """RGB565 转为 RGB888 保存为PNG，不依赖图像库"""
+    rows = bytearray()
+    for y in range(height):
+        rows.append(0)  # 无滤波
+        for p in pixels[y * width:(y + 1) * width]:
+            r, g, b = (p >> 11) & 0x1F, (p >> 5) & 0x3F, p & 0x1F
+            rows += bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+
+    def chunk(tag, data):
+        body = tag + data
+        return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body) & 0xFFFFFFFF)
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(bytes(rows), 9)))
+        f.write(chunk(b"IEND", b""))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="capture LCD screen over COM1")
+    ap.add_argument("port")
+    ap.add_argument("output", nargs="?", default="capture.png")
+    ap.add_argument("--scale", type=int, default=1, choices=range(1, 9), help="downscale factor")
+    ap.add_argument("--baud", type=int, default=115200, help="shell baud rate")
+    ap.add_argument("--fast", type=int, default=921600, help="transfer baud rate")
+    args = ap.parse_args()
+
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    port.reset_input_buffer()
+    port.write(b"tft capture %d %d\r\n" % (args.scale, args.fast))
+    line = wait_line(port, "CAPTURE ", 10)
+    print(line)
+    if not line.startswith("CAPTURE READY"):
+        sys.exit(1)
+
+    start = time.time()
+    if args.fast != args.baud:
+        port.baudrate = args.fast
+    reader = Reader(port, 2)
+    try:
+        magic, width, height, fmt, scale, panel_w, panel_h, _ = struct.unpack("<IHHBBHHH", reader.find_head())
+        if fmt != 2:
+            raise ValueError("unsupported format %d" % fmt)
+        pixels, raw = decode_rle(reader, width * height)
+        size, crc = struct.unpack("<II", reader.read(TAIL_SIZE))
+    finally:
+        time.sleep(0.05)
+        port.baudrate = args.baud
+    elapsed = time.time() - start
+
+    if size != len(raw) or crc != zlib.crc32(raw) & 0xFFFFFFFF:
+        sys.exit("crc error: %d bytes 0x%08X, expected %d bytes 0x%08X" % (len(raw), zlib.crc32(raw) & 0xFFFFFFFF,
+                                                                          size, crc))
+    print(wait_line(port, "CAPTURE ", 5))
+
+    write_png(args.output, width, height, pixels)
+    print("%s %dx%d (panel %dx%d, 1/%d), %d bytes, %.1f s" % (args.output, width, height, panel_w, panel_h, scale,
+                                                              HEAD_SIZE + size + TAIL_SIZE, elapsed))
+
+
+if __name__ == "__main__":
+    main()
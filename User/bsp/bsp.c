@@ -79,7 +79,15 @@ void System_Init(void)
 void bsp_Init(void)
 {
     bsp_InitExtSDRAM();       /* 初始化SDRAM */
+    bsp_InitMem();            /* 初始化DTCM、AXI SRAM、SDRAM内存堆 */
+    bsp_InitPool();           /* 初始化DMA缓冲区内存池 */
     bsp_InitQspi();           /* 初始化QSPI */
+    bsp_InitQspiCache();      /* 初始化QSPI Flash读缓存 */
+    bsp_InitKV();             /* 初始化QSPI Flash KV参数区 */
+    SDRAM_LoadTiming();       /* 加载 sdram tune 保存的SDRAM时序 */
+    bsp_InitOTA();            /* 检查固件升级状态，试运行失败时回滚 */
+    bsp_InitFTL();            /* 初始化QSPI Flash块设备 */
+    bsp_InitAsset();          /* 检查QSPI Flash资源包 */
     init_cycle_counter(TRUE); /* 初始化perf_counter库 定时器已经初始化 */
     bsp_InitKey();            /* 按键初始化，要放在滴答定时器之前，因为按钮检测是通过滴答定时器扫描 */
     bsp_Init_dma();           /* 初始化DMA */
@@ -89,6 +97,9 @@ void bsp_Init(void)
     bsp_InitLed();            /* 初始化LED */
     BEEP_InitHard();          /* 初始化beep */
     userInitMultiTime();      /* 初始化MultiTime */
+    bsp_InitGfx();            /* 初始化DMA2D图形加速 */
+    bsp_InitJpeg();           /* 初始化硬件JPEG解码 */
+    TFT_LoadPanel();          /* 加载 tft panel 保存的面板型号 */
     bsp_InitTFT();            /* 初始化LCD */
 }
 
@@ -287,7 +298,7 @@ static void MPU_Config(void)
 
     /* 配置FMC扩展IO的MPU属性为Device或者Strongly Ordered */
     MPU_InitStruct.Enable = MPU_REGION_ENABLE;
-    MPU_InitStruct.BaseAddress = 0x60000000;
+    MPU_InitStruct.BaseAddress = FMC_NOR_ADDR;
     MPU_InitStruct.Size = ARM_MPU_REGION_SIZE_64KB;
     MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
     MPU_InitStruct.IsBufferable = MPU_ACCESS_BUFFERABLE;
@@ -300,6 +311,36 @@ static void MPU_Config(void)
 
     HAL_MPU_ConfigRegion(&MPU_InitStruct);
 
+    /* 配置SDRAM的MPU属性为Write back, Read allocate，Write allocate，默认属性为Device，不能Cache和非对齐访问 */
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.BaseAddress = EXT_SDRAM_ADDR;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_32MB;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_BUFFERABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.Number = SDRAM_MPU_REGION;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_ENABLE;
+
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    /* 配置LCD显存的MPU属性为Write through，No write allocate，CPU写入直接到达SDRAM，LTDC总能读到最新数据 */
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.BaseAddress = SDRAM_LCD_BUF1;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_4MB; /* SDRAM_LCD_SIZE * SDRAM_LCD_LAYER */
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.Number = SDRAM_LCD_MPU_REGION;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL0;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
     /*使能 MPU */
     HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
 }
@@ -360,6 +401,10 @@ void bsp_RunPer1ms(void)
 void bsp_Idle(void)
 {
     /* --- 喂狗 */
+    OTA_Poll();
+
+    /* --- 统计主循环时间，刷新性能叠加层 */
+    HUD_Idle();
 
     /* --- 让CPU进入休眠，由Systick定时中断唤醒或者其他中断唤醒 */
 
@@ -416,10 +461,96 @@ uint32_t HAL_GetTick(void)
 /**
  * @brief This function handles System tick timer.
  */
-void SysTick_Handler(void)
+RAM_FUNC void SysTick_Handler(void)
 {
     HAL_IncTick();
 }
 #endif
 
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/*
+    中断响应时间测试: 两个未使用的外设中断，CEC中断函数在Flash，SWPMI1中断函数在ITCM。
+    置位中断挂起到进入中断函数的周期数，包含压栈和取中断函数的指令。
+    perf_counter 的计时函数在Flash中，取指时间会计入测量结果，这里直接读DWT周期计数器。
+*/
+#define TCM_BENCH_NUM 64
+
+static volatile uint32_t s_uiIsrCycle;
+
+void CEC_IRQHandler(void)
+{
+    s_uiIsrCycle = DWT->CYCCNT;
+}
+
+RAM_FUNC void SWPMI1_IRQHandler(void)
+{
+    s_uiIsrCycle = DWT->CYCCNT;
+}
+
+/* 测量_num次，_cold为1时每次先作废I-Cache，模拟中断函数不在Cache中的情况 */
+static void tcm_latency(const char *_name, IRQn_Type _irq, uint8_t _cold)
+{
+    uint32_t i, t, min = 0xFFFFFFFF, max = 0, sum = 0;
+
+    HAL_NVIC_SetPriority(_irq, 0, 0);
+    HAL_NVIC_EnableIRQ(_irq);
+
+    for (i = 0; i < TCM_BENCH_NUM; i++)
+    {
+        if (_cold)
+        {
+            SCB_InvalidateICache();
+        }
+        s_uiIsrCycle = 0;
+        t = DWT->CYCCNT;
+        NVIC_SetPendingIRQ(_irq);
+        __DSB();
+        __ISB();
+        t = s_uiIsrCycle - t;
+
+        sum += t;
+        min = (t < min) ? t : min;
+        max = (t > max) ? t : max;
+    }
+
+    HAL_NVIC_DisableIRQ(_irq);
+
+    printf("%-12s: min %4d avg %4d max %4d cycles\r\n", _name, min, sum / TCM_BENCH_NUM, max);
+}
+
+static int cmd_tcm(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "tcm bench"};
+
+    if (argc > 1 && !strcmp(argv[1], "bench"))
+    {
+        /* 使能DWT周期计数器 */
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->LAR = 0xC5ACCE55;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        tcm_latency("flash", CEC_IRQn, 0);
+        tcm_latency("flash cold", CEC_IRQn, 1);
+        tcm_latency("itcm", SWPMI1_IRQn, 0);
+        tcm_latency("itcm cold", SWPMI1_IRQn, 1);
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), tcm, cmd_tcm, tcm[bench]);
+#endif // #ifdef DEBUG_MODE
+
 /***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
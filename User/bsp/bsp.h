@@ -58,6 +58,18 @@
 #define ENABLE_INT() __set_PRIMASK(0)  /* 使能全局中断 */
 #define DISABLE_INT() __set_PRIMASK(1) /* 禁止全局中断 */
 
+/*
+    ITCM/DTCM 放置，分散加载文件 sct_example.sct 中的 ER_ITCM / RW_DTCM 执行域收集对应的段，
+    由 __main 在进入main之前从Flash复制和清0。
+    RAM_FUNC  : 函数复制到ITCM执行，0等待，不受I-Cache命中率影响，用于中断和频繁调用的函数
+    FAST_DATA : 有初值的变量放到DTCM
+    FAST_BSS  : 初值为0的变量放到DTCM
+    DTCM只有CPU和MDMA能访问，DMA1/DMA2/DMA2D使用的缓冲区不能放到DTCM。
+*/
+#define RAM_FUNC __attribute__((section(".itcm_text"), noinline))
+#define FAST_DATA __attribute__((section(".dtcm_data")))
+#define FAST_BSS __attribute__((section(".bss.dtcm")))
+
 typedef enum
 {
     BSP_ERR_NULL = 0,
@@ -162,6 +174,8 @@ typedef enum
 
 /* 通过取消注释或者添加注释的方式控制是否包含底层驱动模块 */
 #include "bsp_dma.h"
+#include "bsp_mem.h"
+#include "bsp_pool.h"
 // #include "bsp_msg.h"
 #include "bsp_user_lib.h"
 // #include "bsp_timer.h"
@@ -187,6 +201,12 @@ typedef enum
 // #include "bsp_spi_vs1053b.h"
 
 #include "bsp_qspi.h"
+#include "bsp_qspi_sfdp.h"
+#include "bsp_qspi_cache.h"
+#include "bsp_qspi_kv.h"
+#include "bsp_qspi_ftl.h"
+#include "bsp_ota.h"
+#include "bsp_asset.h"
 
 // #include "bsp_fmc_sdram.h"
 // #include "bsp_fmc_nand_flash.h"
@@ -203,7 +223,13 @@ typedef enum
 // #include "bsp_i2c_si4730.h"
 // #include "bsp_i2c_wm8978.h"
 
+#include "bsp_gfx.h"
+#include "bsp_gfx_draw.h"
+#include "bsp_jpeg.h"
+#include "bsp_font.h"
+#include "bsp_hud.h"
 #include "bsp_tft_h7.h"
+#include "bsp_tft_capture.h"
 // #include "bsp_tft_429.h"
 // #include "bsp_tft_lcd.h"
 // #include "bsp_ts_touch.h"
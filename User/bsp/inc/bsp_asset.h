@@ -0,0 +1,61 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash资源包模块
+*    文件名称 : bsp_asset.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_ASSET_H
+#define _BSP_ASSET_H
+
+#include <stdint.h>
+
+/* 资源包占用QSPI Flash 0 - 16MB，由 Tools/asset_pack.py 生成后烧录到该地址 */
+#define ASSET_FLASH_ADDR 0x00000000UL
+#define ASSET_FLASH_SIZE (16 * 1024 * 1024)
+
+#define ASSET_MAGIC 0x304B5041UL     /* "APK0" */
+#define ASSET_VERSION 1
+#define ASSET_NAME_MAX 32            /* 资源名最大长度，含结束符 */
+#define ASSET_ALIGN 4096             /* 资源数据按4KB对齐 */
+#define ASSET_BLOCK_SIZE (16 * 1024) /* LZ4分块大小，每块独立压缩，与 asset_pack.py 一致 */
+#define ASSET_BLOCK_MAX 512          /* 单个资源最多分块数，即最大8MB */
+
+/* 存储方式 */
+#define ASSET_METHOD_RAW 0 /* 不压缩 */
+#define ASSET_METHOD_LZ4 1 /* LZ4分块压缩 */
+
+/* 图片的像素格式 param[2]，0-7 与LTDC像素格式相同 */
+#define ASSET_FMT_JPEG 0x100 /* 保持JPEG格式，由 bsp_jpeg.c 硬件解码 */
+
+/* 资源信息，与Flash中的索引项格式相同，64字节 */
+typedef struct
+{
+    char name[ASSET_NAME_MAX]; /* 资源名 */
+    uint32_t offset;           /* 数据相对资源包起始的偏移，4KB对齐 */
+    uint32_t csize;            /* Flash中占用的字节数，LZ4方式含分块表 */
+    uint32_t size;             /* 解压后的字节数 */
+    uint32_t crc;              /* 解压后数据的CRC32 */
+    uint8_t method;            /* ASSET_METHOD_RAW / ASSET_METHOD_LZ4 */
+    uint8_t reserved[3];
+    uint32_t param[3];         /* 附加参数，图片为 宽、高、像素格式 */
+} ASSET_T;
+
+void bsp_InitAsset(void);
+uint32_t Asset_Count(void);
+int Asset_Open(const char *_pName, ASSET_T *_pAsset);
+int Asset_OpenIndex(uint32_t _uiIndex, ASSET_T *_pAsset);
+int Asset_Load(const ASSET_T *_pAsset, void *_pDst, uint32_t _uiSize);
+int Asset_Verify(const ASSET_T *_pAsset, const void *_pData);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
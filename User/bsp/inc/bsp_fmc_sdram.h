@@ -18,7 +18,19 @@
 #ifndef _BSP_FMC_SDRAM_H
 #define _BSP_FMC_SDRAM_H
 
+/*
+    FMC_SDRAM_BANK_SWAP = 1 时交换NOR/PSRAM和SDRAM Bank1的地址(FMC_BCR1.BMAP = 01)，
+    SDRAM映射到0x60000000，扩展IO(74HC574)随之移到0xC0000000。
+*/
+#define FMC_SDRAM_BANK_SWAP 0
+
+#if FMC_SDRAM_BANK_SWAP
+#define EXT_SDRAM_ADDR ((uint32_t)0x60000000)
+#define FMC_NOR_ADDR ((uint32_t)0xC0000000) /* NOR/PSRAM Bank1，扩展IO使用 */
+#else
 #define EXT_SDRAM_ADDR ((uint32_t)0xC0000000)
+#define FMC_NOR_ADDR ((uint32_t)0x60000000) /* NOR/PSRAM Bank1，扩展IO使用 */
+#endif
 #define EXT_SDRAM_SIZE ((uint32_t)(32 * 1024 * 1024))
 
 /* LCD显存,第1页, 分配2M字节 */
@@ -30,11 +42,65 @@
 #define SDRAM_LCD_SIZE (2 * 1024 * 1024) /* 每层2M */
 #define SDRAM_LCD_LAYER 2                /* 2层 */
 
-/* 剩下的12M字节，提供给应用程序使用 */
+/* QSPI Flash读缓存，位于SDRAM末尾，分配1M字节 */
+#define SDRAM_QSPI_CACHE_SIZE (1 * 1024 * 1024)
+#define SDRAM_QSPI_CACHE_BUF (EXT_SDRAM_ADDR + EXT_SDRAM_SIZE - SDRAM_QSPI_CACHE_SIZE)
+
+/* 剩下的字节，提供给应用程序使用 */
 #define SDRAM_APP_BUF (EXT_SDRAM_ADDR + SDRAM_LCD_SIZE * SDRAM_LCD_LAYER)
-#define SDRAM_APP_SIZE (EXT_SDRAM_SIZE - SDRAM_LCD_SIZE * SDRAM_LCD_LAYER)
+#define SDRAM_APP_SIZE (EXT_SDRAM_SIZE - SDRAM_LCD_SIZE * SDRAM_LCD_LAYER - SDRAM_QSPI_CACHE_SIZE)
+
+/*
+    SDRAM的MPU区域，在 bsp.c 的 MPU_Config 中配置，编号大的区域优先：
+    整个SDRAM为Write back, Read allocate, Write allocate；LCD显存为Write through，LTDC/DMA2D读取无需清Cache
+*/
+#define SDRAM_MPU_REGION MPU_REGION_NUMBER2
+#define SDRAM_LCD_MPU_REGION MPU_REGION_NUMBER3
+
+/* bsp_TestSDRAM 的测试项，可以组合 */
+#define SDRAM_TEST_DATA_BUS 0x01 /* 数据线走1、走0 */
+#define SDRAM_TEST_ADDR_BUS 0x02 /* 地址线固定为高、固定为低、短路 */
+#define SDRAM_TEST_BYTE 0x04     /* 字节、半字访问，验证NBL0-NBL3 */
+#define SDRAM_TEST_CHECKER 0x08  /* 棋盘格，MDMA填充 */
+#define SDRAM_TEST_ADDR 0x10     /* 单元写入自己的地址 */
+#define SDRAM_TEST_MARCH 0x20    /* March C- */
+#define SDRAM_TEST_ALL 0x3F
+
+/* SDRAM测试结果 */
+typedef struct
+{
+    uint32_t err;      /* 错误单元个数 */
+    uint32_t addr;     /* 第一个错误的地址 */
+    uint32_t expect;   /* 第一个错误的期望值 */
+    uint32_t read;     /* 第一个错误读到的值，与期望值异或得到出错的数据位 */
+    uint32_t wr_bytes; /* 写入字节数 */
+    uint32_t wr_us;    /* 写入时间，含写回D-Cache */
+    uint32_t rd_bytes; /* 比较字节数 */
+    uint32_t rd_us;    /* 比较时间 */
+} SDRAM_TEST_T;
+
+/* SDRAM时序参数，trcd及以后的单位为SDRAM时钟周期 */
+typedef struct
+{
+    uint8_t cas;   /* CAS Latency，1-3 */
+    uint8_t rpipe; /* 读管道延迟，0-2个HCLK周期 */
+    uint8_t trcd;  /* 激活到读写 */
+    uint8_t trp;   /* 预充电到其它命令 */
+    uint8_t twr;   /* 写到预充电 */
+    uint8_t trc;   /* 刷新到激活 */
+    uint8_t tras;  /* 最短自刷新周期 */
+    uint8_t txsr;  /* 退出自刷新到激活 */
+    uint8_t tmrd;  /* 加载模式寄存器到激活 */
+} SDRAM_TIMING_T;
+
+#define SDRAM_TUNE_SIZE (256 * 1024) /* 时序验证使用的测试区大小 */
 
 void bsp_InitExtSDRAM(void);
+int SDRAM_SetTiming(const SDRAM_TIMING_T *_pCfg);
+void SDRAM_GetTiming(SDRAM_TIMING_T *_pCfg);
+int SDRAM_SaveTiming(void);
+void SDRAM_LoadTiming(void);
+uint32_t bsp_TestSDRAM(uint32_t _addr, uint32_t _size, uint32_t _items, SDRAM_TEST_T *_res);
 uint32_t bsp_TestExtSDRAM1(void);
 uint32_t bsp_TestExtSDRAM2(void);
 
@@ -0,0 +1,94 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 抗锯齿字库模块
+*    文件名称 : bsp_font.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_FONT_H
+#define _BSP_FONT_H
+
+#include <stdint.h>
+
+#define FONT_MAGIC 0x30544E46UL /* "FNT0" */
+#define FONT_VERSION 1
+
+/* 字形缓存，组相联，每组按最近使用替换。共 FONT_CACHE_SETS * FONT_CACHE_WAYS 个字形 */
+#define FONT_CACHE_SETS 128 /* 组数，2的整数次幂 */
+#define FONT_CACHE_WAYS 4   /* 每组的字形数 */
+
+/* 字库文件头，32字节，与 Tools/font_gen.py 一致 */
+typedef struct
+{
+    uint32_t magic;       /* FONT_MAGIC */
+    uint16_t version;     /* FONT_VERSION */
+    uint8_t bpp;          /* 4 或 8，点阵为A4或A8格式 */
+    uint8_t size;         /* 字号，像素 */
+    int16_t ascent;       /* 基线以上的高度 */
+    int16_t descent;      /* 基线以下的深度 */
+    uint16_t line_height; /* 行高 */
+    uint8_t max_w;        /* 最大字形宽度，决定缓存块大小 */
+    uint8_t max_h;        /* 最大字形高度 */
+    uint32_t num;         /* 字形个数 */
+    uint32_t data;        /* 点阵数据相对文件头的偏移 */
+    uint8_t reserved[8];
+} FONT_HEAD_T;
+
+/* 字形索引，16字节，按编码从小到大排列 */
+typedef struct
+{
+    uint32_t code;   /* Unicode 编码 */
+    uint32_t offset; /* 点阵相对点阵数据的偏移 */
+    uint8_t w;       /* 点阵宽度，A4时每行按偶数个像素存储 */
+    uint8_t h;       /* 点阵高度 */
+    int8_t left;     /* 点阵左边相对画笔位置的偏移 */
+    int8_t top;      /* 点阵上边在基线以上的高度 */
+    uint8_t advance; /* 画笔前进的像素数 */
+    uint8_t reserved[3];
+} FONT_GLYPH_T;
+
+/* 缓存的字形 */
+typedef struct
+{
+    uint32_t code;             /* 0xFFFFFFFF 表示空 */
+    uint32_t stamp;            /* 最近一次使用的序号 */
+    uint16_t fence;            /* 最近一次绘制的DMA2D队列位置，替换前要等它完成 */
+    const FONT_GLYPH_T *glyph; /* 字形索引 */
+    uint8_t *bitmap;           /* 点阵，SDRAM */
+} FONT_SLOT_T;
+
+/* 打开的字库 */
+typedef struct
+{
+    FONT_HEAD_T head;
+    uint32_t addr;               /* 字库在QSPI Flash中的地址 */
+    FONT_GLYPH_T *glyph;         /* 字形索引，加载到SDRAM */
+    FONT_SLOT_T *slot;           /* 缓存 */
+    uint8_t *cache;              /* 缓存的点阵 */
+    uint32_t slot_size;          /* 每个字形占用的缓存字节数 */
+    uint32_t stamp;              /* 使用序号，用于替换最久未用的字形 */
+    const FONT_GLYPH_T *missing; /* 字库中没有的字显示为 '?' */
+    uint32_t hit;                /* 缓存命中次数 */
+    uint32_t miss;               /* 缓存未命中次数，从QSPI Flash读取 */
+} FONT_T;
+
+int FONT_Open(const char *_pName, FONT_T *_pFont);
+void FONT_Close(FONT_T *_pFont);
+void FONT_Flush(FONT_T *_pFont);
+uint32_t FONT_DecodeUtf8(const char **_ppStr);
+const FONT_GLYPH_T *FONT_FindGlyph(const FONT_T *_pFont, uint32_t _code);
+uint8_t FONT_DrawChar(FONT_T *_pFont, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint32_t _code, uint32_t _argb);
+int16_t FONT_DrawString(FONT_T *_pFont, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, const char *_pStr, uint32_t _argb);
+uint16_t FONT_TextWidth(const FONT_T *_pFont, const char *_pStr);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
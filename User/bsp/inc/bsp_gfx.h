@@ -0,0 +1,87 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA2D图形加速模块
+*    文件名称 : bsp_gfx.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_GFX_H
+#define _BSP_GFX_H
+
+#include <stdint.h>
+
+#define GFX_QUEUE_SIZE 32 /* 命令队列长度，2的整数次幂 */
+
+/* 像素格式，数值与DMA2D、LTDC的颜色模式寄存器相同 */
+typedef enum
+{
+    GFX_ARGB8888 = 0,
+    GFX_RGB888,
+    GFX_RGB565,
+    GFX_ARGB1555,
+    GFX_ARGB4444,
+    GFX_L8,   /* 8位索引，需要颜色表 */
+    GFX_AL44, /* 4位透明度 + 4位索引 */
+    GFX_AL88, /* 8位透明度 + 8位索引 */
+    GFX_L4,   /* 4位索引 */
+    GFX_A8,   /* 8位透明度，颜色由参数给出，用于字体、图标蒙版 */
+    GFX_A4,   /* 4位透明度 */
+
+    GFX_FMT_NUM
+} GFX_FMT_E;
+
+/*
+    图像(表面)，可以是LCD显存，也可以是SDRAM、AXI SRAM、QSPI Flash中的图片。
+    DMA2D不能访问DTCM，图像不能放在DTCM中
+*/
+typedef struct
+{
+    uint32_t addr;        /* 第一个像素的地址 */
+    uint16_t width;       /* 宽度，像素 */
+    uint16_t height;      /* 高度，像素 */
+    uint16_t pitch;       /* 每行的像素数，不小于width */
+    uint8_t format;       /* GFX_FMT_E */
+    const uint32_t *clut; /* L8/AL44/AL88/L4的颜色表，ARGB8888格式 */
+    uint16_t clut_num;    /* 颜色表项数，1-256 */
+} GFX_SURFACE_T;
+
+/* JPEG YCbCr 色度抽样方式，数值与DMA2D的CSS字段相同 */
+#define GFX_CSS_444 0
+#define GFX_CSS_422 1
+#define GFX_CSS_420 2
+
+/* ARGB8888颜色 */
+#define GFX_ARGB(a, r, g, b) (((uint32_t)(a) << 24) | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define GFX_RGB(r, g, b) GFX_ARGB(0xFF, r, g, b)
+
+void bsp_InitGfx(void);
+void GFX_InitSurface(GFX_SURFACE_T *_pSurf, uint32_t _addr, uint16_t _usWidth, uint16_t _usHeight, GFX_FMT_E _fmt);
+uint8_t GFX_BitsPerPixel(GFX_FMT_E _fmt);
+uint32_t GFX_ColorFromARGB(GFX_FMT_E _fmt, uint32_t _argb);
+void GFX_FlushCache(const GFX_SURFACE_T *_pSurf, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h);
+
+void GFX_FillRect(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h, uint32_t _argb);
+void GFX_Blit(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+              const GFX_SURFACE_T *_pSrc, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h);
+void GFX_Blend(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+               const GFX_SURFACE_T *_pSrc, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h, uint8_t _alpha);
+int GFX_BlitYCbCr(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint32_t _addr, uint16_t _w, uint16_t _h, uint8_t _css);
+void GFX_BlendMask(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                   const GFX_SURFACE_T *_pMask, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h, uint32_t _argb);
+
+uint8_t GFX_Busy(void);
+void GFX_Wait(void);
+uint16_t GFX_GetFence(void);
+uint8_t GFX_FenceDone(uint16_t _usFence);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
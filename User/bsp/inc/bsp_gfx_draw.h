@@ -0,0 +1,43 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 矢量绘图模块
+*    文件名称 : bsp_gfx_draw.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_GFX_DRAW_H
+#define _BSP_GFX_DRAW_H
+
+#include <stdint.h>
+
+#define DRAW_DMA2D_MIN 64 /* 不短于此像素数的水平线、垂直线交给DMA2D填充，0表示全部由CPU绘制 */
+#define DRAW_EDGE_MAX 64  /* 填充多边形最多的顶点数 */
+
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+} GFX_POINT_T;
+
+void GFX_DrawHLine(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _w, uint32_t _argb);
+void GFX_DrawVLine(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _h, uint32_t _argb);
+void GFX_DrawLine(const GFX_SURFACE_T *_pDst, int16_t _x0, int16_t _y0, int16_t _x1, int16_t _y1, uint32_t _argb);
+void GFX_DrawLineAA(const GFX_SURFACE_T *_pDst, int16_t _x0, int16_t _y0, int16_t _x1, int16_t _y1, uint32_t _argb);
+void GFX_DrawCircle(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint32_t _argb);
+void GFX_FillCircle(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint32_t _argb);
+void GFX_DrawArc(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint16_t _width,
+                 int16_t _start, int16_t _end, uint32_t _argb);
+void GFX_DrawPolygon(const GFX_SURFACE_T *_pDst, const GFX_POINT_T *_pPts, uint16_t _num, uint32_t _argb);
+int GFX_FillPolygon(const GFX_SURFACE_T *_pDst, const GFX_POINT_T *_pPts, uint16_t _num, uint32_t _argb);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
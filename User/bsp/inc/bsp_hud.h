@@ -0,0 +1,49 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 性能叠加层模块
+*    文件名称 : bsp_hud.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_HUD_H
+#define _BSP_HUD_H
+
+#include <stdint.h>
+
+#define HUD_PERIOD 500      /* 统计和刷新周期，ms */
+#define HUD_FONT "hud"      /* 资源包中的字库，font_gen.py --charset ascii 生成 */
+#define HUD_LAYER 1         /* 使用LTDC第2层 */
+#define HUD_WIDTH 320       /* 叠加层窗口宽度，像素 */
+#define HUD_LINES 12        /* 最多显示的行数 */
+#define HUD_COLS 48         /* 每行最多字符数 */
+
+/* 最近一个统计周期的结果 */
+typedef struct
+{
+    uint16_t load;     /* CPU占用率，0.1% */
+    uint32_t loop_hz;  /* 主循环频率 */
+    uint32_t fps;      /* 第1层交换链每秒显示的帧数，0.1帧 */
+    uint32_t vsync;    /* 面板刷新率，0.1Hz */
+    uint32_t underrun; /* 累计FIFO下溢帧数 */
+    uint32_t tx[8];    /* COM1 - COM8 发送字节/秒 */
+    uint32_t rx[8];    /* COM1 - COM8 接收字节/秒 */
+    uint8_t com;       /* 已使能的串口，bit0 为 COM1 */
+} HUD_STAT_T;
+
+int HUD_Show(const char *_pFont);
+void HUD_Hide(void);
+void HUD_Toggle(void);
+void HUD_Idle(void);
+void HUD_GetStat(HUD_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,50 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 硬件JPEG解码模块
+*    文件名称 : bsp_jpeg.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_JPEG_H
+#define _BSP_JPEG_H
+
+#include <stdint.h>
+
+#define JPEG_IN_NUM 2                /* QSPI Flash 输入缓冲个数，一个解码时另一个读取 */
+#define JPEG_IN_SIZE 4096            /* 输入缓冲大小，使用 bsp_pool 的4KB块 */
+#define JPEG_MEM_CHUNK (32 * 1024)   /* 内存数据每次送入的字节数，MDMA块长度上限64KB */
+#define JPEG_OUT_CHUNK (48 * 1024)   /* 每次输出的字节数，是各种MCU块大小(192/256/384)的整数倍 */
+#define JPEG_TIMEOUT 1000            /* 解码超时，ms */
+
+/* 解码结果 */
+typedef struct
+{
+    uint16_t width;      /* 图像宽度 */
+    uint16_t height;     /* 图像高度 */
+    uint8_t css;         /* 色度抽样方式，GFX_CSS_444 / GFX_CSS_422 / GFX_CSS_420 */
+    uint32_t bytes;      /* JPEG数据字节数 */
+    uint32_t decode_us;  /* 读取并解码为YCbCr MCU块的时间 */
+    uint32_t convert_us; /* DMA2D转换为RGB的时间 */
+} JPEG_RESULT_T;
+
+extern JPEG_HandleTypeDef hjpeg;
+
+void bsp_InitJpeg(void);
+int JPEG_DecodeFlash(uint32_t _uiAddr, uint32_t _uiSize, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                     JPEG_RESULT_T *_pResult);
+int JPEG_DecodeAsset(const ASSET_T *_pAsset, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                     JPEG_RESULT_T *_pResult);
+int JPEG_DecodeMem(const uint8_t *_pData, uint32_t _uiSize, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                   JPEG_RESULT_T *_pResult);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,78 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 多内存堆管理模块
+*    文件名称 : bsp_mem.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_MEM_H
+#define _BSP_MEM_H
+
+#include <stdint.h>
+
+/*
+    DTCM 0x20000000 - 0x2001FFFF，前64KB留给链接器放置变量，后64KB作为堆。
+    DTCM只有CPU和MDMA能访问，DMA1/DMA2/DMA2D不能使用。
+*/
+#define MEM_DTCM_ADDR 0x20010000UL
+#define MEM_DTCM_SIZE (64 * 1024)
+
+/* AXI SRAM堆，从C库堆所在的AXI SRAM中静态分配，所有DMA都能访问 */
+#define MEM_AXI_SIZE (64 * 1024)
+
+/* SDRAM堆使用 SDRAM_APP_BUF 整个区域 */
+
+#define MEM_ALIGN 8 /* 分配的最小对齐字节数 */
+
+/* 内存堆编号 */
+typedef enum
+{
+    MEM_DTCM = 0, /* 最快，不能DMA */
+    MEM_AXI,      /* 可DMA，Cache行对齐需用 Mem_AllocAlign */
+    MEM_SDRAM,    /* 大容量 */
+
+    MEM_HEAP_NUM
+} MEM_HEAP_E;
+
+/* 内存堆统计信息 */
+typedef struct
+{
+    uint32_t total;    /* 可分配的总字节数 */
+    uint32_t used;     /* 已分配字节数，含块头 */
+    uint32_t peak;     /* 已分配字节数的峰值 */
+    uint32_t free;     /* 空闲字节数 */
+    uint32_t max_free; /* 最大空闲块，决定一次能分配的最大字节数 */
+    uint32_t free_num; /* 空闲块个数 */
+    uint32_t used_num; /* 已分配块个数 */
+    uint32_t fail;     /* 分配失败次数 */
+} MEM_STAT_T;
+
+void bsp_InitMem(void);
+void Mem_InitHeap(MEM_HEAP_E _heap);
+void *Mem_Alloc(MEM_HEAP_E _heap, uint32_t _uiSize);
+void *Mem_AllocAlign(MEM_HEAP_E _heap, uint32_t _uiSize, uint32_t _uiAlign);
+void *Mem_Calloc(MEM_HEAP_E _heap, uint32_t _uiNum, uint32_t _uiSize);
+void *Mem_Realloc(MEM_HEAP_E _heap, void *_ptr, uint32_t _uiSize);
+void Mem_Free(void *_ptr);
+void Mem_GetUsage(MEM_HEAP_E _heap, MEM_STAT_T *_pStat);
+void Mem_GetStat(MEM_HEAP_E _heap, MEM_STAT_T *_pStat);
+
+/* 与 malloc/free 用法相同的接口，mem_free 根据地址找到所属的堆 */
+#define dtcm_malloc(size) Mem_Alloc(MEM_DTCM, (size))
+#define axi_malloc(size) Mem_Alloc(MEM_AXI, (size))
+#define sdram_malloc(size) Mem_Alloc(MEM_SDRAM, (size))
+#define sdram_calloc(num, size) Mem_Calloc(MEM_SDRAM, (num), (size))
+#define sdram_realloc(ptr, size) Mem_Realloc(MEM_SDRAM, (ptr), (size))
+#define mem_free(ptr) Mem_Free(ptr)
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
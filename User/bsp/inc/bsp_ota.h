@@ -0,0 +1,70 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 固件升级(A/B双Bank)模块
+*    文件名称 : bsp_ota.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_OTA_H
+#define _BSP_OTA_H
+
+#include <stdint.h>
+
+/* 暂存区占用QSPI Flash 28MB - 30MB，镜像从暂存区起始地址存放，镜像头放在暂存区最后一个扇区 */
+#define OTA_SLOT_ADDR 0x01C00000UL
+#define OTA_SLOT_SIZE (2 * 1024 * 1024)
+#define OTA_HEAD_ADDR (OTA_SLOT_ADDR + OTA_SLOT_SIZE - QSPI_SECTOR_SIZE)
+
+/* 内部Flash每个Bank 1MB，当前运行的Bank总是映射在0x08000000，另一个Bank映射在0x08100000 */
+#define OTA_BANK_ADDR FLASH_BANK2_BASE
+#define OTA_IMAGE_MAX FLASH_BANK_SIZE
+
+/* 接收参数 */
+#define OTA_COM COM1                  /* 接收固件的串口，与shell共用 */
+#define OTA_HUART huart1              /* OTA_COM 对应的HAL句柄 */
+#define OTA_RX_BUF_SIZE (32 * 1024)   /* 接收期间从SDRAM堆申请的DMA环形缓冲区，2的整数次幂，最大32KB */
+#define OTA_RX_TIMEOUT 3000           /* 接收超时，单位ms */
+
+/* 回滚参数 */
+#define OTA_BOOT_TRIES 3       /* 新固件最多试运行次数，超过后切回旧固件 */
+#define OTA_CONFIRM_TIME 30000 /* 新固件连续运行该时间后自动确认，单位ms。0表示只能调用 OTA_Confirm 确认 */
+#define OTA_IWDG_EN 1          /* 1: 试运行期间启动独立看门狗，死机后复位并计入试运行次数 */
+
+/* 升级状态，保存在KV参数区 "ota.state" */
+typedef enum
+{
+    OTA_STATE_NONE = 0,  /* 未升级 */
+    OTA_STATE_TRIAL,     /* 新固件试运行 */
+    OTA_STATE_CONFIRMED, /* 新固件已确认 */
+    OTA_STATE_ROLLBACK,  /* 新固件启动失败，已切回旧固件 */
+} OTA_STATE_E;
+
+/* 状态信息 */
+typedef struct
+{
+    uint8_t bank;       /* 当前运行的物理Bank 1或2 */
+    uint8_t state;      /* OTA_STATE_E */
+    uint8_t boots;      /* 试运行启动次数 */
+    uint8_t staged;     /* 1: 暂存区有完整镜像 */
+    uint32_t size;      /* 暂存镜像大小 */
+    uint32_t crc;       /* 暂存镜像CRC32 */
+} OTA_STAT_T;
+
+void bsp_InitOTA(void);
+int OTA_Receive(uint32_t _uiSize, uint32_t _uiCrc, uint32_t _uiBaud);
+int OTA_Install(void);
+void OTA_Confirm(void);
+void OTA_Poll(void);
+void OTA_GetStat(OTA_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,45 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA缓冲区固定块内存池
+*    文件名称 : bsp_pool.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_POOL_H
+#define _BSP_POOL_H
+
+#include <stdint.h>
+
+#define POOL_LINE_SIZE 32 /* D-Cache行大小，所有块按此对齐，大小是其整数倍 */
+
+/* 各级块的个数，内存池位于AXI SRAM，所有DMA都能访问 */
+#define POOL_32_NUM 64  /* 32字节块，2KB */
+#define POOL_256_NUM 32 /* 256字节块，8KB */
+#define POOL_4K_NUM 8   /* 4KB块，32KB */
+
+typedef enum
+{
+    POOL_32 = 0,
+    POOL_256,
+    POOL_4K,
+
+    POOL_NUM
+} POOL_E;
+
+void bsp_InitPool(void);
+void *Pool_Alloc(uint32_t _uiSize);
+void *Pool_AllocClass(POOL_E _class);
+void Pool_Free(void *_ptr);
+uint32_t Pool_BlockSize(const void *_ptr);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -1,7 +1,7 @@
 /*
 *********************************************************************************************************
 *
-*    模块名称 : W25Q256 QSPI驱动模块
+*    模块名称 : QSPI Flash驱动模块
 *    文件名称 : bsp_qspi_w25q256.h
 *
 *    Copyright (C),  2020-2030. 安富莱电子 www.armfly.com
@@ -12,15 +12,25 @@
 #ifndef _BSP_QSPI_H
 #define _BSP_QSPI_H
 
-/* W25Q256JV基本信息 */
-#define QSPI_FLASH_SIZES 32 * 1024 * 1024                  /* Flash大小，x MB*/
-#define QSPI_FLASH_SIZE (32 - __CLZ(QSPI_FLASH_SIZES - 1)) /* Flash大小，2^23 = 8MB*/
-#define QSPI_SECTOR_SIZE (4 * 1024)                        /* 扇区大小，4KB */
-#define QSPI_PAGE_SIZE 256                                 /* 页大小，256字节 */
-#define QSPI_END_ADDR (QSPI_FLASH_SIZES - 1)               /* 末尾地址 */
+#include <stdint.h>
 
-/* W25Q256JV相关命令 */
+/*
+    分区规划使用的容量和擦除粒度。实际容量、页大小、擦除指令和读写方式在 bsp_InitQspi 中
+    从SFDP读取，保存在 QSPI_GetFlash() 描述符中，各分区地址按下面的容量规划，Flash不能小于该值。
+*/
+#define QSPI_FLASH_SIZES (32 * 1024 * 1024) /* 规划容量，32MB */
+#define QSPI_SECTOR_SIZE (4 * 1024)         /* 扇区大小，4KB */
+#define QSPI_BLOCK_SIZE (64 * 1024)         /* 块大小，64KB */
+#define QSPI_PAGE_SIZE 256                  /* 页大小，256字节，QSPI_WriteBuffer 按实际页大小拆分 */
+#define QSPI_END_ADDR (QSPI_FLASH_SIZES - 1) /* 末尾地址 */
+
+/* qspi bench 写入/擦除测试使用的区域，位于OTA分区和KV分区之间的空闲区，测试会破坏其中数据 */
+#define QSPI_BENCH_ADDR 0x01E00000UL
+#define QSPI_BENCH_SIZE (1024 * 1024)
+
+/* 通用命令，JESD216 SFDP 之外的指令 */
 #define QSPI_READ_JEDEC_ID 0x9F     /* 读取JEDEC ID命令 */
+#define QSPI_READ_SFDP_CMD 0x5A     /* 读取SFDP参数表，1-1-1，24位地址，8个空周期 */
 #define QSPI_READ_STATU_REG_1 0x05  /* 读取状态寄存器1 */
 #define QSPI_READ_STATU_REG_2 0x35  /* 读取状态寄存器2 */
 #define QSPI_READ_STATU_REG_3 0x15  /* 读取状态寄存器3 */
@@ -28,32 +38,115 @@
 #define QSPI_WRITE_STATU_REG_2 0x31 /* 写入状态寄存器2 */
 #define QSPI_WRITE_STATU_REG_3 0x11 /* 写入状态寄存器3 */
 
-#define QSPI_WRITE_ENABLE_CMD 0x06          /* 写使能指令 */
-#define QSPI_WRITE_ENABLE_REG_CMD 0x50      /* 写易失STATUS寄存器使能指令 */
-#define QSPI_WRITE_DISABLE_CMD 0x04         /* 写失能指令 */
-#define QSPI_SECTOR_ERASE_4K_CMD 0x20       /* 擦除4K扇区,地址4K对齐 */
-#define QSPI_SECTOR_ERASE_32ADD_4K_CMD 0x21 /* 擦除4K扇区,地址4K对齐 */
-#define QSPI_BULK_ERASE_CMD 0xC7            /* 整个芯片擦除命令 */
-#define QSPI_PAGE_PROG_CMD 0x02             /* 24bit地址页编程命令 */
-#define QSPI_PAGE_PROG_32ADD_CMD 0x12       /* 32bit地址页编程命令 */
-#define QSPI_FAST_READ_4_CMD 0xEB           /* 24bit地址的4线快速读取命令 */
-#define QSPI_FAST_READ_32ADD_4_CMD 0xEC     /* 32bit地址的4线快速读取命令 */
-
-/* 供外部调用的变量声明 */
+#define QSPI_WRITE_ENABLE_CMD 0x06     /* 写使能指令 */
+#define QSPI_WRITE_ENABLE_REG_CMD 0x50 /* 写易失STATUS寄存器使能指令 */
+#define QSPI_WRITE_DISABLE_CMD 0x04    /* 写失能指令 */
+#define QSPI_BULK_ERASE_CMD 0xC7       /* 整个芯片擦除命令 */
+#define QSPI_ENTER_4BYTE_CMD 0xB7      /* 进入4字节地址模式 */
+#define QSPI_RESET_ENABLE_CMD 0x66     /* 软件复位使能 */
+#define QSPI_RESET_CMD 0x99            /* 软件复位 */
+#define QSPI_SET_READ_PARAM_CMD 0xC0   /* QPI模式下设置读参数(空周期数)，Winbond */
+#define QSPI_READ_QPI_ID 0xAF          /* QPI模式下读取JEDEC ID命令，Winbond */
+
+/* 4线快速读取的 M7-0 模式字节, M5-4 = 10b 时进入连续读模式, 后续读操作省略指令 */
+#define QSPI_CONTINUOUS_READ_ON 0x20
+#define QSPI_CONTINUOUS_READ_OFF 0xF0
+
+/* 线宽 指令-地址-数据 */
+typedef enum
+{
+    QSPI_MODE_1_1_1 = 0,
+    QSPI_MODE_1_1_2,
+    QSPI_MODE_1_2_2,
+    QSPI_MODE_1_1_4,
+    QSPI_MODE_1_4_4,
+    QSPI_MODE_4_4_4,
+} QSPI_MODE_E;
+
+/* 读取指令描述 */
+typedef struct
+{
+    uint8_t cmd;         /* 指令，0表示不支持 */
+    uint8_t mode;        /* QSPI_MODE_E */
+    uint8_t mode_clocks; /* 模式位(M7-0)占用的时钟数 */
+    uint8_t dummy;       /* 模式位之后的空周期数 */
+} QSPI_READ_OP_T;
+
+/* Flash参数描述符，上电从SFDP读取，读不到SFDP时按JEDEC ID生成默认参数 */
+typedef struct
+{
+    uint32_t id;            /* JEDEC ID */
+    uint32_t size;          /* 容量，字节 */
+    uint16_t page_size;     /* 页大小 */
+    uint8_t sfdp;           /* SFDP版本 主版本 << 4 | 次版本，0 表示没有SFDP */
+    uint8_t addr4;          /* 0: 3字节地址  1: 4字节地址专用指令  2: 进入4字节地址模式 */
+    uint8_t erase_cmd[4];   /* 擦除类型1-4的指令，0表示不支持 */
+    uint8_t erase_shift[4]; /* 擦除类型1-4的大小 2^n 字节 */
+    uint8_t erase_4k_cmd;   /* 4KB擦除指令 */
+    uint8_t erase_64k_cmd;  /* 64KB擦除指令，0 表示不支持，用4KB擦除代替 */
+    uint8_t prog_cmd;       /* 页编程指令 */
+    uint8_t prog_mode;      /* 页编程线宽 QSPI_MODE_1_1_1 或 QSPI_MODE_1_1_4 */
+    uint8_t qe_method;      /* QE位设置方法，SFDP BFPT DWORD15[22:20] */
+    uint8_t qpi_enter;      /* 进入QPI指令，0表示不支持QPI */
+    uint8_t qpi_exit;       /* 退出QPI指令 */
+    uint8_t dtr_cmd;        /* 1-4-4 DTR读取指令，0表示不支持DTR */
+    QSPI_READ_OP_T read;    /* 自动选择的最快SPI读取方式 */
+    QSPI_READ_OP_T qpi;     /* QPI模式读取方式 */
+} QSPI_FLASH_T;
+
+/* QSPI读取参数 */
+typedef struct
+{
+    uint8_t qpi;       /* 1: QPI模式, 指令/地址/数据都使用4线 */
+    uint8_t dtr;       /* 1: 地址和数据双沿采样 */
+    uint8_t sioo;      /* 1: 内存映射时使用连续读模式, 只发送一次指令 */
+    uint8_t dummy;     /* M7-0之后的空周期数, SPI模式由SFDP决定, Winbond QPI模式 0/2/4/6 */
+    uint8_t prescaler; /* 时钟分频, QSPI clock = 200MHz / (prescaler + 1) */
+    uint8_t shift;     /* 1: 采样延迟半个时钟周期 */
+} QSPI_READ_CFG_T;
+
+/*
+    MDMA异步读取。请求按顺序排队，每次最多传输 QSPI_ASYNC_CHUNK 字节，完成后自动开始下一段。
+    目标缓冲区建议32字节对齐且长度为32的整数倍，避免与相邻数据共用Cache行。
+    回调函数在中断中执行，不能调用阻塞的QSPI函数。
+*/
+#define QSPI_ASYNC_QUEUE_SIZE 8     /* 排队请求个数 */
+#define QSPI_ASYNC_CHUNK (32 * 1024) /* 单次MDMA传输最大字节数，MDMA块长度上限64KB */
+#define QSPI_ASYNC_TIMEOUT 100       /* 一段传输的超时时间，ms，1线12.5MHz读取32KB约需3ms */
+
+typedef void (*QSPI_ASYNC_CB)(void *_pArg, int _iStatus);
+
+/* 等待BUSY期间调用 QSPI_BusyCallback 的最长时间，ms。W25Q256JV整片擦除最长400秒 */
+#define QSPI_BUSY_TIMEOUT 400000
+
+/* 供外部调用的变量声明，没有包含HAL时(KV、FTL模块，PC上的模拟器)不需要 */
+#ifdef HAL_QSPI_MODULE_ENABLED
 extern QSPI_HandleTypeDef hqspi;
+extern MDMA_HandleTypeDef hmdma_quadspi;
+#endif
 
 /* 供外部调用的函数声明 */
 
 void bsp_InitQspi(void);
+const QSPI_FLASH_T *QSPI_GetFlash(void);
 uint8_t QSPI_ReadSR(uint8_t _reg);
 uint32_t QSPI_ReadID(void);
 void QSPI_WaitBusy(void);
 uint8_t QSPI_WriteSR(uint8_t _reg, uint8_t _value);
+void QSPI_ModifyCallback(uint32_t _uiAddr, uint32_t _uiSize);
+void QSPI_BusyCallback(void);
 void QSPI_EraseSector(uint32_t address);
+void QSPI_EraseBlock(uint32_t address);
 void QSPI_EraseChip(void);
 void QSPI_ReadBuffer(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize);
 void QSPI_WriteBuffer(uint8_t *_pBuf, uint32_t _uiWriteAddr, uint16_t _usWriteSize);
 void QSPI_MemoryMapped(void);
+void QSPI_MemoryMappedExit(void);
+void QSPI_GetReadCfg(QSPI_READ_CFG_T *_pCfg);
+int QSPI_SetReadCfg(const QSPI_READ_CFG_T *_pCfg);
+int QSPI_ReadAsync(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize, QSPI_ASYNC_CB _cb, void *_pArg);
+uint8_t QSPI_AsyncBusy(void);
+int QSPI_WaitAsync(void);
 
 #endif
 
@@ -0,0 +1,51 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 读缓存模块
+*    文件名称 : bsp_qspi_cache.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_QSPI_CACHE_H
+#define _BSP_QSPI_CACHE_H
+
+#include <stdint.h>
+
+/* 缓存数据放在SDRAM中，索引放在内部RAM */
+#define QSPI_CACHE_BUF SDRAM_QSPI_CACHE_BUF
+#define QSPI_CACHE_SIZE SDRAM_QSPI_CACHE_SIZE
+#define QSPI_CACHE_BLOCK_SIZE (4 * 1024) /* 缓存块大小，2的整数次幂，32 - 64KB */
+#define QSPI_CACHE_LINES (QSPI_CACHE_SIZE / QSPI_CACHE_BLOCK_SIZE)
+#define QSPI_CACHE_BYPASS (64 * 1024) /* 大于等于该长度的读取直接读Flash，避免冲掉热点数据 */
+#define QSPI_CACHE_PREFETCH_EN 1      /* 1: 缺失时用MDMA异步预取下一个块 */
+
+/* 统计信息 */
+typedef struct
+{
+    uint32_t hits;          /* 命中块数 */
+    uint32_t misses;        /* 缺失块数 */
+    uint32_t prefetch;      /* 预取块数 */
+    uint32_t prefetch_hits; /* 预取后被使用的块数 */
+    uint32_t bypass;        /* 直接读Flash的次数 */
+    uint32_t invalidates;   /* 因写入、擦除作废的块数 */
+    uint16_t lines;         /* 缓存块总数 */
+    uint16_t valid;         /* 有效块数 */
+} QSPI_CACHE_STAT_T;
+
+void bsp_InitQspiCache(void);
+void QSPI_CacheRead(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize);
+void QSPI_CacheInvalidate(uint32_t _uiAddr, uint32_t _uiSize);
+void QSPI_CacheClear(void);
+void QSPI_CacheGetStat(QSPI_CACHE_STAT_T *_pStat);
+void QSPI_CacheResetStat(void);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,86 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 块设备(FTL)模块
+*    文件名称 : bsp_qspi_ftl.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_QSPI_FTL_H
+#define _BSP_QSPI_FTL_H
+
+#include <stdint.h>
+
+/* FTL占用QSPI Flash 16MB - 28MB 共12MB */
+#define FTL_FLASH_ADDR 0x01000000UL
+#define FTL_FLASH_SIZE (12 * 1024 * 1024)
+
+#define FTL_BLOCK_SIZE QSPI_SECTOR_SIZE /* 逻辑块大小4KB，与擦除扇区相同 */
+#define FTL_SECTOR_SIZE 512             /* 逻辑扇区大小 */
+#define FTL_SECTOR_PER_BLOCK (FTL_BLOCK_SIZE / FTL_SECTOR_SIZE)
+
+#define FTL_CKPT_SECTORS 5    /* 每个检查点占用的扇区数，共两份交替写入 */
+#define FTL_JOURNAL_SECTORS 8 /* 映射日志占用的扇区数 */
+#define FTL_META_SECTORS (FTL_CKPT_SECTORS * 2 + FTL_JOURNAL_SECTORS)
+#define FTL_PHY_NUM (FTL_FLASH_SIZE / FTL_BLOCK_SIZE - FTL_META_SECTORS) /* 数据区物理块个数 */
+#define FTL_SPARE_NUM 48                                                  /* 预留块，用于磨损均衡和替换坏块 */
+#define FTL_BLOCK_NUM (FTL_PHY_NUM - FTL_SPARE_NUM)                       /* 逻辑块个数 */
+#define FTL_SECTOR_NUM (FTL_BLOCK_NUM * FTL_SECTOR_PER_BLOCK)             /* 逻辑扇区个数 */
+
+/*
+    接入文件系统:
+    FatFs  diskio.c
+        disk_read(pdrv, buff, sector, count)  -> FTL_Read(buff, sector, count)
+        disk_write(pdrv, buff, sector, count) -> FTL_Write(buff, sector, count)
+        disk_ioctl CTRL_SYNC        -> FTL_Sync()
+                   GET_SECTOR_COUNT -> FTL_SECTOR_NUM
+                   GET_SECTOR_SIZE  -> FTL_SECTOR_SIZE
+                   GET_BLOCK_SIZE   -> FTL_SECTOR_PER_BLOCK
+                   CTRL_TRIM        -> 按块调用 FTL_Trim()
+    LittleFS  block_size = FTL_BLOCK_SIZE, block_count = FTL_BLOCK_NUM,
+              read_size = prog_size = FTL_SECTOR_SIZE
+        read  -> FTL_Read(buffer, block * FTL_SECTOR_PER_BLOCK + off / FTL_SECTOR_SIZE, size / FTL_SECTOR_SIZE)
+        prog  -> FTL_Write(同上)
+        erase -> FTL_Trim(block)，擦除后的块读出为0xFF
+        sync  -> FTL_Sync()
+
+    FTL_Write 写入不足一个块的数据时先缓存在RAM中，调用 FTL_Sync 或访问其它块时才写入Flash。
+    FTL_WriteBlock、FTL_Trim、FTL_Sync 返回0后数据已经提交，之后掉电不会丢失，也不会被破坏。
+*/
+
+/* 统计信息 */
+typedef struct
+{
+    uint16_t blocks;    /* 逻辑块个数 */
+    uint16_t used;      /* 已映射的逻辑块个数 */
+    uint16_t free;      /* 空闲物理块个数 */
+    uint16_t bad;       /* 坏块个数 */
+    uint32_t erase_min; /* 最小擦除次数 */
+    uint32_t erase_max; /* 最大擦除次数 */
+    uint32_t erase_avg; /* 平均擦除次数 */
+    uint32_t writes;    /* 累计写入块数 */
+    uint32_t ckpt_seq;  /* 检查点序号 */
+    uint16_t journal;   /* 日志已用条数 */
+    uint16_t wl_moves;  /* 上电以来静态磨损均衡搬移次数 */
+} FTL_STAT_T;
+
+void bsp_InitFTL(void);
+int FTL_Format(void);
+int FTL_ReadBlock(uint32_t _uiBlock, uint8_t *_pBuf);
+int FTL_WriteBlock(uint32_t _uiBlock, const uint8_t *_pBuf);
+int FTL_Trim(uint32_t _uiBlock);
+int FTL_Read(uint8_t *_pBuf, uint32_t _uiSector, uint32_t _uiCount);
+int FTL_Write(const uint8_t *_pBuf, uint32_t _uiSector, uint32_t _uiCount);
+int FTL_Sync(void);
+void FTL_GetStat(FTL_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
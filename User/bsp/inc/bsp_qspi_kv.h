@@ -0,0 +1,60 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash KV参数存储模块
+*    文件名称 : bsp_qspi_kv.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_QSPI_KV_H
+#define _BSP_QSPI_KV_H
+
+#include <stdint.h>
+
+/* KV参数区占用QSPI Flash末尾64KB，共16个扇区 */
+#define KV_FLASH_SIZE (64 * 1024)
+#define KV_FLASH_ADDR (QSPI_FLASH_SIZES - KV_FLASH_SIZE)
+#define KV_SECTOR_SIZE QSPI_SECTOR_SIZE
+#define KV_SECTOR_NUM (KV_FLASH_SIZE / KV_SECTOR_SIZE)
+
+#define KV_KEY_MAX 32     /* 键名最大长度 */
+#define KV_VALUE_MAX 1024 /* 键值最大长度 */
+#define KV_INDEX_SIZE 256 /* RAM索引表大小，2的整数次幂，最多存放 3/4 个键 */
+
+/* 统计信息 */
+typedef struct
+{
+    uint16_t keys;       /* 有效键个数 */
+    uint16_t free;       /* 空闲扇区数 */
+    uint32_t used;       /* 已写入字节数(含已失效记录) */
+    uint32_t live;       /* 有效记录字节数 */
+    uint32_t erase_min;  /* 最小擦除次数 */
+    uint32_t erase_max;  /* 最大擦除次数 */
+    uint32_t gc_count;   /* 上电以来垃圾回收次数 */
+} KV_STAT_T;
+
+/* 遍历回调，返回非0停止遍历 */
+typedef int (*KV_FOREACH_CB)(const char *_key, uint16_t _usLen, void *_pArg);
+
+void bsp_InitKV(void);
+int KV_Format(void);
+int KV_Set(const char *_key, const void *_pVal, uint16_t _usLen);
+int KV_Get(const char *_key, void *_pVal, uint16_t _usSize);
+int KV_Delete(const char *_key);
+int KV_SetU32(const char *_key, uint32_t _uiVal);
+uint32_t KV_GetU32(const char *_key, uint32_t _uiDefault);
+uint32_t KV_AddU32(const char *_key, int32_t _iDelta);
+int KV_Collect(void);
+void KV_Foreach(KV_FOREACH_CB _cb, void *_pArg);
+void KV_GetStat(KV_STAT_T *_pStat);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,35 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash SFDP参数解析模块
+*    文件名称 : bsp_qspi_sfdp.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_QSPI_SFDP_H
+#define _BSP_QSPI_SFDP_H
+
+#include <stdint.h>
+
+#define SFDP_SIGNATURE 0x50444653UL /* "SFDP" */
+#define SFDP_BFPT_ID 0xFF00         /* JEDEC Basic Flash Parameter Table */
+#define SFDP_4BAIT_ID 0xFF84        /* JEDEC 4-Byte Address Instruction Table */
+#define SFDP_BFPT_DWORDS 16         /* 只解析BFPT前16个DWORD(JESD216B) */
+#define SFDP_PARAM_MAX 8            /* 最多查找的参数头个数 */
+
+/* 读取SFDP区域，成功返回0 */
+typedef int (*SFDP_READ_FN)(uint32_t _uiAddr, void *_pBuf, uint32_t _uiSize);
+
+int SFDP_Parse(SFDP_READ_FN _pRead, uint32_t _uiId, QSPI_FLASH_T *_pFlash);
+void SFDP_Default(uint32_t _uiId, QSPI_FLASH_T *_pFlash);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
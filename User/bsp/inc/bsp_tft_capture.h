@@ -0,0 +1,58 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 屏幕截图模块
+*    文件名称 : bsp_tft_capture.h
+*    版    本 : V1.0
+*    说    明 : 头文件
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+
+#ifndef _BSP_TFT_CAPTURE_H
+#define _BSP_TFT_CAPTURE_H
+
+#include <stdint.h>
+
+#define CAP_COM COM1        /* 发送截图的串口，与shell共用 */
+#define CAP_HUART huart1    /* CAP_COM 对应的HAL句柄 */
+#define CAP_CHUNK 1024      /* 每次写入发送缓冲区的字节数，不大于 UART1_TX_BUF_SIZE */
+#define CAP_SWITCH_TIME 100 /* 切换波特率后等待对方切换的时间，ms */
+#define CAP_TX_TIMEOUT 500  /* 发送一块数据的超时时间，ms */
+
+#define CAP_MAGIC 0x30504143UL /* "CAP0" */
+
+/* 数据流开头，16字节，与 Tools/tft_capture.py 一致 */
+typedef struct
+{
+    uint32_t magic;  /* CAP_MAGIC */
+    uint16_t width;  /* 缩小后的宽度 */
+    uint16_t height; /* 缩小后的高度 */
+    uint8_t format;  /* 像素格式 GFX_FMT_E，固定为 GFX_RGB565 */
+    uint8_t scale;   /* 缩小倍数，1 - 8 */
+    uint16_t panel_w;
+    uint16_t panel_h;
+    uint16_t reserved;
+} CAP_HEAD_T;
+
+/*
+    头部之后是 RLE 压缩的像素，按行从上到下。每个包以1字节开始:
+        0x00 - 0x7F : 其后 n+1 个不同的像素
+        0x80 - 0xFF : 其后1个像素，重复 (n & 0x7F)+1 次
+    像素为2字节，小端。最后是8字节的尾部: 压缩数据字节数、压缩数据的CRC32
+*/
+typedef struct
+{
+    uint32_t size; /* 压缩数据的字节数，不含头部和尾部 */
+    uint32_t crc;  /* 压缩数据的CRC32 */
+} CAP_TAIL_T;
+
+int TFT_Capture(uint8_t _scale, uint32_t _baud);
+
+#endif
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
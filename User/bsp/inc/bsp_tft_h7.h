@@ -28,9 +28,22 @@ typedef struct
     uint16_t vbp;     // 垂直后廊
     uint16_t hfp;     // 水平前廊
     uint16_t vfp;     // 垂直前廊
+    uint32_t pclk;    // 像素时钟, kHz, 由此计算PLL3的分频系数
 } tft_cfg_t;
 
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+} TFT_RECT_T;
+
+typedef void (*TFT_FRAME_CB)(uint8_t _layer); /* 翻转完成回调，在中断中调用 */
+
 /* 宏定义 --------------------------------------------------------------------*/
+#define TFT_BUF_MAX 3    /* 每层交换链最多3个显存(三缓冲) */
+#define TFT_DIRTY_MAX 16 /* 每帧脏区域合并后最多的矩形个数 */
 
 /* 扩展变量 ------------------------------------------------------------------*/
 
@@ -38,7 +51,29 @@ typedef struct
 
 void bsp_InitTFT(void);
 char *TFT_GetDescribe(void);
+uint32_t bsp_ltdc_clk(uint32_t _khz);
+int TFT_SetPanel(uint8_t _type);
+uint8_t TFT_GetPanel(void);
+int TFT_SavePanel(void);
+void TFT_LoadPanel(void);
 void TFT_DispOn(void);
 void TFT_DispOff(void);
+void TFT_GetLayer(uint8_t _layer, GFX_SURFACE_T *_pSurf);
+
+int TFT_SetBuffers(uint8_t _layer, uint8_t _num);
+uint8_t TFT_BackBufferFree(uint8_t _layer);
+void TFT_GetBackBuffer(uint8_t _layer, GFX_SURFACE_T *_pSurf);
+void TFT_Present(uint8_t _layer);
+void TFT_WaitVSync(void);
+void TFT_SetFrameCallback(TFT_FRAME_CB _cb);
+void TFT_GetStat(uint8_t _layer, uint32_t *_pFrames, uint32_t *_pVSync, uint32_t *_pUnderrun);
+int TFT_Snapshot(const GFX_SURFACE_T *_pDst);
+void TFT_Invalidate(uint8_t _layer, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h);
+uint8_t TFT_GetDirty(uint8_t _layer, TFT_RECT_T *_pRect, uint8_t _ucMax);
+
+int TFT_SetLayerFormat(uint8_t _layer, GFX_FMT_E _fmt);
+int TFT_SetPalette(uint8_t _layer, const uint32_t *_pArgb, uint16_t _usNum);
+void TFT_SetLayerWindow(uint8_t _layer, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h);
+void TFT_FitLayerWindow(uint8_t _layer);
 
 #endif
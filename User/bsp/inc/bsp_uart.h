@@ -153,6 +153,9 @@ typedef struct
     RINGBUFF_T tx_kfifo;
     RINGBUFF_T rx_kfifo;
     uint8_t Sending; /* 正在发送中 */
+
+    volatile uint32_t tx_bytes; /* 累计发送字节数，用于统计吞吐量 */
+    volatile uint32_t rx_bytes; /* 累计接收字节数，含缓冲区溢出丢弃的 */
 } UART_T;
 
 /* 供外部调用的变量声明 */
@@ -167,6 +170,8 @@ void comClearTxFifo(COM_PORT_E _ucPort);
 void comClearRxFifo(COM_PORT_E _ucPort);
 int comSetBaud(COM_PORT_E _ucPort, uint32_t _BaudRate);
 uint16_t comGetLen(COM_PORT_E _ucPort);
+int comSetRxBuf(COM_PORT_E _ucPort, uint8_t *_pBuf, uint16_t _usSize);
+int comGetStat(COM_PORT_E _ucPort, uint32_t *_pTxBytes, uint32_t *_pRxBytes);
 
 void RS485_SendBuf(uint8_t *_ucaBuf, uint16_t _usLen);
 void RS485_SendStr(char *_pBuf);
@@ -12,6 +12,8 @@
 #ifndef __BSP_USER_LIB_H
 #define __BSP_USER_LIB_H
 
+#include <stdint.h>
+
 int str_len(char *_str);
 void str_cpy(char *_tar, char *_src);
 int str_cmp(char *s1, char *s2);
@@ -27,6 +29,7 @@ uint32_t BEBufToUint32(uint8_t *_pBuf);
 uint32_t LEBufToUint32(uint8_t *_pBuf);
 
 uint16_t CRC16_Modbus(uint8_t *_pBuf, uint16_t _usLen);
+uint32_t CRC32_Update(uint32_t _crc, const uint8_t *_pBuf, uint32_t _uiLen);
 int32_t CaculTwoPoint(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x);
 
 char BcdToChar(uint8_t _bcd);
@@ -44,8 +47,8 @@ static __inline__ uint32_t roundup_pow_of_two(uint32_t _num) /* 找出最接近
     //启用 STM32 硬件提供的计算前导零指令 CLZ
     if (_num != 0)
     {
-        // return (0x80000000UL >> (__clz(_num) - 1)); //向上取整为2次幂
-        return (0x80000000UL >> __clz(_num)); //向下取整为2次幂
+        // return (0x80000000UL >> (__builtin_clz(_num) - 1)); //向上取整为2次幂
+        return (0x80000000UL >> __builtin_clz(_num)); //向下取整为2次幂，armclang和GCC都编译为CLZ指令
     }
     return 0;
 #else
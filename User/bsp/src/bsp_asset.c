@@ -0,0 +1,528 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash资源包模块
+*    文件名称 : bsp_asset.c
+*    版    本 : V1.0
+*    说    明 : 图片、字库等资源打包存放在QSPI Flash，按名字查找，加载时边读边解压。
+*               1. 资源包由 Tools/asset_pack.py 生成: 包头 + 索引表 + 按4KB对齐的资源数据
+*               2. 压缩资源按16KB分块独立做LZ4压缩，分块表记录每块压缩后的长度，压缩后不变小的块原样存放
+*               3. 加载时MDMA读取下一块的同时CPU解压当前块，QSPI读取和解压并行。
+*                  目标在SDRAM时先解压到内部RAM再整块复制，避免LZ4匹配复制时逐字节访问SDRAM
+*               4. 不压缩的资源直接用MDMA读取到目标缓冲区
+*               QSPI带宽只有几十MB/s，图片数据压缩后读取量减少，总加载时间缩短。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_fmc_sdram.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+#include "bsp_asset.h"
+
+/*
+    资源包格式:
+    +------------+----------------------+-----------+-----------+-----
+    | 包头 32字节 | 索引 64字节 x count   | 资源1数据 | 资源2数据 | ...
+    +------------+----------------------+-----------+-----------+-----
+    LZ4资源数据: 分块表 uint32 x n (bit31为1表示该块未压缩，低31位为长度) + 各块数据(4字节对齐)
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;     /* 资源个数 */
+    uint32_t index_crc; /* 索引表CRC32 */
+    uint32_t total;     /* 资源包总字节数 */
+    uint32_t reserved[3];
+} ASSET_HEAD_T;
+
+#define ASSET_BLOCK_RAW 0x80000000UL /* 分块未压缩 */
+
+static uint32_t s_uiCount = 0; /* 有效资源个数，资源包无效时为0 */
+
+__attribute__((aligned(32))) static uint8_t s_ucIn[2][ASSET_BLOCK_SIZE]; /* 压缩数据，MDMA乒乓读取 */
+__attribute__((aligned(32))) static uint8_t s_ucOut[ASSET_BLOCK_SIZE];   /* 解压数据，目标在SDRAM时使用 */
+static uint32_t s_uiTable[ASSET_BLOCK_MAX];                             /* 分块表 */
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_LZ4Decode
+*    功能说明: 解压一个LZ4块(LZ4 block格式)，匹配只引用本块内已解压的数据
+*    形    参: _pSrc : 压缩数据
+*              _uiSrcLen : 压缩数据长度
+*              _pDst : 输出缓冲区
+*              _uiDstLen : 输出缓冲区大小
+*    返 回 值: 解压后的字节数，-1表示数据错误
+*********************************************************************************************************
+*/
+static int Asset_LZ4Decode(const uint8_t *_pSrc, uint32_t _uiSrcLen, uint8_t *_pDst, uint32_t _uiDstLen)
+{
+    const uint8_t *ip = _pSrc;
+    const uint8_t *iend = _pSrc + _uiSrcLen;
+    uint8_t *op = _pDst;
+    uint8_t *oend = _pDst + _uiDstLen;
+    const uint8_t *match;
+    uint32_t len, off;
+    uint8_t token, b;
+
+    while (ip < iend)
+    {
+        token = *ip++;
+
+        /* 字面量长度，15表示后面还有扩展字节 */
+        len = token >> 4;
+        if (len == 15)
+        {
+            do
+            {
+                if (ip >= iend)
+                {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (uint32_t)(iend - ip) || len > (uint32_t)(oend - op))
+        {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /* 最后一个序列只有字面量 */
+        if (ip >= iend)
+        {
+            break;
+        }
+
+        /* 匹配偏移和长度，长度最小为4 */
+        if (iend - ip < 2)
+        {
+            return -1;
+        }
+        off = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (off == 0 || off > (uint32_t)(op - _pDst))
+        {
+            return -1;
+        }
+
+        len = token & 0x0F;
+        if (len == 15)
+        {
+            do
+            {
+                if (ip >= iend)
+                {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += 4;
+        if (len > (uint32_t)(oend - op))
+        {
+            return -1;
+        }
+
+        /* 偏移小于长度时源和目标重叠，用于重复图案，只能逐字节复制 */
+        match = op - off;
+        if (off >= len)
+        {
+            memcpy(op, match, len);
+            op += len;
+        }
+        else
+        {
+            while (len--)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return (int)(op - _pDst);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitAsset
+*    功能说明: 检查资源包包头和索引表CRC，资源包无效时资源个数为0。需要在 bsp_InitQspiCache 之后调用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitAsset(void)
+{
+    ASSET_HEAD_T head;
+    ASSET_T item;
+    uint32_t crc = 0;
+    uint32_t i;
+
+    s_uiCount = 0;
+
+    QSPI_CacheRead((uint8_t *)&head, ASSET_FLASH_ADDR, sizeof(head));
+    if (head.magic != ASSET_MAGIC || head.version != ASSET_VERSION ||
+        head.total > ASSET_FLASH_SIZE || sizeof(head) + head.count * sizeof(ASSET_T) > head.total)
+    {
+        return;
+    }
+
+    for (i = 0; i < head.count; i++)
+    {
+        QSPI_CacheRead((uint8_t *)&item, ASSET_FLASH_ADDR + sizeof(head) + i * sizeof(ASSET_T), sizeof(ASSET_T));
+        crc = CRC32_Update(crc, (uint8_t *)&item, sizeof(ASSET_T));
+    }
+
+    if (crc == head.index_crc)
+    {
+        s_uiCount = head.count;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_Count
+*    功能说明: 获取资源个数
+*    形    参: 无
+*    返 回 值: 资源个数，资源包无效时为0
+*********************************************************************************************************
+*/
+uint32_t Asset_Count(void)
+{
+    return s_uiCount;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_OpenIndex
+*    功能说明: 按序号读取资源信息
+*    形    参: _uiIndex : 序号，0 - Asset_Count() - 1
+*              _pAsset : 资源信息
+*    返 回 值: 0:成功， -1：序号超出范围
+*********************************************************************************************************
+*/
+int Asset_OpenIndex(uint32_t _uiIndex, ASSET_T *_pAsset)
+{
+    if (_uiIndex >= s_uiCount)
+    {
+        return -1;
+    }
+
+    QSPI_CacheRead((uint8_t *)_pAsset, ASSET_FLASH_ADDR + sizeof(ASSET_HEAD_T) + _uiIndex * sizeof(ASSET_T), sizeof(ASSET_T));
+    _pAsset->name[ASSET_NAME_MAX - 1] = 0;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_Open
+*    功能说明: 按名字查找资源。索引表经过QSPI读缓存，重复查找不访问Flash
+*    形    参: _pName : 资源名
+*              _pAsset : 资源信息
+*    返 回 值: 0:成功， -1：没有找到
+*********************************************************************************************************
+*/
+int Asset_Open(const char *_pName, ASSET_T *_pAsset)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_uiCount; i++)
+    {
+        Asset_OpenIndex(i, _pAsset);
+        if (strcmp(_pAsset->name, _pName) == 0)
+        {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_LoadLZ4
+*    功能说明: 加载LZ4分块压缩的资源。MDMA读取第 n+1 块的同时解压第 n 块
+*    形    参: _pAsset : 资源信息
+*              _pDst : 目标缓冲区
+*    返 回 值: 0:成功， -1：数据错误
+*********************************************************************************************************
+*/
+static int Asset_LoadLZ4(const ASSET_T *_pAsset, uint8_t *_pDst)
+{
+    uint32_t num = (_pAsset->size + ASSET_BLOCK_SIZE - 1) / ASSET_BLOCK_SIZE;
+    uint32_t addr = ASSET_FLASH_ADDR + _pAsset->offset + num * 4;
+    uint32_t end = ASSET_FLASH_ADDR + _pAsset->offset + _pAsset->csize;
+    uint8_t sdram = ((uint32_t)_pDst >= EXT_SDRAM_ADDR && (uint32_t)_pDst < EXT_SDRAM_ADDR + EXT_SDRAM_SIZE);
+    uint32_t i, len, clen, rlen;
+    uint8_t *out;
+    uint8_t cur = 0;
+    int ret = 0;
+
+    if (num > ASSET_BLOCK_MAX || num * 4 > _pAsset->csize)
+    {
+        return -1;
+    }
+
+    /* 分块表 */
+    QSPI_ReadBuffer((uint8_t *)s_uiTable, ASSET_FLASH_ADDR + _pAsset->offset, num * 4);
+    for (i = 0; i < num; i++)
+    {
+        if ((s_uiTable[i] & ~ASSET_BLOCK_RAW) > ASSET_BLOCK_SIZE)
+        {
+            return -1;
+        }
+    }
+
+    /* 各块按4字节对齐存放，读取长度补齐到4字节，MDMA按字传输 */
+    rlen = ((s_uiTable[0] & ~ASSET_BLOCK_RAW) + 3) & ~3UL;
+    if (addr + rlen > end)
+    {
+        return -1;
+    }
+    if (QSPI_ReadAsync(s_ucIn[0], addr, rlen, NULL, NULL) != 0)
+    {
+        /* 异步队列已满时改为阻塞读取 */
+        QSPI_ReadBuffer(s_ucIn[0], addr, rlen);
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        clen = s_uiTable[i] & ~ASSET_BLOCK_RAW;
+        len = (i + 1 < num) ? ASSET_BLOCK_SIZE : _pAsset->size - i * ASSET_BLOCK_SIZE;
+        if (QSPI_WaitAsync() != 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        /* 先启动下一块的读取 */
+        addr += rlen;
+        if (i + 1 < num)
+        {
+            rlen = ((s_uiTable[i + 1] & ~ASSET_BLOCK_RAW) + 3) & ~3UL;
+            if (addr + rlen > end)
+            {
+                ret = -1;
+                break;
+            }
+            if (QSPI_ReadAsync(s_ucIn[cur ^ 1], addr, rlen, NULL, NULL) != 0)
+            {
+                QSPI_ReadBuffer(s_ucIn[cur ^ 1], addr, rlen);
+            }
+        }
+
+        if (s_uiTable[i] & ASSET_BLOCK_RAW)
+        {
+            if (clen != len)
+            {
+                ret = -1;
+                break;
+            }
+            memcpy(_pDst, s_ucIn[cur], len);
+        }
+        else
+        {
+            out = sdram ? s_ucOut : _pDst;
+            if (Asset_LZ4Decode(s_ucIn[cur], clen, out, len) != (int)len)
+            {
+                ret = -1;
+                break;
+            }
+            if (sdram)
+            {
+                memcpy(_pDst, s_ucOut, len);
+            }
+        }
+
+        _pDst += len;
+        cur ^= 1;
+    }
+
+    QSPI_WaitAsync();
+    return ret;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_Load
+*    功能说明: 加载资源到目标缓冲区，压缩资源边读边解压。不校验CRC，需要时调用 Asset_Verify
+*    形    参: _pAsset : 资源信息，由 Asset_Open 获得
+*              _pDst : 目标缓冲区，可以是内部RAM、SDRAM或者显存
+*              _uiSize : 目标缓冲区大小，不能小于资源解压后的大小
+*    返 回 值: 0:成功， -1：参数或数据错误
+*********************************************************************************************************
+*/
+int Asset_Load(const ASSET_T *_pAsset, void *_pDst, uint32_t _uiSize)
+{
+    if (_pAsset->size > _uiSize || _pAsset->offset + _pAsset->csize > ASSET_FLASH_SIZE)
+    {
+        return -1;
+    }
+
+    if (_pAsset->size == 0)
+    {
+        return 0;
+    }
+
+    if (_pAsset->method == ASSET_METHOD_RAW)
+    {
+        if (_pAsset->csize != _pAsset->size ||
+            QSPI_ReadAsync(_pDst, ASSET_FLASH_ADDR + _pAsset->offset, _pAsset->size, NULL, NULL) != 0)
+        {
+            return -1;
+        }
+        return QSPI_WaitAsync();
+    }
+    else if (_pAsset->method == ASSET_METHOD_LZ4)
+    {
+        return Asset_LoadLZ4(_pAsset, _pDst);
+    }
+
+    return -1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Asset_Verify
+*    功能说明: 校验已加载数据的CRC32
+*    形    参: _pAsset : 资源信息
+*              _pData : Asset_Load 加载的数据
+*    返 回 值: 0:正确， -1：错误
+*********************************************************************************************************
+*/
+int Asset_Verify(const ASSET_T *_pAsset, const void *_pData)
+{
+    return (CRC32_Update(0, _pData, _pAsset->size) == _pAsset->crc) ? 0 : -1;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 打印加载时间和速度，速度按解压后的字节数计算 */
+static void asset_print(const char *_name, const ASSET_T *_pAsset, int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+    uint32_t rate;
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    rate = (uint32_t)((uint64_t)_pAsset->size * 100 / us);
+    printf("%-10s: %8d -> %8d bytes %8d us %4d.%02d MB/s\r\n", _name, _pAsset->csize, _pAsset->size, us, rate / 100, rate % 100);
+}
+
+/* 加载到第1层显存并计时，返回加载时间 */
+static int64_t asset_load(const char *_pName, ASSET_T *_pAsset)
+{
+    int64_t ticks;
+
+    if (Asset_Open(_pName, _pAsset) != 0)
+    {
+        printf("%s not found.\r\n", _pName);
+        return -1;
+    }
+
+    ticks = get_system_ticks();
+    if (Asset_Load(_pAsset, (void *)SDRAM_LCD_BUF1, SDRAM_LCD_SIZE) != 0)
+    {
+        printf("%s load error.\r\n", _pName);
+        return -1;
+    }
+    ticks = get_system_ticks() - ticks;
+
+    asset_print(_pName, _pAsset, ticks);
+    if (Asset_Verify(_pAsset, (void *)SDRAM_LCD_BUF1) != 0)
+    {
+        printf("%s crc error.\r\n", _pName);
+    }
+
+    return ticks;
+}
+
+static int cmd_asset(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "asset list",
+        "asset load name",
+        "asset bench"};
+
+    ASSET_T asset;
+
+    if (argc < 2)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+    else if (!strcmp(argv[1], "list"))
+    {
+        printf("%d assets\r\n", Asset_Count());
+        for (uint32_t i = 0; i < Asset_Count(); i++)
+        {
+            Asset_OpenIndex(i, &asset);
+            printf("%-32s %s %8d -> %8d 0x%08X", asset.name, asset.method == ASSET_METHOD_LZ4 ? "lz4" : "raw",
+                   asset.csize, asset.size, asset.crc);
+            if (asset.param[0] != 0)
+            {
+                printf(" %dx%d", asset.param[0], asset.param[1]);
+            }
+            printf("\r\n");
+        }
+
+        return 0;
+    }
+    else if (!strcmp(argv[1], "load"))
+    {
+        if (argc < 3)
+        {
+            printf("Error Command.\r\n%s\r\n", help_info[1]);
+            return -1;
+        }
+
+        return (asset_load(argv[2], &asset) < 0) ? -1 : 0;
+    }
+    else if (!strcmp(argv[1], "bench"))
+    {
+        /* 同一幅1024x600 RGB565图片分别以原始和LZ4方式打包，加载到显存比较时间 */
+        int64_t raw = asset_load("bench_raw", &asset);
+        int64_t lz4 = asset_load("bench_lz4", &asset);
+
+        if (raw <= 0 || lz4 <= 0)
+        {
+            printf("Pack with: asset_pack.py --bench\r\n");
+            return -1;
+        }
+        printf("ratio = %d%% speedup = %d.%02dx\r\n", (int)((uint64_t)asset.csize * 100 / asset.size),
+               (int)(raw / lz4), (int)(raw * 100 / lz4 % 100));
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), asset, cmd_asset, asset[list load bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -26,6 +26,9 @@ extern DMA_HandleTypeDef hdma_usart3_rx;
 extern DMA_HandleTypeDef hdma_usart3_tx;
 extern DMA_HandleTypeDef hdma_usart6_rx;
 extern DMA_HandleTypeDef hdma_usart6_tx;
+extern MDMA_HandleTypeDef hmdma_quadspi;
+extern MDMA_HandleTypeDef hmdma_jpeg_in;
+extern MDMA_HandleTypeDef hmdma_jpeg_out;
 
 /**
 * [bsp_Init_dma]
@@ -58,13 +61,21 @@ void bsp_Init_dma(void)
     /* DMA1_Stream5_IRQn interrupt configuration */
     HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+
+    /* MDMA controller clock enable */
+    __HAL_RCC_MDMA_CLK_ENABLE();
+
+    /* MDMA interrupt initialization */
+    /* MDMA_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(MDMA_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(MDMA_IRQn);
 }
 
 #if UART1_FIFO_EN == 1
 /**
 * @brief This function handles DMA1 stream0 global interrupt.
 */
-void DMA1_Stream0_IRQHandler(void)
+RAM_FUNC void DMA1_Stream0_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream0_IRQn 0 */
 
@@ -79,7 +90,7 @@ void DMA1_Stream0_IRQHandler(void)
 /**
  * @brief This function handles DMA1 stream1 global interrupt.
  */
-void DMA1_Stream1_IRQHandler(void)
+RAM_FUNC void DMA1_Stream1_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream1_IRQn 0 */
 
@@ -94,7 +105,7 @@ void DMA1_Stream1_IRQHandler(void)
 /**
  * @brief This function handles DMA1 stream2 global interrupt.
  */
-void DMA1_Stream2_IRQHandler(void)
+RAM_FUNC void DMA1_Stream2_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream2_IRQn 0 */
 
@@ -109,7 +120,7 @@ void DMA1_Stream2_IRQHandler(void)
 /**
  * @brief This function handles DMA1 stream3 global interrupt.
  */
-void DMA1_Stream3_IRQHandler(void)
+RAM_FUNC void DMA1_Stream3_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream3_IRQn 0 */
 
@@ -124,7 +135,7 @@ void DMA1_Stream3_IRQHandler(void)
 /**
  * @brief This function handles DMA1 stream4 global interrupt.
  */
-void DMA1_Stream4_IRQHandler(void)
+RAM_FUNC void DMA1_Stream4_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream4_IRQn 0 */
 
@@ -139,7 +150,7 @@ void DMA1_Stream4_IRQHandler(void)
 /**
  * @brief This function handles DMA1 stream5 global interrupt.
  */
-void DMA1_Stream5_IRQHandler(void)
+RAM_FUNC void DMA1_Stream5_IRQHandler(void)
 {
     /* USER CODE BEGIN DMA1_Stream5_IRQn 0 */
 
@@ -150,4 +161,18 @@ void DMA1_Stream5_IRQHandler(void)
     /* USER CODE END DMA1_Stream5_IRQn 1 */
 }
 #endif
+
+/**
+ * @brief This function handles MDMA global interrupt.
+ */
+RAM_FUNC void MDMA_IRQHandler(void)
+{
+    /* 所有MDMA通道共用一个中断，HAL_MDMA_IRQHandler 会检查各自通道的标志 */
+    HAL_MDMA_IRQHandler(&hmdma_quadspi);
+    if (hmdma_jpeg_in.Instance != NULL) /* bsp_InitJpeg 之前QSPI已经在使用MDMA */
+    {
+        HAL_MDMA_IRQHandler(&hmdma_jpeg_in);
+        HAL_MDMA_IRQHandler(&hmdma_jpeg_out);
+    }
+}
 /***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -16,6 +16,7 @@
 */
 
 #include "bsp.h"
+#include "bsp_fmc_sdram.h"
 
 /*
     安富莱STM32-H7 开发板扩展口线分配: FMC总线地址 = 0x64001000
@@ -59,7 +60,7 @@
     D31  - Y33_7
 */
 
-#define  HC574_PORT     *(uint32_t *)0x60001000
+#define  HC574_PORT     *(uint32_t *)(FMC_NOR_ADDR + 0x1000)
 
 __IO uint32_t g_HC574;    /* 保存74HC574端口状态 */
 
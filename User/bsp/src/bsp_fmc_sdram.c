@@ -42,7 +42,28 @@
 static uint8_t FMC_Initialized = 0;   // HAL_FMC_MspInit
 static uint8_t FMC_DeInitialized = 0; // HAL_FMC_MspDeInit
 
+/*
+    SDRAM时序参数，bsp_InitExtSDRAM 使用的默认值。
+    FMC使用的HCLK3时钟，200MHz，用于SDRAM的话，至少2分频，也就是100MHz，即1个SDRAM时钟周期是10ns
+    下面参数单位均为10ns。sdram tune 找到的配置保存在KV参数区，SDRAM_LoadTiming 加载
+*/
+static const SDRAM_TIMING_T s_tTimingDef = {
+    3, /* CAS Latency可以设置Latency1，2和3，实际测试Latency3稳定 */
+    0, /* 此位定CAS延时后延后多少个HCLK周期读取数据，实际测此位可以设置无需延迟 */
+    2, /* 20ns, TRCD定义激活命令与读/写命令之间的延迟 */
+    2, /* 20ns, TRP定义预充电命令与其它命令之间的延迟 */
+    3, /* 20ns, TWR定义在写命令和预充电命令之间的延迟 */
+    7, /* 70ns, TRC定义刷新命令和激活命令之间的延迟 */
+    4, /* 50ns, TRAS定义最短的自刷新周期 */
+    7, /* 70ns, TXSR定义从发出自刷新命令到发出激活命令之间的延迟 */
+    2, /* 20ns, TMRD定义加载模式寄存器的命令与激活命令或刷新命令之间的延迟 */
+};
+static SDRAM_TIMING_T s_tTiming; /* 当前使用的时序 */
+
+#define SDRAM_TIMING_KEY "sdram.timing" /* KV参数区保存时序的键名 */
+
 static void SDRAM_Initialization_Sequence(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM_CommandTypeDef *Command);
+static void SDRAM_LoadMode(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM_CommandTypeDef *Command);
 
 /* ### STM32CubeMX CODE BEGIN */
 static void HAL_FMC_MspInit(void)
@@ -286,6 +307,40 @@ void HAL_SDRAM_MspDeInit(SDRAM_HandleTypeDef *hsdram)
 }
 /* ### STM32CubeMX CODE END */
 
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_FillConfig
+*    功能说明: 根据时序参数填写SDRAM控制器配置
+*    形    参: hsdram: SDRAM句柄
+*              _pTiming: FMC时序结构体
+*              _pCfg: 时序参数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SDRAM_FillConfig(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM_TimingTypeDef *_pTiming, const SDRAM_TIMING_T *_pCfg)
+{
+    hsdram->Instance = FMC_SDRAM_DEVICE;
+
+    _pTiming->LoadToActiveDelay = _pCfg->tmrd;
+    _pTiming->ExitSelfRefreshDelay = _pCfg->txsr;
+    _pTiming->SelfRefreshTime = _pCfg->tras;
+    _pTiming->RowCycleDelay = _pCfg->trc;
+    _pTiming->WriteRecoveryTime = _pCfg->twr;
+    _pTiming->RPDelay = _pCfg->trp;
+    _pTiming->RCDDelay = _pCfg->trcd;
+
+    hsdram->Init.SDBank = FMC_SDRAM_BANK1;                             /* 硬件设计上用的BANK1 */
+    hsdram->Init.ColumnBitsNumber = FMC_SDRAM_COLUMN_BITS_NUM_9;       /* 9列 */
+    hsdram->Init.RowBitsNumber = FMC_SDRAM_ROW_BITS_NUM_12;            /* 12行 */
+    hsdram->Init.MemoryDataWidth = FMC_SDRAM_MEM_BUS_WIDTH_32;         /* 32位带宽 */
+    hsdram->Init.InternalBankNumber = FMC_SDRAM_INTERN_BANKS_NUM_4;    /* SDRAM有4个BANK */
+    hsdram->Init.CASLatency = (uint32_t)_pCfg->cas << FMC_SDCRx_CAS_Pos;
+    hsdram->Init.WriteProtection = FMC_SDRAM_WRITE_PROTECTION_DISABLE; /* 禁止写保护 */
+    hsdram->Init.SDClockPeriod = FMC_SDRAM_CLOCK_PERIOD_2;             /* FMC时钟200MHz，2分频后给SDRAM，即100MHz */
+    hsdram->Init.ReadBurst = FMC_SDRAM_RBURST_ENABLE;                  /* 使能读突发 */
+    hsdram->Init.ReadPipeDelay = (uint32_t)_pCfg->rpipe << FMC_SDCRx_RPIPE_Pos;
+}
+
 /*
 *********************************************************************************************************
 *    函 数 名: bsp_InitExtSDRAM
@@ -309,30 +364,8 @@ void bsp_InitExtSDRAM(void)
     __HAL_RCC_GPIOI_CLK_ENABLE();
 
     /* SDRAM配置 */
-    hsdram.Instance = FMC_SDRAM_DEVICE;
-
-    /*
-       FMC使用的HCLK3时钟，200MHz，用于SDRAM的话，至少2分频，也就是100MHz，即1个SDRAM时钟周期是10ns
-       下面参数单位均为10ns。
-    */
-    SdramTiming.LoadToActiveDelay = 2;    /* 20ns, TMRD定义加载模式寄存器的命令与激活命令或刷新命令之间的延迟 */
-    SdramTiming.ExitSelfRefreshDelay = 7; /* 70ns, TXSR定义从发出自刷新命令到发出激活命令之间的延迟 */
-    SdramTiming.SelfRefreshTime = 4;      /* 50ns, TRAS定义最短的自刷新周期 */
-    SdramTiming.RowCycleDelay = 7;        /* 70ns, TRC定义刷新命令和激活命令之间的延迟 */
-    SdramTiming.WriteRecoveryTime = 3;    /* 20ns, TWR定义在写命令和预充电命令之间的延迟 */
-    SdramTiming.RPDelay = 2;              /* 20ns, TRP定义预充电命令与其它命令之间的延迟 */
-    SdramTiming.RCDDelay = 2;             /* 20ns, TRCD定义激活命令与读/写命令之间的延迟 */
-
-    hsdram.Init.SDBank = FMC_SDRAM_BANK1;                             /* 硬件设计上用的BANK1 */
-    hsdram.Init.ColumnBitsNumber = FMC_SDRAM_COLUMN_BITS_NUM_9;       /* 9列 */
-    hsdram.Init.RowBitsNumber = FMC_SDRAM_ROW_BITS_NUM_12;            /* 12行 */
-    hsdram.Init.MemoryDataWidth = FMC_SDRAM_MEM_BUS_WIDTH_32;         /* 32位带宽 */
-    hsdram.Init.InternalBankNumber = FMC_SDRAM_INTERN_BANKS_NUM_4;    /* SDRAM有4个BANK */
-    hsdram.Init.CASLatency = FMC_SDRAM_CAS_LATENCY_3;                 /* CAS Latency可以设置Latency1，2和3，实际测试Latency3稳定 */
-    hsdram.Init.WriteProtection = FMC_SDRAM_WRITE_PROTECTION_DISABLE; /* 禁止写保护 */
-    hsdram.Init.SDClockPeriod = FMC_SDRAM_CLOCK_PERIOD_2;             /* FMC时钟200MHz，2分频后给SDRAM，即100MHz */
-    hsdram.Init.ReadBurst = FMC_SDRAM_RBURST_ENABLE;                  /* 使能读突发 */
-    hsdram.Init.ReadPipeDelay = FMC_SDRAM_RPIPE_DELAY_0;              /* 此位定CAS延时后延后多少个SDRAM时钟周期读取数据，实际测此位可以设置无需延迟 */
+    s_tTiming = s_tTimingDef;
+    SDRAM_FillConfig(&hsdram, &SdramTiming, &s_tTiming);
 
     /* 配置SDRAM控制器基本参数 */
     if (HAL_SDRAM_Init(&hsdram, &SdramTiming) != HAL_OK)
@@ -343,6 +376,11 @@ void bsp_InitExtSDRAM(void)
 
     /* 完成SDRAM序列初始化 */
     SDRAM_Initialization_Sequence(&hsdram, &command);
+
+#if FMC_SDRAM_BANK_SWAP
+    /* SDRAM Bank1与NOR/PSRAM Bank1交换地址，SDRAM映射到0x60000000 */
+    HAL_SetFMCMemorySwappingConfig(FMC_SWAPBMAP_SDRAM_SRAM);
+#endif
 }
 
 /*
@@ -356,8 +394,6 @@ void bsp_InitExtSDRAM(void)
 */
 static void SDRAM_Initialization_Sequence(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM_CommandTypeDef *Command)
 {
-    __IO uint32_t tmpmrd = 0;
-
     /*##-1- 时钟使能命令 ##################################################*/
     Command->CommandMode = FMC_SDRAM_CMD_CLK_ENABLE;
     Command->CommandTarget = FMC_SDRAM_CMD_TARGET_BANK1;
@@ -371,6 +407,22 @@ static void SDRAM_Initialization_Sequence(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM
     /*##-2- 插入延迟，至少100us ##################################################*/
     HAL_Delay(1);
 
+    SDRAM_LoadMode(hsdram, Command);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_LoadMode
+*    功能说明: 预充电、自动刷新、写模式寄存器、设置刷新率。SDRAM保持时钟，数据不丢失，修改时序后也调用此函数
+*    形    参: hsdram: SDRAM句柄
+*              Command: 命令结构体指针
+*    返 回 值: None
+*********************************************************************************************************
+*/
+static void SDRAM_LoadMode(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM_CommandTypeDef *Command)
+{
+    __IO uint32_t tmpmrd = 0;
+
     /*##-3- 整个SDRAM预充电命令，PALL(precharge all) #############################*/
     Command->CommandMode = FMC_SDRAM_CMD_PALL;
     Command->CommandTarget = FMC_SDRAM_CMD_TARGET_BANK1;
@@ -392,7 +444,7 @@ static void SDRAM_Initialization_Sequence(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM
     /*##-5- 配置SDRAM模式寄存器 ###############################################*/
     tmpmrd = (uint32_t)SDRAM_MODEREG_BURST_LENGTH_1 |
              SDRAM_MODEREG_BURST_TYPE_SEQUENTIAL |
-             SDRAM_MODEREG_CAS_LATENCY_3 |
+             ((uint16_t)s_tTiming.cas << 4) | /* SDRAM_MODEREG_CAS_LATENCY_x */
              SDRAM_MODEREG_OPERATING_MODE_STANDARD |
              SDRAM_MODEREG_WRITEBURST_MODE_SINGLE;
 
@@ -413,194 +465,852 @@ static void SDRAM_Initialization_Sequence(SDRAM_HandleTypeDef *hsdram, FMC_SDRAM
     HAL_SDRAM_ProgramRefreshRate(hsdram, SDRAM_REFRESH_COUNT);
 }
 
+/*
+    SDRAM测试：
+    1. 填充由MDMA完成，1KB的图案块重复写入(块重复模式，每块结束源地址回退1KB)，一次最多4MB，
+       数据不经过D-Cache，突发写入SDRAM
+    2. 比较由CPU完成，SDRAM为Write back区域，读取按Cache行突发进行
+    3. 所有测试记录第一个错误的地址、期望值和读到的值，以及读写的字节数和时间
+*/
+#define SDRAM_TILE_WORDS 256      /* MDMA填充图案块，1KB */
+#define SDRAM_MDMA_MAX_BLOCK 4096 /* MDMA块重复次数最大值 */
+#define SDRAM_MDMA_TIMEOUT 1000   /* 4MB填充超时，ms */
+
+__attribute__((aligned(32))) static uint32_t s_uiTile[SDRAM_TILE_WORDS];
+static MDMA_HandleTypeDef s_hmdmaSdram;
+
+/* 系统节拍数转换为us */
+static uint32_t SDRAM_TicksToUs(int64_t _ticks)
+{
+    return (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+}
+
+/* 记录错误，只保存第一个错误的信息 */
+static void SDRAM_Error(SDRAM_TEST_T *_res, volatile uint32_t *_addr, uint32_t _expect, uint32_t _read)
+{
+    if (_res->err++ == 0)
+    {
+        _res->addr = (uint32_t)_addr;
+        _res->expect = _expect;
+        _res->read = _read;
+    }
+}
+
+/* 配置MDMA通道1，软件触发，字传输，16拍突发，每块结束源地址回到图案块开头 */
+static void SDRAM_InitMdma(void)
+{
+    __HAL_RCC_MDMA_CLK_ENABLE();
+
+    s_hmdmaSdram.Instance = MDMA_Channel1; /* 通道0由QSPI使用 */
+    s_hmdmaSdram.Init.Request = MDMA_REQUEST_SW;
+    s_hmdmaSdram.Init.TransferTriggerMode = MDMA_REPEAT_BLOCK_TRANSFER;
+    s_hmdmaSdram.Init.Priority = MDMA_PRIORITY_LOW;
+    s_hmdmaSdram.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    s_hmdmaSdram.Init.SourceInc = MDMA_SRC_INC_WORD;
+    s_hmdmaSdram.Init.DestinationInc = MDMA_DEST_INC_WORD;
+    s_hmdmaSdram.Init.SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+    s_hmdmaSdram.Init.DestDataSize = MDMA_DEST_DATASIZE_WORD;
+    s_hmdmaSdram.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    s_hmdmaSdram.Init.BufferTransferLength = 128;
+    s_hmdmaSdram.Init.SourceBurst = MDMA_SOURCE_BURST_16BEATS;
+    s_hmdmaSdram.Init.DestBurst = MDMA_DEST_BURST_16BEATS;
+    s_hmdmaSdram.Init.SourceBlockAddressOffset = -(int32_t)sizeof(s_uiTile);
+    s_hmdmaSdram.Init.DestBlockAddressOffset = 0;
+    if (HAL_MDMA_Init(&s_hmdmaSdram) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+}
+
 /*
 *********************************************************************************************************
-*    函 数 名: bsp_TestExtSDRAM
-*    功能说明: 扫描测试外部SDRAM的全部单元。
-*    形    参: 无
-*    返 回 值: 0 表示测试通过； 大于0表示错误单元的个数。
+*    函 数 名: SDRAM_Fill
+*    功能说明: MDMA用两个字交替的图案填充SDRAM，偶数字为_a，奇数字为_b
+*    形    参: _res : 测试结果，累加写入字节数和时间
+*              _addr : 起始地址，1KB对齐
+*              _size : 字节数，1KB的整数倍
+*              _a, _b : 图案
+*    返 回 值: 无
 *********************************************************************************************************
 */
-uint32_t bsp_TestExtSDRAM1(void)
+static void SDRAM_Fill(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size, uint32_t _a, uint32_t _b)
 {
-    uint32_t i;
-    uint32_t *pSRAM;
-    uint8_t *pBytes;
-    uint32_t err;
-    const uint8_t ByteBuf[4] = {0x55, 0xA5, 0x5A, 0xAA};
+    uint32_t i, blocks;
+    int64_t ticks;
 
-    /* 写SRAM */
-    pSRAM = (uint32_t *)EXT_SDRAM_ADDR;
-    for (i = 0; i < EXT_SDRAM_SIZE / 4; i++)
+    for (i = 0; i < SDRAM_TILE_WORDS; i += 2)
     {
-        *pSRAM++ = i;
+        s_uiTile[i] = _a;
+        s_uiTile[i + 1] = _b;
     }
 
-    /* 读SRAM */
-    err = 0;
-    pSRAM = (uint32_t *)EXT_SDRAM_ADDR;
-    for (i = 0; i < EXT_SDRAM_SIZE / 4; i++)
+    /* 图案块写回AXI SRAM，SDRAM中的脏数据先写回，MDMA写入后不会被覆盖 */
+    SCB_CleanInvalidateDCache();
+
+    ticks = get_system_ticks();
+    _res->wr_bytes += _size;
+    while (_size > 0)
     {
-        if (*pSRAM++ != i)
+        blocks = _size / sizeof(s_uiTile);
+        if (blocks > SDRAM_MDMA_MAX_BLOCK)
+        {
+            blocks = SDRAM_MDMA_MAX_BLOCK;
+        }
+
+        if (HAL_MDMA_Start(&s_hmdmaSdram, (uint32_t)s_uiTile, _addr, sizeof(s_uiTile), blocks) != HAL_OK ||
+            HAL_MDMA_PollForTransfer(&s_hmdmaSdram, HAL_MDMA_FULL_TRANSFER, SDRAM_MDMA_TIMEOUT) != HAL_OK)
         {
-            err++;
+            SDRAM_Error(_res, (uint32_t *)_addr, _a, ~_a);
+            HAL_MDMA_Abort(&s_hmdmaSdram);
+            break;
         }
+
+        _addr += blocks * sizeof(s_uiTile);
+        _size -= blocks * sizeof(s_uiTile);
     }
+    _res->wr_us += SDRAM_TicksToUs(get_system_ticks() - ticks);
+
+    /* 作废投机读入Cache的SDRAM数据，后面读到的是MDMA写入的值 */
+    SCB_CleanInvalidateDCache();
+}
+
+/* 比较两个字交替的图案，累加读取字节数和时间 */
+static void SDRAM_Verify(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size, uint32_t _a, uint32_t _b)
+{
+    volatile uint32_t *p = (uint32_t *)_addr;
+    uint32_t i, n = _size / 4;
+    uint32_t v0, v1;
+    int64_t ticks;
 
-    if (err > 0)
+    ticks = get_system_ticks();
+    for (i = 0; i < n; i += 2)
     {
-        return (4 * err);
+        v0 = p[i];
+        v1 = p[i + 1];
+        if (v0 != _a)
+        {
+            SDRAM_Error(_res, &p[i], _a, v0);
+        }
+        if (v1 != _b)
+        {
+            SDRAM_Error(_res, &p[i + 1], _b, v1);
+        }
     }
+    _res->rd_bytes += _size;
+    _res->rd_us += SDRAM_TicksToUs(get_system_ticks() - ticks);
+}
 
-    /* 对SRAM 的数据求反并写入 */
-    pSRAM = (uint32_t *)EXT_SDRAM_ADDR;
-    for (i = 0; i < EXT_SDRAM_SIZE / 4; i++)
+/* 数据线测试，每根数据线走1和走0，另一个Cache行写入反码，数据线上不残留期望值 */
+static void SDRAM_TestDataBus(SDRAM_TEST_T *_res, uint32_t _addr)
+{
+    volatile uint32_t *p = (uint32_t *)_addr;
+    uint32_t pattern, v;
+    uint8_t i, k;
+
+    for (k = 0; k < 2; k++)
     {
-        *pSRAM = ~*pSRAM;
-        pSRAM++;
+        for (i = 0; i < 32; i++)
+        {
+            pattern = (k == 0) ? (1UL << i) : ~(1UL << i);
+            p[0] = pattern;
+            p[8] = ~pattern;
+            SCB_CleanInvalidateDCache_by_Addr((uint32_t *)_addr, 64);
+
+            v = p[0];
+            if (v != pattern)
+            {
+                SDRAM_Error(_res, &p[0], pattern, v);
+            }
+        }
     }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_TestAddrBus
+*    功能说明: 地址线测试。在2的幂次偏移处写入图案，逐个改写后检查其它单元，
+*              能发现固定为高、固定为低和相互短路的地址线
+*    形    参: _res : 测试结果
+*              _addr : 起始地址
+*              _size : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SDRAM_TestAddrBus(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size)
+{
+    const uint32_t pattern = 0xAAAAAAAA;
+    const uint32_t anti = 0x55555555;
+    volatile uint32_t *p = (uint32_t *)_addr;
+    uint32_t n = _size / 4;
+    uint32_t off, test, v;
 
-    /* 再次比较SDRAM的数据 */
-    err = 0;
-    pSRAM = (uint32_t *)EXT_SDRAM_ADDR;
-    for (i = 0; i < EXT_SDRAM_SIZE / 4; i++)
+    for (off = 1; off < n; off <<= 1)
     {
-        if (*pSRAM++ != (~i))
+        p[off] = pattern;
+    }
+
+    /* 地址线固定为高：改写0单元后，其它单元不应改变 */
+    p[0] = anti;
+    SCB_CleanInvalidateDCache();
+    for (off = 1; off < n; off <<= 1)
+    {
+        v = p[off];
+        if (v != pattern)
         {
-            err++;
+            SDRAM_Error(_res, &p[off], pattern, v);
         }
     }
+    p[0] = pattern;
 
-    if (err > 0)
+    /* 地址线固定为低或短路：逐个改写后，其它单元不应改变 */
+    for (test = 1; test < n; test <<= 1)
     {
-        return (4 * err);
+        p[test] = anti;
+        SCB_CleanInvalidateDCache();
+
+        v = p[0];
+        if (v != pattern)
+        {
+            SDRAM_Error(_res, &p[test], pattern, v);
+        }
+        for (off = 1; off < n; off <<= 1)
+        {
+            v = p[off];
+            if (off != test && v != pattern)
+            {
+                SDRAM_Error(_res, &p[test], pattern, v);
+            }
+        }
+        p[test] = pattern;
     }
+    SCB_CleanInvalidateDCache();
+}
 
-    /* 测试按字节方式访问, 目的是验证 FSMC_NBL0 、 FSMC_NBL1 口线 */
-    pBytes = (uint8_t *)EXT_SDRAM_ADDR;
+/* 字节和半字访问，验证 FMC_NBL0 - FMC_NBL3 */
+static void SDRAM_TestByte(SDRAM_TEST_T *_res, uint32_t _addr)
+{
+    const uint8_t ByteBuf[4] = {0x55, 0xA5, 0x5A, 0xAA};
+    volatile uint32_t *p = (uint32_t *)_addr;
+    volatile uint8_t *pBytes = (uint8_t *)_addr;
+    volatile uint16_t *pHalf = (uint16_t *)(_addr + 4);
+    uint32_t v;
+    uint8_t i;
+
+    p[0] = 0;
+    p[1] = 0;
     for (i = 0; i < sizeof(ByteBuf); i++)
     {
-        *pBytes++ = ByteBuf[i];
+        pBytes[i] = ByteBuf[i];
     }
+    pHalf[0] = 0x1234;
+    pHalf[1] = 0xABCD;
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)_addr, 32);
 
-    /* 比较SDRAM的数据 */
-    err = 0;
-    pBytes = (uint8_t *)EXT_SDRAM_ADDR;
-    for (i = 0; i < sizeof(ByteBuf); i++)
+    v = p[0];
+    if (v != 0xAA5AA555)
+    {
+        SDRAM_Error(_res, &p[0], 0xAA5AA555, v);
+    }
+    v = p[1];
+    if (v != 0xABCD1234)
     {
-        if (*pBytes++ != ByteBuf[i])
+        SDRAM_Error(_res, &p[1], 0xABCD1234, v);
+    }
+}
+
+/* 单元写入自己的地址，再写入地址的反码 */
+static void SDRAM_TestAddrInAddr(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size)
+{
+    volatile uint32_t *p = (uint32_t *)_addr;
+    uint32_t i, n = _size / 4;
+    uint32_t inv, v;
+    int64_t ticks;
+
+    for (inv = 0; inv <= 1; inv++)
+    {
+        ticks = get_system_ticks();
+        for (i = 0; i < n; i++)
         {
-            err++;
+            p[i] = (uint32_t)&p[i] ^ -inv;
+        }
+        SCB_CleanInvalidateDCache();
+        _res->wr_bytes += _size;
+        _res->wr_us += SDRAM_TicksToUs(get_system_ticks() - ticks);
+
+        ticks = get_system_ticks();
+        for (i = 0; i < n; i++)
+        {
+            v = p[i];
+            if (v != ((uint32_t)&p[i] ^ -inv))
+            {
+                SDRAM_Error(_res, &p[i], (uint32_t)&p[i] ^ -inv, v);
+            }
         }
+        _res->rd_bytes += _size;
+        _res->rd_us += SDRAM_TicksToUs(get_system_ticks() - ticks);
     }
-    if (err > 0)
+}
+
+/* March单元：按地址升序或降序读出_r并检查，再写入_w */
+static void SDRAM_MarchElement(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size, uint8_t _down, uint32_t _r, uint32_t _w)
+{
+    volatile uint32_t *p = (uint32_t *)_addr;
+    uint32_t i, n = _size / 4;
+    uint32_t v;
+
+    for (i = 0; i < n; i++)
     {
-        return err;
+        volatile uint32_t *q = _down ? &p[n - 1 - i] : &p[i];
+
+        v = *q;
+        if (v != _r)
+        {
+            SDRAM_Error(_res, q, _r, v);
+        }
+        *q = _w;
     }
-    return 0;
+    /* 写回Cache中剩余的数据，下一个单元从SDRAM读取 */
+    SCB_CleanInvalidateDCache();
+}
+
+/*
+    March C-：{⇕(w0); ⇑(r0,w1); ⇑(r1,w0); ⇓(r0,w1); ⇓(r1,w0); ⇕(r0)}
+    按字进行，0为全0，1为全1。能发现固定故障、转换故障、耦合故障和地址译码故障
+*/
+static void SDRAM_TestMarchC(SDRAM_TEST_T *_res, uint32_t _addr, uint32_t _size)
+{
+    SDRAM_Fill(_res, _addr, _size, 0, 0);
+    SDRAM_MarchElement(_res, _addr, _size, 0, 0, 0xFFFFFFFF);
+    SDRAM_MarchElement(_res, _addr, _size, 0, 0xFFFFFFFF, 0);
+    SDRAM_MarchElement(_res, _addr, _size, 1, 0, 0xFFFFFFFF);
+    SDRAM_MarchElement(_res, _addr, _size, 1, 0xFFFFFFFF, 0);
+    SDRAM_Verify(_res, _addr, _size, 0, 0);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_TestSDRAM
+*    功能说明: 按顺序执行选定的测试项，某一项出错时停止。测试会改写整个区域
+*    形    参: _addr : 起始地址，1KB对齐
+*              _size : 字节数，1KB的整数倍
+*              _items : 测试项，SDRAM_TEST_DATA_BUS 等的组合
+*              _res : 测试结果，第一个错误的信息和读写带宽
+*    返 回 值: 0 表示测试通过； 大于0表示错误单元的个数。
+*********************************************************************************************************
+*/
+uint32_t bsp_TestSDRAM(uint32_t _addr, uint32_t _size, uint32_t _items, SDRAM_TEST_T *_res)
+{
+    memset(_res, 0, sizeof(SDRAM_TEST_T));
+
+    SDRAM_InitMdma();
+
+    if ((_items & SDRAM_TEST_DATA_BUS) && _res->err == 0)
+    {
+        SDRAM_TestDataBus(_res, _addr);
+    }
+    if ((_items & SDRAM_TEST_ADDR_BUS) && _res->err == 0)
+    {
+        SDRAM_TestAddrBus(_res, _addr, _size);
+    }
+    if ((_items & SDRAM_TEST_BYTE) && _res->err == 0)
+    {
+        SDRAM_TestByte(_res, _addr);
+    }
+    if ((_items & SDRAM_TEST_CHECKER) && _res->err == 0)
+    {
+        SDRAM_Fill(_res, _addr, _size, 0x55555555, 0xAAAAAAAA);
+        SDRAM_Verify(_res, _addr, _size, 0x55555555, 0xAAAAAAAA);
+        SDRAM_Fill(_res, _addr, _size, 0xAAAAAAAA, 0x55555555);
+        SDRAM_Verify(_res, _addr, _size, 0xAAAAAAAA, 0x55555555);
+    }
+    if ((_items & SDRAM_TEST_ADDR) && _res->err == 0)
+    {
+        SDRAM_TestAddrInAddr(_res, _addr, _size);
+    }
+    if ((_items & SDRAM_TEST_MARCH) && _res->err == 0)
+    {
+        SDRAM_TestMarchC(_res, _addr, _size);
+    }
+
+    return _res->err;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_TestExtSDRAM1
+*    功能说明: 测试外部SDRAM的全部单元，包括显存。会改写显存和SDRAM堆，调用前须释放全部 MEM_SDRAM 内存，
+*              结束后调用 Mem_InitHeap(MEM_SDRAM)。
+*    形    参: 无
+*    返 回 值: 0 表示测试通过； 大于0表示错误单元的个数。
+*********************************************************************************************************
+*/
+uint32_t bsp_TestExtSDRAM1(void)
+{
+    SDRAM_TEST_T res;
+
+    return bsp_TestSDRAM(EXT_SDRAM_ADDR, EXT_SDRAM_SIZE, SDRAM_TEST_ALL, &res);
 }
 
 /*
 *********************************************************************************************************
 *    函 数 名: bsp_TestExtSDRAM2
-*    功能说明: 扫描测试外部SDRAM，不扫描前面4M字节的显存。
+*    功能说明: 测试外部SDRAM，不测试前面4M字节的显存和末尾的QSPI读缓存。测试区域就是SDRAM堆，
+*              调用前须释放全部 MEM_SDRAM 内存，结束后调用 Mem_InitHeap(MEM_SDRAM)。
 *    形    参: 无
 *    返 回 值: 0 表示测试通过； 大于0表示错误单元的个数。
 *********************************************************************************************************
 */
 uint32_t bsp_TestExtSDRAM2(void)
 {
-    uint32_t i;
-    uint32_t *pSRAM;
-    uint8_t *pBytes;
-    uint32_t err;
-    const uint8_t ByteBuf[4] = {0x55, 0xA5, 0x5A, 0xAA};
+    SDRAM_TEST_T res;
+
+    return bsp_TestSDRAM(SDRAM_APP_BUF, SDRAM_APP_SIZE, SDRAM_TEST_ALL, &res);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_CheckTiming
+*    功能说明: 检查时序参数是否合法。FMC要求 TWR >= TRAS - TRCD，TWR >= TRC - TRCD - TRP
+*    形    参: _pCfg: 时序参数
+*    返 回 值: 1 表示合法
+*********************************************************************************************************
+*/
+static uint8_t SDRAM_CheckTiming(const SDRAM_TIMING_T *_pCfg)
+{
+    if (_pCfg->cas < 1 || _pCfg->cas > 3 || _pCfg->rpipe > 2)
+    {
+        return 0;
+    }
+    if (_pCfg->trcd < 1 || _pCfg->trcd > 16 || _pCfg->trp < 1 || _pCfg->trp > 16 ||
+        _pCfg->twr < 1 || _pCfg->twr > 16 || _pCfg->trc < 1 || _pCfg->trc > 16 ||
+        _pCfg->tras < 1 || _pCfg->tras > 16 || _pCfg->txsr < 1 || _pCfg->txsr > 16 ||
+        _pCfg->tmrd < 1 || _pCfg->tmrd > 16)
+    {
+        return 0;
+    }
+    if (_pCfg->twr + _pCfg->trcd < _pCfg->tras || _pCfg->twr + _pCfg->trcd + _pCfg->trp < _pCfg->trc)
+    {
+        return 0;
+    }
+    return 1;
+}
 
-    /* 写SRAM */
-    pSRAM = (uint32_t *)SDRAM_APP_BUF;
-    for (i = 0; i < SDRAM_APP_SIZE / 4; i++)
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_SetTiming
+*    功能说明: 运行中修改SDRAM时序，SDRAM中的数据保持不变。
+*              关闭FMC期间SDCLK停止，时间只有几us，远小于64ms的刷新周期，数据不会丢失。
+*              期间关闭中断，暂停LTDC读取显存
+*    形    参: _pCfg: 时序参数
+*    返 回 值: 0 表示成功，-1 表示参数不合法
+*********************************************************************************************************
+*/
+int SDRAM_SetTiming(const SDRAM_TIMING_T *_pCfg)
+{
+    SDRAM_HandleTypeDef hsdram = {0};
+    FMC_SDRAM_TimingTypeDef SdramTiming = {0};
+    FMC_SDRAM_CommandTypeDef command = {0};
+    uint32_t primask, ltdc;
+
+    if (!SDRAM_CheckTiming(_pCfg))
     {
-        *pSRAM++ = i;
+        return -1;
     }
 
-    /* 读SRAM */
-    err = 0;
-    pSRAM = (uint32_t *)SDRAM_APP_BUF;
-    for (i = 0; i < SDRAM_APP_SIZE / 4; i++)
+    QSPI_WaitAsync();  /* QSPI读缓存的MDMA预取可能正在写SDRAM */
+    SCB_CleanDCache(); /* SDRAM的脏数据按原时序写回 */
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    ltdc = LTDC->GCR & LTDC_GCR_LTDCEN;
+    LTDC->GCR &= ~LTDC_GCR_LTDCEN;
+
+    s_tTiming = *_pCfg;
+    SDRAM_FillConfig(&hsdram, &SdramTiming, &s_tTiming);
+
+    __FMC_DISABLE();
+    FMC_SDRAM_Init(hsdram.Instance, &hsdram.Init);
+    FMC_SDRAM_Timing_Init(hsdram.Instance, &SdramTiming, hsdram.Init.SDBank);
+    __FMC_ENABLE();
+
+    /* 重新发送时钟使能命令，然后写入新的CAS Latency */
+    hsdram.State = HAL_SDRAM_STATE_READY;
+    command.CommandMode = FMC_SDRAM_CMD_CLK_ENABLE;
+    command.CommandTarget = FMC_SDRAM_CMD_TARGET_BANK1;
+    command.AutoRefreshNumber = 1;
+    HAL_SDRAM_SendCommand(&hsdram, &command, SDRAM_TIMEOUT);
+    SDRAM_LoadMode(&hsdram, &command);
+
+    LTDC->GCR |= ltdc;
+    __set_PRIMASK(primask);
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_GetTiming
+*    功能说明: 读取当前使用的SDRAM时序
+*    形    参: _pCfg: 时序参数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void SDRAM_GetTiming(SDRAM_TIMING_T *_pCfg)
+{
+    *_pCfg = s_tTiming;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_SaveTiming
+*    功能说明: 当前时序保存到KV参数区，下次上电由 SDRAM_LoadTiming 加载
+*    形    参: 无
+*    返 回 值: 0 表示成功
+*********************************************************************************************************
+*/
+int SDRAM_SaveTiming(void)
+{
+    return KV_Set(SDRAM_TIMING_KEY, &s_tTiming, sizeof(s_tTiming));
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SDRAM_LoadTiming
+*    功能说明: 加载KV参数区保存的时序，快速测试不通过时(例如温度变化)恢复默认时序。
+*              需在 bsp_InitKV 之后调用，此时SDRAM堆还没有使用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void SDRAM_LoadTiming(void)
+{
+    SDRAM_TIMING_T cfg;
+    SDRAM_TEST_T res;
+    uint8_t *buf;
+
+    if (KV_Get(SDRAM_TIMING_KEY, &cfg, sizeof(cfg)) != sizeof(cfg) || SDRAM_SetTiming(&cfg) != 0)
     {
-        if (*pSRAM++ != i)
+        return;
+    }
+
+    buf = Mem_AllocAlign(MEM_SDRAM, SDRAM_TUNE_SIZE, 1024);
+    if (buf == NULL || bsp_TestSDRAM((uint32_t)buf, SDRAM_TUNE_SIZE, SDRAM_TEST_ALL, &res) != 0)
+    {
+        SDRAM_SetTiming(&s_tTimingDef);
+    }
+    Mem_Free(buf);
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 打印速度，bytes/us 即 MB/s，保留两位小数 */
+static void sdram_bench_print(const char *_name, uint32_t _bytes, int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+    uint32_t rate;
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    rate = (uint32_t)((uint64_t)_bytes * 100 / us);
+    printf("%-14s: %8d bytes %8d us %4d.%02d MB/s\r\n", _name, _bytes, us, rate / 100, rate % 100);
+}
+
+/* 开启或关闭SDRAM的MPU区域，关闭后SDRAM恢复默认的Device属性 */
+static void sdram_mpu_enable(uint8_t _enable)
+{
+    static const uint8_t s_region[] = {SDRAM_MPU_REGION, SDRAM_LCD_MPU_REGION};
+    uint8_t i;
+
+    /* 关闭前把Cache中的数据写回SDRAM */
+    SCB_CleanInvalidateDCache();
+
+    HAL_MPU_Disable();
+    for (i = 0; i < sizeof(s_region); i++)
+    {
+        MPU->RNR = s_region[i];
+        if (_enable)
         {
-            err++;
+            MPU->RASR |= MPU_RASR_ENABLE_Msk;
+        }
+        else
+        {
+            MPU->RASR &= ~MPU_RASR_ENABLE_Msk;
         }
     }
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+/*
+    memset/memcpy带宽测试，先用默认属性(不使用MPU区域)测试，再用MPU配置的Cache属性测试。
+    写入测试计入写回D-Cache的时间，读取测试前作废D-Cache，保证数据来自SDRAM。
+*/
+static void sdram_bench(uint32_t _size)
+{
+#define SDRAM_BENCH_SRAM_SIZE (32 * 1024)
 
-    if (err > 0)
+    uint8_t *sram, *app, *app2;
+    int64_t ticks;
+    uint32_t addr;
+    uint8_t pass;
+
+    if (_size < SDRAM_BENCH_SRAM_SIZE || _size > SDRAM_APP_SIZE / 4)
     {
-        return (4 * err);
+        _size = SDRAM_APP_SIZE / 4;
     }
+    _size &= ~(SDRAM_BENCH_SRAM_SIZE - 1);
 
-#if 0
-    /* 对SRAM 的数据求反并写入 */
-    pSRAM = (uint32_t *)SDRAM_APP_BUF;
-    for (i = 0; i < SDRAM_APP_SIZE / 4; i++)
+    sram = Mem_AllocAlign(MEM_AXI, SDRAM_BENCH_SRAM_SIZE, 32);
+    app = Mem_AllocAlign(MEM_SDRAM, _size, 32);
+    app2 = Mem_AllocAlign(MEM_SDRAM, _size, 32);
+    if (sram == NULL || app == NULL || app2 == NULL)
     {
-        *pSRAM = ~*pSRAM;
-        pSRAM++;
+        printf("Low memory! size = %d\r\n", _size);
+        Mem_Free(sram);
+        Mem_Free(app);
+        Mem_Free(app2);
+        return;
     }
+    memset(sram, 0x5A, SDRAM_BENCH_SRAM_SIZE);
 
-    /* 再次比较SDRAM的数据 */
-    err = 0;
-    pSRAM = (uint32_t *)SDRAM_APP_BUF;
-    for (i = 0; i < SDRAM_APP_SIZE / 4; i++)
+    for (pass = 0; pass < 2; pass++)
     {
-        if (*pSRAM++ != (~i))
+        sdram_mpu_enable(pass);
+        printf("%s\r\n", pass ? "MPU write back" : "default (device)");
+
+        ticks = get_system_ticks();
+        memset(app, 0xA5, _size);
+        SCB_CleanDCache();
+        sdram_bench_print("memset", _size, get_system_ticks() - ticks);
+
+        ticks = get_system_ticks();
+        for (addr = 0; addr < _size; addr += SDRAM_BENCH_SRAM_SIZE)
+        {
+            memcpy(app + addr, sram, SDRAM_BENCH_SRAM_SIZE);
+        }
+        SCB_CleanDCache();
+        sdram_bench_print("memcpy sram>sd", _size, get_system_ticks() - ticks);
+
+        SCB_InvalidateDCache_by_Addr((uint32_t *)app, _size);
+        ticks = get_system_ticks();
+        for (addr = 0; addr < _size; addr += SDRAM_BENCH_SRAM_SIZE)
         {
-            err++;
+            memcpy(sram, app + addr, SDRAM_BENCH_SRAM_SIZE);
         }
+        sdram_bench_print("memcpy sd>sram", _size, get_system_ticks() - ticks);
+
+        SCB_InvalidateDCache_by_Addr((uint32_t *)app, _size);
+        ticks = get_system_ticks();
+        memcpy(app2, app, _size);
+        SCB_CleanDCache();
+        sdram_bench_print("memcpy sd>sd", _size, get_system_ticks() - ticks);
     }
 
-    if (err >  0)
+    Mem_Free(sram);
+    Mem_Free(app);
+    Mem_Free(app2);
+}
+
+/* bytes/us 即 MB/s，保留两位小数 */
+static uint32_t sdram_rate(uint32_t _bytes, uint32_t _us)
+{
+    return (_us == 0) ? 0 : (uint32_t)((uint64_t)_bytes * 100 / _us);
+}
+
+/*
+    逐项执行SDRAM测试，打印每一项的结果、第一个错误和读写带宽。
+    _loops 次循环用于老化测试，出错时停止。
+*/
+static uint32_t sdram_test(uint32_t _addr, uint32_t _size, uint32_t _loops)
+{
+    static const char *s_name[] = {"data bus", "addr bus", "byte", "checker", "addr", "march C-"};
+    SDRAM_TEST_T res;
+    uint32_t loop, wr, rd, us;
+    int64_t ticks;
+    uint8_t i;
+
+    printf("SDRAM test 0x%08X - 0x%08X, %d loops\r\n", _addr, _addr + _size - 1, _loops);
+    ticks = get_system_ticks();
+    for (loop = 0; loop < _loops; loop++)
     {
-        return (4 * err);
+        for (i = 0; i < sizeof(s_name) / sizeof(s_name[0]); i++)
+        {
+            bsp_TestSDRAM(_addr, _size, 1UL << i, &res);
+
+            wr = sdram_rate(res.wr_bytes, res.wr_us);
+            rd = sdram_rate(res.rd_bytes, res.rd_us);
+            printf("%-8s %s  write %4d.%02d MB/s  read %4d.%02d MB/s\r\n", s_name[i],
+                   res.err ? "FAIL" : "ok  ", wr / 100, wr % 100, rd / 100, rd % 100);
+            if (res.err)
+            {
+                printf("  %d errors, first at 0x%08X expect 0x%08X read 0x%08X bits 0x%08X\r\n",
+                       res.err, res.addr, res.expect, res.read, res.expect ^ res.read);
+                return res.err;
+            }
+        }
     }
-#endif
+    us = SDRAM_TicksToUs(get_system_ticks() - ticks);
+    printf("pass, %d.%03d s\r\n", us / 1000000, us / 1000 % 1000);
 
-    /* 测试按字节方式访问, 目的是验证 FSMC_NBL0 、 FSMC_NBL1 口线 */
-    pBytes = (uint8_t *)SDRAM_APP_BUF;
-    for (i = 0; i < sizeof(ByteBuf); i++)
+    return 0;
+}
+
+static void sdram_timing_print(const SDRAM_TIMING_T *_pCfg)
+{
+    printf("CL%d pipe%d tRCD%d tRP%d tWR%d tRC%d", _pCfg->cas, _pCfg->rpipe,
+           _pCfg->trcd, _pCfg->trp, _pCfg->twr, _pCfg->trc);
+}
+
+/*
+    用候选时序测试 _loops 次，全部通过返回吞吐量(MB/s * 100)，失败返回0。
+    测试期间不打印，测试结束后恢复 _pSafe 时序，串口输出等不会受不稳定时序影响
+*/
+static uint32_t sdram_tune_try(const SDRAM_TIMING_T *_pCfg, const SDRAM_TIMING_T *_pSafe, uint32_t _addr, uint32_t _loops)
+{
+    SDRAM_TEST_T res;
+    uint32_t bytes = 0, us = 0;
+    uint32_t i, err = 0;
+
+    if (SDRAM_SetTiming(_pCfg) != 0)
     {
-        *pBytes++ = ByteBuf[i];
+        return 0;
     }
+    for (i = 0; i < _loops && err == 0; i++)
+    {
+        err = bsp_TestSDRAM(_addr, SDRAM_TUNE_SIZE, SDRAM_TEST_ALL, &res);
+        bytes += res.wr_bytes + res.rd_bytes;
+        us += res.wr_us + res.rd_us;
+    }
+    SDRAM_SetTiming(_pSafe);
 
-    /* 比较SDRAM的数据 */
-    err = 0;
-    pBytes = (uint8_t *)SDRAM_APP_BUF;
-    for (i = 0; i < sizeof(ByteBuf); i++)
+    sdram_timing_print(_pCfg);
+    if (err)
+    {
+        printf("  FAIL at 0x%08X bits 0x%08X\r\n", res.addr, res.expect ^ res.read);
+        return 0;
+    }
+    printf("  ok %4d.%02d MB/s\r\n", sdram_rate(bytes, us) / 100, sdram_rate(bytes, us) % 100);
+
+    return sdram_rate(bytes, us);
+}
+
+/*
+    时序自动调整：
+    1. 默认行时序下扫描全部 CAS Latency 和读管道延迟组合
+    2. 在最好的组合上逐个减小 tRCD、tRP、tWR、tRC，直到测试失败
+    吞吐量提高超过0.5%才替换，相同时保留更保守的配置
+*/
+static void sdram_tune(uint32_t _loops)
+{
+    SDRAM_TIMING_T safe, best, cfg;
+    uint32_t rate, best_rate;
+    uint8_t *buf, *p;
+    uint8_t i;
+
+    buf = Mem_AllocAlign(MEM_SDRAM, SDRAM_TUNE_SIZE, 1024);
+    if (buf == NULL)
+    {
+        printf("Low memory! size = %d\r\n", SDRAM_TUNE_SIZE);
+        return;
+    }
+
+    SDRAM_GetTiming(&safe);
+    printf("current: ");
+    sdram_timing_print(&safe);
+    printf("\r\n");
+
+    best = safe;
+    best_rate = sdram_tune_try(&safe, &safe, (uint32_t)buf, _loops);
+    if (best_rate == 0)
+    {
+        printf("current timing is not stable.\r\n");
+        Mem_Free(buf);
+        return;
+    }
+
+    cfg = safe;
+    for (cfg.cas = 3; cfg.cas >= 2; cfg.cas--)
     {
-        if (*pBytes++ != ByteBuf[i])
+        for (cfg.rpipe = 0; cfg.rpipe <= 2; cfg.rpipe++)
         {
-            err++;
+            if (cfg.cas == safe.cas && cfg.rpipe == safe.rpipe)
+            {
+                continue;
+            }
+            rate = sdram_tune_try(&cfg, &safe, (uint32_t)buf, _loops);
+            if (rate > best_rate + best_rate / 200)
+            {
+                best = cfg;
+                best_rate = rate;
+            }
         }
     }
-    if (err > 0)
+
+    /* 逐个减小行时序参数 */
+    for (i = 0; i < 4; i++)
     {
-        return err;
+        cfg = best;
+        p = (i == 0) ? &cfg.trcd : (i == 1) ? &cfg.trp : (i == 2) ? &cfg.twr : &cfg.trc;
+        while (*p > 1)
+        {
+            (*p)--;
+            rate = sdram_tune_try(&cfg, &safe, (uint32_t)buf, _loops);
+            if (rate == 0)
+            {
+                break;
+            }
+            if (rate > best_rate + best_rate / 200)
+            {
+                best = cfg;
+                best_rate = rate;
+            }
+        }
     }
-    return 0;
+
+    SDRAM_SetTiming(&best);
+    Mem_Free(buf);
+
+    printf("best: ");
+    sdram_timing_print(&best);
+    printf("  %d.%02d MB/s, \"sdram tune save\" to keep it.\r\n", best_rate / 100, best_rate % 100);
 }
 
-#if defined(__SHELL_H__) && defined(DEBUG_MODE)
 static int _cmd(int argc, char *argv[])
 {
     const char *help_info[] = {
         "set init/deinit",
-        "test 1/2",
+        "test 1/2 [loops]",
         "read bit32/buff",
-        "write bit32/buff"};
+        "write bit32/buff",
+        "bench [size]",
+        "tune [loops]/save/clear"};
 
     // printf("\r\nargc = %d\r\n\r\n", argc);
 
-    if (!strcmp(argv[1], "set"))
+    if (argc > 1 && !strcmp(argv[1], "bench"))
+    {
+        sdram_bench(argc > 2 ? strtoul(argv[2], NULL, 0) : 1024 * 1024);
+
+        return 0;
+    }
+    else if (argc > 1 && !strcmp(argv[1], "tune"))
+    {
+        if (argc > 2 && !strcmp(argv[2], "save"))
+        {
+            return SDRAM_SaveTiming();
+        }
+        else if (argc > 2 && !strcmp(argv[2], "clear"))
+        {
+            KV_Delete(SDRAM_TIMING_KEY);
+            printf("default timing after reset.\r\n");
+
+            return 0;
+        }
+        sdram_tune(argc > 2 ? strtoul(argv[2], NULL, 0) : 3);
+
+        return 0;
+    }
+    else if (!strcmp(argv[1], "set"))
     {
         if (!strcmp(argv[2], "init"))
         {
@@ -630,13 +1340,33 @@ static int _cmd(int argc, char *argv[])
     }
     else if (!strcmp(argv[1], "test"))
     {
+        MEM_STAT_T st;
+        uint32_t err;
+
+        /* 测试改写整个SDRAM堆，有未释放的内存时不能测试 */
+        Mem_GetStat(MEM_SDRAM, &st);
+        if (st.used != 0)
+        {
+            printf("SDRAM heap in use, %d bytes.\r\n", st.used);
+            return -1;
+        }
+
         if (!strcmp(argv[2], "1"))
         {
-            return bsp_TestExtSDRAM1();
+            err = sdram_test(EXT_SDRAM_ADDR, EXT_SDRAM_SIZE, argc > 3 ? strtoul(argv[3], NULL, 0) : 1);
+
+            /* 全片测试改写了显存和QSPI读缓存 */
+            QSPI_CacheClear();
+            Mem_InitHeap(MEM_SDRAM);
+
+            return err;
         }
         else if (!strcmp(argv[2], "2"))
         {
-            return bsp_TestExtSDRAM2();
+            err = sdram_test(SDRAM_APP_BUF, SDRAM_APP_SIZE, argc > 3 ? strtoul(argv[3], NULL, 0) : 1);
+            Mem_InitHeap(MEM_SDRAM);
+
+            return err;
         }
         else
         {
@@ -756,7 +1486,7 @@ static int _cmd(int argc, char *argv[])
     return -1;
 }
 // 导出到命令列表里
-SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), sdram, _cmd, sdram[set test read write]);
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), sdram, _cmd, sdram[set test read write bench tune]);
 #endif // #ifdef DEBUG_MODE
 
 /***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,511 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 抗锯齿字库模块
+*    文件名称 : bsp_font.c
+*    版    本 : V1.0
+*    说    明 : 显示QSPI Flash资源包中的A4/A8抗锯齿字库，字库由 Tools/font_gen.py 从TTF生成。
+*               1. 字库文件：FONT_HEAD_T + 按编码排序的 FONT_GLYPH_T 索引 + 点阵数据。打开字库时索引加载到
+*                  SDRAM，按Unicode编码二分查找，GB2312约7500字的索引约120KB
+*               2. 点阵按需从QSPI Flash读取，缓存在SDRAM中。缓存为组相联，编码低位选组，组内替换最久未用的
+*                  字形。被替换的字形可能还在DMA2D队列中等待绘制，替换前等待它的队列位置(栅栏)完成
+*               3. 绘制用DMA2D A4/A8 前景混合，颜色和整体透明度由参数给出，字符串为UTF-8编码
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_font.h"
+
+#define FONT_EMPTY 0xFFFFFFFFUL /* 空缓存块的编码 */
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_Open
+*    功能说明: 打开资源包中的字库，加载字形索引，分配字形缓存
+*    形    参: _pName : 资源名，字库用 asset_pack.py --raw 打包(不能压缩)
+*              _pFont : 字库
+*    返 回 值: 0 表示成功，-1 表示没有找到或格式错误，-2 表示内存不足
+*********************************************************************************************************
+*/
+int FONT_Open(const char *_pName, FONT_T *_pFont)
+{
+    ASSET_T asset;
+    FONT_HEAD_T *h = &_pFont->head;
+    uint32_t i;
+
+    memset(_pFont, 0, sizeof(FONT_T));
+    if (Asset_Open(_pName, &asset) != 0 || asset.method != ASSET_METHOD_RAW || asset.size < sizeof(FONT_HEAD_T))
+    {
+        return -1;
+    }
+
+    _pFont->addr = ASSET_FLASH_ADDR + asset.offset;
+    QSPI_ReadBuffer((uint8_t *)h, _pFont->addr, sizeof(FONT_HEAD_T));
+    if (h->magic != FONT_MAGIC || h->version != FONT_VERSION || (h->bpp != 4 && h->bpp != 8) ||
+        h->num == 0 || sizeof(FONT_HEAD_T) + h->num * sizeof(FONT_GLYPH_T) > h->data || h->data > asset.size)
+    {
+        return -1;
+    }
+
+    /* A4每行按偶数个像素存储，缓存块32字节对齐 */
+    _pFont->slot_size = (((h->max_w + 1) & ~1) * h->max_h * h->bpp / 8 + 31) & ~31UL;
+    _pFont->glyph = Mem_Alloc(MEM_SDRAM, h->num * sizeof(FONT_GLYPH_T));
+    _pFont->slot = Mem_Alloc(MEM_SDRAM, FONT_CACHE_SETS * FONT_CACHE_WAYS * sizeof(FONT_SLOT_T));
+    _pFont->cache = Mem_AllocAlign(MEM_SDRAM, FONT_CACHE_SETS * FONT_CACHE_WAYS * _pFont->slot_size, 32);
+    if (_pFont->glyph == NULL || _pFont->slot == NULL || _pFont->cache == NULL)
+    {
+        FONT_Close(_pFont);
+        return -2;
+    }
+
+    QSPI_ReadBuffer((uint8_t *)_pFont->glyph, _pFont->addr + sizeof(FONT_HEAD_T), h->num * sizeof(FONT_GLYPH_T));
+    for (i = 0; i < FONT_CACHE_SETS * FONT_CACHE_WAYS; i++)
+    {
+        _pFont->slot[i].bitmap = _pFont->cache + i * _pFont->slot_size;
+    }
+    FONT_Flush(_pFont);
+    _pFont->missing = FONT_FindGlyph(_pFont, '?');
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_Close
+*    功能说明: 关闭字库，释放索引和缓存。DMA2D队列中的绘制命令还在使用缓存，先等待完成
+*    形    参: _pFont : 字库
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void FONT_Close(FONT_T *_pFont)
+{
+    GFX_Wait();
+    Mem_Free(_pFont->glyph);
+    Mem_Free(_pFont->slot);
+    Mem_Free(_pFont->cache);
+    _pFont->glyph = NULL;
+    _pFont->slot = NULL;
+    _pFont->cache = NULL;
+    _pFont->head.num = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_Flush
+*    功能说明: 清空字形缓存和统计，用于测试未命中时的速度
+*    形    参: _pFont : 字库
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void FONT_Flush(FONT_T *_pFont)
+{
+    uint32_t i;
+
+    GFX_Wait();
+    for (i = 0; i < FONT_CACHE_SETS * FONT_CACHE_WAYS; i++)
+    {
+        _pFont->slot[i].code = FONT_EMPTY;
+        _pFont->slot[i].stamp = 0;
+        _pFont->slot[i].fence = GFX_GetFence();
+    }
+    _pFont->stamp = 0;
+    _pFont->hit = 0;
+    _pFont->miss = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_DecodeUtf8
+*    功能说明: 读取一个UTF-8字符，指针移到下一个字符。编码错误的字节按一个字符返回 0xFFFD
+*    形    参: _ppStr : 字符串指针的地址
+*    返 回 值: Unicode编码，0 表示字符串结束
+*********************************************************************************************************
+*/
+uint32_t FONT_DecodeUtf8(const char **_ppStr)
+{
+    const uint8_t *p = (const uint8_t *)*_ppStr;
+    uint32_t code;
+    uint8_t n, i;
+
+    if (*p == 0)
+    {
+        return 0;
+    }
+    if (*p < 0x80)
+    {
+        *_ppStr += 1;
+        return *p;
+    }
+
+    if ((*p & 0xE0) == 0xC0)
+    {
+        code = *p & 0x1F;
+        n = 1;
+    }
+    else if ((*p & 0xF0) == 0xE0)
+    {
+        code = *p & 0x0F;
+        n = 2;
+    }
+    else if ((*p & 0xF8) == 0xF0)
+    {
+        code = *p & 0x07;
+        n = 3;
+    }
+    else
+    {
+        *_ppStr += 1;
+        return 0xFFFD;
+    }
+
+    for (i = 1; i <= n; i++)
+    {
+        if ((p[i] & 0xC0) != 0x80)
+        {
+            *_ppStr += i; /* 后续字节不完整，不越过结束符 */
+            return 0xFFFD;
+        }
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+    *_ppStr += n + 1;
+
+    return code;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_FindGlyph
+*    功能说明: 在字形索引中二分查找
+*    形    参: _pFont : 字库
+*              _code : Unicode编码
+*    返 回 值: 字形索引，NULL 表示字库中没有该字
+*********************************************************************************************************
+*/
+const FONT_GLYPH_T *FONT_FindGlyph(const FONT_T *_pFont, uint32_t _code)
+{
+    uint32_t lo = 0, hi = _pFont->head.num, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (_pFont->glyph[mid].code < _code)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return (lo < _pFont->head.num && _pFont->glyph[lo].code == _code) ? &_pFont->glyph[lo] : NULL;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_GetSlot
+*    功能说明: 在缓存中查找字形，没有时替换组内最久未用的块，从QSPI Flash读取点阵
+*    形    参: _pFont : 字库
+*              _pGlyph : 字形索引
+*    返 回 值: 缓存块
+*********************************************************************************************************
+*/
+static FONT_SLOT_T *FONT_GetSlot(FONT_T *_pFont, const FONT_GLYPH_T *_pGlyph)
+{
+    FONT_SLOT_T *set = &_pFont->slot[(_pGlyph->code & (FONT_CACHE_SETS - 1)) * FONT_CACHE_WAYS];
+    FONT_SLOT_T *s = &set[0];
+    uint8_t i;
+
+    _pFont->stamp++;
+    for (i = 0; i < FONT_CACHE_WAYS; i++)
+    {
+        if (set[i].code == _pGlyph->code)
+        {
+            _pFont->hit++;
+            set[i].stamp = _pFont->stamp;
+            return &set[i];
+        }
+        if (set[i].stamp < s->stamp)
+        {
+            s = &set[i];
+        }
+    }
+
+    /* 替换前等待使用该块的DMA2D命令完成 */
+    _pFont->miss++;
+    while (!GFX_FenceDone(s->fence))
+    {
+    }
+    QSPI_ReadBuffer(s->bitmap, _pFont->addr + _pFont->head.data + _pGlyph->offset,
+                    ((_pGlyph->w + 1) & ~1) * _pGlyph->h * _pFont->head.bpp / 8);
+    s->code = _pGlyph->code;
+    s->glyph = _pGlyph;
+    s->stamp = _pFont->stamp;
+
+    return s;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_DrawChar
+*    功能说明: 显示一个字符。点阵作为DMA2D前景透明度，与目标图像混合
+*    形    参: _pFont : 字库
+*              _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444
+*              _x : 画笔位置
+*              _y : 行的上边，基线在 _y + ascent
+*              _code : Unicode编码
+*              _argb : 颜色，最高字节为整体透明度
+*    返 回 值: 画笔前进的像素数
+*********************************************************************************************************
+*/
+uint8_t FONT_DrawChar(FONT_T *_pFont, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint32_t _code, uint32_t _argb)
+{
+    const FONT_GLYPH_T *g = FONT_FindGlyph(_pFont, _code);
+    FONT_SLOT_T *s;
+    GFX_SURFACE_T mask;
+
+    if (g == NULL)
+    {
+        g = _pFont->missing;
+        if (g == NULL)
+        {
+            return _pFont->head.size / 2;
+        }
+    }
+    if (g->w == 0 || g->h == 0)
+    {
+        return g->advance; /* 空格 */
+    }
+
+    s = FONT_GetSlot(_pFont, g);
+    GFX_InitSurface(&mask, (uint32_t)s->bitmap, (g->w + 1) & ~1, g->h, (_pFont->head.bpp == 4) ? GFX_A4 : GFX_A8);
+    GFX_BlendMask(_pDst, _x + g->left, _y + _pFont->head.ascent - g->top, &mask, 0, 0, g->w, g->h, _argb);
+    s->fence = GFX_GetFence();
+
+    return g->advance;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_DrawString
+*    功能说明: 显示UTF-8字符串，'\n' 换行到 _x。超出目标图像的部分被裁剪
+*    形    参: _pFont : 字库
+*              _pDst : 目标图像
+*              _x, _y : 第一行的左上角
+*              _pStr : 字符串
+*              _argb : 颜色
+*    返 回 值: 最后一个字符之后的画笔位置
+*********************************************************************************************************
+*/
+int16_t FONT_DrawString(FONT_T *_pFont, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, const char *_pStr, uint32_t _argb)
+{
+    int16_t x = _x;
+    uint32_t code;
+
+    while ((code = FONT_DecodeUtf8(&_pStr)) != 0)
+    {
+        if (code == '\n')
+        {
+            x = _x;
+            _y += _pFont->head.line_height;
+            continue;
+        }
+        x += FONT_DrawChar(_pFont, _pDst, x, _y, code, _argb);
+    }
+
+    return x;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FONT_TextWidth
+*    功能说明: 计算单行UTF-8字符串的显示宽度，用于对齐
+*    形    参: _pFont : 字库
+*              _pStr : 字符串
+*    返 回 值: 宽度，像素
+*********************************************************************************************************
+*/
+uint16_t FONT_TextWidth(const FONT_T *_pFont, const char *_pStr)
+{
+    const FONT_GLYPH_T *g;
+    uint16_t w = 0;
+    uint32_t code;
+
+    while ((code = FONT_DecodeUtf8(&_pStr)) != 0 && code != '\n')
+    {
+        g = FONT_FindGlyph(_pFont, code);
+        if (g == NULL)
+        {
+            g = _pFont->missing;
+        }
+        w += (g != NULL) ? g->advance : _pFont->head.size / 2;
+    }
+
+    return w;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+static FONT_T s_tShellFont;
+static char s_cShellFont[ASSET_NAME_MAX];
+
+/* 打开字库，与上次打开的相同时不重新加载 */
+static int font_open(const char *_pName)
+{
+    int ret;
+
+    if (s_tShellFont.glyph != NULL && !strcmp(s_cShellFont, _pName))
+    {
+        return 0;
+    }
+    if (s_tShellFont.glyph != NULL)
+    {
+        FONT_Close(&s_tShellFont);
+    }
+
+    ret = FONT_Open(_pName, &s_tShellFont);
+    if (ret != 0)
+    {
+        printf("%s %s, make with: font_gen.py font.ttf 24 %s.fnt, asset_pack.py --raw %s.fnt\r\n",
+               _pName, (ret == -2) ? "no memory" : "not found", _pName, _pName);
+        return -1;
+    }
+    strncpy(s_cShellFont, _pName, sizeof(s_cShellFont) - 1);
+
+    return 0;
+}
+
+/* 按字库中的编码顺序铺满屏幕，返回绘制的字数 */
+static uint32_t font_fill(FONT_T *_pFont, const GFX_SURFACE_T *_pDst, uint32_t _uiStart, uint32_t _uiNum)
+{
+    int16_t x = 0, y = 0;
+    uint32_t i;
+
+    for (i = 0; i < _uiNum; i++)
+    {
+        const FONT_GLYPH_T *g = &_pFont->glyph[(_uiStart + i) % _pFont->head.num];
+
+        if (x + g->advance > _pDst->width)
+        {
+            x = 0;
+            y += _pFont->head.line_height;
+            if (y + _pFont->head.line_height > _pDst->height)
+            {
+                y = 0;
+            }
+        }
+        x += FONT_DrawChar(_pFont, _pDst, x, y, g->code, GFX_RGB(255, 255, 255));
+    }
+    GFX_Wait();
+
+    return i;
+}
+
+/* 打印速度和缓存命中率 */
+static void font_print(const char *_name, FONT_T *_pFont, uint32_t _num, int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    printf("%-6s: %5d glyphs %7d us %7d glyphs/s, hit %d miss %d\r\n", _name, _num, us,
+           (uint32_t)((uint64_t)_num * 1000000 / us), _pFont->hit, _pFont->miss);
+}
+
+static int cmd_font(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "font show name text [x y]",
+        "font bench name [glyphs]"};
+
+    GFX_SURFACE_T lcd;
+    int64_t ticks;
+
+    if (argc < 3)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+        return -1;
+    }
+    if (font_open(argv[2]) != 0)
+    {
+        return -1;
+    }
+    TFT_GetLayer(0, &lcd);
+
+    if (!strcmp(argv[1], "show"))
+    {
+        int16_t x = (argc > 5) ? atoi(argv[4]) : 0;
+        int16_t y = (argc > 5) ? atoi(argv[5]) : 0;
+
+        if (argc < 4)
+        {
+            printf("Error Command.\r\n%s\r\n", help_info[0]);
+            return -1;
+        }
+        FONT_DrawString(&s_tShellFont, &lcd, x, y, argv[3], GFX_RGB(255, 255, 255));
+        GFX_Wait();
+        printf("width %d, hit %d miss %d\r\n", FONT_TextWidth(&s_tShellFont, argv[3]), s_tShellFont.hit, s_tShellFont.miss);
+
+        return 0;
+    }
+    else if (!strcmp(argv[1], "bench"))
+    {
+        /* 不超过缓存容量的字数，第一遍全部从Flash读取，第二遍全部命中 */
+        uint32_t num = (argc > 3) ? strtoul(argv[3], NULL, 0) : FONT_CACHE_SETS * FONT_CACHE_WAYS / 2;
+        const char *str = "Hello, 世界! 抗锯齿字库 DMA2D A4/A8 混合 0123456789\n";
+
+        if (num == 0)
+        {
+            num = 1;
+        }
+        GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_RGB(0, 0, 64));
+        FONT_Flush(&s_tShellFont);
+        ticks = get_system_ticks();
+        font_fill(&s_tShellFont, &lcd, 0, num);
+        font_print("cold", &s_tShellFont, num, get_system_ticks() - ticks);
+
+        s_tShellFont.hit = 0;
+        s_tShellFont.miss = 0;
+        ticks = get_system_ticks();
+        font_fill(&s_tShellFont, &lcd, 0, num);
+        font_print("warm", &s_tShellFont, num, get_system_ticks() - ticks);
+
+        /* 每个字都不在缓存中的最坏情况：依次显示整个字库，超过缓存容量 */
+        s_tShellFont.hit = 0;
+        s_tShellFont.miss = 0;
+        ticks = get_system_ticks();
+        font_fill(&s_tShellFont, &lcd, num, s_tShellFont.head.num);
+        font_print("all", &s_tShellFont, s_tShellFont.head.num, get_system_ticks() - ticks);
+
+        FONT_DrawString(&s_tShellFont, &lcd, 0, lcd.height - s_tShellFont.head.line_height, str, GFX_RGB(255, 255, 0));
+        GFX_Wait();
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), font, cmd_font, font[show bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,889 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA2D图形加速模块
+*    文件名称 : bsp_gfx.c
+*    版    本 : V1.0
+*    说    明 : 用Chrom-ART(DMA2D)实现矩形填充、图像拷贝、像素格式转换和透明度混合。
+*               1. 绘图函数只把DMA2D寄存器值写入命令队列，CPU不等待，DMA2D传输完成中断中启动下一条命令。
+*                  队列满时才等待，需要读取结果时调用 GFX_Wait
+*               2. 所有坐标按目标和源图像大小裁剪
+*               3. 提交命令前写回源区域的D-Cache，写回并作废目标区域的D-Cache，Write back区域(SDRAM中的
+*                  后台缓冲区等)里DMA2D的结果不会被Cache中的旧数据覆盖或遮挡。CPU要读取目标区域时先调用
+*                  GFX_Wait，DMA2D执行期间不要读写目标区域。CPU直接改写Write back区域后调用 GFX_FlushCache
+*               4. 绘图函数不能在中断中调用
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_gfx.h"
+#include "bsp_fmc_sdram.h"
+
+/* DMA2D工作模式，CR寄存器MODE字段 */
+#define GFX_MODE_M2M (0UL << DMA2D_CR_MODE_Pos)       /* 拷贝 */
+#define GFX_MODE_M2M_PFC (1UL << DMA2D_CR_MODE_Pos)   /* 拷贝并转换像素格式 */
+#define GFX_MODE_M2M_BLEND (2UL << DMA2D_CR_MODE_Pos) /* 前景与背景混合 */
+#define GFX_MODE_R2M (3UL << DMA2D_CR_MODE_Pos)       /* 填充 */
+
+#define GFX_AM_REPLACE (1UL << DMA2D_FGPFCCR_AM_Pos)  /* 用ALPHA字段替换像素的透明度 */
+#define GFX_AM_MULTIPLY (2UL << DMA2D_FGPFCCR_AM_Pos) /* 像素的透明度乘以ALPHA字段 */
+
+#define GFX_CM_YCBCR 0x0BUL /* 前景YCbCr格式，JPEG解码输出的MCU块 */
+
+/* 一条DMA2D命令，启动时依次写入寄存器 */
+typedef struct
+{
+    uint32_t cr;
+    uint32_t fgmar;
+    uint32_t fgor;
+    uint32_t fgpfccr;
+    uint32_t fgcolr;
+    uint32_t bgmar;
+    uint32_t bgor;
+    uint32_t bgpfccr;
+    uint32_t opfccr;
+    uint32_t ocolr;
+    uint32_t omar;
+    uint32_t oor;
+    uint32_t nlr;
+    const uint32_t *clut; /* 前景颜色表，NULL表示不需要 */
+    uint16_t clut_num;
+} GFX_CMD_T;
+
+static GFX_CMD_T s_tQueue[GFX_QUEUE_SIZE];
+static volatile uint16_t s_usHead = 0; /* 写入位置，只由主程序修改 */
+static volatile uint16_t s_usTail = 0; /* 执行位置，只由中断修改 */
+static volatile uint8_t s_ucBusy = 0;  /* 1: DMA2D正在执行队列中的命令 */
+static volatile uint32_t s_uiError = 0; /* 传输错误、配置错误次数 */
+
+/* 每个像素的位数 */
+static const uint8_t s_ucBits[GFX_FMT_NUM] = {32, 24, 16, 16, 16, 8, 8, 16, 4, 8, 4};
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitGfx
+*    功能说明: 使能DMA2D时钟和中断
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitGfx(void)
+{
+    __HAL_RCC_DMA2D_CLK_ENABLE();
+
+    s_usHead = 0;
+    s_usTail = 0;
+    s_ucBusy = 0;
+
+    HAL_NVIC_SetPriority(DMA2D_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_InitSurface
+*    功能说明: 初始化图像描述，每行像素数等于宽度，没有颜色表
+*    形    参: _pSurf : 图像
+*              _addr : 第一个像素的地址
+*              _usWidth, _usHeight : 宽度和高度
+*              _fmt : 像素格式
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_InitSurface(GFX_SURFACE_T *_pSurf, uint32_t _addr, uint16_t _usWidth, uint16_t _usHeight, GFX_FMT_E _fmt)
+{
+    _pSurf->addr = _addr;
+    _pSurf->width = _usWidth;
+    _pSurf->height = _usHeight;
+    _pSurf->pitch = _usWidth;
+    _pSurf->format = _fmt;
+    _pSurf->clut = NULL;
+    _pSurf->clut_num = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_BitsPerPixel
+*    功能说明: 返回像素格式的位数
+*    形    参: _fmt : 像素格式
+*    返 回 值: 每个像素的位数，4 - 32
+*********************************************************************************************************
+*/
+uint8_t GFX_BitsPerPixel(GFX_FMT_E _fmt)
+{
+    return (_fmt < GFX_FMT_NUM) ? s_ucBits[_fmt] : 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_ColorFromARGB
+*    功能说明: ARGB8888颜色转换为输出格式的像素值
+*    形    参: _fmt : GFX_ARGB8888 / GFX_RGB888 / GFX_RGB565 / GFX_ARGB1555 / GFX_ARGB4444 /
+*                     GFX_L8 / GFX_AL44 / GFX_A8
+*              _argb : ARGB8888颜色。索引格式时低8位为颜色表序号，AL44取高4位透明度和低4位序号
+*    返 回 值: 像素值
+*********************************************************************************************************
+*/
+uint32_t GFX_ColorFromARGB(GFX_FMT_E _fmt, uint32_t _argb)
+{
+    uint32_t a = _argb >> 24;
+    uint32_t r = (_argb >> 16) & 0xFF;
+    uint32_t g = (_argb >> 8) & 0xFF;
+    uint32_t b = _argb & 0xFF;
+
+    switch (_fmt)
+    {
+    case GFX_RGB888:
+        return _argb & 0xFFFFFF;
+
+    case GFX_RGB565:
+        return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+
+    case GFX_ARGB1555:
+        return ((a >> 7) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+
+    case GFX_ARGB4444:
+        return ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+
+    case GFX_L8:
+        return b;
+
+    case GFX_AL44:
+        return ((a >> 4) << 4) | (b & 0x0F);
+
+    case GFX_A8:
+        return a;
+
+    default:
+        return _argb;
+    }
+}
+
+/* 像素(x, y)的地址，4位格式的x为偶数 */
+static uint32_t GFX_PixelAddr(const GFX_SURFACE_T *_pSurf, int32_t _x, int32_t _y)
+{
+    return _pSurf->addr + ((uint32_t)_y * _pSurf->pitch + _x) * s_ucBits[_pSurf->format] / 8;
+}
+
+/* 写回源区域所在的D-Cache，DMA2D读到CPU写入的数据 */
+static void GFX_CleanRect(const GFX_SURFACE_T *_pSurf, int32_t _x, int32_t _y, int32_t _w, int32_t _h)
+{
+    uint32_t start = GFX_PixelAddr(_pSurf, _x, _y) & ~31UL;
+    uint32_t end = GFX_PixelAddr(_pSurf, _x + _w, _y + _h - 1);
+
+    SCB_CleanDCache_by_Addr((uint32_t *)start, end - start);
+}
+
+/* 写回并作废目标区域所在的D-Cache: CPU写入的数据先到达显存，DMA2D写入后CPU读到新数据，
+   Write back区域中的脏行也不会在之后被换出时覆盖DMA2D的结果 */
+static void GFX_FlushRect(const GFX_SURFACE_T *_pSurf, int32_t _x, int32_t _y, int32_t _w, int32_t _h)
+{
+    uint32_t start = GFX_PixelAddr(_pSurf, _x, _y) & ~31UL;
+    uint32_t end = GFX_PixelAddr(_pSurf, _x + _w, _y + _h - 1);
+
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)start, end - start);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Clip
+*    功能说明: 按目标图像和源图像的大小裁剪矩形
+*    形    参: _pDst : 目标图像
+*              _x, _y : 目标坐标，返回裁剪后的值
+*              _pSrc : 源图像，NULL表示没有源图像(填充)
+*              _sx, _sy : 源坐标，返回裁剪后的值
+*              _w, _h : 宽度和高度，返回裁剪后的值
+*    返 回 值: 0 表示没有需要绘制的像素
+*********************************************************************************************************
+*/
+static uint8_t GFX_Clip(const GFX_SURFACE_T *_pDst, int32_t *_x, int32_t *_y,
+                        const GFX_SURFACE_T *_pSrc, int32_t *_sx, int32_t *_sy, int32_t *_w, int32_t *_h)
+{
+    if (*_x < 0)
+    {
+        *_w += *_x;
+        *_sx -= *_x;
+        *_x = 0;
+    }
+    if (*_y < 0)
+    {
+        *_h += *_y;
+        *_sy -= *_y;
+        *_y = 0;
+    }
+    if (_pSrc != NULL)
+    {
+        if (*_sx < 0)
+        {
+            *_w += *_sx;
+            *_x -= *_sx;
+            *_sx = 0;
+        }
+        if (*_sy < 0)
+        {
+            *_h += *_sy;
+            *_y -= *_sy;
+            *_sy = 0;
+        }
+        if (*_sx + *_w > _pSrc->width)
+        {
+            *_w = _pSrc->width - *_sx;
+        }
+        if (*_sy + *_h > _pSrc->height)
+        {
+            *_h = _pSrc->height - *_sy;
+        }
+    }
+    if (*_x + *_w > _pDst->width)
+    {
+        *_w = _pDst->width - *_x;
+    }
+    if (*_y + *_h > _pDst->height)
+    {
+        *_h = _pDst->height - *_y;
+    }
+
+    return (*_w > 0 && *_h > 0);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_FlushCache
+*    功能说明: 写回并作废矩形区域的D-Cache。CPU在Write back区域中绘制后调用，LTDC和DMA2D读到新的像素；
+*              DMA2D完成后CPU要改写同一区域时调用，作废DMA2D执行期间预取的旧数据
+*    形    参: _pSurf : 图像
+*              _x, _y : 左上角坐标
+*              _w, _h : 宽度和高度，按图像大小裁剪
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_FlushCache(const GFX_SURFACE_T *_pSurf, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h)
+{
+    int32_t x = _x, y = _y, sx = 0, sy = 0, w = _w, h = _h;
+
+    if (GFX_Clip(_pSurf, &x, &y, NULL, &sx, &sy, &w, &h))
+    {
+        GFX_FlushRect(_pSurf, x, y, w, h);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Start
+*    功能说明: 把命令写入DMA2D寄存器并启动。需要颜色表时先由CPU写入FGCLUT，DMA2D空闲时才调用
+*    形    参: _pCmd : 命令
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC static void GFX_Start(const GFX_CMD_T *_pCmd)
+{
+    uint16_t i;
+
+    for (i = 0; i < _pCmd->clut_num; i++)
+    {
+        DMA2D->FGCLUT[i] = _pCmd->clut[i];
+    }
+
+    DMA2D->FGMAR = _pCmd->fgmar;
+    DMA2D->FGOR = _pCmd->fgor;
+    DMA2D->FGPFCCR = _pCmd->fgpfccr;
+    DMA2D->FGCOLR = _pCmd->fgcolr;
+    DMA2D->BGMAR = _pCmd->bgmar;
+    DMA2D->BGOR = _pCmd->bgor;
+    DMA2D->BGPFCCR = _pCmd->bgpfccr;
+    DMA2D->OPFCCR = _pCmd->opfccr;
+    DMA2D->OCOLR = _pCmd->ocolr;
+    DMA2D->OMAR = _pCmd->omar;
+    DMA2D->OOR = _pCmd->oor;
+    DMA2D->NLR = _pCmd->nlr;
+    DMA2D->CR = _pCmd->cr | DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE | DMA2D_CR_START;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Submit
+*    功能说明: 命令放入队列，DMA2D空闲时立即启动。队列满时等待
+*    形    参: _pCmd : 命令
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void GFX_Submit(const GFX_CMD_T *_pCmd)
+{
+    uint32_t primask;
+
+    while ((uint16_t)(s_usHead - s_usTail) >= GFX_QUEUE_SIZE)
+    {
+    }
+
+    s_tQueue[s_usHead & (GFX_QUEUE_SIZE - 1)] = *_pCmd;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    s_usHead++;
+    if (!s_ucBusy)
+    {
+        s_ucBusy = 1;
+        GFX_Start(&s_tQueue[s_usTail & (GFX_QUEUE_SIZE - 1)]);
+    }
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: DMA2D_IRQHandler
+*    功能说明: DMA2D传输完成或出错，启动队列中的下一条命令
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void DMA2D_IRQHandler(void)
+{
+    uint32_t isr = DMA2D->ISR;
+
+    DMA2D->IFCR = isr & (DMA2D_IFCR_CTEIF | DMA2D_IFCR_CTCIF | DMA2D_IFCR_CAECIF |
+                         DMA2D_IFCR_CCTCIF | DMA2D_IFCR_CCEIF);
+    if (isr & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF))
+    {
+        s_uiError++;
+    }
+    if (!(isr & (DMA2D_ISR_TCIF | DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)))
+    {
+        return;
+    }
+
+    s_usTail++;
+    if (s_usTail != s_usHead)
+    {
+        GFX_Start(&s_tQueue[s_usTail & (GFX_QUEUE_SIZE - 1)]);
+    }
+    else
+    {
+        s_ucBusy = 0;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_FillRect
+*    功能说明: 用颜色填充矩形(DMA2D寄存器到存储器模式)。DMA2D不能输出8位格式，
+*              L8 / AL44 / A8 等待队列完成后由CPU逐行填充
+*    形    参: _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444 / L8 / AL44 / A8
+*              _x, _y : 左上角坐标
+*              _w, _h : 宽度和高度
+*              _argb : ARGB8888颜色，按目标格式转换
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_FillRect(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h, uint32_t _argb)
+{
+    GFX_CMD_T cmd = {0};
+    int32_t x = _x, y = _y, sx = 0, sy = 0, w = _w, h = _h;
+    uint8_t val;
+
+    if (s_ucBits[_pDst->format] == 8)
+    {
+        if (!GFX_Clip(_pDst, &x, &y, NULL, &sx, &sy, &w, &h))
+        {
+            return;
+        }
+        val = GFX_ColorFromARGB((GFX_FMT_E)_pDst->format, _argb);
+        GFX_Wait();
+        for (; h > 0; h--, y++)
+        {
+            memset((uint8_t *)GFX_PixelAddr(_pDst, x, y), val, w);
+        }
+        return;
+    }
+
+    if (_pDst->format > GFX_ARGB4444 || !GFX_Clip(_pDst, &x, &y, NULL, &sx, &sy, &w, &h))
+    {
+        return;
+    }
+    GFX_FlushRect(_pDst, x, y, w, h);
+
+    cmd.cr = GFX_MODE_R2M;
+    cmd.opfccr = _pDst->format;
+    cmd.ocolr = GFX_ColorFromARGB((GFX_FMT_E)_pDst->format, _argb);
+    cmd.omar = GFX_PixelAddr(_pDst, x, y);
+    cmd.oor = _pDst->pitch - w;
+    cmd.nlr = ((uint32_t)w << DMA2D_NLR_PL_Pos) | h;
+    GFX_Submit(&cmd);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Blit
+*    功能说明: 拷贝图像，格式不同时转换像素格式(如 ARGB8888/RGB888/L8 转 RGB565)，不做透明度混合。
+*              格式相同时直接拷贝，L8 / AL44 / AL88 / A8 只能拷贝到相同格式
+*    形    参: _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444，
+*                      或与源图像相同的8位、16位格式
+*              _x, _y : 目标坐标
+*              _pSrc : 源图像，任意格式，索引格式需要颜色表
+*              _sx, _sy : 源坐标
+*              _w, _h : 宽度和高度
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_Blit(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+              const GFX_SURFACE_T *_pSrc, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h)
+{
+    GFX_CMD_T cmd = {0};
+    int32_t x = _x, y = _y, sx = _sx, sy = _sy, w = _w, h = _h;
+
+    /* 存储器到存储器模式按前景格式的位数拷贝，不转换格式 */
+    if ((_pDst->format > GFX_ARGB4444 && (_pDst->format != _pSrc->format || s_ucBits[_pDst->format] < 8)) ||
+        !GFX_Clip(_pDst, &x, &y, _pSrc, &sx, &sy, &w, &h))
+    {
+        return;
+    }
+    GFX_CleanRect(_pSrc, sx, sy, w, h);
+    GFX_FlushRect(_pDst, x, y, w, h);
+
+    cmd.cr = (_pSrc->format == _pDst->format) ? GFX_MODE_M2M : GFX_MODE_M2M_PFC;
+    cmd.fgmar = GFX_PixelAddr(_pSrc, sx, sy);
+    cmd.fgor = _pSrc->pitch - w;
+    cmd.fgpfccr = _pSrc->format;
+    if (_pSrc->clut != NULL && cmd.cr == GFX_MODE_M2M_PFC)
+    {
+        cmd.fgpfccr |= (uint32_t)(_pSrc->clut_num - 1) << DMA2D_FGPFCCR_CS_Pos;
+        cmd.clut = _pSrc->clut;
+        cmd.clut_num = _pSrc->clut_num;
+    }
+    cmd.opfccr = (_pDst->format <= GFX_ARGB4444) ? _pDst->format : 0;
+    cmd.omar = GFX_PixelAddr(_pDst, x, y);
+    cmd.oor = _pDst->pitch - w;
+    cmd.nlr = ((uint32_t)w << DMA2D_NLR_PL_Pos) | h;
+    GFX_Submit(&cmd);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_BlitYCbCr
+*    功能说明: JPEG解码输出的YCbCr MCU块转换为RGB格式写入目标图像，一条DMA2D命令完成整幅图像。
+*              MCU块不能按行裁剪，图像必须完全在目标图像内
+*    形    参: _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444
+*              _x, _y : 目标坐标
+*              _addr : MCU块数据的地址
+*              _w, _h : 图像的宽度和高度
+*              _css : GFX_CSS_444 / GFX_CSS_422 / GFX_CSS_420
+*    返 回 值: 0 表示成功，-1 表示参数错误
+*********************************************************************************************************
+*/
+int GFX_BlitYCbCr(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint32_t _addr, uint16_t _w, uint16_t _h, uint8_t _css)
+{
+    GFX_CMD_T cmd = {0};
+    uint16_t mcu = (_css == GFX_CSS_444) ? 8 : 16; /* MCU块的宽度 */
+
+    if (_pDst->format > GFX_ARGB4444 || _css > GFX_CSS_420 || _x < 0 || _y < 0 ||
+        _x + _w > _pDst->width || _y + _h > _pDst->height || _w == 0 || _h == 0)
+    {
+        return -1;
+    }
+    GFX_FlushRect(_pDst, _x, _y, _w, _h);
+
+    /* 每行的最后一个MCU块不满时，多出的像素作为前景行偏移跳过 */
+    cmd.cr = GFX_MODE_M2M_PFC;
+    cmd.fgmar = _addr;
+    cmd.fgor = (mcu - _w % mcu) % mcu;
+    cmd.fgpfccr = GFX_CM_YCBCR | ((uint32_t)_css << DMA2D_FGPFCCR_CSS_Pos) | GFX_AM_REPLACE | (0xFFUL << DMA2D_FGPFCCR_ALPHA_Pos);
+    cmd.opfccr = _pDst->format;
+    cmd.omar = GFX_PixelAddr(_pDst, _x, _y);
+    cmd.oor = _pDst->pitch - _w;
+    cmd.nlr = ((uint32_t)_w << DMA2D_NLR_PL_Pos) | _h;
+    GFX_Submit(&cmd);
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Blend
+*    功能说明: 源图像按像素透明度乘以_alpha与目标图像混合
+*    形    参: _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444
+*              _x, _y : 目标坐标
+*              _pSrc : 源图像，任意格式，没有透明度的格式按不透明处理
+*              _sx, _sy : 源坐标
+*              _w, _h : 宽度和高度
+*              _alpha : 整体透明度，255为不改变源图像的透明度
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_Blend(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+               const GFX_SURFACE_T *_pSrc, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h, uint8_t _alpha)
+{
+    GFX_CMD_T cmd = {0};
+    int32_t x = _x, y = _y, sx = _sx, sy = _sy, w = _w, h = _h;
+
+    if (_pDst->format > GFX_ARGB4444 || !GFX_Clip(_pDst, &x, &y, _pSrc, &sx, &sy, &w, &h))
+    {
+        return;
+    }
+    GFX_CleanRect(_pSrc, sx, sy, w, h);
+    GFX_FlushRect(_pDst, x, y, w, h);
+
+    cmd.cr = GFX_MODE_M2M_BLEND;
+    cmd.fgmar = GFX_PixelAddr(_pSrc, sx, sy);
+    cmd.fgor = _pSrc->pitch - w;
+    cmd.fgpfccr = _pSrc->format | GFX_AM_MULTIPLY | ((uint32_t)_alpha << DMA2D_FGPFCCR_ALPHA_Pos);
+    if (_pSrc->clut != NULL)
+    {
+        cmd.fgpfccr |= (uint32_t)(_pSrc->clut_num - 1) << DMA2D_FGPFCCR_CS_Pos;
+        cmd.clut = _pSrc->clut;
+        cmd.clut_num = _pSrc->clut_num;
+    }
+    cmd.bgmar = GFX_PixelAddr(_pDst, x, y);
+    cmd.bgor = _pDst->pitch - w;
+    cmd.bgpfccr = _pDst->format;
+    cmd.opfccr = _pDst->format;
+    cmd.omar = cmd.bgmar;
+    cmd.oor = cmd.bgor;
+    cmd.nlr = ((uint32_t)w << DMA2D_NLR_PL_Pos) | h;
+    GFX_Submit(&cmd);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_BlendMask
+*    功能说明: 用颜色和透明度蒙版(A8/A4)绘制，用于抗锯齿字体和单色图标
+*    形    参: _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444
+*              _x, _y : 目标坐标
+*              _pMask : 蒙版，GFX_A8 或 GFX_A4
+*              _sx, _sy : 蒙版坐标
+*              _w, _h : 宽度和高度
+*              _argb : 颜色，透明度与蒙版相乘
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_BlendMask(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                   const GFX_SURFACE_T *_pMask, int16_t _sx, int16_t _sy, uint16_t _w, uint16_t _h, uint32_t _argb)
+{
+    GFX_CMD_T cmd = {0};
+    int32_t x = _x, y = _y, sx = _sx, sy = _sy, w = _w, h = _h;
+
+    if (_pDst->format > GFX_ARGB4444 || (_pMask->format != GFX_A8 && _pMask->format != GFX_A4) ||
+        !GFX_Clip(_pDst, &x, &y, _pMask, &sx, &sy, &w, &h))
+    {
+        return;
+    }
+    GFX_CleanRect(_pMask, sx, sy, w, h);
+    GFX_FlushRect(_pDst, x, y, w, h);
+
+    cmd.cr = GFX_MODE_M2M_BLEND;
+    cmd.fgmar = GFX_PixelAddr(_pMask, sx, sy);
+    cmd.fgor = _pMask->pitch - w;
+    cmd.fgpfccr = _pMask->format | GFX_AM_MULTIPLY | ((_argb >> 24) << DMA2D_FGPFCCR_ALPHA_Pos);
+    cmd.fgcolr = _argb & 0xFFFFFF;
+    cmd.bgmar = GFX_PixelAddr(_pDst, x, y);
+    cmd.bgor = _pDst->pitch - w;
+    cmd.bgpfccr = _pDst->format;
+    cmd.opfccr = _pDst->format;
+    cmd.omar = cmd.bgmar;
+    cmd.oor = cmd.bgor;
+    cmd.nlr = ((uint32_t)w << DMA2D_NLR_PL_Pos) | h;
+    GFX_Submit(&cmd);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Busy
+*    功能说明: 查询队列中是否还有未完成的命令
+*    形    参: 无
+*    返 回 值: 1 表示DMA2D正在工作
+*********************************************************************************************************
+*/
+uint8_t GFX_Busy(void)
+{
+    return s_ucBusy;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_Wait
+*    功能说明: 等待队列中的命令全部完成
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_Wait(void)
+{
+    while (s_ucBusy)
+    {
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_GetFence
+*    功能说明: 读取当前的队列位置(栅栏)，此前提交的命令完成后 GFX_FenceDone 返回1。
+*              用于页面翻转: 画完一帧后记下栅栏，DMA2D执行到栅栏时才显示该帧，主程序不用等待
+*    形    参: 无
+*    返 回 值: 栅栏值
+*********************************************************************************************************
+*/
+uint16_t GFX_GetFence(void)
+{
+    return s_usHead;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_FenceDone
+*    功能说明: 查询栅栏之前的命令是否全部完成，可以在中断中调用
+*    形    参: _usFence : GFX_GetFence 的返回值
+*    返 回 值: 1 表示已完成
+*********************************************************************************************************
+*/
+RAM_FUNC uint8_t GFX_FenceDone(uint16_t _usFence)
+{
+    return (int16_t)(s_usTail - _usFence) >= 0;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+#define GFX_BENCH_W 800 /* 填充测试区域，位于LCD第2层显存 */
+#define GFX_BENCH_H 480
+#define GFX_BENCH_IMG 256 /* 源图像边长 */
+
+static uint32_t gfx_us(int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+
+    return (us == 0) ? 1 : us;
+}
+
+/* 打印 Mpixel/s，即 像素数/us，保留两位小数 */
+static void gfx_bench_print(const char *_name, uint32_t _pixels, uint32_t _us_dma, uint32_t _us_cpu)
+{
+    uint32_t dma = (uint32_t)((uint64_t)_pixels * 100 / _us_dma);
+    uint32_t cpu = (uint32_t)((uint64_t)_pixels * 100 / _us_cpu);
+
+    printf("%-14s %4d.%02d %4d.%02d  x%d.%d\r\n", _name, dma / 100, dma % 100, cpu / 100, cpu % 100,
+           _us_cpu / _us_dma, _us_cpu * 10 / _us_dma % 10);
+}
+
+/* CPU混合一个像素，ARGB8888叠加到RGB565 */
+static uint16_t gfx_cpu_blend(uint32_t _argb, uint16_t _bg)
+{
+    uint32_t a = _argb >> 24;
+    uint32_t r = (((_argb >> 16) & 0xFF) * a + ((_bg >> 11) << 3) * (255 - a)) / 255;
+    uint32_t g = (((_argb >> 8) & 0xFF) * a + (((_bg >> 5) & 0x3F) << 2) * (255 - a)) / 255;
+    uint32_t b = ((_argb & 0xFF) * a + ((_bg & 0x1F) << 3) * (255 - a)) / 255;
+
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+/*
+    DMA2D与CPU的对比测试，结果为 Mpixel/s。
+    目标为LCD第2层显存(Write through)，源图像在SDRAM堆中。
+*/
+static void gfx_bench(uint8_t _loops)
+{
+    GFX_SURFACE_T lcd, img565, img8888, imgL8;
+    static uint32_t s_clut[256];
+    static uint16_t s_clut565[256];
+    uint32_t x, y, i, us_dma, us_cpu, n;
+    uint32_t *p32;
+    uint16_t *p16;
+    uint8_t *p8;
+    int64_t ticks;
+
+    if (_loops == 0)
+    {
+        _loops = 1;
+    }
+    GFX_InitSurface(&lcd, SDRAM_LCD_BUF2, GFX_BENCH_W, GFX_BENCH_H, GFX_RGB565);
+    GFX_InitSurface(&img565, (uint32_t)Mem_AllocAlign(MEM_SDRAM, GFX_BENCH_IMG * GFX_BENCH_IMG * 2, 32),
+                    GFX_BENCH_IMG, GFX_BENCH_IMG, GFX_RGB565);
+    GFX_InitSurface(&img8888, (uint32_t)Mem_AllocAlign(MEM_SDRAM, GFX_BENCH_IMG * GFX_BENCH_IMG * 4, 32),
+                    GFX_BENCH_IMG, GFX_BENCH_IMG, GFX_ARGB8888);
+    GFX_InitSurface(&imgL8, (uint32_t)Mem_AllocAlign(MEM_SDRAM, GFX_BENCH_IMG * GFX_BENCH_IMG, 32),
+                    GFX_BENCH_IMG, GFX_BENCH_IMG, GFX_L8);
+    if (img565.addr == 0 || img8888.addr == 0 || imgL8.addr == 0)
+    {
+        printf("Low memory!\r\n");
+        Mem_Free((void *)img565.addr);
+        Mem_Free((void *)img8888.addr);
+        Mem_Free((void *)imgL8.addr);
+        return;
+    }
+
+    /* 渐变图像 */
+    for (i = 0; i < 256; i++)
+    {
+        s_clut[i] = GFX_RGB(i, 255 - i, i / 2);
+        s_clut565[i] = GFX_ColorFromARGB(GFX_RGB565, s_clut[i]);
+    }
+    imgL8.clut = s_clut;
+    imgL8.clut_num = 256;
+    for (y = 0; y < GFX_BENCH_IMG; y++)
+    {
+        for (x = 0; x < GFX_BENCH_IMG; x++)
+        {
+            ((uint32_t *)img8888.addr)[y * GFX_BENCH_IMG + x] = GFX_ARGB(x, y, 255 - y, x ^ y);
+            ((uint16_t *)img565.addr)[y * GFX_BENCH_IMG + x] = GFX_ColorFromARGB(GFX_RGB565, GFX_RGB(x, y, 255 - x));
+            ((uint8_t *)imgL8.addr)[y * GFX_BENCH_IMG + x] = x + y;
+        }
+    }
+
+    printf("%-14s %7s %7s  (Mpixel/s)\r\n", "", "DMA2D", "CPU");
+
+    /* 填充 */
+    n = GFX_BENCH_W * GFX_BENCH_H * _loops;
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_FillRect(&lcd, 0, 0, GFX_BENCH_W, GFX_BENCH_H, GFX_RGB(0, 0, 255));
+    }
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        p32 = (uint32_t *)lcd.addr;
+        for (x = 0; x < GFX_BENCH_W * GFX_BENCH_H / 2; x++)
+        {
+            p32[x] = 0x001F001F;
+        }
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    gfx_bench_print("fill", n, us_dma, us_cpu);
+
+    /* 拷贝 RGB565 */
+    n = GFX_BENCH_IMG * GFX_BENCH_IMG * _loops;
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_Blit(&lcd, 0, 0, &img565, 0, 0, GFX_BENCH_IMG, GFX_BENCH_IMG);
+    }
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        for (y = 0; y < GFX_BENCH_IMG; y++)
+        {
+            memcpy((uint16_t *)lcd.addr + y * lcd.pitch, (uint16_t *)img565.addr + y * GFX_BENCH_IMG, GFX_BENCH_IMG * 2);
+        }
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    gfx_bench_print("blit 565", n, us_dma, us_cpu);
+
+    /* ARGB8888 转 RGB565 */
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_Blit(&lcd, 0, 0, &img8888, 0, 0, GFX_BENCH_IMG, GFX_BENCH_IMG);
+    }
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        for (y = 0; y < GFX_BENCH_IMG; y++)
+        {
+            p32 = (uint32_t *)img8888.addr + y * GFX_BENCH_IMG;
+            p16 = (uint16_t *)lcd.addr + y * lcd.pitch;
+            for (x = 0; x < GFX_BENCH_IMG; x++)
+            {
+                p16[x] = ((p32[x] >> 8) & 0xF800) | ((p32[x] >> 5) & 0x07E0) | ((p32[x] >> 3) & 0x001F);
+            }
+        }
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    gfx_bench_print("8888>565", n, us_dma, us_cpu);
+
+    /* L8 转 RGB565，CPU使用预先转换的颜色表 */
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_Blit(&lcd, 0, 0, &imgL8, 0, 0, GFX_BENCH_IMG, GFX_BENCH_IMG);
+    }
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        for (y = 0; y < GFX_BENCH_IMG; y++)
+        {
+            p8 = (uint8_t *)imgL8.addr + y * GFX_BENCH_IMG;
+            p16 = (uint16_t *)lcd.addr + y * lcd.pitch;
+            for (x = 0; x < GFX_BENCH_IMG; x++)
+            {
+                p16[x] = s_clut565[p8[x]];
+            }
+        }
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    gfx_bench_print("L8>565", n, us_dma, us_cpu);
+
+    /* ARGB8888 混合到 RGB565，CPU读取显存前作废Cache */
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_Blend(&lcd, 0, 0, &img8888, 0, 0, GFX_BENCH_IMG, GFX_BENCH_IMG, 255);
+    }
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    SCB_InvalidateDCache_by_Addr((uint32_t *)lcd.addr, lcd.pitch * GFX_BENCH_IMG * 2);
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        for (y = 0; y < GFX_BENCH_IMG; y++)
+        {
+            p32 = (uint32_t *)img8888.addr + y * GFX_BENCH_IMG;
+            p16 = (uint16_t *)lcd.addr + y * lcd.pitch;
+            for (x = 0; x < GFX_BENCH_IMG; x++)
+            {
+                p16[x] = gfx_cpu_blend(p32[x], p16[x]);
+            }
+        }
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    gfx_bench_print("blend 8888", n, us_dma, us_cpu);
+
+    /* 命令队列：CPU提交1000个32x32填充的时间与全部完成的时间 */
+    ticks = get_system_ticks();
+    for (i = 0; i < 1000; i++)
+    {
+        GFX_FillRect(&lcd, (i * 37) % (GFX_BENCH_W - 32), (i * 23) % (GFX_BENCH_H - 32), 32, 32, GFX_RGB(i, i * 3, i * 7));
+    }
+    us_cpu = gfx_us(get_system_ticks() - ticks);
+    GFX_Wait();
+    us_dma = gfx_us(get_system_ticks() - ticks);
+    printf("queue 1000 x 32x32 fill: submit %d us, done %d us, errors %d\r\n", us_cpu, us_dma, s_uiError);
+
+    Mem_Free((void *)img565.addr);
+    Mem_Free((void *)img8888.addr);
+    Mem_Free((void *)imgL8.addr);
+}
+
+static int cmd_gfx(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "gfx bench [loops]"};
+
+    if (argc > 1 && !strcmp(argv[1], "bench"))
+    {
+        gfx_bench(argc > 2 ? atoi(argv[2]) : 10);
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), gfx, cmd_gfx, gfx[bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
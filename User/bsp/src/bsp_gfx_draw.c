@@ -0,0 +1,1128 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 矢量绘图模块
+*    文件名称 : bsp_gfx_draw.c
+*    版    本 : V1.0
+*    说    明 : 直线、抗锯齿直线、圆、圆弧和多边形，用于曲线图、仪表盘。DMA2D只能填充矩形，这些图形由CPU光栅化。
+*               1. 直线用Bresenham算法，抗锯齿直线用Wu算法，圆用中点画圆法，多边形用边表扫描线填充(奇偶规则)
+*               2. 填充图形按水平线输出，不短于 DRAW_DMA2D_MIN 的水平线交给DMA2D，CPU继续计算下一行；
+*                  短的由CPU写入，16位格式每次写32位(2个像素)
+*               3. 每次提交DMA2D命令后，CPU写入前都要等待完成，并写回作废DMA2D写入行的D-Cache。同一图形的像素
+*                  颜色相同，DMA2D与CPU写入的像素重叠不影响结果。绘制结束时写回CPU写入行的D-Cache，目标可以是
+*                  Write back区域(SDRAM中的后台缓冲区)，LTDC和之后的DMA2D命令读到CPU绘制的像素
+*               4. 抗锯齿直线要读取目标像素，绘制前作废对应行的D-Cache
+*               5. 支持8位以上的格式(AL88除外)，抗锯齿直线在8位格式上按覆盖率一半取舍。不能在中断中调用
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_gfx_draw.h"
+#include <math.h>
+
+/* 一次绘制的参数 */
+typedef struct
+{
+    const GFX_SURFACE_T *dst;
+    uint32_t argb;
+    uint32_t pix;   /* 颜色转换为目标格式的像素值 */
+    uint32_t fg565; /* RGB565颜色展开为 0x07E0F81F 的形式，用于混合 */
+    uint8_t bytes;  /* 每个像素的字节数 */
+    uint8_t alpha;  /* 颜色的透明度，抗锯齿直线使用 */
+    uint8_t wait;   /* 1: CPU写入前要等待DMA2D */
+    int32_t new_y0; /* 上次等待DMA2D之后已作废D-Cache的行，new_y0 > new_y1 表示没有 */
+    int32_t new_y1;
+    int32_t cpu_y0; /* CPU写入的行，绘制结束时写回D-Cache */
+    int32_t cpu_y1;
+} DRAW_CTX_T;
+
+/* 圆弧的角度范围，起始和结束方向的单位向量乘以4096 */
+typedef struct
+{
+    int32_t sx, sy;
+    int32_t ex, ey;
+    uint8_t full; /* 整圆 */
+    uint8_t wide; /* 大于180度 */
+} DRAW_ARC_T;
+
+/* 多边形的边 */
+typedef struct
+{
+    int64_t x;  /* 当前扫描线像素中心处的x，16.16定点 */
+    int64_t dx; /* 每行x的增量 */
+    int32_t y0; /* 第一条扫描线 */
+    int32_t y1; /* 最后一条扫描线的下一行 */
+} DRAW_EDGE_T;
+
+static DRAW_EDGE_T s_tEdge[DRAW_EDGE_MAX];   /* 边表，按起始扫描线排序 */
+static DRAW_EDGE_T *s_pAct[DRAW_EDGE_MAX];   /* 活动边表，按x排序 */
+static uint16_t s_usDmaMin = DRAW_DMA2D_MIN; /* draw bench 对比时临时修改 */
+
+/*
+*********************************************************************************************************
+*    函 数 名: DRAW_Begin
+*    功能说明: 准备绘制，颜色转换为目标格式
+*    形    参: _pCtx : 绘制参数
+*              _pDst : 目标图像
+*              _argb : ARGB8888颜色
+*    返 回 值: 0 表示目标格式不支持
+*********************************************************************************************************
+*/
+static uint8_t DRAW_Begin(DRAW_CTX_T *_pCtx, const GFX_SURFACE_T *_pDst, uint32_t _argb)
+{
+    uint8_t bits = GFX_BitsPerPixel((GFX_FMT_E)_pDst->format);
+    uint32_t c;
+
+    if (bits < 8 || _pDst->format == GFX_AL88)
+    {
+        return 0;
+    }
+    c = GFX_ColorFromARGB(GFX_RGB565, _argb);
+    _pCtx->dst = _pDst;
+    _pCtx->argb = _argb;
+    _pCtx->pix = GFX_ColorFromARGB((GFX_FMT_E)_pDst->format, _argb);
+    _pCtx->fg565 = (c | (c << 16)) & 0x07E0F81F;
+    _pCtx->bytes = bits / 8;
+    _pCtx->alpha = _argb >> 24;
+    _pCtx->wait = 1;
+    _pCtx->new_y0 = _pCtx->cpu_y0 = INT32_MAX;
+    _pCtx->new_y1 = _pCtx->cpu_y1 = -1;
+    return 1;
+}
+
+/* 写回并作废 _y0 - _y1 行的D-Cache，超出图像的行不处理 */
+static void DRAW_FlushRows(const DRAW_CTX_T *_pCtx, int32_t _y0, int32_t _y1)
+{
+    _y0 = (_y0 > 0) ? _y0 : 0;
+    _y1 = (_y1 < _pCtx->dst->height) ? _y1 : _pCtx->dst->height - 1;
+    if (_y0 <= _y1)
+    {
+        GFX_FlushCache(_pCtx->dst, 0, _y0, _pCtx->dst->width, _y1 - _y0 + 1);
+    }
+}
+
+/* 矩形交给DMA2D填充，之后CPU写入前要再次等待 */
+static inline void DRAW_Submit(DRAW_CTX_T *_pCtx, int32_t _x, int32_t _y, int32_t _w, int32_t _h)
+{
+    GFX_FillRect(_pCtx->dst, _x, _y, _w, _h, _pCtx->argb);
+    _pCtx->wait = 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: DRAW_Touch
+*    功能说明: CPU读写 _y0 - _y1 行前调用。先等待已提交的DMA2D命令完成，否则之后完成的命令会覆盖CPU绘制的
+*              像素。DMA2D执行期间D-Cache可能预取了目标区域的旧数据，CPU写入同一Cache行后换出时会覆盖
+*              DMA2D的结果，所以每次等待后第一次写入某行前写回并作废该行的D-Cache
+*    形    参: _pCtx : 绘制参数
+*              _y0, _y1 : 起始行和结束行
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void DRAW_Touch(DRAW_CTX_T *_pCtx, int32_t _y0, int32_t _y1)
+{
+    if (_pCtx->wait)
+    {
+        GFX_Wait();
+        _pCtx->wait = 0;
+        _pCtx->new_y0 = INT32_MAX;
+        _pCtx->new_y1 = -1;
+    }
+
+    if (_pCtx->new_y0 > _pCtx->new_y1)
+    {
+        DRAW_FlushRows(_pCtx, _y0, _y1);
+        _pCtx->new_y0 = _y0;
+        _pCtx->new_y1 = _y1;
+    }
+    else
+    {
+        /* 扫描线逐行移动，只处理新增的行 */
+        if (_y0 < _pCtx->new_y0)
+        {
+            DRAW_FlushRows(_pCtx, _y0, _pCtx->new_y0 - 1);
+            _pCtx->new_y0 = _y0;
+        }
+        if (_y1 > _pCtx->new_y1)
+        {
+            DRAW_FlushRows(_pCtx, _pCtx->new_y1 + 1, _y1);
+            _pCtx->new_y1 = _y1;
+        }
+    }
+
+    _pCtx->cpu_y0 = (_y0 < _pCtx->cpu_y0) ? _y0 : _pCtx->cpu_y0;
+    _pCtx->cpu_y1 = (_y1 > _pCtx->cpu_y1) ? _y1 : _pCtx->cpu_y1;
+}
+
+/* 绘制结束，写回CPU写入行的D-Cache，LTDC和DMA2D读到新的像素 */
+static void DRAW_End(DRAW_CTX_T *_pCtx)
+{
+    if (_pCtx->cpu_y0 <= _pCtx->cpu_y1)
+    {
+        DRAW_FlushRows(_pCtx, _pCtx->cpu_y0, _pCtx->cpu_y1);
+    }
+}
+
+/* 像素(x, y)的地址，坐标已裁剪 */
+static inline uint8_t *DRAW_Addr(const DRAW_CTX_T *_pCtx, int32_t _x, int32_t _y)
+{
+    return (uint8_t *)(uintptr_t)_pCtx->dst->addr + ((uint32_t)_y * _pCtx->dst->pitch + _x) * _pCtx->bytes;
+}
+
+/* 写一个像素 */
+static inline void DRAW_Put(uint8_t *_p, uint8_t _bytes, uint32_t _pix)
+{
+    switch (_bytes)
+    {
+    case 1:
+        *_p = _pix;
+        break;
+
+    case 2:
+        *(uint16_t *)_p = _pix;
+        break;
+
+    case 3:
+        _p[0] = _pix;
+        _p[1] = _pix >> 8;
+        _p[2] = _pix >> 16;
+        break;
+
+    default:
+        *(uint32_t *)_p = _pix;
+        break;
+    }
+}
+
+/* 写一个像素，超出图像的不画 */
+static inline void DRAW_Plot(DRAW_CTX_T *_pCtx, int32_t _x, int32_t _y)
+{
+    if ((uint32_t)_x < (uint32_t)_pCtx->dst->width && (uint32_t)_y < (uint32_t)_pCtx->dst->height)
+    {
+        DRAW_Put(DRAW_Addr(_pCtx, _x, _y), _pCtx->bytes, _pCtx->pix);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: DRAW_Span
+*    功能说明: 画水平线 [_x0, _x1]，按图像大小裁剪。长的交给DMA2D，短的由CPU写入
+*    形    参: _pCtx : 绘制参数
+*              _x0, _x1 : 起点和终点，包含终点
+*              _y : 行
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void DRAW_Span(DRAW_CTX_T *_pCtx, int32_t _x0, int32_t _x1, int32_t _y)
+{
+    const GFX_SURFACE_T *dst = _pCtx->dst;
+    uint32_t pix = _pCtx->pix;
+    uint32_t *p32;
+    uint8_t *p;
+    int32_t n;
+
+    if ((uint32_t)_y >= (uint32_t)dst->height)
+    {
+        return;
+    }
+    _x0 = (_x0 > 0) ? _x0 : 0;
+    _x1 = (_x1 < dst->width) ? _x1 : dst->width - 1;
+    n = _x1 - _x0 + 1;
+    if (n <= 0)
+    {
+        return;
+    }
+
+    if (s_usDmaMin != 0 && n >= s_usDmaMin && dst->format <= GFX_ARGB4444)
+    {
+        DRAW_Submit(_pCtx, _x0, _y, n, 1);
+        return;
+    }
+
+    DRAW_Touch(_pCtx, _y, _y);
+    p = DRAW_Addr(_pCtx, _x0, _y);
+    switch (_pCtx->bytes)
+    {
+    case 1:
+        memset(p, pix, n);
+        break;
+
+    case 2:
+        /* 对齐到4字节后每次写2个像素 */
+        if ((uintptr_t)p & 2)
+        {
+            *(uint16_t *)p = pix;
+            p += 2;
+            n--;
+        }
+        p32 = (uint32_t *)p;
+        pix |= pix << 16;
+        for (; n >= 2; n -= 2)
+        {
+            *p32++ = pix;
+        }
+        if (n)
+        {
+            *(uint16_t *)p32 = pix;
+        }
+        break;
+
+    case 3:
+        for (; n > 0; n--, p += 3)
+        {
+            DRAW_Put(p, 3, pix);
+        }
+        break;
+
+    default:
+        p32 = (uint32_t *)p;
+        while (n--)
+        {
+            *p32++ = pix;
+        }
+        break;
+    }
+}
+
+/* 目标格式的像素转换为ARGB8888 */
+static uint32_t DRAW_ToARGB(uint8_t _fmt, uint32_t _pix)
+{
+    uint32_t a, r, g, b;
+
+    switch (_fmt)
+    {
+    case GFX_RGB888:
+        return 0xFF000000 | _pix;
+
+    case GFX_RGB565:
+        r = (_pix >> 11) & 0x1F;
+        g = (_pix >> 5) & 0x3F;
+        b = _pix & 0x1F;
+        return GFX_RGB((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+
+    case GFX_ARGB1555:
+        a = (_pix & 0x8000) ? 0xFF : 0;
+        r = (_pix >> 10) & 0x1F;
+        g = (_pix >> 5) & 0x1F;
+        b = _pix & 0x1F;
+        return GFX_ARGB(a, (r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2));
+
+    case GFX_ARGB4444:
+        return GFX_ARGB(((_pix >> 12) & 0xF) * 17, ((_pix >> 8) & 0xF) * 17, ((_pix >> 4) & 0xF) * 17, (_pix & 0xF) * 17);
+
+    default:
+        return _pix;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: DRAW_Blend
+*    功能说明: 按覆盖率混合一个像素，超出图像的不画
+*    形    参: _pCtx : 绘制参数
+*              _x, _y : 坐标
+*              _cov : 覆盖率，0 - 255
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void DRAW_Blend(DRAW_CTX_T *_pCtx, int32_t _x, int32_t _y, uint32_t _cov)
+{
+    const GFX_SURFACE_T *dst = _pCtx->dst;
+    uint32_t a = (_pCtx->alpha * _cov + 255) >> 8;
+    uint32_t bg, fg, out, i;
+    uint8_t *p;
+
+    if (a == 0 || (uint32_t)_x >= (uint32_t)dst->width || (uint32_t)_y >= (uint32_t)dst->height)
+    {
+        return;
+    }
+    p = DRAW_Addr(_pCtx, _x, _y);
+
+    switch (dst->format)
+    {
+    case GFX_RGB565:
+        /* 绿色移到高16位，三个分量之间有空位，一次乘法完成混合 */
+        bg = *(uint16_t *)p;
+        bg = (bg | (bg << 16)) & 0x07E0F81F;
+        out = (((((_pCtx->fg565 - bg) * ((a + 4) >> 3)) >> 5) + bg) & 0x07E0F81F);
+        *(uint16_t *)p = out | (out >> 16);
+        break;
+
+    case GFX_L8:
+    case GFX_AL44:
+    case GFX_A8:
+        if (a >= 128)
+        {
+            *p = _pCtx->pix;
+        }
+        break;
+
+    default:
+        bg = (_pCtx->bytes == 4) ? *(uint32_t *)p : (_pCtx->bytes == 3) ? (p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)) : *(uint16_t *)p;
+        bg = DRAW_ToARGB(dst->format, bg);
+        fg = _pCtx->argb;
+        out = (a + ((bg >> 24) * (255 - a) + 127) / 255) << 24;
+        for (i = 0; i < 24; i += 8)
+        {
+            out |= ((((fg >> i) & 0xFF) * a + ((bg >> i) & 0xFF) * (255 - a) + 127) / 255) << i;
+        }
+        DRAW_Put(p, _pCtx->bytes, GFX_ColorFromARGB((GFX_FMT_E)dst->format, out));
+        break;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawHLine
+*    功能说明: 画水平线，不短于 DRAW_DMA2D_MIN 时由DMA2D填充
+*    形    参: _pDst : 目标图像
+*              _x, _y : 起点
+*              _w : 长度
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawHLine(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _w, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+
+    if (_w != 0 && DRAW_Begin(&ctx, _pDst, _argb))
+    {
+        DRAW_Span(&ctx, _x, _x + _w - 1, _y);
+        DRAW_End(&ctx);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawVLine
+*    功能说明: 画垂直线，不短于 DRAW_DMA2D_MIN 时由DMA2D填充
+*    形    参: _pDst : 目标图像
+*              _x, _y : 起点
+*              _h : 长度
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawVLine(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _h, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    int32_t y0 = _y, y1 = _y + _h - 1;
+    uint32_t step;
+    uint8_t *p;
+
+    if (_h == 0 || !DRAW_Begin(&ctx, _pDst, _argb) || (uint32_t)_x >= (uint32_t)_pDst->width)
+    {
+        return;
+    }
+    y0 = (y0 > 0) ? y0 : 0;
+    y1 = (y1 < _pDst->height) ? y1 : _pDst->height - 1;
+    if (y0 > y1)
+    {
+        return;
+    }
+    if (s_usDmaMin != 0 && y1 - y0 + 1 >= s_usDmaMin && _pDst->format <= GFX_ARGB4444)
+    {
+        DRAW_Submit(&ctx, _x, y0, 1, y1 - y0 + 1);
+        return;
+    }
+
+    DRAW_Touch(&ctx, y0, y1);
+    p = DRAW_Addr(&ctx, _x, y0);
+    step = (uint32_t)_pDst->pitch * ctx.bytes;
+    for (; y0 <= y1; y0++, p += step)
+    {
+        DRAW_Put(p, ctx.bytes, ctx.pix);
+    }
+    DRAW_End(&ctx);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawLine
+*    功能说明: 画1像素宽的直线(Bresenham)，包含两个端点。整条线在图像内时按地址步进，不逐点裁剪
+*    形    参: _pDst : 目标图像
+*              _x0, _y0 : 起点
+*              _x1, _y1 : 终点
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawLine(const GFX_SURFACE_T *_pDst, int16_t _x0, int16_t _y0, int16_t _x1, int16_t _y1, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    int32_t dx = abs(_x1 - _x0), dy = -abs(_y1 - _y0);
+    int32_t sx = (_x0 < _x1) ? 1 : -1, sy = (_y0 < _y1) ? 1 : -1;
+    int32_t err = dx + dy, e2, x = _x0, y = _y0;
+    int32_t w = _pDst->width, h = _pDst->height;
+    int32_t step_x, step_y;
+    uint8_t *p;
+
+    if (_y0 == _y1)
+    {
+        GFX_DrawHLine(_pDst, (_x0 < _x1) ? _x0 : _x1, _y0, dx + 1, _argb);
+        return;
+    }
+    if (_x0 == _x1)
+    {
+        GFX_DrawVLine(_pDst, _x0, (_y0 < _y1) ? _y0 : _y1, -dy + 1, _argb);
+        return;
+    }
+    if (!DRAW_Begin(&ctx, _pDst, _argb) ||
+        (_x0 < 0 && _x1 < 0) || (_y0 < 0 && _y1 < 0) || (_x0 >= w && _x1 >= w) || (_y0 >= h && _y1 >= h))
+    {
+        return;
+    }
+    DRAW_Touch(&ctx, (_y0 < _y1) ? _y0 : _y1, (_y0 > _y1) ? _y0 : _y1);
+
+    if (_x0 >= 0 && _x0 < w && _x1 >= 0 && _x1 < w && _y0 >= 0 && _y0 < h && _y1 >= 0 && _y1 < h)
+    {
+        p = DRAW_Addr(&ctx, _x0, _y0);
+        step_x = sx * ctx.bytes;
+        step_y = sy * (int32_t)_pDst->pitch * ctx.bytes;
+        for (;;)
+        {
+            DRAW_Put(p, ctx.bytes, ctx.pix);
+            if (x == _x1 && y == _y1)
+            {
+                break;
+            }
+            e2 = 2 * err;
+            if (e2 >= dy)
+            {
+                err += dy;
+                x += sx;
+                p += step_x;
+            }
+            if (e2 <= dx)
+            {
+                err += dx;
+                y += sy;
+                p += step_y;
+            }
+        }
+        DRAW_End(&ctx);
+        return;
+    }
+
+    for (;;)
+    {
+        DRAW_Plot(&ctx, x, y);
+        if (x == _x1 && y == _y1)
+        {
+            break;
+        }
+        e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y += sy;
+        }
+    }
+    DRAW_End(&ctx);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawLineAA
+*    功能说明: 画抗锯齿直线(Wu)。沿主方向每步画相邻的两个像素，按到直线的距离分配覆盖率
+*    形    参: _pDst : 目标图像
+*              _x0, _y0 : 起点
+*              _x1, _y1 : 终点
+*              _argb : 颜色，透明度与覆盖率相乘
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawLineAA(const GFX_SURFACE_T *_pDst, int16_t _x0, int16_t _y0, int16_t _x1, int16_t _y1, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    int32_t ax = _x0, ay = _y0, bx = _x1, by = _y1, t, x, y, yf, grad;
+    uint32_t f;
+    uint8_t steep;
+
+    if (!DRAW_Begin(&ctx, _pDst, _argb))
+    {
+        return;
+    }
+    DRAW_Touch(&ctx, (_y0 < _y1) ? _y0 : _y1, ((_y0 > _y1) ? _y0 : _y1) + 1);
+
+    /* 按x方向步进，斜率绝对值不大于1 */
+    steep = abs(by - ay) > abs(bx - ax);
+    if (steep)
+    {
+        t = ax, ax = ay, ay = t;
+        t = bx, bx = by, by = t;
+    }
+    if (ax > bx)
+    {
+        t = ax, ax = bx, bx = t;
+        t = ay, ay = by, by = t;
+    }
+    grad = (bx == ax) ? 0 : (int32_t)(((int64_t)(by - ay) * 65536) / (bx - ax));
+
+    for (x = ax, yf = ay * 65536; x <= bx; x++, yf += grad)
+    {
+        y = yf >> 16;
+        f = (yf >> 8) & 0xFF;
+        if (steep)
+        {
+            DRAW_Blend(&ctx, y, x, 255 - f);
+            DRAW_Blend(&ctx, y + 1, x, f);
+        }
+        else
+        {
+            DRAW_Blend(&ctx, x, y, 255 - f);
+            DRAW_Blend(&ctx, x, y + 1, f);
+        }
+    }
+    DRAW_End(&ctx);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawCircle
+*    功能说明: 画圆(中点画圆法)，每步画8个对称点
+*    形    参: _pDst : 目标图像
+*              _cx, _cy : 圆心
+*              _r : 半径
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawCircle(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    int32_t x = _r, y = 0, err = 1 - _r;
+
+    if (!DRAW_Begin(&ctx, _pDst, _argb) || _cx + _r < 0 || _cy + _r < 0 ||
+        _cx - _r >= _pDst->width || _cy - _r >= _pDst->height)
+    {
+        return;
+    }
+    DRAW_Touch(&ctx, _cy - _r, _cy + _r);
+
+    while (x >= y)
+    {
+        DRAW_Plot(&ctx, _cx + x, _cy + y);
+        DRAW_Plot(&ctx, _cx - x, _cy + y);
+        DRAW_Plot(&ctx, _cx + x, _cy - y);
+        DRAW_Plot(&ctx, _cx - x, _cy - y);
+        DRAW_Plot(&ctx, _cx + y, _cy + x);
+        DRAW_Plot(&ctx, _cx - y, _cy + x);
+        DRAW_Plot(&ctx, _cx + y, _cy - x);
+        DRAW_Plot(&ctx, _cx - y, _cy - x);
+        y++;
+        if (err < 0)
+        {
+            err += 2 * y + 1;
+        }
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    DRAW_End(&ctx);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_FillCircle
+*    功能说明: 填充圆，与 GFX_DrawCircle 的轮廓一致，每行只画一次
+*    形    参: _pDst : 目标图像
+*              _cx, _cy : 圆心
+*              _r : 半径
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_FillCircle(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    int32_t x = _r, y = 0, err = 1 - _r;
+
+    if (!DRAW_Begin(&ctx, _pDst, _argb))
+    {
+        return;
+    }
+
+    while (x >= y)
+    {
+        DRAW_Span(&ctx, _cx - x, _cx + x, _cy + y);
+        if (y != 0)
+        {
+            DRAW_Span(&ctx, _cx - x, _cx + x, _cy - y);
+        }
+        y++;
+        if (err < 0)
+        {
+            err += 2 * y + 1;
+        }
+        else
+        {
+            /* x 减小前，第 cy±x 行的宽度已确定 */
+            if (x >= y)
+            {
+                DRAW_Span(&ctx, _cx - y + 1, _cx + y - 1, _cy + x);
+                DRAW_Span(&ctx, _cx - y + 1, _cx + y - 1, _cy - x);
+            }
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    DRAW_End(&ctx);
+}
+
+/* 相对圆心(_dx, _dy)的像素是否在圆弧的角度范围内 */
+static inline uint8_t DRAW_InArc(const DRAW_ARC_T *_pArc, int32_t _dx, int32_t _dy)
+{
+    int32_t c0 = _pArc->sx * _dy - _pArc->sy * _dx; /* >= 0: 在起始方向顺时针一侧 */
+    int32_t c1 = _dx * _pArc->ey - _dy * _pArc->ex; /* >= 0: 在结束方向逆时针一侧 */
+
+    return _pArc->wide ? (c0 >= 0 || c1 >= 0) : (c0 >= 0 && c1 >= 0);
+}
+
+/* 画圆环一行中的一段 [_x0, _x1]，坐标相对圆心，角度范围内连续的像素合并为水平线 */
+static void DRAW_ArcRun(DRAW_CTX_T *_pCtx, const DRAW_ARC_T *_pArc, int32_t _cx, int32_t _cy,
+                        int32_t _dy, int32_t _x0, int32_t _x1)
+{
+    int32_t x, start = 0;
+    uint8_t in = 0;
+
+    if (_pArc->full)
+    {
+        DRAW_Span(_pCtx, _cx + _x0, _cx + _x1, _cy + _dy);
+        return;
+    }
+
+    /* 图像外的像素不用判断角度 */
+    _x0 = (_cx + _x0 > 0) ? _x0 : -_cx;
+    _x1 = (_cx + _x1 < _pCtx->dst->width) ? _x1 : _pCtx->dst->width - 1 - _cx;
+    for (x = _x0; x <= _x1; x++)
+    {
+        if (DRAW_InArc(_pArc, x, _dy))
+        {
+            if (!in)
+            {
+                start = x;
+                in = 1;
+            }
+        }
+        else if (in)
+        {
+            DRAW_Span(_pCtx, _cx + start, _cx + x - 1, _cy + _dy);
+            in = 0;
+        }
+    }
+    if (in)
+    {
+        DRAW_Span(_pCtx, _cx + start, _cx + _x1, _cy + _dy);
+    }
+}
+
+/* 整数平方根，向下取整 */
+static uint32_t DRAW_Sqrt(uint32_t _v)
+{
+    uint32_t r = 0, b = 1UL << 30;
+
+    while (b > _v)
+    {
+        b >>= 2;
+    }
+    while (b != 0)
+    {
+        if (_v >= r + b)
+        {
+            _v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return r;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawArc
+*    功能说明: 画圆弧(圆环的一段)，用于仪表盘。逐行计算圆环的内外边界，角度范围内的部分合并为水平线填充
+*    形    参: _pDst : 目标图像
+*              _cx, _cy : 圆心
+*              _r : 外半径
+*              _width : 圆环宽度，像素。不小于半径时为扇形
+*              _start, _end : 起始和结束角度，度。0为3点钟方向，顺时针增加。相差360度以上为整个圆环
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawArc(const GFX_SURFACE_T *_pDst, int16_t _cx, int16_t _cy, uint16_t _r, uint16_t _width,
+                 int16_t _start, int16_t _end, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    DRAW_ARC_T arc;
+    int32_t sweep = ((_end - _start) % 360 + 360) % 360;
+    int32_t ri = (int32_t)_r - ((_width != 0) ? _width : 1);
+    uint32_t ro2 = (uint32_t)_r * _r + _r; /* 按半径 r + 0.5 取舍，轮廓更圆 */
+    uint32_t ri2 = (ri >= 0) ? (uint32_t)ri * ri + ri : 0;
+    uint32_t yy;
+    int32_t dy, xo, xi;
+
+    if (_r == 0 || (sweep == 0 && _end - _start < 360) || !DRAW_Begin(&ctx, _pDst, _argb))
+    {
+        return;
+    }
+    arc.full = (_end - _start >= 360);
+    arc.wide = (sweep > 180);
+    arc.sx = (int32_t)lroundf(cosf(_start * 3.14159265f / 180) * 4096);
+    arc.sy = (int32_t)lroundf(sinf(_start * 3.14159265f / 180) * 4096);
+    arc.ex = (int32_t)lroundf(cosf(_end * 3.14159265f / 180) * 4096);
+    arc.ey = (int32_t)lroundf(sinf(_end * 3.14159265f / 180) * 4096);
+
+    for (dy = -_r; dy <= _r; dy++)
+    {
+        if ((uint32_t)(_cy + dy) >= (uint32_t)_pDst->height)
+        {
+            continue;
+        }
+        yy = (uint32_t)(dy * dy);
+        xo = DRAW_Sqrt(ro2 - yy);
+        if (ri >= 0 && yy <= ri2)
+        {
+            /* 内圆以内的像素不画，左右各一段 */
+            xi = DRAW_Sqrt(ri2 - yy) + 1;
+            if (xi <= xo)
+            {
+                DRAW_ArcRun(&ctx, &arc, _cx, _cy, dy, -xo, -xi);
+                DRAW_ArcRun(&ctx, &arc, _cx, _cy, dy, xi, xo);
+            }
+        }
+        else
+        {
+            DRAW_ArcRun(&ctx, &arc, _cx, _cy, dy, -xo, xo);
+        }
+    }
+    DRAW_End(&ctx);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_DrawPolygon
+*    功能说明: 画多边形的轮廓，最后一个顶点与第一个顶点相连
+*    形    参: _pDst : 目标图像
+*              _pPts : 顶点
+*              _num : 顶点个数
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void GFX_DrawPolygon(const GFX_SURFACE_T *_pDst, const GFX_POINT_T *_pPts, uint16_t _num, uint32_t _argb)
+{
+    uint16_t i;
+
+    for (i = 0; i < _num; i++)
+    {
+        GFX_DrawLine(_pDst, _pPts[i].x, _pPts[i].y, _pPts[(i + 1) % _num].x, _pPts[(i + 1) % _num].y, _argb);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: GFX_FillPolygon
+*    功能说明: 填充多边形(奇偶规则)，可以是凹多边形和自相交多边形。边表按起始行排序，逐行更新活动边表，
+*              像素中心在左右边界之间的像素被填充，相邻多边形的公共边不重复绘制
+*    形    参: _pDst : 目标图像
+*              _pPts : 顶点
+*              _num : 顶点个数，3 - DRAW_EDGE_MAX
+*              _argb : 颜色，不透明绘制
+*    返 回 值: 0 表示成功，-1 表示顶点个数或目标格式不支持
+*********************************************************************************************************
+*/
+int GFX_FillPolygon(const GFX_SURFACE_T *_pDst, const GFX_POINT_T *_pPts, uint16_t _num, uint32_t _argb)
+{
+    DRAW_CTX_T ctx;
+    const GFX_POINT_T *a, *b, *t;
+    DRAW_EDGE_T *e;
+    uint16_t i, j, n = 0, act = 0, next = 0;
+    int32_t y, ymax = 0;
+
+    if (_num < 3 || _num > DRAW_EDGE_MAX || !DRAW_Begin(&ctx, _pDst, _argb))
+    {
+        return -1;
+    }
+
+    /* 边表，去掉水平边，按起始行插入排序。扫描线取像素中心 y + 0.5 */
+    for (i = 0; i < _num; i++)
+    {
+        a = &_pPts[i];
+        b = &_pPts[(i + 1) % _num];
+        if (a->y == b->y)
+        {
+            continue;
+        }
+        if (a->y > b->y)
+        {
+            t = a, a = b, b = t;
+        }
+        for (j = n++; j > 0 && s_tEdge[j - 1].y0 > a->y; j--)
+        {
+            s_tEdge[j] = s_tEdge[j - 1];
+        }
+        e = &s_tEdge[j];
+        e->y0 = a->y;
+        e->y1 = b->y;
+        e->dx = ((int64_t)(b->x - a->x) * 65536) / (b->y - a->y);
+        e->x = ((int64_t)a->x * 65536) + e->dx / 2;
+        ymax = (b->y > ymax) ? b->y : ymax;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    ymax = (ymax < _pDst->height) ? ymax : _pDst->height;
+
+    for (y = (s_tEdge[0].y0 > 0) ? s_tEdge[0].y0 : 0; y < ymax; y++)
+    {
+        /* 加入从本行开始的边，图像上方裁掉的行直接跳过 */
+        while (next < n && s_tEdge[next].y0 <= y)
+        {
+            e = &s_tEdge[next++];
+            if (e->y1 > y)
+            {
+                e->x += e->dx * (y - e->y0);
+                s_pAct[act++] = e;
+            }
+        }
+
+        /* 去掉已结束的边，按x插入排序，相邻行的顺序基本不变 */
+        for (i = 0, j = 0; i < act; i++)
+        {
+            if (s_pAct[i]->y1 > y)
+            {
+                s_pAct[j++] = s_pAct[i];
+            }
+        }
+        act = j;
+        for (i = 1; i < act; i++)
+        {
+            e = s_pAct[i];
+            for (j = i; j > 0 && s_pAct[j - 1]->x > e->x; j--)
+            {
+                s_pAct[j] = s_pAct[j - 1];
+            }
+            s_pAct[j] = e;
+        }
+
+        /* 像素中心 x + 0.5 在 [左边界, 右边界) 内的像素 */
+        for (i = 0; i + 1 < act; i += 2)
+        {
+            DRAW_Span(&ctx, (int32_t)((s_pAct[i]->x + 0x7FFF) >> 16), (int32_t)((s_pAct[i + 1]->x + 0x7FFF) >> 16) - 1, y);
+        }
+        for (i = 0; i < act; i++)
+        {
+            s_pAct[i]->x += s_pAct[i]->dx;
+        }
+    }
+    DRAW_End(&ctx);
+
+    return 0;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 经过的时间，us */
+static uint32_t draw_us(int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+
+    return (us == 0) ? 1 : us;
+}
+
+/* 五角星 */
+static void draw_star(GFX_POINT_T *_pPts, int16_t _cx, int16_t _cy, int16_t _r)
+{
+    uint8_t i;
+
+    for (i = 0; i < 5; i++)
+    {
+        _pPts[i].x = _cx + (int16_t)(_r * cosf((i * 144 - 90) * 3.14159265f / 180));
+        _pPts[i].y = _cy + (int16_t)(_r * sinf((i * 144 - 90) * 3.14159265f / 180));
+    }
+}
+
+/* 在第0层画仪表盘、曲线图和多边形 */
+static void draw_demo(void)
+{
+    GFX_SURFACE_T lcd;
+    GFX_POINT_T pts[5];
+    int16_t cx, cy, r, x, y, v, last = 0, i;
+
+    TFT_GetLayer(0, &lcd);
+    GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_RGB(16, 24, 32));
+
+    /* 仪表盘：刻度、背景圆弧、数值圆弧、指针 */
+    cx = lcd.width / 4;
+    cy = lcd.height / 2;
+    r = lcd.height / 3;
+    GFX_DrawArc(&lcd, cx, cy, r, 12, 135, 405, GFX_RGB(64, 64, 64));
+    GFX_DrawArc(&lcd, cx, cy, r, 12, 135, 315, GFX_RGB(0, 200, 255));
+    for (i = 0; i <= 10; i++)
+    {
+        x = cx + (int16_t)((r - 18) * cosf((135 + i * 27) * 3.14159265f / 180));
+        y = cy + (int16_t)((r - 18) * sinf((135 + i * 27) * 3.14159265f / 180));
+        GFX_DrawLineAA(&lcd, x, y, cx + (int16_t)((r - 30) * cosf((135 + i * 27) * 3.14159265f / 180)),
+                       cy + (int16_t)((r - 30) * sinf((135 + i * 27) * 3.14159265f / 180)), GFX_RGB(255, 255, 255));
+    }
+    GFX_DrawLineAA(&lcd, cx, cy, cx + (int16_t)((r - 24) * cosf(315 * 3.14159265f / 180)),
+                   cy + (int16_t)((r - 24) * sinf(315 * 3.14159265f / 180)), GFX_RGB(255, 64, 64));
+    GFX_FillCircle(&lcd, cx, cy, 8, GFX_RGB(255, 64, 64));
+    GFX_DrawCircle(&lcd, cx, cy, r + 4, GFX_RGB(128, 128, 128));
+
+    /* 曲线图：网格和抗锯齿折线 */
+    x = lcd.width / 2 + 10;
+    y = lcd.height / 8;
+    for (i = 0; i <= 4; i++)
+    {
+        GFX_DrawHLine(&lcd, x, y + i * lcd.height / 16, lcd.width / 2 - 20, GFX_RGB(48, 64, 80));
+    }
+    for (i = 0; i <= lcd.width / 2 - 20; i += 4)
+    {
+        v = y + lcd.height / 8 - (int16_t)(lcd.height / 10 * sinf(i / 20.0f) * cosf(i / 57.0f));
+        if (i != 0)
+        {
+            GFX_DrawLineAA(&lcd, x + i - 4, last, x + i, v, GFX_RGB(255, 200, 0));
+        }
+        last = v;
+    }
+
+    /* 多边形：自相交的五角星(奇偶规则中间镂空)和轮廓 */
+    draw_star(pts, lcd.width * 5 / 8, lcd.height * 3 / 4, lcd.height / 6);
+    GFX_FillPolygon(&lcd, pts, 5, GFX_RGB(64, 220, 64));
+    draw_star(pts, lcd.width * 7 / 8, lcd.height * 3 / 4, lcd.height / 6);
+    GFX_DrawPolygon(&lcd, pts, 5, GFX_RGB(255, 255, 255));
+    GFX_Wait();
+}
+
+/* 各图形的耗时，填充图形对比 DMA2D + CPU 和只用CPU */
+static void draw_bench(uint16_t _loops)
+{
+    GFX_SURFACE_T lcd;
+    GFX_POINT_T pts[5];
+    uint32_t us[2], i, k;
+    int64_t ticks;
+
+    TFT_GetLayer(0, &lcd);
+    if (_loops == 0)
+    {
+        _loops = 1;
+    }
+    printf("%-14s %9s %9s  (us/call)\r\n", "", "DMA2D+CPU", "CPU");
+
+    /* 不用DMA2D的图形只测一次 */
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_DrawLine(&lcd, 0, i % lcd.height, lcd.width - 1, lcd.height - 1 - i % lcd.height, GFX_RGB(i, 255, 0));
+    }
+    printf("%-14s %9d\r\n", "line", draw_us(get_system_ticks() - ticks) / _loops);
+
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_DrawLineAA(&lcd, 0, i % lcd.height, lcd.width - 1, lcd.height - 1 - i % lcd.height, GFX_ARGB(200, 255, i, 0));
+    }
+    printf("%-14s %9d\r\n", "line AA", draw_us(get_system_ticks() - ticks) / _loops);
+
+    ticks = get_system_ticks();
+    for (i = 0; i < _loops; i++)
+    {
+        GFX_DrawCircle(&lcd, lcd.width / 2, lcd.height / 2, 10 + i % (lcd.height / 2 - 10), GFX_RGB(0, i, 255));
+    }
+    printf("%-14s %9d\r\n", "circle", draw_us(get_system_ticks() - ticks) / _loops);
+
+    for (k = 0; k < 2; k++)
+    {
+        s_usDmaMin = (k == 0) ? DRAW_DMA2D_MIN : 0;
+        ticks = get_system_ticks();
+        for (i = 0; i < _loops; i++)
+        {
+            GFX_FillCircle(&lcd, lcd.width / 2, lcd.height / 2, lcd.height / 2 - 1, GFX_RGB(i, 0, 255));
+        }
+        GFX_Wait();
+        us[k] = draw_us(get_system_ticks() - ticks) / _loops;
+    }
+    printf("%-14s %9d %9d\r\n", "fill circle", us[0], us[1]);
+
+    draw_star(pts, lcd.width / 2, lcd.height / 2, lcd.height / 2 - 1);
+    for (k = 0; k < 2; k++)
+    {
+        s_usDmaMin = (k == 0) ? DRAW_DMA2D_MIN : 0;
+        ticks = get_system_ticks();
+        for (i = 0; i < _loops; i++)
+        {
+            GFX_FillPolygon(&lcd, pts, 5, GFX_RGB(255, i, 0));
+        }
+        GFX_Wait();
+        us[k] = draw_us(get_system_ticks() - ticks) / _loops;
+    }
+    printf("%-14s %9d %9d\r\n", "fill polygon", us[0], us[1]);
+
+    for (k = 0; k < 2; k++)
+    {
+        s_usDmaMin = (k == 0) ? DRAW_DMA2D_MIN : 0;
+        ticks = get_system_ticks();
+        for (i = 0; i < _loops; i++)
+        {
+            GFX_DrawArc(&lcd, lcd.width / 2, lcd.height / 2, lcd.height / 2 - 1, 40, 135, 405, GFX_RGB(0, 255, i));
+        }
+        GFX_Wait();
+        us[k] = draw_us(get_system_ticks() - ticks) / _loops;
+    }
+    printf("%-14s %9d %9d\r\n", "arc 270", us[0], us[1]);
+
+    s_usDmaMin = DRAW_DMA2D_MIN;
+}
+
+static int cmd_draw(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "draw demo",
+        "draw bench [loops]"};
+
+    if (argc > 1 && !strcmp(argv[1], "demo"))
+    {
+        draw_demo();
+        return 0;
+    }
+    else if (argc > 1 && !strcmp(argv[1], "bench"))
+    {
+        draw_bench(argc > 2 ? atoi(argv[2]) : 20);
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), draw, cmd_draw, draw[demo bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,355 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 性能叠加层模块
+*    文件名称 : bsp_hud.c
+*    版    本 : V1.0
+*    说    明 : 在LTDC第2层显示CPU占用率、主循环频率、帧率、各串口吞吐量和内存堆使用情况，不需要串口终端。
+*               1. CPU占用率：bsp_Idle 每次主循环调用 HUD_Idle，记录最短的一次循环时间作为空闲循环的时间，
+*                  统计周期内 循环次数 x 空闲循环时间 之外的时间都是忙，中断占用的时间也计算在内
+*               2. 叠加层为 ARGB4444 格式，单显存，LTDC窗口缩小到文字所在的区域，只读取这部分显存。
+*                  每 HUD_PERIOD 刷新一次，只重画内容改变的行，用DMA2D填充背景和混合文字
+*               3. shell 命令 hud on/off 或同时按下 K1、K2 切换显示，显示时占用第2层
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_hud.h"
+
+#define HUD_BG GFX_ARGB(0xA0, 0, 0, 0) /* 半透明黑色背景 */
+#define HUD_MARGIN 4                   /* 文字左边距 */
+
+typedef struct
+{
+    uint8_t on;
+    FONT_T font;
+    char line[HUD_LINES][HUD_COLS]; /* 已显示的文字，内容不变的行不重画 */
+    uint8_t rows;                   /* 已显示的行数 */
+
+    /* 主循环统计 */
+    int64_t last;  /* 上一次进入 HUD_Idle 的时刻 */
+    int64_t min;   /* 最短的一次循环，视为空闲循环的时间 */
+    int64_t start; /* 统计周期开始的时刻 */
+    uint32_t loops;
+
+    /* 上一周期结束时的累计值 */
+    uint32_t frames;
+    uint32_t vsync;
+    uint32_t tx[8];
+    uint32_t rx[8];
+
+    HUD_STAT_T stat;
+} HUD_T;
+
+static HUD_T s_tHud = {.min = INT64_MAX};
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Sample
+*    功能说明: 一个统计周期结束，计算CPU占用率、循环频率、帧率和串口吞吐量
+*    形    参: _now : 当前时刻，ticks
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void HUD_Sample(int64_t _now)
+{
+    HUD_T *h = &s_tHud;
+    HUD_STAT_T *st = &h->stat;
+    int64_t total = _now - h->start;
+    int64_t idle = (int64_t)h->loops * h->min;
+    uint32_t ms = (uint32_t)(total / (SystemCoreClock / 1000));
+    uint32_t frames, vsync, tx, rx;
+    uint8_t i;
+
+    if (ms == 0)
+    {
+        ms = 1;
+    }
+    idle = (idle < total) ? idle : total;
+    st->load = (uint16_t)((total - idle) * 1000 / total);
+    st->loop_hz = (uint32_t)((uint64_t)h->loops * SystemCoreClock / total);
+
+    /* tft fps 会清零显示的帧数 */
+    TFT_GetStat(0, &frames, &vsync, &st->underrun);
+    st->fps = ((frames >= h->frames) ? frames - h->frames : frames) * 10000 / ms;
+    st->vsync = (vsync - h->vsync) * 10000 / ms;
+    h->frames = frames;
+    h->vsync = vsync;
+
+    st->com = 0;
+    for (i = 0; i < 8; i++)
+    {
+        if (comGetStat((COM_PORT_E)(COM1 + i), &tx, &rx) != 0)
+        {
+            continue;
+        }
+        st->com |= 1 << i;
+        st->tx[i] = (uint32_t)((uint64_t)(tx - h->tx[i]) * 1000 / ms);
+        st->rx[i] = (uint32_t)((uint64_t)(rx - h->rx[i]) * 1000 / ms);
+        h->tx[i] = tx;
+        h->rx[i] = rx;
+    }
+
+    h->start = _now;
+    h->loops = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Draw
+*    功能说明: 生成各行文字，重画内容改变的行，窗口高度随行数调整
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void HUD_Draw(void)
+{
+    HUD_T *h = &s_tHud;
+    HUD_STAT_T *st = &h->stat;
+    char text[HUD_LINES][HUD_COLS];
+    uint32_t color[HUD_LINES];
+    uint16_t lh = h->font.head.line_height;
+    GFX_SURFACE_T lcd;
+    MEM_STAT_T dtcm, axi, sdram;
+    uint8_t n = 0, i;
+
+    /* 只读取计数，Mem_GetStat 关中断遍历整个堆，不能每次刷新都调用 */
+    Mem_GetUsage(MEM_DTCM, &dtcm);
+    Mem_GetUsage(MEM_AXI, &axi);
+    Mem_GetUsage(MEM_SDRAM, &sdram);
+
+    color[n] = (st->load >= 800) ? GFX_RGB(255, 64, 64) : (st->load >= 500) ? GFX_RGB(255, 255, 0) : GFX_RGB(64, 255, 64);
+    snprintf(text[n++], HUD_COLS, "CPU %3d.%d%%  loop %7d Hz", st->load / 10, st->load % 10, st->loop_hz);
+    color[n] = (st->underrun != 0) ? GFX_RGB(255, 255, 0) : GFX_RGB(255, 255, 255);
+    snprintf(text[n++], HUD_COLS, "FPS %3d.%d  vsync %2d.%d Hz  underrun %d", st->fps / 10, st->fps % 10,
+             st->vsync / 10, st->vsync % 10, st->underrun);
+    color[n] = GFX_RGB(255, 255, 255);
+    snprintf(text[n++], HUD_COLS, "DTCM %2dK/%2dK  AXI %2dK/%2dK", dtcm.used / 1024, dtcm.total / 1024,
+             axi.used / 1024, axi.total / 1024);
+    color[n] = GFX_RGB(255, 255, 255);
+    snprintf(text[n++], HUD_COLS, "SDRAM %5dK/%5dK  peak %5dK", sdram.used / 1024, sdram.total / 1024,
+             sdram.peak / 1024);
+    for (i = 0; i < 8 && n < HUD_LINES; i++)
+    {
+        if (st->com & (1 << i))
+        {
+            color[n] = GFX_RGB(128, 200, 255);
+            snprintf(text[n++], HUD_COLS, "COM%d TX %6d B/s  RX %6d B/s", i + 1, st->tx[i], st->rx[i]);
+        }
+    }
+
+    TFT_GetLayer(HUD_LAYER, &lcd);
+    lcd.width = (lcd.width < HUD_WIDTH) ? lcd.width : HUD_WIDTH;
+    for (i = 0; i < n; i++)
+    {
+        if (!strcmp(text[i], h->line[i]))
+        {
+            continue;
+        }
+        GFX_FillRect(&lcd, 0, i * lh, lcd.width, lh, HUD_BG);
+        FONT_DrawString(&h->font, &lcd, HUD_MARGIN, i * lh, text[i], color[i]);
+        strcpy(h->line[i], text[i]);
+    }
+
+    if (n != h->rows)
+    {
+        for (i = n; i < h->rows; i++)
+        {
+            h->line[i][0] = 0;
+        }
+        h->rows = n;
+        TFT_SetLayerWindow(HUD_LAYER, 0, 0, lcd.width, n * lh);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Show
+*    功能说明: 显示叠加层。第2层改为 ARGB4444 格式，画布宽度限制为 HUD_WIDTH
+*    形    参: _pFont : 资源包中的字库名，NULL 使用 HUD_FONT
+*    返 回 值: 0 表示成功，-1 表示没有字库或LCD未初始化
+*********************************************************************************************************
+*/
+int HUD_Show(const char *_pFont)
+{
+    HUD_T *h = &s_tHud;
+    GFX_SURFACE_T lcd;
+
+    if (h->on)
+    {
+        return 0;
+    }
+    if (FONT_Open((_pFont != NULL) ? _pFont : HUD_FONT, &h->font) != 0)
+    {
+        return -1;
+    }
+    if (TFT_SetLayerFormat(HUD_LAYER, GFX_ARGB4444) != 0)
+    {
+        FONT_Close(&h->font);
+        return -1;
+    }
+
+    /* 透明背景，窗口在第一次刷新时缩小到文字区域 */
+    TFT_GetLayer(HUD_LAYER, &lcd);
+    lcd.width = (lcd.width < HUD_WIDTH) ? lcd.width : HUD_WIDTH;
+    GFX_FillRect(&lcd, 0, 0, lcd.width, HUD_LINES * h->font.head.line_height, 0);
+    memset(h->line, 0, sizeof(h->line));
+    h->rows = 0;
+    h->on = 1;
+    HUD_Draw();
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Hide
+*    功能说明: 关闭叠加层，第2层关闭，释放字库
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HUD_Hide(void)
+{
+    HUD_T *h = &s_tHud;
+
+    if (!h->on)
+    {
+        return;
+    }
+    h->on = 0;
+    TFT_SetLayerWindow(HUD_LAYER, 0, 0, 0, 0);
+    FONT_Close(&h->font);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Toggle
+*    功能说明: 切换叠加层的显示，用于组合键 K1 + K2
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HUD_Toggle(void)
+{
+    if (s_tHud.on)
+    {
+        HUD_Hide();
+    }
+    else
+    {
+        HUD_Show(NULL);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_Idle
+*    功能说明: 每次主循环调用一次(bsp_Idle)。统计循环时间，每 HUD_PERIOD 计算一次结果，显示时刷新叠加层
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HUD_Idle(void)
+{
+    HUD_T *h = &s_tHud;
+    int64_t now = get_system_ticks();
+
+    if (h->last != 0 && now - h->last < h->min)
+    {
+        h->min = now - h->last;
+    }
+    h->last = now;
+    h->loops++;
+
+    if (h->start == 0)
+    {
+        h->start = now;
+        h->loops = 0;
+        return;
+    }
+    if (now - h->start < (int64_t)HUD_PERIOD * (SystemCoreClock / 1000))
+    {
+        return;
+    }
+
+    HUD_Sample(now);
+    if (h->on)
+    {
+        HUD_Draw();
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HUD_GetStat
+*    功能说明: 读取最近一个统计周期的结果，叠加层关闭时也在统计
+*    形    参: _pStat : 统计结果
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HUD_GetStat(HUD_STAT_T *_pStat)
+{
+    *_pStat = s_tHud.stat;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+static int cmd_hud(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "hud on [font]",
+        "hud off",
+        "hud stat"};
+
+    HUD_STAT_T st;
+
+    if (argc > 1 && !strcmp(argv[1], "on"))
+    {
+        if (HUD_Show((argc > 2) ? argv[2] : NULL) != 0)
+        {
+            printf("no font, make with: font_gen.py font.ttf 16 %s.fnt --charset ascii, asset_pack.py --raw %s.fnt\r\n",
+                   HUD_FONT, HUD_FONT);
+            return -1;
+        }
+        return 0;
+    }
+    else if (argc > 1 && !strcmp(argv[1], "off"))
+    {
+        HUD_Hide();
+        return 0;
+    }
+    else if (argc > 1 && !strcmp(argv[1], "stat"))
+    {
+        HUD_GetStat(&st);
+        printf("cpu %d.%d%%, loop %d Hz, fps %d.%d, vsync %d.%d Hz, underrun %d\r\n", st.load / 10, st.load % 10,
+               st.loop_hz, st.fps / 10, st.fps % 10, st.vsync / 10, st.vsync % 10, st.underrun);
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            if (st.com & (1 << i))
+            {
+                printf("COM%d tx %d B/s, rx %d B/s\r\n", i + 1, st.tx[i], st.rx[i]);
+            }
+        }
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), hud, cmd_hud, hud[on off stat]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,723 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 硬件JPEG解码模块
+*    文件名称 : bsp_jpeg.c
+*    版    本 : V1.0
+*    说    明 : JPEG编解码器 + MDMA + DMA2D 解码流水线，CPU只处理回调。
+*               1. 数据来源：QSPI Flash中的资源(JPEG_DecodeAsset/JPEG_DecodeFlash)，两个4KB输入缓冲轮流
+*                  由 QSPI_ReadAsync 填充，解码器读完一个缓冲时另一个已经在读取；或者内存中的数据
+*                  (JPEG_DecodeMem)，例如串口接收到SDRAM中的图片，分段直接送入解码器
+*               2. 输入MDMA(通道2)把数据送入JPEG输入FIFO，输出MDMA(通道3)把YCbCr MCU块写入SDRAM，
+*                  每段 JPEG_OUT_CHUNK 字节
+*               3. 解码完成后一条DMA2D命令把整幅图像的MCU块转换为目标格式，直接写入显存
+*               4. 只支持基线YCbCr图像，灰度、CMYK以及超出目标区域的图像在读到文件头后停止
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_jpeg.h"
+
+/* 解码状态 */
+#define JPEG_BUSY 0
+#define JPEG_DONE 1
+#define JPEG_ERR_FORMAT -2 /* 格式不支持或图像超出目标区域 */
+#define JPEG_ERR_DECODE -3 /* 数据错误或超时 */
+
+typedef struct
+{
+    /* 数据来源 */
+    uint8_t flash;                         /* 1 表示从QSPI Flash读取，0 表示内存 */
+    const uint8_t *src;                    /* 内存数据下一段的地址 */
+    uint32_t addr;                         /* Flash下一次读取的地址 */
+    uint32_t remain;                       /* 内存：未送入解码器的字节数；Flash：未读取的字节数 */
+    uint8_t *in[JPEG_IN_NUM];              /* Flash输入缓冲 */
+    volatile uint32_t in_len[JPEG_IN_NUM]; /* 缓冲中的字节数，0 表示空 */
+    uint32_t in_pos;                       /* 当前缓冲已解码的字节数 */
+    uint8_t rd;                            /* 解码器正在读取的缓冲 */
+    uint8_t wr;                            /* 下一个填充的缓冲 */
+    volatile uint8_t loading;              /* QSPI正在填充 */
+    volatile uint8_t paused;               /* 输入缓冲都空，暂停了解码器的输入 */
+
+    /* MCU块输出缓冲 */
+    uint8_t *out;
+    uint32_t out_size;
+    uint32_t out_len;
+    uint16_t max_w; /* 图像允许的最大宽度和高度 */
+    uint16_t max_h;
+
+    JPEG_ConfTypeDef info;
+    volatile int8_t state; /* JPEG_BUSY / JPEG_DONE / 错误码 */
+    int64_t ticks;         /* 解码完成的时刻 */
+} JPEG_CTX_T;
+
+JPEG_HandleTypeDef hjpeg;
+MDMA_HandleTypeDef hmdma_jpeg_in;
+MDMA_HandleTypeDef hmdma_jpeg_out;
+
+static JPEG_CTX_T s_tJpeg;
+
+static void JPEG_Fill(void);
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitJpeg
+*    功能说明: 初始化JPEG编解码器，MDMA通道在 HAL_JPEG_MspInit 中配置
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitJpeg(void)
+{
+    hjpeg.Instance = JPEG;
+    if (HAL_JPEG_Init(&hjpeg) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_MspInit
+*    功能说明: 时钟、MDMA和中断配置。MDMA按FIFO阀值(8字)请求，每次传输32字节
+*    形    参: hjpeg : JPEG句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_MspInit(JPEG_HandleTypeDef *hjpeg)
+{
+    __HAL_RCC_JPGDECEN_CLK_ENABLE();
+    __HAL_RCC_MDMA_CLK_ENABLE();
+
+    /* 输入：内存按字节读取，打包成字写入输入FIFO。通道0由QSPI使用，通道1由SDRAM测试使用 */
+    hmdma_jpeg_in.Instance = MDMA_Channel2;
+    hmdma_jpeg_in.Init.Request = MDMA_REQUEST_JPEG_INFIFO_TH;
+    hmdma_jpeg_in.Init.TransferTriggerMode = MDMA_BUFFER_TRANSFER;
+    hmdma_jpeg_in.Init.Priority = MDMA_PRIORITY_HIGH;
+    hmdma_jpeg_in.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    hmdma_jpeg_in.Init.SourceInc = MDMA_SRC_INC_BYTE;
+    hmdma_jpeg_in.Init.DestinationInc = MDMA_DEST_INC_DISABLE;
+    hmdma_jpeg_in.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+    hmdma_jpeg_in.Init.DestDataSize = MDMA_DEST_DATASIZE_WORD;
+    hmdma_jpeg_in.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    hmdma_jpeg_in.Init.BufferTransferLength = 32;
+    hmdma_jpeg_in.Init.SourceBurst = MDMA_SOURCE_BURST_32BEATS;
+    hmdma_jpeg_in.Init.DestBurst = MDMA_DEST_BURST_16BEATS;
+    hmdma_jpeg_in.Init.SourceBlockAddressOffset = 0;
+    hmdma_jpeg_in.Init.DestBlockAddressOffset = 0;
+    if (HAL_MDMA_Init(&hmdma_jpeg_in) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+    __HAL_LINKDMA(hjpeg, hdmain, hmdma_jpeg_in);
+
+    /* 输出：从输出FIFO按字读取，按字节写入SDRAM */
+    hmdma_jpeg_out.Instance = MDMA_Channel3;
+    hmdma_jpeg_out.Init.Request = MDMA_REQUEST_JPEG_OUTFIFO_TH;
+    hmdma_jpeg_out.Init.TransferTriggerMode = MDMA_BUFFER_TRANSFER;
+    hmdma_jpeg_out.Init.Priority = MDMA_PRIORITY_VERY_HIGH;
+    hmdma_jpeg_out.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    hmdma_jpeg_out.Init.SourceInc = MDMA_SRC_INC_DISABLE;
+    hmdma_jpeg_out.Init.DestinationInc = MDMA_DEST_INC_BYTE;
+    hmdma_jpeg_out.Init.SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+    hmdma_jpeg_out.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+    hmdma_jpeg_out.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    hmdma_jpeg_out.Init.BufferTransferLength = 32;
+    hmdma_jpeg_out.Init.SourceBurst = MDMA_SOURCE_BURST_32BEATS;
+    hmdma_jpeg_out.Init.DestBurst = MDMA_DEST_BURST_32BEATS;
+    hmdma_jpeg_out.Init.SourceBlockAddressOffset = 0;
+    hmdma_jpeg_out.Init.DestBlockAddressOffset = 0;
+    if (HAL_MDMA_Init(&hmdma_jpeg_out) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+    __HAL_LINKDMA(hjpeg, hdmaout, hmdma_jpeg_out);
+
+    /* 与MDMA中断同一优先级，QSPI读取完成和解码器的回调不会互相打断 */
+    HAL_NVIC_SetPriority(JPEG_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(JPEG_IRQn);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_IRQHandler
+*    功能说明: JPEG中断服务程序。MDMA完成中断在 bsp_dma.c 的 MDMA_IRQHandler 中处理
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void JPEG_IRQHandler(void)
+{
+    HAL_JPEG_IRQHandler(&hjpeg);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_ReadDone
+*    功能说明: QSPI读取完成回调(中断中执行)。解码器因为没有数据暂停时，从刚读完的缓冲恢复输入
+*    形    参: _pArg : 本次读取的有效字节数
+*              _iStatus : 0 表示成功
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void JPEG_ReadDone(void *_pArg, int _iStatus)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+    uint32_t n = (uint32_t)_pArg;
+    uint8_t idx = j->wr;
+
+    j->loading = 0;
+    if (j->state != JPEG_BUSY)
+    {
+        return; /* 解码已经结束或出错，丢弃预读的数据 */
+    }
+    if (_iStatus != 0)
+    {
+        j->state = JPEG_ERR_DECODE;
+        return;
+    }
+
+    /* 最后一段长度按4字节向上取整，HAL只送入4的整数倍字节，多读的是资源的0xFF填充 */
+    j->addr += n;
+    j->remain -= n;
+    j->in_len[idx] = (n + 3) & ~3UL;
+    j->wr = (idx + 1) % JPEG_IN_NUM;
+
+    if (j->paused && idx == j->rd)
+    {
+        j->paused = 0;
+        j->in_pos = 0;
+        HAL_JPEG_ConfigInputBuffer(&hjpeg, j->in[idx], j->in_len[idx]);
+        HAL_JPEG_Resume(&hjpeg, JPEG_PAUSE_RESUME_INPUT);
+    }
+
+    JPEG_Fill();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_Fill
+*    功能说明: 下一个输入缓冲为空时开始QSPI读取，一次只有一个读取请求
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void JPEG_Fill(void)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+    uint32_t n;
+
+    if (j->loading || j->remain == 0 || j->in_len[j->wr] != 0 || j->state != JPEG_BUSY)
+    {
+        return;
+    }
+
+    n = (j->remain < JPEG_IN_SIZE) ? j->remain : JPEG_IN_SIZE;
+    j->loading = 1;
+    if (QSPI_ReadAsync(j->in[j->wr], j->addr, (n + 3) & ~3UL, JPEG_ReadDone, (void *)n) != 0)
+    {
+        j->loading = 0;
+        j->state = JPEG_ERR_DECODE;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_InfoReadyCallback
+*    功能说明: 解析完文件头。不支持的格式或超出目标区域时暂停输入输出，由 JPEG_Run 终止解码
+*    形    参: hjpeg : JPEG句柄
+*              pInfo : 图像信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_InfoReadyCallback(JPEG_HandleTypeDef *hjpeg, JPEG_ConfTypeDef *pInfo)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+
+    j->info = *pInfo;
+    if (pInfo->ColorSpace != JPEG_YCBCR_COLORSPACE || pInfo->ImageWidth > j->max_w ||
+        pInfo->ImageHeight > j->max_h)
+    {
+        HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_INPUT_OUTPUT);
+        j->state = JPEG_ERR_FORMAT;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_GetDataCallback
+*    功能说明: 解码器取走了 NbDecodedData 字节，送入下一段数据。Flash数据还没有读到时暂停输入
+*    形    参: hjpeg : JPEG句柄
+*              NbDecodedData : 上次送入的数据中已解码的字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_GetDataCallback(JPEG_HandleTypeDef *hjpeg, uint32_t NbDecodedData)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+    uint32_t n;
+
+    if (!j->flash)
+    {
+        j->src += NbDecodedData;
+        j->remain -= NbDecodedData;
+        if (j->remain == 0)
+        {
+            HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_INPUT);
+            return;
+        }
+        n = (j->remain < JPEG_MEM_CHUNK) ? j->remain : JPEG_MEM_CHUNK;
+        HAL_JPEG_ConfigInputBuffer(hjpeg, (uint8_t *)j->src, n);
+        return;
+    }
+
+    /* 缓冲只解码了一部分(文件头解析完时)，送入剩余部分 */
+    j->in_pos += NbDecodedData;
+    if (j->in_pos < j->in_len[j->rd])
+    {
+        HAL_JPEG_ConfigInputBuffer(hjpeg, j->in[j->rd] + j->in_pos, j->in_len[j->rd] - j->in_pos);
+        return;
+    }
+
+    /* 缓冲用完，交给QSPI重新填充，切换到下一个缓冲 */
+    j->in_len[j->rd] = 0;
+    j->in_pos = 0;
+    j->rd = (j->rd + 1) % JPEG_IN_NUM;
+    JPEG_Fill();
+
+    if (j->in_len[j->rd] != 0)
+    {
+        HAL_JPEG_ConfigInputBuffer(hjpeg, j->in[j->rd], j->in_len[j->rd]);
+    }
+    else
+    {
+        HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_INPUT);
+        j->paused = 1;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_DataReadyCallback
+*    功能说明: 输出了一段MCU块，输出缓冲向后移动
+*    形    参: hjpeg : JPEG句柄
+*              pDataOut : 本段数据地址
+*              OutDataLength : 本段字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_DataReadyCallback(JPEG_HandleTypeDef *hjpeg, uint8_t *pDataOut, uint32_t OutDataLength)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+    uint32_t n;
+
+    j->out_len += OutDataLength;
+    n = j->out_size - j->out_len;
+    if (n > JPEG_OUT_CHUNK)
+    {
+        n = JPEG_OUT_CHUNK;
+    }
+
+    /* 文件头已检查过图像大小，输出缓冲不会用完，用完时暂停输出，由超时终止 */
+    if (n == 0)
+    {
+        HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_OUTPUT);
+        return;
+    }
+    HAL_JPEG_ConfigOutputBuffer(hjpeg, j->out + j->out_len, n);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_DecodeCpltCallback
+*    功能说明: 解码完成，记录完成时刻
+*    形    参: hjpeg : JPEG句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_DecodeCpltCallback(JPEG_HandleTypeDef *hjpeg)
+{
+    s_tJpeg.ticks = get_system_ticks();
+    s_tJpeg.state = JPEG_DONE;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_JPEG_ErrorCallback
+*    功能说明: 解码器或MDMA错误
+*    形    参: hjpeg : JPEG句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void HAL_JPEG_ErrorCallback(JPEG_HandleTypeDef *hjpeg)
+{
+    s_tJpeg.state = JPEG_ERR_DECODE;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_Run
+*    功能说明: 解码 s_tJpeg 中设定的数据源，MCU块写入SDRAM后用DMA2D转换到目标图像。
+*              输出缓冲按目标区域大小、MCU块对齐和 4:4:4(每像素3字节) 分配
+*    形    参: _pDst : 目标图像
+*              _x, _y : 图像左上角在目标中的位置
+*              _usMaxW, _usMaxH : 图像的最大宽度、高度，0 表示到目标的右边、下边为止
+*              _pResult : 返回图像信息和时间，可以为NULL
+*    返 回 值: 0 表示成功，-1 表示参数错误或内存不足，-2 表示格式不支持，-3 表示解码错误
+*********************************************************************************************************
+*/
+static int JPEG_Run(const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y, uint16_t _usMaxW, uint16_t _usMaxH,
+                    JPEG_RESULT_T *_pResult)
+{
+    JPEG_CTX_T *j = &s_tJpeg;
+    const uint8_t css[3] = {GFX_CSS_444, GFX_CSS_420, GFX_CSS_422}; /* HAL与DMA2D的抽样方式编码不同 */
+    uint8_t *first;
+    uint32_t first_len;
+    uint32_t tick;
+    int64_t ticks;
+    int ret = -1;
+
+    if (_pDst->format > GFX_ARGB4444 || _x < 0 || _y < 0 || _x >= _pDst->width || _y >= _pDst->height)
+    {
+        return -1;
+    }
+    j->max_w = _pDst->width - _x;
+    j->max_h = _pDst->height - _y;
+    if (_usMaxW != 0 && _usMaxW < j->max_w)
+    {
+        j->max_w = _usMaxW;
+    }
+    if (_usMaxH != 0 && _usMaxH < j->max_h)
+    {
+        j->max_h = _usMaxH;
+    }
+
+    j->out_size = (uint32_t)((j->max_w + 15) & ~15) * ((j->max_h + 15) & ~15) * 3;
+    j->out_len = 0;
+    j->out = Mem_AllocAlign(MEM_SDRAM, j->out_size, 32);
+    j->in[0] = NULL;
+    j->in[1] = NULL;
+    j->in_len[0] = 0;
+    j->in_len[1] = 0;
+    j->in_pos = 0;
+    j->rd = 0;
+    j->wr = 0;
+    j->loading = 0;
+    j->paused = 0;
+    j->state = JPEG_BUSY;
+    if (j->out == NULL)
+    {
+        return -1;
+    }
+    /* MDMA直接写SDRAM，先作废Cache，避免脏数据写回覆盖解码结果 */
+    SCB_InvalidateDCache_by_Addr((uint32_t *)j->out, j->out_size);
+
+    tick = HAL_GetTick();
+    ticks = get_system_ticks();
+    if (j->flash)
+    {
+        j->in[0] = Pool_AllocClass(POOL_4K);
+        j->in[1] = Pool_AllocClass(POOL_4K);
+        if (j->in[0] == NULL || j->in[1] == NULL)
+        {
+            goto out;
+        }
+
+        /* 等第一个缓冲读完再启动解码，第二个缓冲在回调中接着读取 */
+        JPEG_Fill();
+        while (j->in_len[0] == 0 && j->state == JPEG_BUSY && HAL_GetTick() - tick < JPEG_TIMEOUT)
+        {
+        }
+        if (j->in_len[0] == 0)
+        {
+            ret = -3;
+            goto out;
+        }
+        first = j->in[0];
+        first_len = j->in_len[0];
+    }
+    else
+    {
+        /* 数据由CPU写入(例如串口接收)，Clean后MDMA才能读到 */
+        SCB_CleanDCache_by_Addr((uint32_t *)((uint32_t)j->src & ~31UL), j->remain + 32);
+        first = (uint8_t *)j->src;
+        first_len = (j->remain < JPEG_MEM_CHUNK) ? j->remain : JPEG_MEM_CHUNK;
+    }
+
+    if (HAL_JPEG_Decode_DMA(&hjpeg, first, first_len, j->out, JPEG_OUT_CHUNK) != HAL_OK)
+    {
+        ret = -3;
+        goto out;
+    }
+    while (j->state == JPEG_BUSY && HAL_GetTick() - tick < JPEG_TIMEOUT)
+    {
+    }
+    if (j->state != JPEG_DONE)
+    {
+        HAL_JPEG_Abort(&hjpeg);
+        ret = (j->state == JPEG_ERR_FORMAT) ? -2 : -3;
+        goto out;
+    }
+    ticks = j->ticks - ticks;
+
+    if (_pResult != NULL)
+    {
+        _pResult->width = j->info.ImageWidth;
+        _pResult->height = j->info.ImageHeight;
+        _pResult->css = css[j->info.ChromaSubsampling];
+        _pResult->decode_us = (uint32_t)(ticks / (SystemCoreClock / 1000000ul));
+    }
+
+    /* DMA2D转换。先等之前排队的命令完成，转换时间只计本次 */
+    GFX_Wait();
+    ticks = get_system_ticks();
+    GFX_BlitYCbCr(_pDst, _x, _y, (uint32_t)j->out, j->info.ImageWidth, j->info.ImageHeight,
+                  css[j->info.ChromaSubsampling]);
+    GFX_Wait();
+    ticks = get_system_ticks() - ticks;
+    if (_pResult != NULL)
+    {
+        _pResult->convert_us = (uint32_t)(ticks / (SystemCoreClock / 1000000ul));
+    }
+    ret = 0;
+
+out:
+    /* 解码结束后可能还有预读的QSPI请求，等它完成再释放输入缓冲 */
+    if (j->state == JPEG_BUSY)
+    {
+        j->state = JPEG_ERR_DECODE;
+    }
+    if (j->flash)
+    {
+        QSPI_WaitAsync();
+    }
+    Pool_Free(j->in[0]);
+    Pool_Free(j->in[1]);
+    Mem_Free(j->out);
+    j->out = NULL;
+
+    return ret;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_DecodeFlash
+*    功能说明: 解码QSPI Flash中的JPEG数据，边读取边解码
+*    形    参: _uiAddr : Flash地址，4字节对齐
+*              _uiSize : JPEG数据字节数
+*              _pDst : 目标图像，格式为 ARGB8888 / RGB888 / RGB565 / ARGB1555 / ARGB4444
+*              _x, _y : 图像左上角在目标中的位置，图像必须完全在目标内
+*              _pResult : 返回图像信息和时间，可以为NULL
+*    返 回 值: 0 表示成功，-1 表示参数错误或内存不足，-2 表示格式不支持，-3 表示解码错误
+*********************************************************************************************************
+*/
+int JPEG_DecodeFlash(uint32_t _uiAddr, uint32_t _uiSize, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                     JPEG_RESULT_T *_pResult)
+{
+    s_tJpeg.flash = 1;
+    s_tJpeg.addr = _uiAddr;
+    s_tJpeg.remain = _uiSize;
+    if (_pResult != NULL)
+    {
+        _pResult->bytes = _uiSize;
+    }
+
+    return JPEG_Run(_pDst, _x, _y, 0, 0, _pResult);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_DecodeAsset
+*    功能说明: 解码资源包中的JPEG图片，资源需用 asset_pack.py --jpeg 打包(不压缩，保持JPEG格式)
+*    形    参: _pAsset : Asset_Open 得到的资源
+*              _pDst : 目标图像
+*              _x, _y : 图像左上角在目标中的位置
+*              _pResult : 返回图像信息和时间，可以为NULL
+*    返 回 值: 0 表示成功，-1 表示参数错误或内存不足，-2 表示格式不支持，-3 表示解码错误
+*********************************************************************************************************
+*/
+int JPEG_DecodeAsset(const ASSET_T *_pAsset, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                     JPEG_RESULT_T *_pResult)
+{
+    if (_pAsset->method != ASSET_METHOD_RAW || _pAsset->param[2] != ASSET_FMT_JPEG)
+    {
+        return -2;
+    }
+
+    s_tJpeg.flash = 1;
+    s_tJpeg.addr = ASSET_FLASH_ADDR + _pAsset->offset;
+    s_tJpeg.remain = _pAsset->size;
+    if (_pResult != NULL)
+    {
+        _pResult->bytes = _pAsset->size;
+    }
+
+    /* 索引中有宽高时输出缓冲按图像大小分配 */
+    return JPEG_Run(_pDst, _x, _y, _pAsset->param[0], _pAsset->param[1], _pResult);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: JPEG_DecodeMem
+*    功能说明: 解码内存中的JPEG数据，例如串口接收到SDRAM中的图片。数据必须在MDMA能访问的内存中
+*    形    参: _pData : JPEG数据。长度不是4的整数倍时最多多读3字节
+*              _uiSize : 字节数
+*              _pDst : 目标图像
+*              _x, _y : 图像左上角在目标中的位置
+*              _pResult : 返回图像信息和时间，可以为NULL
+*    返 回 值: 0 表示成功，-1 表示参数错误或内存不足，-2 表示格式不支持，-3 表示解码错误
+*********************************************************************************************************
+*/
+int JPEG_DecodeMem(const uint8_t *_pData, uint32_t _uiSize, const GFX_SURFACE_T *_pDst, int16_t _x, int16_t _y,
+                   JPEG_RESULT_T *_pResult)
+{
+    if (_uiSize == 0)
+    {
+        return -1;
+    }
+
+    s_tJpeg.flash = 0;
+    s_tJpeg.src = _pData;
+    s_tJpeg.remain = (_uiSize + 3) & ~3UL; /* HAL只送入4的整数倍字节，否则结束标记可能送不进去 */
+    if (_pResult != NULL)
+    {
+        _pResult->bytes = _uiSize;
+    }
+
+    return JPEG_Run(_pDst, _x, _y, 0, 0, _pResult);
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 打印解码时间和速度 */
+static void jpeg_print(const char *_name, const JPEG_RESULT_T *_pRes)
+{
+    static const char *css[] = {"4:4:4", "4:2:2", "4:2:0"};
+    uint32_t us = (_pRes->decode_us != 0) ? _pRes->decode_us : 1;
+    uint32_t rate = (uint32_t)((uint64_t)_pRes->bytes * 100 / us);
+    uint32_t pix = (uint32_t)((uint64_t)_pRes->width * _pRes->height * 100 / us);
+
+    printf("%-6s: %dx%d %s %7d bytes, decode %6d us %3d.%02d MB/s %3d.%02d Mpix/s, convert %5d us\r\n",
+           _name, _pRes->width, _pRes->height, css[_pRes->css], _pRes->bytes, _pRes->decode_us,
+           rate / 100, rate % 100, pix / 100, pix % 100, _pRes->convert_us);
+}
+
+static int cmd_jpeg(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "jpeg show name",
+        "jpeg bench name [loops]"};
+
+    ASSET_T asset;
+    GFX_SURFACE_T lcd;
+    JPEG_RESULT_T res;
+    int16_t x, y;
+    int ret;
+
+    if (argc < 3)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+        return -1;
+    }
+
+    if (Asset_Open(argv[2], &asset) != 0 || asset.param[2] != ASSET_FMT_JPEG)
+    {
+        printf("%s not found, pack with: asset_pack.py --jpeg %s.jpg\r\n", argv[2], argv[2]);
+        return -1;
+    }
+
+    /* 直接解码到第1层当前显示的显存，图像居中 */
+    TFT_GetLayer(0, &lcd);
+    x = (lcd.width > asset.param[0]) ? (lcd.width - asset.param[0]) / 2 : 0;
+    y = (lcd.height > asset.param[1]) ? (lcd.height - asset.param[1]) / 2 : 0;
+
+    if (!strcmp(argv[1], "show"))
+    {
+        GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_RGB(0, 0, 0));
+        ret = JPEG_DecodeAsset(&asset, &lcd, x, y, &res);
+        if (ret != 0)
+        {
+            printf("decode error %d\r\n", ret);
+            return -1;
+        }
+        jpeg_print("flash", &res);
+
+        return 0;
+    }
+    else if (!strcmp(argv[1], "bench"))
+    {
+        /* 分别从QSPI Flash边读边解码，和从SDRAM中解码(相当于串口接收的数据) */
+        uint32_t loops = (argc > 3) ? strtoul(argv[3], NULL, 0) : 10;
+        JPEG_RESULT_T sum = {0};
+        uint8_t *buf;
+
+        if (loops == 0)
+        {
+            loops = 1;
+        }
+        for (uint32_t i = 0; i < loops; i++)
+        {
+            if (JPEG_DecodeAsset(&asset, &lcd, x, y, &res) != 0)
+            {
+                printf("decode error\r\n");
+                return -1;
+            }
+            sum.decode_us += res.decode_us;
+            sum.convert_us += res.convert_us;
+        }
+        res.decode_us = sum.decode_us / loops;
+        res.convert_us = sum.convert_us / loops;
+        jpeg_print("flash", &res);
+
+        buf = Mem_AllocAlign(MEM_SDRAM, asset.size + 4, 32);
+        if (buf == NULL || Asset_Load(&asset, buf, asset.size + 4) != 0)
+        {
+            Mem_Free(buf);
+            printf("no memory\r\n");
+            return -1;
+        }
+        sum.decode_us = 0;
+        sum.convert_us = 0;
+        for (uint32_t i = 0; i < loops; i++)
+        {
+            if (JPEG_DecodeMem(buf, asset.size, &lcd, x, y, &res) != 0)
+            {
+                Mem_Free(buf);
+                printf("decode error\r\n");
+                return -1;
+            }
+            sum.decode_us += res.decode_us;
+            sum.convert_us += res.convert_us;
+        }
+        Mem_Free(buf);
+        res.decode_us = sum.decode_us / loops;
+        res.convert_us = sum.convert_us / loops;
+        jpeg_print("sdram", &res);
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), jpeg, cmd_jpeg, jpeg[show bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -375,6 +375,10 @@ void bsp_key_test(void)
             bsp_LedToggle(4);
             break;
 
+        case KEY_PRESS_DOWN(KID_K1_K2): /* K1、K2同时按下，切换性能叠加层 */
+            HUD_Toggle();
+            break;
+
         default:
             break;
         }
@@ -0,0 +1,782 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 多内存堆管理模块
+*    文件名称 : bsp_mem.c
+*    版    本 : V1.0
+*    说    明 : TLSF(Two-Level Segregated Fit)内存分配器，分配和释放都是O(1)，执行时间确定。
+*               1. 空闲块按大小分级: 一级按2的幂，二级把每个2的幂区间再分16份，每级用位图记录非空链表
+*               2. 分配时用CLZ在位图中找到第一个足够大的链表，取出后切分，剩余部分放回空闲链表
+*               3. 释放时与物理上相邻的空闲块合并，减少碎片
+*               4. DTCM、AXI SRAM、SDRAM各一个独立的堆，按用途选择: 频繁访问的小数据放DTCM，
+*                  DMA缓冲放AXI SRAM，图片、大数组放SDRAM
+*               C库的 malloc 仍使用 AXI SRAM 剩余空间，两者互不影响。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_fmc_sdram.h"
+#include "bsp_mem.h"
+
+#define MEM_SL_LOG2 4                                 /* 二级分为16份 */
+#define MEM_SL_COUNT (1 << MEM_SL_LOG2)               /* 二级链表个数 */
+#define MEM_FL_SHIFT (MEM_SL_LOG2 + 3)                /* 小于128字节的块都放在一级0中，按8字节分级 */
+#define MEM_FL_MAX 25                                 /* 最大块32MB */
+#define MEM_FL_COUNT (MEM_FL_MAX - MEM_FL_SHIFT + 1)  /* 一级链表个数 */
+#define MEM_SMALL_SIZE (1UL << MEM_FL_SHIFT)          /* 小块上限 */
+
+/*
+    块头。size为数据区字节数，bit0为1表示空闲。prev_phys指向物理上的前一个块，用于释放时合并。
+    next_free/prev_free只在空闲块中有效，占用数据区，所以已分配块的开销只有8字节。
+*/
+typedef struct MEM_BLOCK
+{
+    struct MEM_BLOCK *prev_phys;
+    uint32_t size;
+    struct MEM_BLOCK *next_free;
+    struct MEM_BLOCK *prev_free;
+} MEM_BLOCK_T;
+
+#define MEM_HEAD_SIZE 8                                    /* prev_phys + size */
+#define MEM_BLOCK_MIN (sizeof(MEM_BLOCK_T) - MEM_HEAD_SIZE) /* 数据区最小字节数，放得下空闲链表指针 */
+#define MEM_FREE_BIT 1UL
+
+#define BLOCK_SIZE(b) ((b)->size & ~MEM_FREE_BIT)
+#define BLOCK_IS_FREE(b) ((b)->size & MEM_FREE_BIT)
+#define BLOCK_DATA(b) ((void *)((uint8_t *)(b) + MEM_HEAD_SIZE))
+#define BLOCK_FROM_DATA(p) ((MEM_BLOCK_T *)((uint8_t *)(p) - MEM_HEAD_SIZE))
+#define BLOCK_NEXT(b) ((MEM_BLOCK_T *)((uint8_t *)(b) + MEM_HEAD_SIZE + BLOCK_SIZE(b)))
+
+typedef struct
+{
+    const char *name;
+    uint8_t *base;
+    uint32_t size;
+
+    uint32_t fl_bitmap;                              /* 一级位图 */
+    uint32_t sl_bitmap[MEM_FL_COUNT];                /* 二级位图 */
+    MEM_BLOCK_T *blocks[MEM_FL_COUNT][MEM_SL_COUNT]; /* 空闲链表 */
+
+    uint32_t used;
+    uint32_t peak;
+    uint32_t fail;
+} MEM_HEAP_T;
+
+__attribute__((aligned(32))) static uint8_t s_ucAxiHeap[MEM_AXI_SIZE];
+
+static MEM_HEAP_T s_tHeap[MEM_HEAP_NUM] = {
+    {"dtcm", (uint8_t *)MEM_DTCM_ADDR, MEM_DTCM_SIZE},
+    {"axi", s_ucAxiHeap, MEM_AXI_SIZE},
+    {"sdram", (uint8_t *)SDRAM_APP_BUF, SDRAM_APP_SIZE},
+};
+
+/* 最高位1的位置，_x不能为0 */
+static inline uint32_t Mem_Fls(uint32_t _x)
+{
+    return 31 - __CLZ(_x);
+}
+
+/* 最低位1的位置，_x不能为0 */
+static inline uint32_t Mem_Ffs(uint32_t _x)
+{
+    return __CLZ(__RBIT(_x));
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Mapping
+*    功能说明: 计算块大小所在的一级和二级链表
+*    形    参: _uiSize : 数据区字节数
+*              _pFl : 一级序号
+*              _pSl : 二级序号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void Mem_Mapping(uint32_t _uiSize, uint32_t *_pFl, uint32_t *_pSl)
+{
+    uint32_t fl;
+
+    if (_uiSize < MEM_SMALL_SIZE)
+    {
+        *_pFl = 0;
+        *_pSl = _uiSize / (MEM_SMALL_SIZE / MEM_SL_COUNT);
+    }
+    else
+    {
+        fl = Mem_Fls(_uiSize);
+        *_pSl = (_uiSize >> (fl - MEM_SL_LOG2)) ^ (1UL << MEM_SL_LOG2);
+        *_pFl = fl - MEM_FL_SHIFT + 1;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_FindSuitable
+*    功能说明: 查找能满足分配的空闲链表。请求大小先向上取整到下一级，链表中任意一个块都足够大
+*    形    参: _ptHeap : 堆
+*              _uiSize : 数据区字节数
+*              _pFl : 返回一级序号
+*              _pSl : 返回二级序号
+*    返 回 值: 空闲块，NULL表示没有足够大的块
+*********************************************************************************************************
+*/
+static MEM_BLOCK_T *Mem_FindSuitable(MEM_HEAP_T *_ptHeap, uint32_t _uiSize, uint32_t *_pFl, uint32_t *_pSl)
+{
+    uint32_t fl, sl, map;
+
+    if (_uiSize >= MEM_SMALL_SIZE)
+    {
+        _uiSize += (1UL << (Mem_Fls(_uiSize) - MEM_SL_LOG2)) - 1;
+    }
+    Mem_Mapping(_uiSize, &fl, &sl);
+    if (fl >= MEM_FL_COUNT)
+    {
+        return NULL;
+    }
+
+    /* 同一级中更大的二级链表 */
+    map = _ptHeap->sl_bitmap[fl] & (~0UL << sl);
+    if (map == 0)
+    {
+        /* 更大的一级链表 */
+        map = _ptHeap->fl_bitmap & (~0UL << (fl + 1));
+        if (map == 0)
+        {
+            return NULL;
+        }
+        fl = Mem_Ffs(map);
+        map = _ptHeap->sl_bitmap[fl];
+    }
+    sl = Mem_Ffs(map);
+
+    *_pFl = fl;
+    *_pSl = sl;
+    return _ptHeap->blocks[fl][sl];
+}
+
+/* 从空闲链表中取出 */
+static void Mem_RemoveFree(MEM_HEAP_T *_ptHeap, MEM_BLOCK_T *_pBlock)
+{
+    uint32_t fl, sl;
+
+    Mem_Mapping(BLOCK_SIZE(_pBlock), &fl, &sl);
+
+    if (_pBlock->next_free != NULL)
+    {
+        _pBlock->next_free->prev_free = _pBlock->prev_free;
+    }
+    if (_pBlock->prev_free != NULL)
+    {
+        _pBlock->prev_free->next_free = _pBlock->next_free;
+    }
+    else
+    {
+        /* 链表头 */
+        _ptHeap->blocks[fl][sl] = _pBlock->next_free;
+        if (_pBlock->next_free == NULL)
+        {
+            _ptHeap->sl_bitmap[fl] &= ~(1UL << sl);
+            if (_ptHeap->sl_bitmap[fl] == 0)
+            {
+                _ptHeap->fl_bitmap &= ~(1UL << fl);
+            }
+        }
+    }
+    _pBlock->size &= ~MEM_FREE_BIT;
+}
+
+/* 放入空闲链表头部 */
+static void Mem_InsertFree(MEM_HEAP_T *_ptHeap, MEM_BLOCK_T *_pBlock)
+{
+    uint32_t fl, sl;
+
+    Mem_Mapping(BLOCK_SIZE(_pBlock), &fl, &sl);
+
+    _pBlock->size |= MEM_FREE_BIT;
+    _pBlock->prev_free = NULL;
+    _pBlock->next_free = _ptHeap->blocks[fl][sl];
+    if (_pBlock->next_free != NULL)
+    {
+        _pBlock->next_free->prev_free = _pBlock;
+    }
+    _ptHeap->blocks[fl][sl] = _pBlock;
+    _ptHeap->fl_bitmap |= 1UL << fl;
+    _ptHeap->sl_bitmap[fl] |= 1UL << sl;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Split
+*    功能说明: 已分配块超出_uiSize的部分足够组成一个块时切下来，与后面的空闲块合并后放回空闲链表
+*    形    参: _ptHeap : 堆
+*              _pBlock : 已分配块
+*              _uiSize : 保留的数据区字节数，已对齐
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void Mem_Split(MEM_HEAP_T *_ptHeap, MEM_BLOCK_T *_pBlock, uint32_t _uiSize)
+{
+    MEM_BLOCK_T *rest, *next;
+
+    if (BLOCK_SIZE(_pBlock) < _uiSize + MEM_HEAD_SIZE + MEM_BLOCK_MIN)
+    {
+        return;
+    }
+
+    rest = (MEM_BLOCK_T *)((uint8_t *)BLOCK_DATA(_pBlock) + _uiSize);
+    rest->size = BLOCK_SIZE(_pBlock) - _uiSize - MEM_HEAD_SIZE;
+    rest->prev_phys = _pBlock;
+    _pBlock->size = _uiSize;
+
+    next = BLOCK_NEXT(rest);
+    if (BLOCK_IS_FREE(next))
+    {
+        Mem_RemoveFree(_ptHeap, next);
+        rest->size += MEM_HEAD_SIZE + BLOCK_SIZE(next);
+        next = BLOCK_NEXT(rest);
+    }
+    next->prev_phys = rest;
+
+    Mem_InsertFree(_ptHeap, rest);
+}
+
+/* 找到地址所属的堆 */
+static MEM_HEAP_T *Mem_FindHeap(void *_ptr)
+{
+    uint8_t i;
+
+    for (i = 0; i < MEM_HEAP_NUM; i++)
+    {
+        if ((uint8_t *)_ptr >= s_tHeap[i].base && (uint8_t *)_ptr < s_tHeap[i].base + s_tHeap[i].size)
+        {
+            return &s_tHeap[i];
+        }
+    }
+    return NULL;
+}
+
+/* 已分配字节数统计 */
+static void Mem_Account(MEM_HEAP_T *_ptHeap, int32_t _iDelta)
+{
+    _ptHeap->used += _iDelta;
+    if (_ptHeap->used > _ptHeap->peak)
+    {
+        _ptHeap->peak = _ptHeap->used;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitMem
+*    功能说明: 初始化所有内存堆，SDRAM堆要在 bsp_InitExtSDRAM 之后初始化
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitMem(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < MEM_HEAP_NUM; i++)
+    {
+        Mem_InitHeap((MEM_HEAP_E)i);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_InitHeap
+*    功能说明: 初始化一个堆，原有的分配全部作废。整个区域为一个空闲块，末尾是大小为0的哨兵块
+*    形    参: _heap : 堆编号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void Mem_InitHeap(MEM_HEAP_E _heap)
+{
+    MEM_HEAP_T *h = &s_tHeap[_heap];
+    MEM_BLOCK_T *first, *last;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    h->fl_bitmap = 0;
+    memset(h->sl_bitmap, 0, sizeof(h->sl_bitmap));
+    memset(h->blocks, 0, sizeof(h->blocks));
+    h->used = 0;
+    h->peak = 0;
+    h->fail = 0;
+
+    first = (MEM_BLOCK_T *)h->base;
+    first->prev_phys = NULL;
+    first->size = (h->size & ~(MEM_ALIGN - 1)) - 2 * MEM_HEAD_SIZE;
+
+    last = BLOCK_NEXT(first);
+    last->prev_phys = first;
+    last->size = 0;
+
+    Mem_InsertFree(h, first);
+
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Alloc
+*    功能说明: 从指定的堆中分配内存，8字节对齐
+*    形    参: _heap : 堆编号
+*              _uiSize : 字节数
+*    返 回 值: 内存地址，NULL表示失败
+*********************************************************************************************************
+*/
+void *Mem_Alloc(MEM_HEAP_E _heap, uint32_t _uiSize)
+{
+    MEM_HEAP_T *h = &s_tHeap[_heap];
+    MEM_BLOCK_T *block;
+    uint32_t fl, sl;
+    uint32_t primask;
+
+    if (_uiSize == 0 || _uiSize > h->size)
+    {
+        return NULL;
+    }
+
+    _uiSize = (_uiSize + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
+    if (_uiSize < MEM_BLOCK_MIN)
+    {
+        _uiSize = MEM_BLOCK_MIN;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    block = Mem_FindSuitable(h, _uiSize, &fl, &sl);
+    if (block == NULL)
+    {
+        h->fail++;
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+
+    Mem_RemoveFree(h, block);
+    Mem_Split(h, block, _uiSize);
+    Mem_Account(h, BLOCK_SIZE(block) + MEM_HEAD_SIZE);
+
+    __set_PRIMASK(primask);
+
+    return BLOCK_DATA(block);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_AllocAlign
+*    功能说明: 分配按_uiAlign对齐的内存，DMA缓冲区用32字节对齐，与D-Cache行一致
+*    形    参: _heap : 堆编号
+*              _uiSize : 字节数
+*              _uiAlign : 对齐字节数，2的幂
+*    返 回 值: 内存地址，NULL表示失败
+*********************************************************************************************************
+*/
+void *Mem_AllocAlign(MEM_HEAP_E _heap, uint32_t _uiSize, uint32_t _uiAlign)
+{
+    MEM_HEAP_T *h = &s_tHeap[_heap];
+    MEM_BLOCK_T *block, *aligned, *next;
+    uint32_t addr, gap;
+    uint8_t *p;
+    uint32_t primask;
+
+    if (_uiAlign <= MEM_ALIGN)
+    {
+        return Mem_Alloc(_heap, _uiSize);
+    }
+
+    /* 多分配一些，保证能在前面切出一个最小的空闲块，使数据区对齐 */
+    p = Mem_Alloc(_heap, _uiSize + _uiAlign + MEM_HEAD_SIZE + MEM_BLOCK_MIN);
+    if (p == NULL || ((uint32_t)p & (_uiAlign - 1)) == 0)
+    {
+        if (p != NULL)
+        {
+            primask = __get_PRIMASK();
+            __disable_irq();
+            block = BLOCK_FROM_DATA(p);
+            Mem_Account(h, -(int32_t)BLOCK_SIZE(block));
+            Mem_Split(h, block, (_uiSize + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1));
+            Mem_Account(h, BLOCK_SIZE(block));
+            __set_PRIMASK(primask);
+        }
+        return p;
+    }
+
+    addr = ((uint32_t)p + MEM_HEAD_SIZE + MEM_BLOCK_MIN + _uiAlign - 1) & ~(_uiAlign - 1);
+    gap = addr - (uint32_t)p;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    block = BLOCK_FROM_DATA(p);
+    Mem_Account(h, -(int32_t)(BLOCK_SIZE(block) + MEM_HEAD_SIZE));
+
+    /* 对齐后的块从原块中切出，前面剩余部分作为空闲块 */
+    aligned = BLOCK_FROM_DATA(addr);
+    aligned->size = BLOCK_SIZE(block) - gap;
+    aligned->prev_phys = block;
+    next = BLOCK_NEXT(aligned);
+    next->prev_phys = aligned;
+    block->size = gap - MEM_HEAD_SIZE;
+
+    /* 前面的空闲块与更前面的空闲块合并 */
+    if (block->prev_phys != NULL && BLOCK_IS_FREE(block->prev_phys))
+    {
+        MEM_BLOCK_T *prev = block->prev_phys;
+
+        Mem_RemoveFree(h, prev);
+        prev->size += MEM_HEAD_SIZE + BLOCK_SIZE(block);
+        aligned->prev_phys = prev;
+        block = prev;
+    }
+    Mem_InsertFree(h, block);
+
+    Mem_Split(h, aligned, (_uiSize + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1));
+    Mem_Account(h, BLOCK_SIZE(aligned) + MEM_HEAD_SIZE);
+
+    __set_PRIMASK(primask);
+
+    return (void *)addr;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Calloc
+*    功能说明: 分配内存并清0，用法与 calloc 相同
+*    形    参: _heap : 堆编号
+*              _uiNum : 个数
+*              _uiSize : 每个的字节数
+*    返 回 值: 内存地址，NULL表示失败
+*********************************************************************************************************
+*/
+void *Mem_Calloc(MEM_HEAP_E _heap, uint32_t _uiNum, uint32_t _uiSize)
+{
+    uint64_t size = (uint64_t)_uiNum * _uiSize;
+    void *p;
+
+    if (size > 0xFFFFFFFFUL)
+    {
+        return NULL;
+    }
+
+    p = Mem_Alloc(_heap, (uint32_t)size);
+    if (p != NULL)
+    {
+        memset(p, 0, (uint32_t)size);
+    }
+    return p;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Realloc
+*    功能说明: 调整内存大小，用法与 realloc 相同。后面相邻的是空闲块时原地扩大，否则重新分配并复制
+*    形    参: _heap : 堆编号，_ptr为NULL时从该堆分配，否则在_ptr所属的堆中调整
+*              _ptr : 原内存地址
+*              _uiSize : 新的字节数，为0时释放
+*    返 回 值: 内存地址，NULL表示失败，原内存不变
+*********************************************************************************************************
+*/
+void *Mem_Realloc(MEM_HEAP_E _heap, void *_ptr, uint32_t _uiSize)
+{
+    MEM_HEAP_T *h;
+    MEM_BLOCK_T *block, *next;
+    uint32_t size, old;
+    uint32_t primask;
+    void *p;
+
+    if (_ptr == NULL)
+    {
+        return Mem_Alloc(_heap, _uiSize);
+    }
+    if (_uiSize == 0)
+    {
+        Mem_Free(_ptr);
+        return NULL;
+    }
+
+    h = Mem_FindHeap(_ptr);
+    if (h == NULL)
+    {
+        return NULL;
+    }
+
+    size = (_uiSize + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
+    if (size < MEM_BLOCK_MIN)
+    {
+        size = MEM_BLOCK_MIN;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    block = BLOCK_FROM_DATA(_ptr);
+    old = BLOCK_SIZE(block);
+    next = BLOCK_NEXT(block);
+
+    if (size > old && BLOCK_IS_FREE(next) && old + MEM_HEAD_SIZE + BLOCK_SIZE(next) >= size)
+    {
+        /* 合并后面的空闲块 */
+        Mem_RemoveFree(h, next);
+        block->size += MEM_HEAD_SIZE + BLOCK_SIZE(next);
+        BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    if (size <= BLOCK_SIZE(block))
+    {
+        Mem_Split(h, block, size);
+        Mem_Account(h, (int32_t)BLOCK_SIZE(block) - (int32_t)old);
+        __set_PRIMASK(primask);
+        return _ptr;
+    }
+
+    __set_PRIMASK(primask);
+
+    p = Mem_Alloc((MEM_HEAP_E)(h - s_tHeap), _uiSize);
+    if (p != NULL)
+    {
+        memcpy(p, _ptr, old);
+        Mem_Free(_ptr);
+    }
+    return p;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_Free
+*    功能说明: 释放内存，根据地址找到所属的堆，与相邻的空闲块合并
+*    形    参: _ptr : Mem_Alloc 等返回的地址，NULL时不处理
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void Mem_Free(void *_ptr)
+{
+    MEM_HEAP_T *h;
+    MEM_BLOCK_T *block, *prev, *next;
+    uint32_t primask;
+
+    if (_ptr == NULL)
+    {
+        return;
+    }
+
+    h = Mem_FindHeap(_ptr);
+    if (h == NULL)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    block = BLOCK_FROM_DATA(_ptr);
+    Mem_Account(h, -(int32_t)(BLOCK_SIZE(block) + MEM_HEAD_SIZE));
+
+    /* 与前面的空闲块合并 */
+    prev = block->prev_phys;
+    if (prev != NULL && BLOCK_IS_FREE(prev))
+    {
+        Mem_RemoveFree(h, prev);
+        prev->size += MEM_HEAD_SIZE + BLOCK_SIZE(block);
+        block = prev;
+    }
+
+    /* 与后面的空闲块合并 */
+    next = BLOCK_NEXT(block);
+    if (BLOCK_IS_FREE(next))
+    {
+        Mem_RemoveFree(h, next);
+        block->size += MEM_HEAD_SIZE + BLOCK_SIZE(next);
+        next = BLOCK_NEXT(block);
+    }
+    next->prev_phys = block;
+
+    Mem_InsertFree(h, block);
+
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_GetUsage
+*    功能说明: 读取分配时累计的计数: 总字节数、已分配字节数、峰值和失败次数，不遍历堆，O(1)。
+*              空闲块等其余成员为0，需要时调用 Mem_GetStat。用于周期刷新的显示
+*    形    参: _heap : 堆编号
+*              _pStat : 统计结果
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void Mem_GetUsage(MEM_HEAP_E _heap, MEM_STAT_T *_pStat)
+{
+    MEM_HEAP_T *h = &s_tHeap[_heap];
+
+    memset(_pStat, 0, sizeof(MEM_STAT_T));
+    _pStat->total = (h->size & ~(MEM_ALIGN - 1)) - MEM_HEAD_SIZE;
+    _pStat->used = h->used;
+    _pStat->peak = h->peak;
+    _pStat->fail = h->fail;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Mem_GetStat
+*    功能说明: 统计堆的使用情况，遍历所有块，执行时间与块数成正比，不要在中断中调用
+*    形    参: _heap : 堆编号
+*              _pStat : 统计结果
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void Mem_GetStat(MEM_HEAP_E _heap, MEM_STAT_T *_pStat)
+{
+    MEM_HEAP_T *h = &s_tHeap[_heap];
+    MEM_BLOCK_T *block;
+    uint32_t primask = __get_PRIMASK();
+
+    memset(_pStat, 0, sizeof(MEM_STAT_T));
+
+    __disable_irq();
+
+    _pStat->total = (h->size & ~(MEM_ALIGN - 1)) - MEM_HEAD_SIZE;
+    _pStat->used = h->used;
+    _pStat->peak = h->peak;
+    _pStat->fail = h->fail;
+
+    for (block = (MEM_BLOCK_T *)h->base; BLOCK_SIZE(block) != 0; block = BLOCK_NEXT(block))
+    {
+        if (BLOCK_IS_FREE(block))
+        {
+            _pStat->free += BLOCK_SIZE(block);
+            _pStat->free_num++;
+            if (BLOCK_SIZE(block) > _pStat->max_free)
+            {
+                _pStat->max_free = BLOCK_SIZE(block);
+            }
+        }
+        else
+        {
+            _pStat->used_num++;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 打印各堆的使用情况，碎片率 = 1 - 最大空闲块 / 空闲总量 */
+static void mem_stat(void)
+{
+    MEM_STAT_T st;
+    uint32_t frag;
+    uint8_t i;
+
+    printf("%-6s %9s %9s %9s %9s %9s %5s %6s %6s %5s\r\n",
+           "heap", "total", "used", "peak", "free", "max free", "frag", "blocks", "holes", "fail");
+    for (i = 0; i < MEM_HEAP_NUM; i++)
+    {
+        Mem_GetStat((MEM_HEAP_E)i, &st);
+        frag = (st.free == 0) ? 0 : 1000 - (uint32_t)((uint64_t)st.max_free * 1000 / st.free);
+        printf("%-6s %9d %9d %9d %9d %9d %3d.%d%% %6d %6d %5d\r\n",
+               s_tHeap[i].name, st.total, st.used, st.peak, st.free, st.max_free,
+               frag / 10, frag % 10, st.used_num, st.free_num, st.fail);
+    }
+    printf("C heap (microlib malloc) is not included\r\n");
+}
+
+/* 随机分配释放，统计每次操作的最大耗时 */
+static void mem_bench(MEM_HEAP_E _heap, uint32_t _uiMax)
+{
+#define MEM_BENCH_SLOTS 64
+#define MEM_BENCH_LOOPS 10000
+
+    void *slot[MEM_BENCH_SLOTS] = {0};
+    uint32_t div = SystemCoreClock / 1000000ul;
+    int64_t ticks, t;
+    int64_t alloc_max = 0, free_max = 0, alloc_sum = 0, free_sum = 0;
+    uint32_t i, n, alloc_num = 0, free_num = 0;
+
+    srand(3);
+    for (i = 0; i < MEM_BENCH_LOOPS; i++)
+    {
+        n = (uint32_t)rand() % MEM_BENCH_SLOTS;
+        ticks = get_system_ticks();
+        if (slot[n] == NULL)
+        {
+            slot[n] = Mem_Alloc(_heap, 1 + (uint32_t)rand() % _uiMax);
+            t = get_system_ticks() - ticks;
+            alloc_sum += t;
+            alloc_num++;
+            alloc_max = (t > alloc_max) ? t : alloc_max;
+        }
+        else
+        {
+            Mem_Free(slot[n]);
+            slot[n] = NULL;
+            t = get_system_ticks() - ticks;
+            free_sum += t;
+            free_num++;
+            free_max = (t > free_max) ? t : free_max;
+        }
+    }
+    for (i = 0; i < MEM_BENCH_SLOTS; i++)
+    {
+        Mem_Free(slot[i]);
+    }
+
+    printf("%s: alloc %d avg %d max %d cycles, free %d avg %d max %d cycles (%d cycles/us)\r\n",
+           s_tHeap[_heap].name,
+           alloc_num, (uint32_t)(alloc_sum / (alloc_num ? alloc_num : 1)), (uint32_t)alloc_max,
+           free_num, (uint32_t)(free_sum / (free_num ? free_num : 1)), (uint32_t)free_max, div);
+}
+
+static int cmd_mem(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "mem stat",
+        "mem bench dtcm/axi/sdram [max size]"};
+
+    if (argc > 1 && !strcmp(argv[1], "stat"))
+    {
+        mem_stat();
+
+        return 0;
+    }
+    else if (argc > 2 && !strcmp(argv[1], "bench"))
+    {
+        uint8_t i;
+
+        for (i = 0; i < MEM_HEAP_NUM; i++)
+        {
+            if (!strcmp(argv[2], s_tHeap[i].name))
+            {
+                mem_bench((MEM_HEAP_E)i, argc > 3 ? strtoul(argv[3], NULL, 0) : 1024);
+                return 0;
+            }
+        }
+        printf("bench parameter Error.\r\n%s\r\n", help_info[1]);
+        return -1;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), mem, cmd_mem, mem[stat bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
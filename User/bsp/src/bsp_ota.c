@@ -0,0 +1,666 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 固件升级(A/B双Bank)模块
+*    文件名称 : bsp_ota.c
+*    版    本 : V1.0
+*    说    明 : 通过串口接收新固件，经QSPI Flash暂存后写入内部Flash的另一个Bank，再切换Bank启动。
+*               1. 接收: 串口DMA写入SDRAM中32KB环形缓冲区，CPU取出数据计算CRC32并按页编程到QSPI，
+*                  页编程在Flash内部进行时CPU继续取下一页，接收、校验、编程三者并行。暂存区预先按64KB块擦除。
+*               2. 安装: MDMA从QSPI读取下一块的同时编程内部Flash当前块，校验后修改选项字节SWAP_BANK并复位。
+*                  STM32H743双Bank交换后，运行中的Bank总是映射在0x08000000，寄存器也随之交换，
+*                  所以不需要单独的Bootloader，应用程序自己就可以擦写另一个Bank。
+*               3. 回滚: 新固件以试运行状态启动，每次启动计数并开启独立看门狗。超过 OTA_BOOT_TRIES 次
+*                  仍未确认(死机、反复复位)时切回旧固件。运行正常后调用 OTA_Confirm 确认。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_kv.h"
+#include "bsp_ota.h"
+
+#define OTA_HEAD_MAGIC 0x3041544FUL /* "OTA0" */
+#define OTA_CHUNK_SIZE (4 * 1024)   /* 安装时每次从QSPI读取的字节数 */
+
+/* 暂存镜像头，镜像数据全部写入并校验后才写入 */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t size; /* 镜像字节数 */
+    uint32_t crc;  /* 镜像CRC32 */
+    uint32_t hcrc; /* 前3个字的CRC32 */
+} OTA_HEAD_T;
+
+static uint8_t s_ucState = OTA_STATE_NONE; /* 当前固件的升级状态 */
+static uint8_t s_ucBoots = 0;              /* 试运行启动次数 */
+static uint8_t s_ucWdg = 0;                /* 1: 看门狗已启动 */
+static uint32_t s_uiStartTick = 0;         /* 试运行开始时间 */
+
+__attribute__((aligned(32))) static uint8_t s_ucBuf[2][OTA_CHUNK_SIZE];
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_GetBank
+*    功能说明: 读取当前运行的物理Bank
+*    形    参: 无
+*    返 回 值: 1 或 2
+*********************************************************************************************************
+*/
+static uint8_t OTA_GetBank(void)
+{
+    return (FLASH->OPTCR & FLASH_OPTCR_SWAP_BANK) ? 2 : 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_StartWdg
+*    功能说明: 启动独立看门狗，LSI 32KHz 256分频，超时约32秒。启动后只能由复位停止
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void OTA_StartWdg(void)
+{
+    IWDG1->KR = 0xCCCC; /* 启动，同时自动打开LSI */
+    IWDG1->KR = 0x5555; /* 允许修改PR和RLR */
+    IWDG1->PR = 6;
+    IWDG1->RLR = 0xFFF;
+    while (IWDG1->SR != 0)
+    {
+    }
+    IWDG1->KR = 0xAAAA;
+    s_ucWdg = 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_FeedWdg
+*    功能说明: 喂狗，看门狗未启动时不操作
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void OTA_FeedWdg(void)
+{
+    if (s_ucWdg)
+    {
+        IWDG1->KR = 0xAAAA;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_BusyCallback
+*    功能说明: 等待QSPI Flash擦除、编程期间由 bsp_qspi.c 调用，喂狗。整片擦除最长400秒，
+*              远超看门狗的32秒，见 QSPI_BUSY_TIMEOUT
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_BusyCallback(void)
+{
+    OTA_FeedWdg();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_WaitTx
+*    功能说明: 等待串口发送完毕，切换波特率或复位前调用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void OTA_WaitTx(void)
+{
+    uint32_t tick = HAL_GetTick();
+
+    while (OTA_HUART.gState != HAL_UART_STATE_READY && HAL_GetTick() - tick < 100)
+    {
+    }
+    HAL_Delay(5);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_SwapBank
+*    功能说明: 翻转选项字节SWAP_BANK并复位，复位后从另一个Bank启动
+*    形    参: 无
+*    返 回 值: 无，不返回
+*********************************************************************************************************
+*/
+static void OTA_SwapBank(void)
+{
+    FLASH_OBProgramInitTypeDef ob = {0};
+
+    OTA_WaitTx();
+
+    ob.OptionType = OPTIONBYTE_USER;
+    ob.USERType = OB_USER_SWAP_BANK;
+    ob.USERConfig = (FLASH->OPTCR & FLASH_OPTCR_SWAP_BANK) ? OB_SWAP_BANK_DISABLE : OB_SWAP_BANK_ENABLE;
+
+    HAL_FLASH_Unlock();
+    HAL_FLASH_OB_Unlock();
+    if (HAL_FLASHEx_OBProgram(&ob) == HAL_OK)
+    {
+        HAL_FLASH_OB_Launch();
+    }
+    HAL_FLASH_OB_Lock();
+    HAL_FLASH_Lock();
+
+    NVIC_SystemReset();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_CheckVector
+*    功能说明: 检查镜像的中断向量表，栈顶指向内部RAM，复位向量指向镜像内部
+*    形    参: _pVec : 向量表前两项
+*              _uiSize : 镜像大小
+*    返 回 值: 1 有效，0 无效
+*********************************************************************************************************
+*/
+static uint8_t OTA_CheckVector(const uint32_t *_pVec, uint32_t _uiSize)
+{
+    uint32_t sp = _pVec[0];
+    uint32_t pc = _pVec[1];
+
+    if (!((sp > 0x20000000 && sp <= 0x20020000) || (sp > 0x24000000 && sp <= 0x24080000)))
+    {
+        return 0;
+    }
+    if ((pc & 1) == 0 || pc < FLASH_BANK1_BASE || pc >= FLASH_BANK1_BASE + _uiSize)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_ReadHead
+*    功能说明: 读取并校验暂存镜像头
+*    形    参: _pHead : 镜像头
+*    返 回 值: 0 暂存区有完整镜像，-1 没有
+*********************************************************************************************************
+*/
+static int OTA_ReadHead(OTA_HEAD_T *_pHead)
+{
+    QSPI_ReadBuffer((uint8_t *)_pHead, OTA_HEAD_ADDR, sizeof(OTA_HEAD_T));
+    if (_pHead->magic != OTA_HEAD_MAGIC || _pHead->hcrc != CRC32_Update(0, (uint8_t *)_pHead, 12))
+    {
+        return -1;
+    }
+    if (_pHead->size == 0 || _pHead->size > OTA_IMAGE_MAX)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_CopyImage
+*    功能说明: 分块读取暂存镜像并计算CRC32。MDMA读取下一块的同时处理当前块，可选编程到内部Flash另一个Bank
+*    形    参: _uiSize : 镜像大小
+*              _ucProgram : 1 编程到 OTA_BANK_ADDR，调用前已解锁并擦除
+*              _pCrc : 返回CRC32
+*    返 回 值: 0 成功，-1 读取或编程失败
+*********************************************************************************************************
+*/
+static int OTA_CopyImage(uint32_t _uiSize, uint8_t _ucProgram, uint32_t *_pCrc)
+{
+    uint32_t crc = 0;
+    uint32_t off, len, next, i;
+    uint8_t cur = 0;
+
+    len = (_uiSize > OTA_CHUNK_SIZE) ? OTA_CHUNK_SIZE : _uiSize;
+    QSPI_ReadAsync(s_ucBuf[0], OTA_SLOT_ADDR, len, NULL, NULL);
+    for (off = 0; off < _uiSize; off += len)
+    {
+        len = (_uiSize - off > OTA_CHUNK_SIZE) ? OTA_CHUNK_SIZE : _uiSize - off;
+        if (QSPI_WaitAsync() != 0)
+        {
+            return -1;
+        }
+
+        /* 先启动下一块的读取 */
+        next = off + len;
+        if (next < _uiSize)
+        {
+            QSPI_ReadAsync(s_ucBuf[cur ^ 1], OTA_SLOT_ADDR + next,
+                           (_uiSize - next > OTA_CHUNK_SIZE) ? OTA_CHUNK_SIZE : _uiSize - next, NULL, NULL);
+        }
+
+        crc = CRC32_Update(crc, s_ucBuf[cur], len);
+        if (_ucProgram)
+        {
+            /* 内部Flash按32字节编程，末尾不足部分补0xFF */
+            memset(&s_ucBuf[cur][len], 0xFF, ((len + 31) & ~31UL) - len);
+            for (i = 0; i < len; i += 32)
+            {
+                if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD, OTA_BANK_ADDR + off + i, (uint32_t)&s_ucBuf[cur][i]) != HAL_OK)
+                {
+                    QSPI_WaitAsync();
+                    return -1;
+                }
+            }
+        }
+        OTA_FeedWdg();
+        cur ^= 1;
+    }
+
+    *_pCrc = crc;
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitOTA
+*    功能说明: 上电检查升级状态。新固件试运行时累计启动次数并启动看门狗，次数超限切回旧固件。
+*              需要在 bsp_InitKV 之后尽早调用。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitOTA(void)
+{
+    s_ucState = KV_GetU32("ota.state", OTA_STATE_NONE);
+    s_ucBoots = 0;
+    if (s_ucState != OTA_STATE_TRIAL)
+    {
+        return;
+    }
+
+    /* 试运行的是另一个Bank，说明已经切回旧固件 */
+    if (KV_GetU32("ota.bank", 0) != OTA_GetBank())
+    {
+        s_ucState = OTA_STATE_ROLLBACK;
+        KV_SetU32("ota.state", s_ucState);
+        KV_Delete("ota.boots");
+        return;
+    }
+
+    s_ucBoots = KV_AddU32("ota.boots", 1);
+    if (s_ucBoots > OTA_BOOT_TRIES)
+    {
+        OTA_SwapBank();
+    }
+
+#if OTA_IWDG_EN == 1
+    OTA_StartWdg();
+#endif
+    s_uiStartTick = HAL_GetTick();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_Receive
+*    功能说明: 从 OTA_COM 接收固件到QSPI暂存区。发送 "OTA READY" 后切换波特率，对方收到后开始发送原始镜像。
+*              结束后用新波特率发送结果，再恢复原波特率。
+*    形    参: _uiSize : 镜像大小
+*              _uiCrc : 镜像CRC32(与zlib.crc32相同)
+*              _uiBaud : 传输波特率，0表示不切换
+*    返 回 值: 0 成功，负数失败
+*********************************************************************************************************
+*/
+int OTA_Receive(uint32_t _uiSize, uint32_t _uiCrc, uint32_t _uiBaud)
+{
+    OTA_HEAD_T head;
+    uint8_t *page = s_ucBuf[0];
+    uint8_t *ring;
+    uint32_t baud = OTA_HUART.Init.BaudRate;
+    uint32_t done = 0;
+    uint32_t fill = 0;
+    uint32_t crc = 0;
+    uint32_t want, len, addr, tick, start;
+    int ret = 0;
+
+    if (_uiSize == 0 || _uiSize > OTA_IMAGE_MAX)
+    {
+        printf("OTA ERROR size\r\n");
+        return -1;
+    }
+    if (_uiBaud == 0)
+    {
+        _uiBaud = baud;
+    }
+
+    /* 先作废旧镜像头，再按块擦除镜像区 */
+    QSPI_EraseSector(OTA_HEAD_ADDR);
+    for (addr = OTA_SLOT_ADDR; addr < OTA_SLOT_ADDR + _uiSize; addr += QSPI_BLOCK_SIZE)
+    {
+        QSPI_EraseBlock(addr);
+        OTA_FeedWdg();
+    }
+    QSPI_WaitBusy();
+
+    /* 接收环形缓冲区从SDRAM堆申请，按Cache行对齐 */
+    ring = Mem_AllocAlign(MEM_SDRAM, OTA_RX_BUF_SIZE, 32);
+    if (ring == NULL || comSetRxBuf(OTA_COM, ring, OTA_RX_BUF_SIZE) != 0)
+    {
+        Mem_Free(ring);
+        printf("OTA ERROR buffer\r\n");
+        return -1;
+    }
+    printf("OTA READY %d\r\n", _uiBaud);
+    if (_uiBaud != baud)
+    {
+        OTA_WaitTx();
+        comSetBaud(OTA_COM, _uiBaud);
+    }
+
+    start = tick = HAL_GetTick();
+    while (done < _uiSize)
+    {
+        want = (_uiSize - done > QSPI_PAGE_SIZE) ? QSPI_PAGE_SIZE : _uiSize - done;
+        len = comGetBuf(OTA_COM, page + fill, want - fill);
+        if (len == 0)
+        {
+            if (HAL_GetTick() - tick > OTA_RX_TIMEOUT)
+            {
+                ret = -2;
+                break;
+            }
+            OTA_FeedWdg();
+            continue;
+        }
+        tick = HAL_GetTick();
+        fill += len;
+        if (fill < want)
+        {
+            continue;
+        }
+
+        /* QSPI_WriteBuffer 发送完数据即返回，Flash内部编程期间继续接收下一页 */
+        crc = CRC32_Update(crc, page, fill);
+        QSPI_WriteBuffer(page, OTA_SLOT_ADDR + done, fill);
+        done += fill;
+        fill = 0;
+    }
+    QSPI_WaitBusy();
+
+    if (ret == 0 && crc != _uiCrc)
+    {
+        ret = -3;
+    }
+    if (ret == 0)
+    {
+        /* 回读校验，全部正确后写入镜像头 */
+        OTA_CopyImage(_uiSize, 0, &crc);
+        if (crc != _uiCrc)
+        {
+            ret = -4;
+        }
+    }
+    if (ret == 0)
+    {
+        head.magic = OTA_HEAD_MAGIC;
+        head.size = _uiSize;
+        head.crc = _uiCrc;
+        head.hcrc = CRC32_Update(0, (uint8_t *)&head, 12);
+        QSPI_WriteBuffer((uint8_t *)&head, OTA_HEAD_ADDR, sizeof(head));
+        QSPI_WaitBusy();
+        printf("OTA OK %d bytes %d ms\r\n", _uiSize, HAL_GetTick() - start);
+    }
+    else
+    {
+        printf("OTA ERROR %s %d/%d\r\n", (ret == -2) ? "timeout" : (ret == -3) ? "crc" : "verify", done + fill, _uiSize);
+    }
+
+    OTA_WaitTx();
+    if (_uiBaud != baud)
+    {
+        comSetBaud(OTA_COM, baud);
+    }
+    comSetRxBuf(OTA_COM, NULL, 0);
+    Mem_Free(ring);
+
+    return ret;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_Install
+*    功能说明: 把暂存镜像写入内部Flash另一个Bank，校验后切换Bank并复位，新固件以试运行状态启动
+*    形    参: 无
+*    返 回 值: 成功时不返回，负数失败
+*********************************************************************************************************
+*/
+int OTA_Install(void)
+{
+    FLASH_EraseInitTypeDef erase = {0};
+    OTA_HEAD_T head;
+    uint32_t vec[2];
+    uint32_t err, crc;
+    uint32_t start = HAL_GetTick();
+    uint8_t bank;
+
+    if (s_ucState == OTA_STATE_TRIAL)
+    {
+        printf("OTA current image not confirmed\r\n");
+        return -1;
+    }
+    if (OTA_ReadHead(&head) != 0)
+    {
+        printf("OTA no staged image\r\n");
+        return -1;
+    }
+    QSPI_ReadBuffer((uint8_t *)vec, OTA_SLOT_ADDR, sizeof(vec));
+    if (!OTA_CheckVector(vec, head.size))
+    {
+        printf("OTA invalid vector table SP = 0x%08X PC = 0x%08X\r\n", vec[0], vec[1]);
+        return -1;
+    }
+
+    /* 交换后寄存器也交换，FLASH_BANK_2 总是另一个Bank。
+       每个128KB扇区擦除最长约4秒，8个扇区会超过看门狗时间，逐个擦除并喂狗 */
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Banks = FLASH_BANK_2;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    HAL_FLASH_Unlock();
+    for (erase.Sector = FLASH_SECTOR_0; erase.Sector < (head.size + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE; erase.Sector++)
+    {
+        if (HAL_FLASHEx_Erase(&erase, &err) != HAL_OK)
+        {
+            HAL_FLASH_Lock();
+            printf("OTA erase error sector %d\r\n", err);
+            return -2;
+        }
+        OTA_FeedWdg();
+    }
+    if (OTA_CopyImage(head.size, 1, &crc) != 0)
+    {
+        HAL_FLASH_Lock();
+        printf("OTA program error\r\n");
+        return -2;
+    }
+    HAL_FLASH_Lock();
+
+    /* 从内部Flash读回校验 */
+    SCB_InvalidateDCache_by_Addr((uint32_t *)OTA_BANK_ADDR, (head.size + 31) & ~31UL);
+    if (crc != head.crc || CRC32_Update(0, (uint8_t *)OTA_BANK_ADDR, head.size) != head.crc)
+    {
+        printf("OTA verify error\r\n");
+        return -3;
+    }
+
+    bank = (OTA_GetBank() == 1) ? 2 : 1;
+    KV_SetU32("ota.bank", bank);
+    KV_SetU32("ota.state", OTA_STATE_TRIAL);
+    KV_Delete("ota.boots");
+
+    printf("OTA installed %d bytes %d ms, boot bank %d\r\n", head.size, HAL_GetTick() - start, bank);
+    OTA_SwapBank();
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_Confirm
+*    功能说明: 确认试运行的新固件正常，之后不再回滚
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void OTA_Confirm(void)
+{
+    if (s_ucState != OTA_STATE_TRIAL)
+    {
+        return;
+    }
+    s_ucState = OTA_STATE_CONFIRMED;
+    KV_SetU32("ota.state", s_ucState);
+    KV_Delete("ota.boots");
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_Poll
+*    功能说明: 喂狗，试运行时间达到 OTA_CONFIRM_TIME 后自动确认。在 bsp_Idle 中调用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void OTA_Poll(void)
+{
+    OTA_FeedWdg();
+#if OTA_CONFIRM_TIME > 0
+    if (s_ucState == OTA_STATE_TRIAL && HAL_GetTick() - s_uiStartTick >= OTA_CONFIRM_TIME)
+    {
+        OTA_Confirm();
+    }
+#endif
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: OTA_GetStat
+*    功能说明: 读取升级状态
+*    形    参: _pStat : 状态信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void OTA_GetStat(OTA_STAT_T *_pStat)
+{
+    OTA_HEAD_T head;
+
+    _pStat->bank = OTA_GetBank();
+    _pStat->state = s_ucState;
+    _pStat->boots = s_ucBoots;
+    if (OTA_ReadHead(&head) == 0)
+    {
+        _pStat->staged = 1;
+        _pStat->size = head.size;
+        _pStat->crc = head.crc;
+    }
+    else
+    {
+        _pStat->staged = 0;
+        _pStat->size = 0;
+        _pStat->crc = 0;
+    }
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+static int cmd_ota(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "ota stat",
+        "ota recv size crc32 [baud]",
+        "ota install",
+        "ota confirm",
+        "ota swap"};
+    const char *state_str[] = {"none", "trial", "confirmed", "rollback"};
+
+    if (argc < 2)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+    else
+    {
+        if (!strcmp(argv[1], "stat"))
+        {
+            OTA_STAT_T stat;
+
+            OTA_GetStat(&stat);
+            printf("bank = %d state = %s boots = %d/%d\r\n", stat.bank,
+                   (stat.state < 4) ? state_str[stat.state] : "?", stat.boots, OTA_BOOT_TRIES);
+            if (stat.staged)
+            {
+                printf("staged image size = %d crc = 0x%08X\r\n", stat.size, stat.crc);
+            }
+            else
+            {
+                printf("no staged image\r\n");
+            }
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "recv"))
+        {
+            if (argc < 4)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[1]);
+                return -1;
+            }
+
+            return OTA_Receive(strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0),
+                               (argc > 4) ? strtoul(argv[4], NULL, 0) : 0);
+        }
+        else if (!strcmp(argv[1], "install"))
+        {
+            return OTA_Install();
+        }
+        else if (!strcmp(argv[1], "confirm"))
+        {
+            OTA_Confirm();
+            printf("state = %s\r\n", state_str[s_ucState]);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "swap"))
+        {
+            /* 手动切换到另一个Bank，先检查那边有没有有效固件 */
+            if (!OTA_CheckVector((uint32_t *)OTA_BANK_ADDR, OTA_IMAGE_MAX))
+            {
+                printf("No valid image in the other bank\r\n");
+                return -1;
+            }
+            KV_SetU32("ota.state", OTA_STATE_NONE);
+            KV_Delete("ota.boots");
+            printf("Swap bank, reset...\r\n");
+            OTA_SwapBank();
+
+            return 0;
+        }
+        else
+        {
+            printf("Error Command\r\nUsage:\r\n");
+            for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+            {
+                printf("%s\r\n", help_info[i]);
+            }
+            printf("\r\n");
+        }
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), ota, cmd_ota, ota[stat recv install confirm swap]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
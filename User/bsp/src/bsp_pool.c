@@ -0,0 +1,275 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : DMA缓冲区固定块内存池
+*    文件名称 : bsp_pool.c
+*    版    本 : V1.0
+*    说    明 : 32字节、256字节、4KB三级固定大小的内存块，用于DMA缓冲区和临时缓冲区。
+*               1. 每个块按D-Cache行(32字节)对齐，大小是Cache行的整数倍，对块做Clean/Invalidate
+*                  不会影响相邻的数据，不存在Cache行共享的问题
+*               2. 空闲块组成单向链表(栈)，用LDREX/STREX无锁压栈出栈，中断中也可以分配和释放。
+*                  Cortex-M进出异常时清除独占监视器，被中断打断的一次操作STREX失败后重试，不会出现ABA问题
+*               3. 块大小固定，没有碎片。请求的级别用完时从更大的一级分配
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_pool.h"
+
+typedef struct POOL_NODE
+{
+    struct POOL_NODE *next;
+} POOL_NODE_T;
+
+typedef struct
+{
+    const char *name;
+    uint32_t size;              /* 块大小 */
+    uint32_t num;               /* 块个数 */
+    uint8_t *base;              /* 第一个块 */
+    POOL_NODE_T *volatile head; /* 空闲链表 */
+    volatile uint32_t free;     /* 空闲块个数 */
+    volatile uint32_t min_free; /* 空闲块个数最小值，用于调整块个数 */
+    volatile uint32_t fail;     /* 分配失败次数 */
+} POOL_T;
+
+__attribute__((aligned(POOL_LINE_SIZE))) static uint8_t s_ucPool32[POOL_32_NUM][32];
+__attribute__((aligned(POOL_LINE_SIZE))) static uint8_t s_ucPool256[POOL_256_NUM][256];
+__attribute__((aligned(POOL_LINE_SIZE))) static uint8_t s_ucPool4K[POOL_4K_NUM][4096];
+
+static POOL_T s_tPool[POOL_NUM] = {
+    {"32", 32, POOL_32_NUM, &s_ucPool32[0][0]},
+    {"256", 256, POOL_256_NUM, &s_ucPool256[0][0]},
+    {"4K", 4096, POOL_4K_NUM, &s_ucPool4K[0][0]},
+};
+
+/* 原子加，返回新的值 */
+static uint32_t Pool_AtomicAdd(volatile uint32_t *_pVal, int32_t _iDelta)
+{
+    uint32_t val;
+
+    do
+    {
+        val = __LDREXW(_pVal) + _iDelta;
+    } while (__STREXW(val, _pVal) != 0);
+
+    return val;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Pool_Pop
+*    功能说明: 从空闲链表头取出一个块。读取head到写回head之间被中断打断时STREX失败，重新读取
+*    形    参: _ptPool : 内存池
+*    返 回 值: 块地址，NULL表示没有空闲块
+*********************************************************************************************************
+*/
+static void *Pool_Pop(POOL_T *_ptPool)
+{
+    POOL_NODE_T *node;
+    uint32_t free;
+
+    do
+    {
+        node = (POOL_NODE_T *)__LDREXW((volatile uint32_t *)&_ptPool->head);
+        if (node == NULL)
+        {
+            __CLREX();
+            return NULL;
+        }
+    } while (__STREXW((uint32_t)node->next, (volatile uint32_t *)&_ptPool->head) != 0);
+
+    free = Pool_AtomicAdd(&_ptPool->free, -1);
+    if (free < _ptPool->min_free)
+    {
+        _ptPool->min_free = free;
+    }
+
+    return node;
+}
+
+/* 块放回空闲链表头 */
+static void Pool_Push(POOL_T *_ptPool, void *_ptr)
+{
+    POOL_NODE_T *node = _ptr;
+
+    do
+    {
+        node->next = (POOL_NODE_T *)__LDREXW((volatile uint32_t *)&_ptPool->head);
+    } while (__STREXW((uint32_t)node, (volatile uint32_t *)&_ptPool->head) != 0);
+
+    Pool_AtomicAdd(&_ptPool->free, 1);
+}
+
+/* 找到地址所属的内存池，不是块首地址时返回NULL */
+static POOL_T *Pool_Find(const void *_ptr)
+{
+    uint32_t off;
+    uint8_t i;
+
+    for (i = 0; i < POOL_NUM; i++)
+    {
+        off = (uint32_t)_ptr - (uint32_t)s_tPool[i].base;
+        if (off < s_tPool[i].size * s_tPool[i].num)
+        {
+            return (off % s_tPool[i].size == 0) ? &s_tPool[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitPool
+*    功能说明: 初始化内存池，所有块放入空闲链表
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitPool(void)
+{
+    POOL_T *p;
+    uint32_t i, k;
+
+    for (i = 0; i < POOL_NUM; i++)
+    {
+        p = &s_tPool[i];
+        p->head = NULL;
+        for (k = p->num; k > 0; k--)
+        {
+            ((POOL_NODE_T *)(p->base + (k - 1) * p->size))->next = p->head;
+            p->head = (POOL_NODE_T *)(p->base + (k - 1) * p->size);
+        }
+        p->free = p->num;
+        p->min_free = p->num;
+        p->fail = 0;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Pool_Alloc
+*    功能说明: 分配能容纳_uiSize字节的最小一级块，该级用完时从更大的一级分配。可以在中断中调用
+*    形    参: _uiSize : 字节数，不超过4096
+*    返 回 值: 块地址，32字节对齐，NULL表示失败
+*********************************************************************************************************
+*/
+void *Pool_Alloc(uint32_t _uiSize)
+{
+    void *ptr;
+    uint8_t i, first = POOL_NUM;
+
+    for (i = 0; i < POOL_NUM; i++)
+    {
+        if (_uiSize > s_tPool[i].size)
+        {
+            continue;
+        }
+        if (first == POOL_NUM)
+        {
+            first = i;
+        }
+        ptr = Pool_Pop(&s_tPool[i]);
+        if (ptr != NULL)
+        {
+            return ptr;
+        }
+    }
+
+    if (first < POOL_NUM)
+    {
+        Pool_AtomicAdd(&s_tPool[first].fail, 1);
+    }
+    return NULL;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Pool_AllocClass
+*    功能说明: 从指定的一级分配，用完时不从其它级分配。可以在中断中调用
+*    形    参: _class : POOL_32 / POOL_256 / POOL_4K
+*    返 回 值: 块地址，NULL表示失败
+*********************************************************************************************************
+*/
+void *Pool_AllocClass(POOL_E _class)
+{
+    void *ptr = Pool_Pop(&s_tPool[_class]);
+
+    if (ptr == NULL)
+    {
+        Pool_AtomicAdd(&s_tPool[_class].fail, 1);
+    }
+    return ptr;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Pool_Free
+*    功能说明: 释放块，根据地址找到所属的一级。可以在中断中调用
+*    形    参: _ptr : Pool_Alloc 返回的地址，NULL或不是块首地址时不处理
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void Pool_Free(void *_ptr)
+{
+    POOL_T *p = Pool_Find(_ptr);
+
+    if (p != NULL)
+    {
+        Pool_Push(p, _ptr);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: Pool_BlockSize
+*    功能说明: 返回块的实际大小，DMA传输后按块大小作废Cache
+*    形    参: _ptr : Pool_Alloc 返回的地址
+*    返 回 值: 块字节数，0表示不是内存池的块
+*********************************************************************************************************
+*/
+uint32_t Pool_BlockSize(const void *_ptr)
+{
+    POOL_T *p = Pool_Find(_ptr);
+
+    return (p != NULL) ? p->size : 0;
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+static int cmd_pool(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "pool stat"};
+
+    if (argc > 1 && !strcmp(argv[1], "stat"))
+    {
+        printf("%-6s %6s %6s %8s %6s\r\n", "block", "num", "free", "min free", "fail");
+        for (uint8_t i = 0; i < POOL_NUM; i++)
+        {
+            printf("%-6s %6d %6d %8d %6d\r\n", s_tPool[i].name, s_tPool[i].num,
+                   s_tPool[i].free, s_tPool[i].min_free, s_tPool[i].fail);
+        }
+
+        return 0;
+    }
+    else
+    {
+        printf("Error Command\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), pool, cmd_pool, pool[stat]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
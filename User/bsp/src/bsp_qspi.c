@@ -1,10 +1,11 @@
 /*
 *********************************************************************************************************
 *
-*    模块名称 : W25Q256 QSPI驱动模块
+*    模块名称 : QSPI Flash驱动模块
 *    文件名称 : bsp_qspi_w25q256.c
 *    版    本 : V1.0
-*    说    明 : 使用CPU的QSPI总线驱动串行FLASH，提供基本的读写函数，采用4线方式，MDMA传输
+*    说    明 : 使用CPU的QSPI总线驱动串行FLASH，提供基本的读写函数，采用4线方式，MDMA传输。
+*               上电读取SFDP参数表，容量、地址宽度、擦除/编程/读取指令和线宽都由 QSPI_FLASH_T 描述符决定。
 *
 *    修改记录 :
 *        版本号  日期        作者     说明
@@ -16,8 +17,52 @@
 */
 #include "bsp.h"
 #include "bsp_qspi.h"
+#include "bsp_qspi_sfdp.h"
+#include "bsp_fmc_sdram.h"
 
 QSPI_HandleTypeDef hqspi;
+MDMA_HandleTypeDef hmdma_quadspi;
+
+/* 异步读取请求 */
+typedef struct
+{
+    uint8_t *pBuf;    /* 目标缓冲区 */
+    uint32_t uiAddr;  /* Flash地址 */
+    uint32_t uiSize;  /* 剩余字节数 */
+    QSPI_ASYNC_CB cb; /* 完成回调 */
+    void *pArg;       /* 回调参数 */
+} QSPI_ASYNC_T;
+
+static QSPI_ASYNC_T s_tAsyncQueue[QSPI_ASYNC_QUEUE_SIZE];
+static volatile uint8_t s_ucAsyncRead = 0;  /* 队列读位置 */
+static volatile uint8_t s_ucAsyncWrite = 0; /* 队列写位置 */
+static volatile uint8_t s_ucAsyncBusy = 0;  /* 1: MDMA传输进行中 */
+static volatile uint32_t s_uiAsyncDone = 0; /* 已完成的传输段数，QSPI_WaitAsync 据此判断是否停滞 */
+static uint32_t s_uiAsyncChunk = 0;         /* 当前传输的字节数 */
+
+/*
+    读取参数，100MHz，读取方式和空周期在初始化时按SFDP选择。
+    内存映射时使用连续读模式(SIOO)，顺序访问只在第一次发送指令。
+*/
+static QSPI_READ_CFG_T s_tReadCfg = {
+    .qpi = 0,
+    .dtr = 0,
+    .sioo = 1,
+    .dummy = 4,
+    .prescaler = 1,
+    .shift = 1,
+};
+static uint8_t s_ucContinuous = 0; /* 1: Flash可能处于连续读模式 */
+static QSPI_FLASH_T s_tFlash;      /* Flash参数描述符 */
+
+/* 各线宽对应的地址线、交替字节线、数据线模式，以及8位模式字节占用的时钟数 */
+static const uint32_t s_uiAddrLines[] = {QSPI_ADDRESS_1_LINE, QSPI_ADDRESS_1_LINE, QSPI_ADDRESS_2_LINES,
+                                         QSPI_ADDRESS_1_LINE, QSPI_ADDRESS_4_LINES, QSPI_ADDRESS_4_LINES};
+static const uint32_t s_uiAltLines[] = {QSPI_ALTERNATE_BYTES_1_LINE, QSPI_ALTERNATE_BYTES_1_LINE, QSPI_ALTERNATE_BYTES_2_LINES,
+                                        QSPI_ALTERNATE_BYTES_1_LINE, QSPI_ALTERNATE_BYTES_4_LINES, QSPI_ALTERNATE_BYTES_4_LINES};
+static const uint32_t s_uiDataLines[] = {QSPI_DATA_1_LINE, QSPI_DATA_2_LINES, QSPI_DATA_2_LINES,
+                                         QSPI_DATA_4_LINES, QSPI_DATA_4_LINES, QSPI_DATA_4_LINES};
+static const uint8_t s_ucAltClocks[] = {8, 8, 4, 8, 2, 2};
 
 static inline HAL_StatusTypeDef QSPI_SendCommand(uint32_t _instruction,
                                                  uint32_t _instructionMode,
@@ -30,6 +75,18 @@ static inline HAL_StatusTypeDef QSPI_SendCommand(uint32_t _instruction,
 static void QSPI_WriteEnable(void);
 static void QSPI_WriteEnableREG(void);
 static void QSPI_WriteDisable(void);
+static void QSPI_ReadCommand(QSPI_CommandTypeDef *_pCmd, uint32_t _uiAddr, uint32_t _uiSize, uint8_t _ucMapped);
+static void QSPI_AsyncStart(void);
+static void QSPI_ResetFlash(void);
+static int QSPI_ReadSFDP(uint32_t _uiAddr, void *_pBuf, uint32_t _uiSize);
+static void QSPI_SetQE(void);
+static void QSPI_Enter4Byte(void);
+
+/* 当前地址长度 */
+#define QSPI_ADDR_SIZE() (s_tFlash.addr4 ? QSPI_ADDRESS_32_BITS : QSPI_ADDRESS_24_BITS)
+
+/* Winbond的QPI读参数指令 C0h 和 QPI读ID指令 AFh */
+#define QSPI_IS_WINBOND() ((s_tFlash.id >> 16) == 0xEF)
 
 /**
  * @brief QSPI MSP Initialization
@@ -90,6 +147,38 @@ void HAL_QSPI_MspInit(QSPI_HandleTypeDef *hqspi)
         GPIO_InitStruct.Alternate = GPIO_AF10_QUADSPI;
         HAL_GPIO_Init(GPIOF, &GPIO_InitStruct);
 
+        /* QUADSPI MDMA Init */
+        __HAL_RCC_MDMA_CLK_ENABLE();
+        hmdma_quadspi.Instance = MDMA_Channel0;
+        hmdma_quadspi.Init.Request = MDMA_REQUEST_QUADSPI_FIFO_TH;
+        hmdma_quadspi.Init.TransferTriggerMode = MDMA_BUFFER_TRANSFER;
+        hmdma_quadspi.Init.Priority = MDMA_PRIORITY_HIGH;
+        hmdma_quadspi.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+        hmdma_quadspi.Init.SourceInc = MDMA_SRC_INC_DISABLE;
+        hmdma_quadspi.Init.DestinationInc = MDMA_DEST_INC_BYTE;
+        hmdma_quadspi.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+        hmdma_quadspi.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+        hmdma_quadspi.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+        hmdma_quadspi.Init.BufferTransferLength = 32; /* 与FIFO阀值一致 */
+        hmdma_quadspi.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+        hmdma_quadspi.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+        hmdma_quadspi.Init.SourceBlockAddressOffset = 0;
+        hmdma_quadspi.Init.DestBlockAddressOffset = 0;
+        if (HAL_MDMA_Init(&hmdma_quadspi) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+
+        __HAL_LINKDMA(hqspi, hmdma, hmdma_quadspi);
+
+        /* MDMA中断。bsp_InitQspiCache、bsp_InitAsset 等在 bsp_Init_dma 之前就会使用异步读取 */
+        HAL_NVIC_SetPriority(MDMA_IRQn, 1, 0);
+        HAL_NVIC_EnableIRQ(MDMA_IRQn);
+
+        /* QUADSPI interrupt Init */
+        HAL_NVIC_SetPriority(QUADSPI_IRQn, 1, 0);
+        HAL_NVIC_EnableIRQ(QUADSPI_IRQn);
+
         /* USER CODE BEGIN QUADSPI_MspInit 1 */
 
         /* USER CODE END QUADSPI_MspInit 1 */
@@ -124,6 +213,12 @@ void HAL_QSPI_MspDeInit(QSPI_HandleTypeDef *hqspi)
 
         HAL_GPIO_DeInit(GPIOF, GPIO_PIN_6 | GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_10 | GPIO_PIN_9);
 
+        /* QUADSPI MDMA DeInit */
+        HAL_MDMA_DeInit(hqspi->hmdma);
+
+        /* QUADSPI interrupt DeInit */
+        HAL_NVIC_DisableIRQ(QUADSPI_IRQn);
+
         /* USER CODE BEGIN QUADSPI_MspDeInit 1 */
 
         /* USER CODE END QUADSPI_MspDeInit 1 */
@@ -152,6 +247,19 @@ static inline HAL_StatusTypeDef QSPI_SendCommand(uint32_t _instruction,     /* 
                                                  uint32_t _nData)           /* 数据长度 */
 {
     QSPI_CommandTypeDef cmd = {0};
+
+    /* 等待异步读取完成，内存映射模式下不能发送其他指令，先退出 */
+    QSPI_WaitAsync();
+    QSPI_MemoryMappedExit();
+
+    /* QPI模式下指令、地址、数据都使用4线 */
+    if (s_tReadCfg.qpi)
+    {
+        _instructionMode = (_instructionMode == QSPI_INSTRUCTION_NONE) ? QSPI_INSTRUCTION_NONE : QSPI_INSTRUCTION_4_LINES;
+        _addressMode = (_addressMode == QSPI_ADDRESS_NONE) ? QSPI_ADDRESS_NONE : QSPI_ADDRESS_4_LINES;
+        _dataMode = (_dataMode == QSPI_DATA_NONE) ? QSPI_DATA_NONE : QSPI_DATA_4_LINES;
+    }
+
     /* 参数配置 */
     cmd.Instruction = _instruction;                       /* 指令 */
     cmd.InstructionMode = _instructionMode;               /* 指令线模式 */
@@ -183,6 +291,8 @@ static inline HAL_StatusTypeDef QSPI_SendCommand(uint32_t _instruction,     /* 
 */
 void bsp_InitQspi(void)
 {
+    uint32_t id;
+
     /* 复位QSPI */
     hqspi.Instance = QUADSPI;
     if (HAL_QSPI_DeInit(&hqspi) != HAL_OK)
@@ -191,7 +301,7 @@ void bsp_InitQspi(void)
     }
 
     /* 设置时钟速度，QSPI clock = 200MHz / (ClockPrescaler+1) = 100MHz */
-    hqspi.Init.ClockPrescaler = 1;
+    hqspi.Init.ClockPrescaler = s_tReadCfg.prescaler;
 
     /* 设置FIFO阀值，范围1 - 32 */
     hqspi.Init.FifoThreshold = 32;
@@ -200,11 +310,10 @@ void bsp_InitQspi(void)
         QUADSPI在FLASH驱动信号后过半个CLK周期才对FLASH驱动的数据采样。
         在外部信号延迟时，这有利于推迟数据采样。
     */
-    hqspi.Init.SampleShifting = QSPI_SAMPLE_SHIFTING_HALFCYCLE;
+    hqspi.Init.SampleShifting = s_tReadCfg.shift ? QSPI_SAMPLE_SHIFTING_HALFCYCLE : QSPI_SAMPLE_SHIFTING_NONE;
 
-    /*Flash大小是2^(FlashSize + 1) = 2^25 = 32MB */
-    // QSPI_FLASH_SIZE - 1; 需要扩大一倍，否则内存映射方式最后1个地址时，会异常。
-    hqspi.Init.FlashSize = QSPI_FLASH_SIZE;
+    /* 读取SFDP之前容量未知，先按规划容量设置 */
+    hqspi.Init.FlashSize = 32 - __CLZ(QSPI_FLASH_SIZES - 1);
 
     /* 命令之间的CS片选至少保持2个时钟周期的高电平 */
     hqspi.Init.ChipSelectHighTime = QSPI_CS_HIGH_TIME_2_CYCLE;
@@ -226,6 +335,243 @@ void bsp_InitQspi(void)
     {
         ERROR_HANDLER();
     }
+
+    /* 复位Flash，读取参数表，没有SFDP时按JEDEC ID使用默认参数 */
+    QSPI_ResetFlash();
+    id = QSPI_ReadID();
+    if (SFDP_Parse(QSPI_ReadSFDP, id, &s_tFlash) != 0)
+    {
+        SFDP_Default(id, &s_tFlash);
+    }
+
+    /*
+        Flash大小是2^(FlashSize + 1)，32MB时为 2^26。
+        需要扩大一倍，否则内存映射方式最后1个地址时，会异常。
+    */
+    hqspi.Init.FlashSize = 32 - __CLZ(s_tFlash.size - 1);
+    if (HAL_QSPI_Init(&hqspi) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+
+    if (s_tFlash.addr4 == 2)
+    {
+        QSPI_Enter4Byte();
+    }
+    QSPI_SetQE();
+
+    /* 按选择的读取方式设置空周期，只有Winbond和GigaDevice的M7-0 = 0x20 表示连续读模式 */
+    s_tReadCfg.dummy = s_tFlash.read.dummy;
+    s_tReadCfg.sioo = (QSPI_IS_WINBOND() || (id >> 16) == 0xC8);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_GetFlash
+*    功能说明: 获取Flash参数描述符
+*    形    参: 无
+*    返 回 值: 描述符
+*********************************************************************************************************
+*/
+const QSPI_FLASH_T *QSPI_GetFlash(void)
+{
+    return &s_tFlash;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ResetFlash
+*    功能说明: 软件复位Flash，回到上电状态: SPI模式、3字节地址、退出连续读模式。
+*              MCU复位时Flash不会复位，可能仍处于QPI或连续读模式，这里按各种模式都发送一遍。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_ResetFlash(void)
+{
+    static const uint32_t s_mode[] = {QSPI_INSTRUCTION_4_LINES, QSPI_INSTRUCTION_1_LINE};
+    uint8_t i;
+
+    /* 连续读模式下Flash等待地址，8个时钟全为1即 M7-0 = 0xFF，退出连续读模式 */
+    if (QSPI_SendCommand(0,                     /* 要发送的指令 */
+                         QSPI_INSTRUCTION_NONE, /* 指令线模式 */
+                         0xFFFFFFFF,            /* 要发送的地址 */
+                         QSPI_ADDRESS_4_LINES,  /* 地址线模式 */
+                         QSPI_ADDRESS_32_BITS,  /* 地址长度 */
+                         0,                     /* 空指令周期数 */
+                         QSPI_DATA_NONE,        /* 数据线模式 */
+                         0) != HAL_OK)          /* 数据长度 */
+    {
+        ERROR_HANDLER();
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        if (QSPI_SendCommand(QSPI_RESET_ENABLE_CMD, s_mode[i], 0, QSPI_ADDRESS_NONE, QSPI_ADDRESS_8_BITS, 0, QSPI_DATA_NONE, 0) != HAL_OK ||
+            QSPI_SendCommand(QSPI_RESET_CMD, s_mode[i], 0, QSPI_ADDRESS_NONE, QSPI_ADDRESS_8_BITS, 0, QSPI_DATA_NONE, 0) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+    }
+
+    /* 复位时间 tRST 最长30us */
+    HAL_Delay(1);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ReadSFDP
+*    功能说明: 读取SFDP区域，1-1-1，24位地址，8个空周期。供 SFDP_Parse 调用
+*    形    参: _uiAddr : SFDP地址
+*              _pBuf : 缓冲区
+*              _uiSize : 字节数
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+static int QSPI_ReadSFDP(uint32_t _uiAddr, void *_pBuf, uint32_t _uiSize)
+{
+    if (QSPI_SendCommand(QSPI_READ_SFDP_CMD,      /* 要发送的指令 */
+                         QSPI_INSTRUCTION_1_LINE, /* 指令线模式 */
+                         _uiAddr,                 /* 要发送的地址 */
+                         QSPI_ADDRESS_1_LINE,     /* 地址线模式 */
+                         QSPI_ADDRESS_24_BITS,    /* 地址长度 */
+                         8,                       /* 空指令周期数 */
+                         QSPI_DATA_1_LINE,        /* 数据线模式 */
+                         _uiSize) != HAL_OK)      /* 数据长度 */
+    {
+        return -1;
+    }
+
+    return (HAL_QSPI_Receive(&hqspi, _pBuf, 5000) == HAL_OK) ? 0 : -1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ReadReg
+*    功能说明: 读取1字节寄存器
+*    形    参: _ucCmd : 读寄存器指令
+*    返 回 值: 寄存器的值
+*********************************************************************************************************
+*/
+static uint8_t QSPI_ReadReg(uint8_t _ucCmd)
+{
+    uint8_t value = 0;
+
+    if (QSPI_SendCommand(_ucCmd, QSPI_INSTRUCTION_1_LINE, 0, QSPI_ADDRESS_NONE, QSPI_ADDRESS_8_BITS, 0, QSPI_DATA_1_LINE, 1) != HAL_OK ||
+        HAL_QSPI_Receive(&hqspi, &value, 5000) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+
+    return value;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_WriteReg
+*    功能说明: 写使能后写寄存器，并等待完成
+*    形    参: _ucCmd : 写寄存器指令
+*              _pBuf : 数据
+*              _ucLen : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_WriteReg(uint8_t _ucCmd, uint8_t *_pBuf, uint8_t _ucLen)
+{
+    QSPI_WriteEnable();
+
+    if (QSPI_SendCommand(_ucCmd, QSPI_INSTRUCTION_1_LINE, 0, QSPI_ADDRESS_NONE, QSPI_ADDRESS_8_BITS, 0, QSPI_DATA_1_LINE, _ucLen) != HAL_OK ||
+        HAL_QSPI_Transmit(&hqspi, _pBuf, 5000) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+
+    QSPI_WaitBusy();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_SetQE
+*    功能说明: 使用4线读取或编程前置位QE位，方法由SFDP BFPT DWORD15[22:20]给出。已置位时不写，减少非易失写入次数
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_SetQE(void)
+{
+    uint8_t sr[2];
+
+    switch (s_tFlash.qe_method)
+    {
+    case 1: /* SR2 bit1，01h 写 SR1 + SR2 */
+    case 4:
+    case 5:
+        sr[0] = QSPI_ReadReg(QSPI_READ_STATU_REG_1);
+        sr[1] = QSPI_ReadReg(QSPI_READ_STATU_REG_2);
+        if ((sr[1] & 0x02) == 0)
+        {
+            sr[1] |= 0x02;
+            QSPI_WriteReg(QSPI_WRITE_STATU_REG_1, sr, 2);
+        }
+        break;
+
+    case 2: /* SR1 bit6 */
+        sr[0] = QSPI_ReadReg(QSPI_READ_STATU_REG_1);
+        if ((sr[0] & 0x40) == 0)
+        {
+            sr[0] |= 0x40;
+            QSPI_WriteReg(QSPI_WRITE_STATU_REG_1, sr, 1);
+        }
+        break;
+
+    case 3: /* SR2 bit7，3Fh 读 3Eh 写 */
+        sr[0] = QSPI_ReadReg(0x3F);
+        if ((sr[0] & 0x80) == 0)
+        {
+            sr[0] |= 0x80;
+            QSPI_WriteReg(0x3E, sr, 1);
+        }
+        break;
+
+    case 6: /* SR2 bit1，31h 单独写 SR2 */
+        sr[0] = QSPI_ReadReg(QSPI_READ_STATU_REG_2);
+        if ((sr[0] & 0x02) == 0)
+        {
+            sr[0] |= 0x02;
+            QSPI_WriteReg(QSPI_WRITE_STATU_REG_2, sr, 1);
+        }
+        break;
+
+    default: /* 没有QE位 */
+        break;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_Enter4Byte
+*    功能说明: 没有4字节地址专用指令的大容量Flash，进入4字节地址模式。部分型号需要先写使能
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_Enter4Byte(void)
+{
+    QSPI_WriteEnable();
+
+    if (QSPI_SendCommand(QSPI_ENTER_4BYTE_CMD,    /* 要发送的指令 */
+                         QSPI_INSTRUCTION_1_LINE, /* 指令线模式 */
+                         0,                       /* 要发送的地址 */
+                         QSPI_ADDRESS_NONE,       /* 地址线模式 */
+                         QSPI_ADDRESS_8_BITS,     /* 地址长度 */
+                         0,                       /* 空指令周期数 */
+                         QSPI_DATA_NONE,          /* 数据线模式 */
+                         0) != HAL_OK)            /* 数据长度 */
+    {
+        ERROR_HANDLER();
+    }
+
+    QSPI_WriteDisable();
 }
 
 /**
@@ -349,7 +695,7 @@ uint32_t QSPI_ReadID(void)
     uint8_t buf[3]; // recv_buf[0]存放Manufacture ID, recv_buf[1]存放Device ID
     uint32_t id = 0;
 
-    if (QSPI_SendCommand(QSPI_READ_JEDEC_ID,      /* 要发送的指令 */
+    if (QSPI_SendCommand((s_tReadCfg.qpi && QSPI_IS_WINBOND()) ? QSPI_READ_QPI_ID : QSPI_READ_JEDEC_ID, /* 要发送的指令 */
                          QSPI_INSTRUCTION_1_LINE, /* 指令线模式 */
                          0,                       /* 要发送的地址 */
                          QSPI_ADDRESS_NONE,       /* 地址线模式 */
@@ -371,14 +717,22 @@ uint32_t QSPI_ReadID(void)
 }
 
 /**
- * @brief    阻塞等待Flash处于空闲状态
+ * @brief    阻塞等待Flash处于空闲状态。擦除可能长达数百秒，等待期间调用 QSPI_BusyCallback(喂狗)，
+ *           超过 QSPI_BUSY_TIMEOUT 仍忙说明Flash故障，不再调用，由看门狗复位
  * @param   none
  * @retval  none
  */
 void QSPI_WaitBusy(void)
 {
-    while ((QSPI_ReadSR(1) & 0x01) == 0x01)
-        ; // 等待BUSY位清空
+    uint32_t tick = HAL_GetTick();
+
+    while ((QSPI_ReadSR(1) & 0x01) == 0x01) // 等待BUSY位清空
+    {
+        if (HAL_GetTick() - tick < QSPI_BUSY_TIMEOUT)
+        {
+            QSPI_BusyCallback();
+        }
+    }
 }
 
 /**
@@ -422,6 +776,34 @@ uint8_t QSPI_WriteSR(uint8_t _reg, uint8_t _value)
     return HAL_QSPI_Transmit(&hqspi, &_value, 5000);
 }
 
+/*
+*********************************************************************************************************
+*   函 数 名: QSPI_ModifyCallback
+*   功能说明: Flash内容即将被写入或擦除时调用，弱定义。读缓存等模块重新实现该函数，作废对应的数据。
+*   形    参: _uiAddr : Flash地址
+*             _uiSize : 字节数
+*   返 回 值: 无
+*********************************************************************************************************
+*/
+__weak void QSPI_ModifyCallback(uint32_t _uiAddr, uint32_t _uiSize)
+{
+    UNUSED(_uiAddr);
+    UNUSED(_uiSize);
+}
+
+/*
+*********************************************************************************************************
+*   函 数 名: QSPI_BusyCallback
+*   功能说明: QSPI_WaitBusy 等待期间反复调用，弱定义。启动了看门狗的模块重新实现该函数喂狗，
+*             整片擦除、FTL格式化等长时间操作不会导致复位。
+*   形    参: 无
+*   返 回 值: 无
+*********************************************************************************************************
+*/
+__weak void QSPI_BusyCallback(void)
+{
+}
+
 /*
 *********************************************************************************************************
 *   函 数 名: QSPI_EraseSector
@@ -432,17 +814,19 @@ uint8_t QSPI_WriteSR(uint8_t _reg, uint8_t _value)
 */
 void QSPI_EraseSector(uint32_t _uiSectorAddr)
 {
+    QSPI_ModifyCallback(_uiSectorAddr & ~(QSPI_SECTOR_SIZE - 1), QSPI_SECTOR_SIZE);
+
     /* 等待Flash处于空闲状态 */
     QSPI_WaitBusy();
 
     /* 写使能 */
     QSPI_WriteEnable();
 
-    if (QSPI_SendCommand(QSPI_SECTOR_ERASE_32ADD_4K_CMD,                        /* 要发送的指令 */
+    if (QSPI_SendCommand(s_tFlash.erase_4k_cmd,                                 /* 要发送的指令 */
                          QSPI_INSTRUCTION_1_LINE,                               /* 指令线模式 */
                          _uiSectorAddr & (0xffffffff - (QSPI_SECTOR_SIZE - 1)), /* 要发送的地址 */
                          QSPI_ADDRESS_1_LINE,                                   /* 地址线模式 */
-                         QSPI_ADDRESS_32_BITS,                                  /* 地址长度 */
+                         QSPI_ADDR_SIZE(),                                      /* 地址长度 */
                          0,                                                     /* 空指令周期数 */
                          QSPI_DATA_NONE,                                        /* 数据线模式 */
                          0) != HAL_OK)                                          /* 数据长度 */
@@ -451,6 +835,50 @@ void QSPI_EraseSector(uint32_t _uiSectorAddr)
     }
 }
 
+/*
+*********************************************************************************************************
+*   函 数 名: QSPI_EraseBlock
+*   功能说明: 擦除指定的块，块大小64KB。连续擦除大片区域时比逐个擦除4KB扇区快得多。
+*             Flash不支持64KB擦除时逐个擦除扇区。
+*   形    参: _uiBlockAddr : 块地址，以64KB为单位的地址，比如0，65536等
+*   返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_EraseBlock(uint32_t _uiBlockAddr)
+{
+    uint32_t addr;
+
+    if (s_tFlash.erase_64k_cmd == 0)
+    {
+        _uiBlockAddr &= ~(QSPI_BLOCK_SIZE - 1);
+        for (addr = _uiBlockAddr; addr < _uiBlockAddr + QSPI_BLOCK_SIZE; addr += QSPI_SECTOR_SIZE)
+        {
+            QSPI_EraseSector(addr);
+        }
+        return;
+    }
+
+    QSPI_ModifyCallback(_uiBlockAddr & ~(QSPI_BLOCK_SIZE - 1), QSPI_BLOCK_SIZE);
+
+    /* 等待Flash处于空闲状态 */
+    QSPI_WaitBusy();
+
+    /* 写使能 */
+    QSPI_WriteEnable();
+
+    if (QSPI_SendCommand(s_tFlash.erase_64k_cmd,                              /* 要发送的指令 */
+                         QSPI_INSTRUCTION_1_LINE,                             /* 指令线模式 */
+                         _uiBlockAddr & (0xffffffff - (QSPI_BLOCK_SIZE - 1)), /* 要发送的地址 */
+                         QSPI_ADDRESS_1_LINE,                                 /* 地址线模式 */
+                         QSPI_ADDR_SIZE(),                                    /* 地址长度 */
+                         0,                                                   /* 空指令周期数 */
+                         QSPI_DATA_NONE,                                      /* 数据线模式 */
+                         0) != HAL_OK)                                        /* 数据长度 */
+    {
+        ERROR_HANDLER();
+    }
+}
+
 /*
 *********************************************************************************************************
 *   函 数 名: QSPI_EraseChip
@@ -461,6 +889,8 @@ void QSPI_EraseSector(uint32_t _uiSectorAddr)
 */
 void QSPI_EraseChip(void)
 {
+    QSPI_ModifyCallback(0, s_tFlash.size);
+
     /* 等待Flash处于空闲状态 */
     QSPI_WaitBusy();
 
@@ -496,22 +926,8 @@ void QSPI_ReadBuffer(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize)
 
     QSPI_WaitBusy();
 
-    /* 参数配置 */
-    cmd.Instruction = QSPI_FAST_READ_32ADD_4_CMD;         /* 指令 */
-    cmd.InstructionMode = QSPI_INSTRUCTION_1_LINE;        /* 指令线模式 */
-    cmd.Address = _uiReadAddr;                            /* 地址 */
-    cmd.AddressMode = QSPI_ADDRESS_4_LINES;               /* 地址线模式 */
-    cmd.AddressSize = QSPI_ADDRESS_32_BITS;               /* 地址长度 */
-    cmd.AlternateBytes = 0xf0;                            /* 交替字节 */
-    cmd.AlternateByteMode = QSPI_ALTERNATE_BYTES_4_LINES; /* 交替字节线模式 */
-    cmd.AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS; /* 交替字节长度 */
-    cmd.DummyCycles = 4;                                  /* 设置空指令周期数 */
-    cmd.DataMode = QSPI_DATA_4_LINES;                     /* 数据线模式 */
-    cmd.NbData = _uiSize;                                 /* 数据长度 */
-    /* 基本配置 */
-    cmd.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;          /* 每次都发送指令 */
-    cmd.DdrMode = QSPI_DDR_MODE_DISABLE;              /* 关闭DDR模式 */
-    cmd.DdrHoldHalfCycle = QSPI_DDR_HHC_ANALOG_DELAY; /* 数据输出延迟 */
+    /* 间接模式每次都要发送指令，不使用连续读模式 */
+    QSPI_ReadCommand(&cmd, _uiReadAddr, _uiSize, 0);
 
     if (HAL_QSPI_Command(&hqspi, &cmd, 10000) != HAL_OK)
     {
@@ -528,36 +944,53 @@ void QSPI_ReadBuffer(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize)
 /*
 *********************************************************************************************************
 *   函 数 名: QSPI_WriteBuffer
-*   功能说明: 页编程，页大小256字节，任意页都可以写入
+*   功能说明: 页编程，按Flash实际页大小拆分，不跨页写入
 *   形    参: _pBuf : 数据源缓冲区；
 *             _uiWriteAddr ：目标区域首地址，即页首地址，比如0， 256, 512等。
-*             _uiSize ：数据个数，不能超过页面大小，范围1 - 256。
+*             _uiSize ：数据个数，一般不超过 QSPI_PAGE_SIZE，范围1 - 256。
 *   返 回 值: 1:成功， 0：失败
 *********************************************************************************************************
 */
 void QSPI_WriteBuffer(uint8_t *_pBuf, uint32_t _uiWriteAddr, uint16_t _uiSize)
 {
-    /* 等待Flash处于空闲状态 */
-    QSPI_WaitBusy();
-    /* 写使能 */
-    QSPI_WriteEnable();
+    uint32_t len;
 
-    if (QSPI_SendCommand(QSPI_PAGE_PROG_32ADD_CMD, /* 要发送的指令 */
-                         QSPI_INSTRUCTION_1_LINE,  /* 指令线模式 */
-                         _uiWriteAddr,             /* 要发送的地址 */
-                         QSPI_ADDRESS_1_LINE,      /* 地址线模式 */
-                         QSPI_ADDRESS_32_BITS,     /* 地址长度 */
-                         0,                        /* 空指令周期数 */
-                         QSPI_DATA_1_LINE,         /* 数据线模式 */
-                         _uiSize) != HAL_OK)       /* 数据长度 */
-    {
-        ERROR_HANDLER();
-    }
+    QSPI_ModifyCallback(_uiWriteAddr, _uiSize);
 
-    /* 启动传输 */
-    if (HAL_QSPI_Transmit(&hqspi, _pBuf, 10000) != HAL_OK)
+    while (_uiSize > 0)
     {
-        ERROR_HANDLER();
+        len = s_tFlash.page_size - (_uiWriteAddr & (s_tFlash.page_size - 1));
+        if (len > _uiSize)
+        {
+            len = _uiSize;
+        }
+
+        /* 等待Flash处于空闲状态 */
+        QSPI_WaitBusy();
+        /* 写使能 */
+        QSPI_WriteEnable();
+
+        if (QSPI_SendCommand(s_tFlash.prog_cmd,                 /* 要发送的指令 */
+                             QSPI_INSTRUCTION_1_LINE,           /* 指令线模式 */
+                             _uiWriteAddr,                      /* 要发送的地址 */
+                             QSPI_ADDRESS_1_LINE,               /* 地址线模式 */
+                             QSPI_ADDR_SIZE(),                  /* 地址长度 */
+                             0,                                 /* 空指令周期数 */
+                             s_uiDataLines[s_tFlash.prog_mode], /* 数据线模式 */
+                             len) != HAL_OK)                    /* 数据长度 */
+        {
+            ERROR_HANDLER();
+        }
+
+        /* 启动传输 */
+        if (HAL_QSPI_Transmit(&hqspi, _pBuf, 10000) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+
+        _pBuf += len;
+        _uiWriteAddr += len;
+        _uiSize -= len;
     }
 }
 
@@ -574,22 +1007,9 @@ void QSPI_MemoryMapped(void)
     QSPI_CommandTypeDef cmd = {0};
     QSPI_MemoryMappedTypeDef cfg = {0};
 
-    /* 参数配置 */
-    cmd.Instruction = QSPI_FAST_READ_32ADD_4_CMD;         /* 指令 */
-    cmd.InstructionMode = QSPI_INSTRUCTION_1_LINE;        /* 指令线模式 */
-    cmd.Address = 0;                                      /* 地址 */
-    cmd.AddressMode = QSPI_ADDRESS_4_LINES;               /* 地址线模式 */
-    cmd.AddressSize = QSPI_ADDRESS_32_BITS;               /* 地址长度 */
-    cmd.AlternateBytes = 0xff;                            /* 交替字节 */
-    cmd.AlternateByteMode = QSPI_ALTERNATE_BYTES_4_LINES; /* 交替字节线模式 */
-    cmd.AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS; /* 交替字节长度 */
-    cmd.DummyCycles = 4;                                  /* 设置空指令周期数 */
-    cmd.DataMode = QSPI_DATA_4_LINES;                     /* 数据线模式 */
-    cmd.NbData = 0;                                       /* 数据长度 */
-    /* 基本配置 */
-    cmd.SIOOMode = QSPI_SIOO_INST_EVERY_CMD;          /* 每次都发送指令 */
-    cmd.DdrMode = QSPI_DDR_MODE_DISABLE;              /* 关闭DDR模式 */
-    cmd.DdrHoldHalfCycle = QSPI_DDR_HHC_ANALOG_DELAY; /* 数据输出延迟 */
+    /* 重新映射前先退出，并等待Flash空闲 */
+    QSPI_WaitBusy();
+    QSPI_ReadCommand(&cmd, 0, 0, 1);
 
     /* 关闭溢出计数 */
     cfg.TimeOutActivation = QSPI_TIMEOUT_COUNTER_DISABLE;
@@ -599,24 +1019,849 @@ void QSPI_MemoryMapped(void)
     {
         ERROR_HANDLER();
     }
+    s_ucContinuous = (cmd.SIOOMode == QSPI_SIOO_INST_ONLY_FIRST_CMD);
 }
 
-#if defined(__SHELL_H__) && defined(DEBUG_MODE)
-static int cmd_qspi(int argc, char *argv[])
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_MemoryMappedExit
+*    功能说明: 退出内存映射模式。连续读模式下Flash不再识别指令，需要补一次M7-0 = 0xF0的读操作。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_MemoryMappedExit(void)
 {
-#define __is_print(ch) ((unsigned int)((ch) - ' ') < 127u - ' ')
-#define HEXDUMP_WIDTH 16
-
-    static uint8_t s_probe = 0;
+    QSPI_CommandTypeDef cmd = {0};
+    uint8_t buf[4];
 
-    const char *help_info[] = {
-        "qspi probe Select 1 - 2",
-        "qspi read reg/buff",
-        "qspi write reg/buff",
-        "qspi erase sector/chip",
-        "qspi xip init/read"};
+    if (HAL_QSPI_GetState(&hqspi) != HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+    {
+        return;
+    }
 
-    // printf("\r\nargc = %d\r\n\r\n", argc);
+    if (HAL_QSPI_Abort(&hqspi) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+
+    if (s_ucContinuous)
+    {
+        /*
+            连续读模式下Flash等待的是地址而不是指令，这里不发送指令直接给出地址和 M7-0 = 0xF0。
+            只有带模式字节的读取方式才会进入连续读模式，QSPI_ReadCommand 会给出模式字节。
+            如果Flash并未处于连续读模式，地址0的第一个字节被当作指令0x00，Flash会忽略。
+        */
+        QSPI_ReadCommand(&cmd, 0, sizeof(buf), 0);
+        cmd.InstructionMode = QSPI_INSTRUCTION_NONE;
+
+        if (HAL_QSPI_Command(&hqspi, &cmd, 5000) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+
+        if (HAL_QSPI_Receive(&hqspi, buf, 5000) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+        s_ucContinuous = 0;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ReadCommand
+*    功能说明: 按当前读取参数和Flash描述符生成快速读取命令，间接读取和内存映射共用。
+*              模式位时钟数等于8位模式字节在地址线上的时钟数时发送模式字节，可以使用连续读模式；
+*              其他情况模式位按空周期处理。
+*    形    参: _pCmd : 命令结构体
+*              _uiAddr ：起始地址
+*              _uiSize ：数据个数，内存映射时为0
+*              _ucMapped ：1表示内存映射模式
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_ReadCommand(QSPI_CommandTypeDef *_pCmd, uint32_t _uiAddr, uint32_t _uiSize, uint8_t _ucMapped)
+{
+    const QSPI_READ_OP_T *op = s_tReadCfg.qpi ? &s_tFlash.qpi : &s_tFlash.read;
+    uint8_t mode = op->mode;
+    uint8_t alt;
+    uint8_t sioo;
+
+    if (s_tReadCfg.dtr)
+    {
+        /* DTR模式地址、交替字节、数据都在双沿传输，M7-0 只占1个时钟 */
+        mode = s_tReadCfg.qpi ? QSPI_MODE_4_4_4 : QSPI_MODE_1_4_4;
+        alt = 1;
+        _pCmd->Instruction = s_tFlash.dtr_cmd;
+        _pCmd->DummyCycles = s_tReadCfg.dummy;
+    }
+    else if (op->mode_clocks >= s_ucAltClocks[mode])
+    {
+        alt = 1;
+        _pCmd->Instruction = op->cmd;
+        _pCmd->DummyCycles = op->mode_clocks - s_ucAltClocks[mode] + s_tReadCfg.dummy;
+    }
+    else
+    {
+        alt = 0;
+        _pCmd->Instruction = op->cmd;
+        _pCmd->DummyCycles = op->mode_clocks + s_tReadCfg.dummy;
+    }
+    sioo = (_ucMapped && s_tReadCfg.sioo && alt);
+
+    _pCmd->InstructionMode = s_tReadCfg.qpi ? QSPI_INSTRUCTION_4_LINES : QSPI_INSTRUCTION_1_LINE;
+    _pCmd->Address = _uiAddr;
+    _pCmd->AddressMode = s_uiAddrLines[mode];
+    _pCmd->AddressSize = QSPI_ADDR_SIZE();
+
+    /* M7-0 模式字节，M5-4 = 10b 时Flash进入连续读模式 */
+    _pCmd->AlternateBytes = sioo ? QSPI_CONTINUOUS_READ_ON : QSPI_CONTINUOUS_READ_OFF;
+    _pCmd->AlternateByteMode = alt ? s_uiAltLines[mode] : QSPI_ALTERNATE_BYTES_NONE;
+    _pCmd->AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS;
+    _pCmd->DataMode = s_uiDataLines[mode];
+    _pCmd->NbData = _uiSize;
+
+    /* 连续读模式下只有第一次访问发送指令 */
+    _pCmd->SIOOMode = sioo ? QSPI_SIOO_INST_ONLY_FIRST_CMD : QSPI_SIOO_INST_EVERY_CMD;
+    _pCmd->DdrMode = s_tReadCfg.dtr ? QSPI_DDR_MODE_ENABLE : QSPI_DDR_MODE_DISABLE;
+    _pCmd->DdrHoldHalfCycle = QSPI_DDR_HHC_ANALOG_DELAY;
+}
+
+/**
+ * @brief    进入/退出QPI模式，进入前需要置位QE位，指令由SFDP给出
+ * @param    _ucEnable  ——  1进入 0退出
+ * @retval   none
+ */
+static void QSPI_SetQPI(uint8_t _ucEnable)
+{
+    if (_ucEnable == s_tReadCfg.qpi)
+    {
+        return;
+    }
+
+    if (_ucEnable)
+    {
+        QSPI_SetQE();
+    }
+
+    /* 进入时按1线发送，退出时按4线发送，QSPI_SendCommand 会根据当前模式处理 */
+    if (QSPI_SendCommand(_ucEnable ? s_tFlash.qpi_enter : s_tFlash.qpi_exit, /* 要发送的指令 */
+                         QSPI_INSTRUCTION_1_LINE,                            /* 指令线模式 */
+                         0,                                                  /* 要发送的地址 */
+                         QSPI_ADDRESS_NONE,                                  /* 地址线模式 */
+                         QSPI_ADDRESS_8_BITS,                                /* 地址长度 */
+                         0,                                                  /* 空指令周期数 */
+                         QSPI_DATA_NONE,                                     /* 数据线模式 */
+                         0) != HAL_OK)                                       /* 数据长度 */
+    {
+        ERROR_HANDLER();
+    }
+
+    s_tReadCfg.qpi = _ucEnable;
+}
+
+/**
+ * @brief    Winbond QPI模式下设置读参数，P5-4 为空周期数(含M7-0) 2/4/6/8
+ * @param    _ucDummy  ——  M7-0 之后的空周期数 0/2/4/6
+ * @retval   none
+ */
+static void QSPI_SetReadParam(uint8_t _ucDummy)
+{
+    uint8_t param = (uint8_t)((((_ucDummy + 2) / 2 - 1) & 0x03) << 4);
+
+    if (QSPI_SendCommand(QSPI_SET_READ_PARAM_CMD, /* 要发送的指令 */
+                         QSPI_INSTRUCTION_4_LINES, /* 指令线模式 */
+                         0,                        /* 要发送的地址 */
+                         QSPI_ADDRESS_NONE,        /* 地址线模式 */
+                         QSPI_ADDRESS_8_BITS,      /* 地址长度 */
+                         0,                        /* 空指令周期数 */
+                         QSPI_DATA_4_LINES,        /* 数据线模式 */
+                         1) != HAL_OK)             /* 数据长度 */
+    {
+        ERROR_HANDLER();
+    }
+
+    if (HAL_QSPI_Transmit(&hqspi, &param, 5000) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_GetReadCfg
+*    功能说明: 获取当前读取参数
+*    形    参: _pCfg : 读取参数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_GetReadCfg(QSPI_READ_CFG_T *_pCfg)
+{
+    *_pCfg = s_tReadCfg;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_SetReadCfg
+*    功能说明: 修改读取参数：QPI/DTR模式、连续读、空周期数、时钟分频和采样延迟。
+*              内存映射模式会被退出，需要时重新调用 QSPI_MemoryMapped。
+*    形    参: _pCfg : 读取参数
+*    返 回 值: 0:成功， -1：参数不支持
+*********************************************************************************************************
+*/
+int QSPI_SetReadCfg(const QSPI_READ_CFG_T *_pCfg)
+{
+    /* W25Q256JV 最高133MHz，分频为0时为200MHz，超出范围 */
+    if (_pCfg->prescaler == 0)
+    {
+        return -1;
+    }
+
+    /* QPI和DTR按SFDP给出的能力开放 */
+    if ((_pCfg->qpi && s_tFlash.qpi_enter == 0) || (_pCfg->dtr && s_tFlash.dtr_cmd == 0))
+    {
+        return -1;
+    }
+
+    if (_pCfg->dtr)
+    {
+        /* DTR空周期SFDP中没有描述，按型号手册给出 */
+        if (_pCfg->dummy > 31)
+        {
+            return -1;
+        }
+    }
+    else if (_pCfg->qpi && QSPI_IS_WINBOND())
+    {
+        /* Winbond QPI模式空周期由 Set Read Parameters 决定 */
+        if ((_pCfg->dummy & 0x01) || _pCfg->dummy > 6)
+        {
+            return -1;
+        }
+    }
+    else if (_pCfg->dummy != (_pCfg->qpi ? s_tFlash.qpi.dummy : s_tFlash.read.dummy))
+    {
+        /* 其他情况空周期固定为SFDP给出的值 */
+        return -1;
+    }
+
+    QSPI_MemoryMappedExit();
+    QSPI_WaitBusy();
+
+    if (_pCfg->prescaler != s_tReadCfg.prescaler || _pCfg->shift != s_tReadCfg.shift)
+    {
+        s_tReadCfg.prescaler = _pCfg->prescaler;
+        s_tReadCfg.shift = _pCfg->shift;
+
+        hqspi.Init.ClockPrescaler = s_tReadCfg.prescaler;
+        hqspi.Init.SampleShifting = s_tReadCfg.shift ? QSPI_SAMPLE_SHIFTING_HALFCYCLE : QSPI_SAMPLE_SHIFTING_NONE;
+        if (HAL_QSPI_Init(&hqspi) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+    }
+
+    QSPI_SetQPI(_pCfg->qpi);
+    if (s_tReadCfg.qpi && QSPI_IS_WINBOND())
+    {
+        QSPI_SetReadParam(_pCfg->dummy);
+    }
+
+    s_tReadCfg.dtr = _pCfg->dtr;
+    s_tReadCfg.sioo = _pCfg->sioo;
+    s_tReadCfg.dummy = _pCfg->dummy;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ReadAsync
+*    功能说明: MDMA方式读取，立即返回。请求排队执行，大数据分段传输，每段完成后作废目标区的D-Cache。
+*    形    参: _pBuf : 目标缓冲区，可以是AXI SRAM或者SDRAM，建议32字节对齐
+*              _uiReadAddr ：起始地址
+*              _uiSize ：数据个数，不能超出芯片总容量
+*              _cb ：完成回调，在中断中执行，可以为NULL
+*              _pArg ：回调参数
+*    返 回 值: 0:成功， -1：队列已满或参数错误
+*********************************************************************************************************
+*/
+int QSPI_ReadAsync(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize, QSPI_ASYNC_CB _cb, void *_pArg)
+{
+    QSPI_ASYNC_T *req;
+    uint8_t next;
+    uint8_t start = 0;
+
+    if (_pBuf == NULL || _uiSize == 0 || _uiReadAddr + _uiSize > s_tFlash.size)
+    {
+        return -1;
+    }
+
+    /* 队列空闲时由任务启动，先退出内存映射并等待Flash空闲；回调中追加请求时传输尚未结束，不会阻塞 */
+    if (s_ucAsyncBusy == 0)
+    {
+        QSPI_WaitBusy();
+    }
+
+    DISABLE_INT();
+    next = (s_ucAsyncWrite + 1) % QSPI_ASYNC_QUEUE_SIZE;
+    if (next == s_ucAsyncRead)
+    {
+        ENABLE_INT();
+        return -1;
+    }
+
+    req = &s_tAsyncQueue[s_ucAsyncWrite];
+    req->pBuf = _pBuf;
+    req->uiAddr = _uiReadAddr;
+    req->uiSize = _uiSize;
+    req->cb = _cb;
+    req->pArg = _pArg;
+    s_ucAsyncWrite = next;
+
+    if (s_ucAsyncBusy == 0)
+    {
+        s_ucAsyncBusy = 1;
+        start = 1;
+    }
+    ENABLE_INT();
+
+    if (start)
+    {
+        QSPI_AsyncStart();
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_AsyncStart
+*    功能说明: 启动队列头部请求的下一段MDMA传输
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void QSPI_AsyncStart(void)
+{
+    QSPI_CommandTypeDef cmd = {0};
+    QSPI_ASYNC_T *req = &s_tAsyncQueue[s_ucAsyncRead];
+    uint32_t width;
+
+    s_uiAsyncChunk = (req->uiSize > QSPI_ASYNC_CHUNK) ? QSPI_ASYNC_CHUNK : req->uiSize;
+
+    /* 地址和长度4字节对齐时按字传输，减少MDMA访问QSPI数据寄存器的次数 */
+    width = ((((uint32_t)req->pBuf | s_uiAsyncChunk) & 0x03) == 0) ? MDMA_SRC_DATASIZE_WORD : MDMA_SRC_DATASIZE_BYTE;
+    if (hmdma_quadspi.Init.SourceDataSize != width)
+    {
+        hmdma_quadspi.Init.SourceDataSize = width;
+        hmdma_quadspi.Init.DestDataSize = (width == MDMA_SRC_DATASIZE_WORD) ? MDMA_DEST_DATASIZE_WORD : MDMA_DEST_DATASIZE_BYTE;
+        hmdma_quadspi.Init.DestinationInc = (width == MDMA_SRC_DATASIZE_WORD) ? MDMA_DEST_INC_WORD : MDMA_DEST_INC_BYTE;
+        if (HAL_MDMA_Init(&hmdma_quadspi) != HAL_OK)
+        {
+            ERROR_HANDLER();
+        }
+    }
+
+    /* 传输前回写并作废目标区的D-Cache，防止脏数据在传输过程中被写回覆盖 */
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)((uint32_t)req->pBuf & ~31UL),
+                                      s_uiAsyncChunk + ((uint32_t)req->pBuf & 31UL));
+
+    QSPI_ReadCommand(&cmd, req->uiAddr, s_uiAsyncChunk, 0);
+
+    if (HAL_QSPI_Command(&hqspi, &cmd, 5000) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+
+    if (HAL_QSPI_Receive_DMA(&hqspi, req->pBuf) != HAL_OK)
+    {
+        ERROR_HANDLER();
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_AsyncDone
+*    功能说明: 一段传输结束，推进当前请求，请求完成后执行回调并启动下一个请求
+*    形    参: _iStatus : 0成功 -1失败
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC static void QSPI_AsyncDone(int _iStatus)
+{
+    QSPI_ASYNC_T *req = &s_tAsyncQueue[s_ucAsyncRead];
+    QSPI_ASYNC_CB cb;
+    void *arg;
+
+    s_uiAsyncDone++;
+
+    /* 作废目标区的D-Cache，丢弃传输期间预取的旧数据 */
+    SCB_InvalidateDCache_by_Addr((uint32_t *)((uint32_t)req->pBuf & ~31UL),
+                                 s_uiAsyncChunk + ((uint32_t)req->pBuf & 31UL));
+
+    req->pBuf += s_uiAsyncChunk;
+    req->uiAddr += s_uiAsyncChunk;
+    req->uiSize -= s_uiAsyncChunk;
+
+    if (req->uiSize != 0 && _iStatus == 0)
+    {
+        QSPI_AsyncStart();
+        return;
+    }
+
+    cb = req->cb;
+    arg = req->pArg;
+    s_ucAsyncRead = (s_ucAsyncRead + 1) % QSPI_ASYNC_QUEUE_SIZE;
+
+    /* 回调中可以继续调用 QSPI_ReadAsync 追加请求 */
+    if (cb != NULL)
+    {
+        cb(arg, _iStatus);
+    }
+
+    if (s_ucAsyncRead != s_ucAsyncWrite)
+    {
+        QSPI_AsyncStart();
+    }
+    else
+    {
+        s_ucAsyncBusy = 0;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_AsyncBusy
+*    功能说明: 查询异步读取是否进行中
+*    形    参: 无
+*    返 回 值: 1:进行中， 0：空闲
+*********************************************************************************************************
+*/
+uint8_t QSPI_AsyncBusy(void)
+{
+    return s_ucAsyncBusy;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_WaitAsync
+*    功能说明: 等待所有排队的异步读取完成。阻塞方式的读写函数在发送指令前会自动调用。
+*              超过 QSPI_ASYNC_TIMEOUT 没有一段传输完成(例如MDMA中断未使能)，终止传输，
+*              排队的请求都以 -1 结束并在开中断状态下执行回调
+*    形    参: 无
+*    返 回 值: 0:完成， -1：超时
+*********************************************************************************************************
+*/
+int QSPI_WaitAsync(void)
+{
+    QSPI_ASYNC_T *req;
+    QSPI_ASYNC_CB cb;
+    void *arg;
+    uint8_t end, start;
+    uint32_t done = s_uiAsyncDone;
+    uint32_t tick = HAL_GetTick();
+
+    while (s_ucAsyncBusy)
+    {
+        if (done != s_uiAsyncDone)
+        {
+            done = s_uiAsyncDone;
+            tick = HAL_GetTick();
+        }
+        else if (HAL_GetTick() - tick > QSPI_ASYNC_TIMEOUT)
+        {
+            break;
+        }
+    }
+    if (!s_ucAsyncBusy)
+    {
+        return 0;
+    }
+
+    /* HAL_QSPI_Abort 用 HAL_GetTick 计时，不能关中断。终止后不会再进入完成中断，再清空队列 */
+    HAL_QSPI_Abort(&hqspi);
+
+    /*
+        关中断取出终止时已排队的请求，开中断后执行回调，与完成中断中一样。
+        回调中可以调用 QSPI_ReadAsync，s_ucAsyncBusy 保持为1，追加的请求只排队不启动
+    */
+    end = s_ucAsyncWrite;
+    while (s_ucAsyncRead != end)
+    {
+        DISABLE_INT();
+        req = &s_tAsyncQueue[s_ucAsyncRead];
+        cb = req->cb;
+        arg = req->pArg;
+        s_ucAsyncRead = (s_ucAsyncRead + 1) % QSPI_ASYNC_QUEUE_SIZE;
+        ENABLE_INT();
+
+        if (cb != NULL)
+        {
+            cb(arg, -1);
+        }
+    }
+
+    /* 回调中追加的请求重新启动传输 */
+    DISABLE_INT();
+    start = (s_ucAsyncRead != s_ucAsyncWrite);
+    if (!start)
+    {
+        s_ucAsyncBusy = 0;
+    }
+    ENABLE_INT();
+
+    if (start)
+    {
+        QSPI_AsyncStart();
+    }
+
+    return -1;
+}
+
+/**
+ * @brief  Rx Transfer completed callback.
+ * @param  hqspi: QSPI handle
+ * @retval None
+ */
+RAM_FUNC void HAL_QSPI_RxCpltCallback(QSPI_HandleTypeDef *hqspi)
+{
+    QSPI_AsyncDone(0);
+}
+
+/**
+ * @brief  Transfer Error callback.
+ * @param  hqspi: QSPI handle
+ * @retval None
+ */
+void HAL_QSPI_ErrorCallback(QSPI_HandleTypeDef *hqspi)
+{
+    if (s_ucAsyncBusy)
+    {
+        /* 放弃当前请求剩余部分，继续处理后面的请求 */
+        s_tAsyncQueue[s_ucAsyncRead].uiSize = s_uiAsyncChunk;
+        QSPI_AsyncDone(-1);
+    }
+}
+
+/**
+ * @brief This function handles QUADSPI global interrupt.
+ */
+RAM_FUNC void QUADSPI_IRQHandler(void)
+{
+    HAL_QSPI_IRQHandler(&hqspi);
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 打印速度，bytes/us 即 MB/s，保留两位小数 */
+static void qspi_bench_print(const char *_name, uint32_t _bytes, int64_t _ticks)
+{
+    uint32_t us = (uint32_t)(_ticks / (SystemCoreClock / 1000000ul));
+    uint32_t rate;
+
+    if (us == 0)
+    {
+        us = 1;
+    }
+    rate = (uint32_t)((uint64_t)_bytes * 100 / us);
+    printf("%-12s: %8d bytes %8d us %4d.%02d MB/s\r\n", _name, _bytes, us, rate / 100, rate % 100);
+}
+
+static int qspi_bench_cmp(const void *_a, const void *_b)
+{
+    uint32_t a = *(const uint32_t *)_a;
+    uint32_t b = *(const uint32_t *)_b;
+
+    return (a > b) - (a < b);
+}
+
+/* 打印耗时分布，_pUs 为各次耗时(us)，排序后取 min/avg/p99/max */
+static void qspi_bench_stat(const char *_name, uint32_t *_pUs, uint32_t _num)
+{
+    uint64_t sum = 0;
+    uint32_t i;
+
+    qsort(_pUs, _num, sizeof(uint32_t), qspi_bench_cmp);
+    for (i = 0; i < _num; i++)
+    {
+        sum += _pUs[i];
+    }
+    printf("%-12s: %5d %8d %8d %8d %8d\r\n", _name, _num, _pUs[0], (uint32_t)(sum / _num),
+           _pUs[(_num * 99 + 99) / 100 - 1], _pUs[_num - 1]);
+}
+
+/* 内存映射区域临时改为不可Cache，用于测试关闭D-Cache时的读取速度 */
+static void qspi_bench_nocache(uint8_t _enable)
+{
+    MPU_Region_InitTypeDef MPU_InitStruct = {0};
+
+    HAL_MPU_Disable();
+
+    MPU_InitStruct.Enable = _enable ? MPU_REGION_ENABLE : MPU_REGION_DISABLE;
+    MPU_InitStruct.BaseAddress = QSPI_BASE;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_256MB;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.Number = MPU_REGION_NUMBER15; /* 最高编号，覆盖其他区域的属性 */
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_ENABLE;
+
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
+/*
+    读取速度测试：间接模式、MDMA、内存映射(D-Cache开/关)的顺序/随机读取。
+    随机读取每次256字节，地址按页对齐，反映指令和空周期的开销。
+*/
+static void qspi_bench(uint32_t _size)
+{
+#define QSPI_BENCH_BUF_SIZE (16 * 1024)
+#define QSPI_BENCH_RAND_SIZE 256
+#define QSPI_BENCH_RAND_NUM 1024
+
+    QSPI_READ_CFG_T cfg;
+    uint8_t *buff = malloc(QSPI_BENCH_BUF_SIZE);
+    uint8_t *dst;
+    int64_t ticks;
+    uint32_t i, addr;
+    uint8_t pass;
+
+    if (buff == NULL)
+    {
+        printf("Low memory! size = %d\r\n", QSPI_BENCH_BUF_SIZE);
+        return;
+    }
+
+    if (_size < QSPI_BENCH_BUF_SIZE || _size > QSPI_FLASH_SIZES)
+    {
+        _size = QSPI_FLASH_SIZES;
+    }
+    _size &= ~(QSPI_BENCH_BUF_SIZE - 1);
+
+    QSPI_GetReadCfg(&cfg);
+    printf("qpi = %d dtr = %d sioo = %d dummy = %d clock = %d MHz shift = %d\r\n",
+           cfg.qpi, cfg.dtr, cfg.sioo, cfg.dummy,
+           HAL_RCC_GetHCLKFreq() / 1000000ul / (cfg.prescaler + 1), cfg.shift);
+
+    /* 间接模式顺序读取 */
+    ticks = get_system_ticks();
+    for (addr = 0; addr < _size; addr += QSPI_BENCH_BUF_SIZE)
+    {
+        QSPI_ReadBuffer(buff, addr, QSPI_BENCH_BUF_SIZE);
+    }
+    qspi_bench_print("seq read", _size, get_system_ticks() - ticks);
+
+    /* 间接模式随机读取 */
+    srand(1);
+    ticks = get_system_ticks();
+    for (i = 0; i < QSPI_BENCH_RAND_NUM; i++)
+    {
+        addr = ((uint32_t)rand() * QSPI_PAGE_SIZE) & (QSPI_FLASH_SIZES - 1);
+        QSPI_ReadBuffer(buff, addr, QSPI_BENCH_RAND_SIZE);
+    }
+    qspi_bench_print("rand read", QSPI_BENCH_RAND_NUM * QSPI_BENCH_RAND_SIZE, get_system_ticks() - ticks);
+
+    /* MDMA顺序读取到SDRAM，一次提交，由驱动按块拆分 */
+    dst = Mem_AllocAlign(MEM_SDRAM, _size, 32);
+    if (dst != NULL)
+    {
+        ticks = get_system_ticks();
+        if (QSPI_ReadAsync(dst, 0, _size, NULL, NULL) == 0)
+        {
+            QSPI_WaitAsync();
+            qspi_bench_print("dma seq", _size, get_system_ticks() - ticks);
+        }
+        Mem_Free(dst);
+    }
+
+    /* MDMA随机读取，每次等待完成，反映启动和中断的开销 */
+    srand(1);
+    ticks = get_system_ticks();
+    for (i = 0; i < QSPI_BENCH_RAND_NUM; i++)
+    {
+        addr = ((uint32_t)rand() * QSPI_PAGE_SIZE) & (QSPI_FLASH_SIZES - 1);
+        if (QSPI_ReadAsync(buff, addr, QSPI_BENCH_RAND_SIZE, NULL, NULL) != 0)
+        {
+            break;
+        }
+        QSPI_WaitAsync();
+    }
+    qspi_bench_print("dma rand", i * QSPI_BENCH_RAND_SIZE, get_system_ticks() - ticks);
+
+    /* 内存映射读取，第1遍D-Cache开启，第2遍用MPU把映射区域改为不可Cache */
+    QSPI_MemoryMapped();
+    for (pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            qspi_bench_nocache(1);
+        }
+
+        /* 顺序读取，先作废D-Cache，保证数据来自Flash */
+        SCB_InvalidateDCache_by_Addr((uint32_t *)QSPI_BASE, _size);
+        ticks = get_system_ticks();
+        for (addr = 0; addr < _size; addr += QSPI_BENCH_BUF_SIZE)
+        {
+            memcpy(buff, (uint8_t *)(QSPI_BASE + addr), QSPI_BENCH_BUF_SIZE);
+        }
+        qspi_bench_print(pass ? "mmap seq nc" : "mmap seq", _size, get_system_ticks() - ticks);
+
+        /* 随机读取 */
+        srand(2);
+        SCB_InvalidateDCache_by_Addr((uint32_t *)QSPI_BASE, QSPI_FLASH_SIZES);
+        ticks = get_system_ticks();
+        for (i = 0; i < QSPI_BENCH_RAND_NUM; i++)
+        {
+            addr = ((uint32_t)rand() * QSPI_PAGE_SIZE) & (QSPI_FLASH_SIZES - 1);
+            memcpy(buff, (uint8_t *)(QSPI_BASE + addr), QSPI_BENCH_RAND_SIZE);
+        }
+        qspi_bench_print(pass ? "mmap rand nc" : "mmap rand", QSPI_BENCH_RAND_NUM * QSPI_BENCH_RAND_SIZE, get_system_ticks() - ticks);
+    }
+    qspi_bench_nocache(0);
+    QSPI_MemoryMappedExit();
+
+    free(buff);
+}
+
+/*
+    编程和擦除测试，使用 QSPI_BENCH_ADDR 开始的 QSPI_BENCH_SIZE 区域，原有数据被破坏。
+    64KB擦除整个区域，逐页编程整个区域，再逐个擦除4KB扇区，统计每次操作到WIP清零的耗时。
+*/
+static void qspi_bench_write(void)
+{
+#define QSPI_BENCH_PAGE_NUM (QSPI_BENCH_SIZE / QSPI_PAGE_SIZE)
+
+    uint32_t *us = malloc(QSPI_BENCH_PAGE_NUM * sizeof(uint32_t));
+    uint8_t page[QSPI_PAGE_SIZE];
+    uint32_t div = SystemCoreClock / 1000000ul;
+    int64_t ticks, total;
+    uint32_t i;
+
+    if (us == NULL)
+    {
+        printf("Low memory! size = %d\r\n", QSPI_BENCH_PAGE_NUM * sizeof(uint32_t));
+        return;
+    }
+
+    for (i = 0; i < QSPI_PAGE_SIZE; i++)
+    {
+        page[i] = (uint8_t)(i * 7 + 0x5A);
+    }
+
+    printf("range 0x%08X - 0x%08X\r\n", QSPI_BENCH_ADDR, QSPI_BENCH_ADDR + QSPI_BENCH_SIZE - 1);
+    printf("%-12s: %5s %8s %8s %8s %8s (us)\r\n", "op", "n", "min", "avg", "p99", "max");
+
+    /* 64KB块擦除 */
+    for (i = 0; i < QSPI_BENCH_SIZE / QSPI_BLOCK_SIZE; i++)
+    {
+        ticks = get_system_ticks();
+        QSPI_EraseBlock(QSPI_BENCH_ADDR + i * QSPI_BLOCK_SIZE);
+        QSPI_WaitBusy();
+        us[i] = (uint32_t)((get_system_ticks() - ticks) / div);
+    }
+    qspi_bench_stat("erase 64K", us, QSPI_BENCH_SIZE / QSPI_BLOCK_SIZE);
+
+    /* 页编程 */
+    total = 0;
+    for (i = 0; i < QSPI_BENCH_PAGE_NUM; i++)
+    {
+        ticks = get_system_ticks();
+        QSPI_WriteBuffer(page, QSPI_BENCH_ADDR + i * QSPI_PAGE_SIZE, QSPI_PAGE_SIZE);
+        QSPI_WaitBusy();
+        ticks = get_system_ticks() - ticks;
+        total += ticks;
+        us[i] = (uint32_t)(ticks / div);
+    }
+    qspi_bench_stat("page prog", us, QSPI_BENCH_PAGE_NUM);
+
+    /* 4KB扇区擦除，扇区已写满数据 */
+    for (i = 0; i < QSPI_BENCH_SIZE / QSPI_SECTOR_SIZE; i++)
+    {
+        ticks = get_system_ticks();
+        QSPI_EraseSector(QSPI_BENCH_ADDR + i * QSPI_SECTOR_SIZE);
+        QSPI_WaitBusy();
+        us[i] = (uint32_t)((get_system_ticks() - ticks) / div);
+    }
+    qspi_bench_stat("erase 4K", us, QSPI_BENCH_SIZE / QSPI_SECTOR_SIZE);
+
+    qspi_bench_print("prog", QSPI_BENCH_SIZE, total);
+
+    free(us);
+}
+
+/* 整片擦除耗时，Flash中所有数据(资源包、OTA、KV等)都被擦除 */
+static void qspi_bench_chip(void)
+{
+    int64_t ticks;
+    uint32_t ms;
+
+    printf("chip erase, please wait...\r\n");
+    ticks = get_system_ticks();
+    QSPI_EraseChip();
+    QSPI_WaitBusy();
+    ms = (uint32_t)((get_system_ticks() - ticks) / (SystemCoreClock / 1000ul));
+    printf("%-12s: %d.%03d s\r\n", "erase chip", ms / 1000, ms % 1000);
+}
+
+/* 打印Flash参数描述符 */
+static void qspi_info(void)
+{
+    static const char *s_mode[] = {"1-1-1", "1-1-2", "1-2-2", "1-1-4", "1-4-4", "4-4-4"};
+    const QSPI_FLASH_T *p = QSPI_GetFlash();
+    uint8_t i;
+
+    printf("id = 0x%06X sfdp = %d.%d size = %d KB page = %d\r\n",
+           p->id, p->sfdp >> 4, p->sfdp & 0x0F, p->size / 1024, p->page_size);
+    printf("address = %s\r\n", p->addr4 == 1 ? "4 byte cmd" : (p->addr4 == 2 ? "4 byte mode" : "3 byte"));
+    for (i = 0; i < 4; i++)
+    {
+        if (p->erase_cmd[i] != 0)
+        {
+            printf("erase %d = %02Xh %d KB\r\n", i + 1, p->erase_cmd[i], (1 << p->erase_shift[i]) / 1024);
+        }
+    }
+    printf("read = %s %02Xh mode %d dummy %d\r\n", s_mode[p->read.mode], p->read.cmd, p->read.mode_clocks, p->read.dummy);
+    printf("prog = %s %02Xh qe = %d\r\n", s_mode[p->prog_mode], p->prog_cmd, p->qe_method);
+    if (p->qpi_enter != 0)
+    {
+        printf("qpi = %02Xh/%02Xh read %02Xh mode %d dummy %d\r\n",
+               p->qpi_enter, p->qpi_exit, p->qpi.cmd, p->qpi.mode_clocks, p->qpi.dummy);
+    }
+    if (p->dtr_cmd != 0)
+    {
+        printf("dtr = %02Xh\r\n", p->dtr_cmd);
+    }
+    if (p->size < QSPI_FLASH_SIZES)
+    {
+        printf("Warning: flash smaller than partition layout %d KB\r\n", QSPI_FLASH_SIZES / 1024);
+    }
+}
+
+static int cmd_qspi(int argc, char *argv[])
+{
+#define __is_print(ch) ((unsigned int)((ch) - ' ') < 127u - ' ')
+#define HEXDUMP_WIDTH 16
+
+    static uint8_t s_probe = 0;
+
+    const char *help_info[] = {
+        "qspi probe Select 1 - 2",
+        "qspi read reg/buff",
+        "qspi write reg/buff",
+        "qspi erase sector/chip",
+        "qspi xip init/read/exit",
+        "qspi cfg [qpi 0/1] [dtr 0/1] [sioo 0/1] [dummy n] [div n] [shift 0/1]",
+        "qspi bench [size] / bench write / bench chip yes",
+        "qspi dma add size",
+        "qspi info"};
+
+    // printf("\r\nargc = %d\r\n\r\n", argc);
 
     if (argc < 2)
     {
@@ -674,18 +1919,31 @@ static int cmd_qspi(int argc, char *argv[])
                            argv[0], argv[1], argv[2]);
                     return -1;
                 }
-                uint32_t add = atoi(argv[3]);
-                uint16_t size = atoi(argv[4]);
-                uint8_t *buff = malloc(size);
+                uint32_t add = strtoul(argv[3], NULL, 0);
+                uint32_t size = strtoul(argv[4], NULL, 0);
+                uint8_t *buff;
+
+                if (size == 0 || add >= QSPI_FLASH_SIZES || size > QSPI_FLASH_SIZES - add)
+                {
+                    printf("Error size = %u.\r\n", size);
+                    return -1;
+                }
+
+                /* 不超过最大的内存池块时用内存池，更大的从AXI SRAM堆申请 */
+                buff = Pool_Alloc(size);
+                if (buff == NULL)
+                {
+                    buff = Mem_Alloc(MEM_AXI, size);
+                }
 
                 if (buff)
                 {
-                    printf("Read buff success. add = %d size = %d.\r\nThe data is:\r\n", add, size);
+                    printf("Read buff success. add = %u size = %u.\r\nThe data is:\r\n", add, size);
 
                     QSPI_ReadBuffer(buff, add, size);
 
                     printf("Offset (h) 00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F\r\n");
-                    for (uint16_t i = 0; i < size; i += HEXDUMP_WIDTH)
+                    for (uint32_t i = 0; i < size; i += HEXDUMP_WIDTH)
                     {
                         printf("[%08X] ", i);
                         /* dump hex */
@@ -712,16 +1970,20 @@ static int cmd_qspi(int argc, char *argv[])
                     }
                     printf("\r\n");
 
-                    if (buff != NULL)
+                    if (Pool_BlockSize(buff) != 0)
+                    {
+                        Pool_Free(buff);
+                    }
+                    else
                     {
-                        free(buff);
+                        Mem_Free(buff);
                     }
 
                     return 0;
                 }
                 else
                 {
-                    printf("Low memory! size = %d\r\n", size);
+                    printf("Low memory! size = %u\r\n", size);
                 }
             }
             else
@@ -819,12 +2081,155 @@ static int cmd_qspi(int argc, char *argv[])
 
                 return 0;
             }
+            else if (!strcmp(argv[2], "exit"))
+            {
+                QSPI_MemoryMappedExit();
+
+                return 0;
+            }
             else
             {
                 printf("write parameter Error.\r\n%s\r\n", help_info[4]);
                 return -1;
             }
         }
+        else if (!strcmp(argv[1], "cfg"))
+        {
+            QSPI_READ_CFG_T cfg;
+
+            QSPI_GetReadCfg(&cfg);
+            for (int i = 2; i + 1 < argc; i += 2)
+            {
+                uint8_t val = atoi(argv[i + 1]);
+
+                if (!strcmp(argv[i], "qpi"))
+                {
+                    cfg.qpi = val;
+                }
+                else if (!strcmp(argv[i], "dtr"))
+                {
+                    cfg.dtr = val;
+                }
+                else if (!strcmp(argv[i], "sioo"))
+                {
+                    cfg.sioo = val;
+                }
+                else if (!strcmp(argv[i], "dummy"))
+                {
+                    cfg.dummy = val;
+                }
+                else if (!strcmp(argv[i], "div"))
+                {
+                    cfg.prescaler = val;
+                }
+                else if (!strcmp(argv[i], "shift"))
+                {
+                    cfg.shift = val;
+                }
+                else
+                {
+                    printf("cfg parameter Error.\r\n%s\r\n", help_info[5]);
+                    return -1;
+                }
+            }
+
+            if (QSPI_SetReadCfg(&cfg) != 0)
+            {
+                printf("Unsupported config.\r\n");
+                return -1;
+            }
+            QSPI_GetReadCfg(&cfg);
+            printf("qpi = %d dtr = %d sioo = %d dummy = %d div = %d shift = %d\r\n",
+                   cfg.qpi, cfg.dtr, cfg.sioo, cfg.dummy, cfg.prescaler, cfg.shift);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "dma"))
+        {
+            /* MDMA读取到SDRAM，与CPU读取的结果比较 */
+            uint8_t *dst, *ref;
+            uint32_t loops = 0;
+            int64_t ticks;
+
+            if (argc < 4)
+            {
+                printf("Error Command\r\n%s\r\n", help_info[7]);
+                return -1;
+            }
+            uint32_t add = strtoul(argv[2], NULL, 0);
+            uint32_t size = strtoul(argv[3], NULL, 0);
+            if (size == 0 || size > SDRAM_APP_SIZE / 2 || add + size > QSPI_FLASH_SIZES)
+            {
+                printf("Error size.\r\n");
+                return -1;
+            }
+
+            dst = Mem_AllocAlign(MEM_SDRAM, size, 32);
+            ref = Mem_Alloc(MEM_SDRAM, size);
+            if (dst == NULL || ref == NULL)
+            {
+                printf("Low memory! size = %d\r\n", size);
+                Mem_Free(dst);
+                Mem_Free(ref);
+                return -1;
+            }
+
+            ticks = get_system_ticks();
+            if (QSPI_ReadAsync(dst, add, size, NULL, NULL) != 0)
+            {
+                printf("QSPI_ReadAsync Error.\r\n");
+                Mem_Free(dst);
+                Mem_Free(ref);
+                return -1;
+            }
+            /* 等待期间CPU可以做其他工作，这里统计空转次数 */
+            while (QSPI_AsyncBusy())
+            {
+                loops++;
+            }
+            qspi_bench_print("mdma read", size, get_system_ticks() - ticks);
+            printf("cpu idle loops = %d\r\n", loops);
+
+            ticks = get_system_ticks();
+            QSPI_ReadBuffer(ref, add, size);
+            qspi_bench_print("cpu read", size, get_system_ticks() - ticks);
+
+            printf("compare %s\r\n", memcmp(dst, ref, size) ? "Error" : "OK");
+
+            Mem_Free(dst);
+            Mem_Free(ref);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "bench"))
+        {
+            if (argc > 2 && !strcmp(argv[2], "write"))
+            {
+                qspi_bench_write();
+            }
+            else if (argc > 2 && !strcmp(argv[2], "chip"))
+            {
+                /* 整片擦除需要确认 */
+                if (argc < 4 || strcmp(argv[3], "yes"))
+                {
+                    printf("erase whole flash, confirm with: qspi bench chip yes\r\n");
+                    return -1;
+                }
+                qspi_bench_chip();
+            }
+            else
+            {
+                qspi_bench(argc > 2 ? strtoul(argv[2], NULL, 0) : 1024 * 1024);
+            }
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "info"))
+        {
+            qspi_info();
+
+            return 0;
+        }
         else
         {
             printf("Error Command\r\nUsage:\r\n");
@@ -839,7 +2244,7 @@ static int cmd_qspi(int argc, char *argv[])
     return -1;
 }
 // 导出到命令列表里
-SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), qspi, cmd_qspi, qspi[probe read write erase]);
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), qspi, cmd_qspi, qspi[probe read write erase xip cfg bench dma info]);
 #endif // #ifdef DEBUG_MODE
 
 /***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,631 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 读缓存模块
+*    文件名称 : bsp_qspi_cache.c
+*    版    本 : V1.0
+*    说    明 : 在SDRAM中缓存QSPI Flash的热点数据(字库、查找表、配置等)，反复读取的小块数据不再每次
+*               发送读指令等待Flash。
+*               1. 按 QSPI_CACHE_BLOCK_SIZE 分块，哈希表查找，LRU替换
+*               2. 缺失时整块读入，同时用MDMA异步预取下一个块，顺序读取时后续块直接命中
+*               3. QSPI_WriteBuffer、QSPI_EraseSector、QSPI_EraseChip 通过 QSPI_ModifyCallback
+*                  作废对应的缓存块，缓存内容与Flash始终一致
+*               缓存函数不可重入，不能在中断中调用。内存映射(XIP)方式的读取不经过本缓存。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "utils_lib.h"
+#include "bsp_fmc_sdram.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_cache.h"
+
+#define CACHE_NIL 0xFFFF
+#define CACHE_HASH_SIZE (QSPI_CACHE_LINES * 2)
+#define CACHE_BLOCK_NUM (QSPI_FLASH_SIZES / QSPI_CACHE_BLOCK_SIZE)
+
+#define CACHE_FREE 0       /* 空闲 */
+#define CACHE_VALID 1      /* 有效 */
+#define CACHE_PENDING 2    /* 正在预取 */
+#define CACHE_PREFETCHED 3 /* 预取完成，尚未被读取 */
+
+typedef struct
+{
+    uint32_t block; /* Flash块号 */
+    uint16_t prev;  /* LRU链表，靠近表头的最近使用过 */
+    uint16_t next;
+    uint16_t hnext; /* 哈希链表 */
+    uint8_t state;
+} QSPI_CACHE_LINE_T;
+
+static QSPI_CACHE_LINE_T s_tLine[QSPI_CACHE_LINES];
+static uint16_t s_usHash[CACHE_HASH_SIZE];
+static uint16_t s_usMru = CACHE_NIL;
+static uint16_t s_usLru = CACHE_NIL;
+static uint16_t s_usPending = CACHE_NIL; /* 正在预取的缓存块 */
+static volatile int8_t s_cPendResult = 0;  /* 1:进行中 0:成功 -1:失败 */
+static QSPI_CACHE_STAT_T s_tStat;
+static uint8_t s_ucInit = 0;
+
+#define CACHE_LINE_ADDR(n) ((uint8_t *)(QSPI_CACHE_BUF + (uint32_t)(n)*QSPI_CACHE_BLOCK_SIZE))
+#define CACHE_HASH(block) ((block) & (CACHE_HASH_SIZE - 1))
+
+/* 从LRU链表中取出 */
+static void CacheUnlink(uint16_t _usLine)
+{
+    QSPI_CACHE_LINE_T *line = &s_tLine[_usLine];
+
+    if (line->prev != CACHE_NIL)
+    {
+        s_tLine[line->prev].next = line->next;
+    }
+    else
+    {
+        s_usMru = line->next;
+    }
+
+    if (line->next != CACHE_NIL)
+    {
+        s_tLine[line->next].prev = line->prev;
+    }
+    else
+    {
+        s_usLru = line->prev;
+    }
+}
+
+/* 放到LRU链表头部(最近使用) */
+static void CachePushMru(uint16_t _usLine)
+{
+    s_tLine[_usLine].prev = CACHE_NIL;
+    s_tLine[_usLine].next = s_usMru;
+    if (s_usMru != CACHE_NIL)
+    {
+        s_tLine[s_usMru].prev = _usLine;
+    }
+    else
+    {
+        s_usLru = _usLine;
+    }
+    s_usMru = _usLine;
+}
+
+/* 放到LRU链表尾部(最先被替换) */
+static void CachePushLru(uint16_t _usLine)
+{
+    s_tLine[_usLine].next = CACHE_NIL;
+    s_tLine[_usLine].prev = s_usLru;
+    if (s_usLru != CACHE_NIL)
+    {
+        s_tLine[s_usLru].next = _usLine;
+    }
+    else
+    {
+        s_usMru = _usLine;
+    }
+    s_usLru = _usLine;
+}
+
+/* 查找Flash块对应的缓存块 */
+static uint16_t CacheFind(uint32_t _uiBlock)
+{
+    uint16_t n = s_usHash[CACHE_HASH(_uiBlock)];
+
+    while (n != CACHE_NIL && s_tLine[n].block != _uiBlock)
+    {
+        n = s_tLine[n].hnext;
+    }
+
+    return n;
+}
+
+/* 设置缓存块对应的Flash块并加入哈希表 */
+static void CacheBind(uint16_t _usLine, uint32_t _uiBlock, uint8_t _ucState)
+{
+    uint16_t *head = &s_usHash[CACHE_HASH(_uiBlock)];
+
+    s_tLine[_usLine].block = _uiBlock;
+    s_tLine[_usLine].state = _ucState;
+    s_tLine[_usLine].hnext = *head;
+    *head = _usLine;
+}
+
+/* 从哈希表中删除，缓存块变为空闲 */
+static void CacheUnbind(uint16_t _usLine)
+{
+    uint16_t *p;
+
+    if (s_tLine[_usLine].state == CACHE_FREE)
+    {
+        return;
+    }
+
+    p = &s_usHash[CACHE_HASH(s_tLine[_usLine].block)];
+    while (*p != _usLine)
+    {
+        p = &s_tLine[*p].hnext;
+    }
+    *p = s_tLine[_usLine].hnext;
+    s_tLine[_usLine].state = CACHE_FREE;
+}
+
+/* 作废缓存块并放到LRU尾部，优先被重新使用 */
+static void CacheDrop(uint16_t _usLine)
+{
+    CacheUnbind(_usLine);
+    CacheUnlink(_usLine);
+    CachePushLru(_usLine);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: CachePoll
+*    功能说明: 检查预取是否完成，完成后更新缓存块状态
+*    形    参: _ucWait : 1 等待预取完成， 0 不等待
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CachePoll(uint8_t _ucWait)
+{
+    if (s_usPending == CACHE_NIL)
+    {
+        return;
+    }
+
+    if (_ucWait)
+    {
+        QSPI_WaitAsync();
+    }
+
+    if (s_cPendResult == 0)
+    {
+        s_tLine[s_usPending].state = CACHE_PREFETCHED;
+        s_usPending = CACHE_NIL;
+    }
+    else if (s_cPendResult < 0)
+    {
+        CacheDrop(s_usPending);
+        s_usPending = CACHE_NIL;
+    }
+}
+
+/* 选择被替换的缓存块，跳过正在预取的块 */
+static uint16_t CacheVictim(void)
+{
+    uint16_t n = s_usLru;
+
+    if (n == s_usPending)
+    {
+        n = s_tLine[n].prev;
+    }
+    CacheUnbind(n);
+
+    return n;
+}
+
+#if QSPI_CACHE_PREFETCH_EN == 1
+/* 预取完成回调，在中断中执行，只记录结果 */
+static void CachePrefetchDone(void *_pArg, int _iStatus)
+{
+    s_cPendResult = (_iStatus == 0) ? 0 : -1;
+}
+#endif
+
+/*
+*********************************************************************************************************
+*    函 数 名: CachePrefetch
+*    功能说明: 异步预取一个Flash块。已在缓存中、上次预取未完成或MDMA被其它模块占用时不预取。
+*    形    参: _uiBlock : Flash块号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CachePrefetch(uint32_t _uiBlock)
+{
+#if QSPI_CACHE_PREFETCH_EN == 1
+    uint16_t n;
+
+    if (_uiBlock >= CACHE_BLOCK_NUM || s_usPending != CACHE_NIL || QSPI_AsyncBusy() || CacheFind(_uiBlock) != CACHE_NIL)
+    {
+        return;
+    }
+
+    n = CacheVictim();
+    CacheBind(n, _uiBlock, CACHE_PENDING);
+    CacheUnlink(n);
+    CachePushMru(n);
+
+    s_usPending = n;
+    s_cPendResult = 1;
+    if (QSPI_ReadAsync(CACHE_LINE_ADDR(n), _uiBlock * QSPI_CACHE_BLOCK_SIZE, QSPI_CACHE_BLOCK_SIZE,
+                       CachePrefetchDone, NULL) != 0)
+    {
+        CacheDrop(n);
+        s_usPending = CACHE_NIL;
+        return;
+    }
+    s_tStat.prefetch++;
+#endif
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitQspiCache
+*    功能说明: 初始化QSPI Flash读缓存，所有缓存块为空闲
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitQspiCache(void)
+{
+    uint16_t i;
+
+    QSPI_WaitAsync();
+    s_usPending = CACHE_NIL;
+
+    for (i = 0; i < CACHE_HASH_SIZE; i++)
+    {
+        s_usHash[i] = CACHE_NIL;
+    }
+
+    s_usMru = CACHE_NIL;
+    s_usLru = CACHE_NIL;
+    for (i = 0; i < QSPI_CACHE_LINES; i++)
+    {
+        s_tLine[i].state = CACHE_FREE;
+        CachePushLru(i);
+    }
+
+    s_ucInit = 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_CacheRead
+*    功能说明: 经过缓存读取Flash，用法与 QSPI_ReadBuffer 相同
+*    形    参: _pBuf : 目标缓冲区
+*              _uiReadAddr : Flash地址
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_CacheRead(uint8_t *_pBuf, uint32_t _uiReadAddr, uint32_t _uiSize)
+{
+    uint32_t block, offset, len;
+    uint8_t prefetch;
+    uint16_t n;
+
+    if (s_ucInit == 0 || _uiSize >= QSPI_CACHE_BYPASS)
+    {
+        s_tStat.bypass++;
+        QSPI_ReadBuffer(_pBuf, _uiReadAddr, _uiSize);
+        return;
+    }
+
+    while (_uiSize)
+    {
+        block = _uiReadAddr / QSPI_CACHE_BLOCK_SIZE;
+        offset = _uiReadAddr & (QSPI_CACHE_BLOCK_SIZE - 1);
+        len = QSPI_CACHE_BLOCK_SIZE - offset;
+        if (len > _uiSize)
+        {
+            len = _uiSize;
+        }
+
+        CachePoll(0);
+        n = CacheFind(block);
+        if (n != CACHE_NIL && n == s_usPending)
+        {
+            /* 正在预取，等待完成。预取失败时缓存块被作废 */
+            CachePoll(1);
+            n = CacheFind(block);
+        }
+
+        prefetch = 0;
+        if (n != CACHE_NIL)
+        {
+            s_tStat.hits++;
+            if (s_tLine[n].state == CACHE_PREFETCHED)
+            {
+                /* 顺序读取到了预取的块，继续预取下一块 */
+                s_tStat.prefetch_hits++;
+                s_tLine[n].state = CACHE_VALID;
+                prefetch = 1;
+            }
+        }
+        else
+        {
+            s_tStat.misses++;
+            n = CacheVictim();
+            QSPI_ReadBuffer(CACHE_LINE_ADDR(n), block * QSPI_CACHE_BLOCK_SIZE, QSPI_CACHE_BLOCK_SIZE);
+            CacheBind(n, block, CACHE_VALID);
+            prefetch = 1;
+        }
+
+        /* 先移到LRU表头，预取时不会替换当前块，预取与下面的复制同时进行 */
+        CacheUnlink(n);
+        CachePushMru(n);
+        if (prefetch)
+        {
+            CachePrefetch(block + 1);
+        }
+        memcpy(_pBuf, CACHE_LINE_ADDR(n) + offset, len);
+
+        _pBuf += len;
+        _uiReadAddr += len;
+        _uiSize -= len;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_CacheInvalidate
+*    功能说明: 作废与Flash地址范围重叠的缓存块
+*    形    参: _uiAddr : Flash地址
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_CacheInvalidate(uint32_t _uiAddr, uint32_t _uiSize)
+{
+    uint32_t first, last, block;
+    uint16_t n;
+
+    if (s_ucInit == 0 || _uiSize == 0)
+    {
+        return;
+    }
+
+    first = _uiAddr / QSPI_CACHE_BLOCK_SIZE;
+    last = (_uiAddr + _uiSize - 1) / QSPI_CACHE_BLOCK_SIZE;
+
+    /* 预取的块在范围内时先等待传输结束，避免旧数据在作废后才写入 */
+    if (s_usPending != CACHE_NIL && s_tLine[s_usPending].block >= first && s_tLine[s_usPending].block <= last)
+    {
+        CachePoll(1);
+    }
+
+    if (last - first >= QSPI_CACHE_LINES)
+    {
+        /* 范围大于缓存容量(擦除整片)，遍历缓存块 */
+        for (n = 0; n < QSPI_CACHE_LINES; n++)
+        {
+            if (s_tLine[n].state != CACHE_FREE && n != s_usPending &&
+                s_tLine[n].block >= first && s_tLine[n].block <= last)
+            {
+                CacheDrop(n);
+                s_tStat.invalidates++;
+            }
+        }
+        return;
+    }
+
+    for (block = first; block <= last; block++)
+    {
+        n = CacheFind(block);
+        if (n != CACHE_NIL && n != s_usPending)
+        {
+            CacheDrop(n);
+            s_tStat.invalidates++;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_ModifyCallback
+*    功能说明: Flash内容即将被写入或擦除，由 bsp_qspi.c 调用，作废对应的缓存块
+*    形    参: _uiAddr : Flash地址
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_ModifyCallback(uint32_t _uiAddr, uint32_t _uiSize)
+{
+    QSPI_CacheInvalidate(_uiAddr, _uiSize);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_CacheClear
+*    功能说明: 作废全部缓存块，SDRAM中的缓存数据被其它程序改写后调用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_CacheClear(void)
+{
+    if (s_ucInit == 0)
+    {
+        return;
+    }
+
+    bsp_InitQspiCache();
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_CacheGetStat
+*    功能说明: 读取统计信息
+*    形    参: _pStat : 统计信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_CacheGetStat(QSPI_CACHE_STAT_T *_pStat)
+{
+    CachePoll(0);
+
+    *_pStat = s_tStat;
+    _pStat->lines = QSPI_CACHE_LINES;
+    _pStat->valid = 0;
+    for (uint16_t i = 0; i < QSPI_CACHE_LINES; i++)
+    {
+        if (s_tLine[i].state != CACHE_FREE)
+        {
+            _pStat->valid++;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: QSPI_CacheResetStat
+*    功能说明: 清零统计计数
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void QSPI_CacheResetStat(void)
+{
+    memset(&s_tStat, 0, sizeof(s_tStat));
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 在指定范围内随机读取小块数据，比较直接读取和经过缓存读取的耗时 */
+static void qcache_bench(uint32_t _uiAddr, uint32_t _uiRange)
+{
+#define QCACHE_BENCH_SIZE 64
+#define QCACHE_BENCH_NUM 4096
+    uint8_t buf[QCACHE_BENCH_SIZE];
+    uint32_t seed, i;
+    int64_t direct, cached;
+
+    _uiRange &= ~(QCACHE_BENCH_SIZE - 1);
+    if (_uiRange < QCACHE_BENCH_SIZE || _uiAddr + _uiRange > QSPI_FLASH_SIZES)
+    {
+        printf("range error\r\n");
+        return;
+    }
+
+    seed = 1;
+    direct = get_system_ticks();
+    for (i = 0; i < QCACHE_BENCH_NUM; i++)
+    {
+        seed = seed * 1103515245UL + 12345;
+        QSPI_ReadBuffer(buf, _uiAddr + ((seed >> 8) % (_uiRange / QCACHE_BENCH_SIZE)) * QCACHE_BENCH_SIZE, QCACHE_BENCH_SIZE);
+    }
+    direct = get_system_ticks() - direct;
+
+    QSPI_CacheClear();
+    QSPI_CacheResetStat();
+    seed = 1;
+    cached = get_system_ticks();
+    for (i = 0; i < QCACHE_BENCH_NUM; i++)
+    {
+        seed = seed * 1103515245UL + 12345;
+        QSPI_CacheRead(buf, _uiAddr + ((seed >> 8) % (_uiRange / QCACHE_BENCH_SIZE)) * QCACHE_BENCH_SIZE, QCACHE_BENCH_SIZE);
+    }
+    cached = get_system_ticks() - cached;
+
+    printf("%d x %d bytes in %d KB\r\n", QCACHE_BENCH_NUM, QCACHE_BENCH_SIZE, _uiRange / 1024);
+    printf("direct : %6d ns/read\r\n", (uint32_t)(direct * 1000 / (SystemCoreClock / 1000000) / QCACHE_BENCH_NUM));
+    printf("cached : %6d ns/read\r\n", (uint32_t)(cached * 1000 / (SystemCoreClock / 1000000) / QCACHE_BENCH_NUM));
+}
+
+static int cmd_qcache(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "qcache stat",
+        "qcache clear",
+        "qcache read add size",
+        "qcache bench [add] [range]"};
+
+    if (argc < 2)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+    else
+    {
+        if (!strcmp(argv[1], "stat"))
+        {
+            QSPI_CACHE_STAT_T stat;
+            uint32_t total;
+
+            QSPI_CacheGetStat(&stat);
+            total = stat.hits + stat.misses;
+            printf("lines = %d x %d bytes valid = %d\r\n", stat.lines, QSPI_CACHE_BLOCK_SIZE, stat.valid);
+            printf("hits = %d misses = %d hit rate = %d%%\r\n", stat.hits, stat.misses,
+                   total ? (uint32_t)((uint64_t)stat.hits * 100 / total) : 0);
+            printf("prefetch = %d used = %d bypass = %d invalidates = %d\r\n",
+                   stat.prefetch, stat.prefetch_hits, stat.bypass, stat.invalidates);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "clear"))
+        {
+            QSPI_CacheClear();
+            QSPI_CacheResetStat();
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "read"))
+        {
+            uint8_t buf[64];
+            uint32_t add, size;
+            int64_t ticks;
+
+            if (argc < 4)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[2]);
+                return -1;
+            }
+            add = strtoul(argv[2], NULL, 0);
+            size = strtoul(argv[3], NULL, 0);
+            if (size == 0 || size > sizeof(buf) || add + size > QSPI_FLASH_SIZES)
+            {
+                printf("size 1 - %d\r\n", sizeof(buf));
+                return -1;
+            }
+
+            ticks = get_system_ticks();
+            QSPI_CacheRead(buf, add, size);
+            ticks = get_system_ticks() - ticks;
+
+            dump_hex(buf, size, 16);
+            printf("%d ns\r\n", (uint32_t)(ticks * 1000 / (SystemCoreClock / 1000000)));
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "bench"))
+        {
+            uint32_t add = 0;
+            uint32_t range = 256 * 1024;
+
+            if (argc > 2)
+            {
+                add = strtoul(argv[2], NULL, 0);
+            }
+            if (argc > 3)
+            {
+                range = strtoul(argv[3], NULL, 0);
+            }
+            qcache_bench(add, range);
+
+            return 0;
+        }
+        else
+        {
+            printf("Error Command\r\nUsage:\r\n");
+            for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+            {
+                printf("%s\r\n", help_info[i]);
+            }
+            printf("\r\n");
+        }
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), qcache, cmd_qcache, qcache[stat clear read bench]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,1207 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash 块设备(FTL)模块
+*    文件名称 : bsp_qspi_ftl.c
+*    版    本 : V1.0
+*    说    明 : 在QSPI Flash上实现掉电安全的块设备，供FatFs、LittleFS等文件系统使用。
+*               1. 逻辑块按4KB映射到物理扇区，写入时总是写到新的物理扇区，不覆盖已提交的数据
+*               2. 数据写完并校验后追加一条带CRC的映射日志，日志写入即为提交点
+*               3. 日志写满后把整张映射表写入检查点，两份检查点交替写入，上电取有效的最新一份再重放日志
+*               4. 动态磨损均衡: 总是分配擦除次数最少的空闲块;
+*                  静态磨损均衡: 冷数据所在块与最大擦除次数相差过大时，把冷数据搬到磨损较多的块
+*               5. 擦除或编程校验失败的块记为坏块，不再使用
+*               只使用 bsp_qspi.h 的读、页编程、扇区擦除接口，不包含 bsp.h 和HAL，
+*               在PC上用 Tools/qspi_sim 的文件模拟Flash做掉电测试。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <string.h>
+#include "bsp_user_lib.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_ftl.h"
+
+/*
+    区域划分:
+    | 检查点A 5扇区 | 检查点B 5扇区 | 日志 8扇区 | 数据区 FTL_PHY_NUM 个物理块 |
+
+    检查点: | 头 32字节 | 映射表 u16[FTL_BLOCK_NUM] | 擦除次数 u32[FTL_PHY_NUM] | 坏块位图 |
+    头中的 crc 校验头的后半部分和全部数据，最后写入头。
+
+    日志条目 16字节: | seq(4) | erase_cnt(4) | block(2) | phy(2) | type(2) | crc(2) |
+    seq 等于当前检查点序号的条目才有效，写检查点后旧日志自动失效，再擦除日志区。
+    seq 在条目其余内容写完后最后写入，作为提交标记，写入中掉电的条目 seq 不完整。
+*/
+#define FTL_CKPT_MAGIC 0x304C5446UL /* "FTL0" */
+#define FTL_UNMAPPED 0xFFFF
+
+#define FTL_JOURNAL_MAP 0x4D50  /* 逻辑块映射到新物理块 */
+#define FTL_JOURNAL_TRIM 0x5254 /* 逻辑块解除映射 */
+#define FTL_JOURNAL_BAD 0x4442  /* 物理块记为坏块 */
+
+#define FTL_JOURNAL_NUM (FTL_JOURNAL_SECTORS * QSPI_SECTOR_SIZE / sizeof(FTL_JOURNAL_T))
+
+#define FTL_WL_PERIOD 64     /* 每写入多少块检查一次静态磨损均衡 */
+#define FTL_WL_THRESHOLD 256 /* 擦除次数差超过该值时搬移冷数据 */
+
+#define FTL_CKPT_ADDR(n) (FTL_FLASH_ADDR + (uint32_t)(n)*FTL_CKPT_SECTORS * QSPI_SECTOR_SIZE)
+#define FTL_JOURNAL_ADDR (FTL_FLASH_ADDR + 2 * FTL_CKPT_SECTORS * QSPI_SECTOR_SIZE)
+#define FTL_PHY_ADDR(n) (FTL_FLASH_ADDR + (uint32_t)(FTL_META_SECTORS + (n)) * QSPI_SECTOR_SIZE)
+
+#define FTL_BAD_BYTES ((FTL_PHY_NUM + 7) / 8)
+#define FTL_CKPT_BODY (FTL_BLOCK_NUM * 2 + FTL_PHY_NUM * 4 + FTL_BAD_BYTES)
+
+#if (32 + FTL_CKPT_BODY) > (FTL_CKPT_SECTORS * QSPI_SECTOR_SIZE)
+#error "FTL_CKPT_SECTORS too small"
+#endif
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t crc;
+    uint16_t block_num;
+    uint16_t phy_num;
+    uint32_t writes;
+    uint32_t reserve[3];
+} FTL_CKPT_HEAD_T;
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t erase_cnt;
+    uint16_t block;
+    uint16_t phy;
+    uint16_t type;
+    uint16_t crc;
+} FTL_JOURNAL_T;
+
+static uint16_t s_usMap[FTL_BLOCK_NUM];       /* 逻辑块 -> 物理块 */
+static uint32_t s_uiEraseCnt[FTL_PHY_NUM];    /* 物理块擦除次数 */
+static uint8_t s_ucBad[FTL_BAD_BYTES];        /* 坏块位图 */
+static uint8_t s_ucUsed[FTL_BAD_BYTES];       /* 已映射位图，由映射表生成 */
+static uint8_t s_ucBuf[FTL_BLOCK_SIZE] __attribute__((aligned(32)));   /* 搬移数据用 */
+static uint8_t s_ucCache[FTL_BLOCK_SIZE] __attribute__((aligned(32))); /* 扇区写缓存 */
+static uint16_t s_usCacheBlock = FTL_UNMAPPED;
+static uint8_t s_ucCacheDirty = 0;
+static uint32_t s_uiSeq = 0;        /* 当前检查点序号 */
+static uint32_t s_uiJournalPos = 0; /* 下一条日志位置 */
+static uint32_t s_uiWrites = 0;
+static uint16_t s_usWlCnt = 0;
+static uint16_t s_usWlMoves = 0;
+static uint8_t s_ucInit = 0;
+
+#define FTL_BIT_GET(map, n) ((map)[(n) >> 3] & (1 << ((n)&7)))
+#define FTL_BIT_SET(map, n) ((map)[(n) >> 3] |= (1 << ((n)&7)))
+#define FTL_BIT_CLR(map, n) ((map)[(n) >> 3] &= ~(1 << ((n)&7)))
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Program
+*    功能说明: 写入任意长度数据，按页边界拆分。目标区域必须已擦除。
+*    形    参: _uiAddr : Flash地址
+*              _pBuf : 数据
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void FTL_Program(uint32_t _uiAddr, const uint8_t *_pBuf, uint32_t _uiSize)
+{
+    uint32_t len;
+
+    while (_uiSize)
+    {
+        len = QSPI_PAGE_SIZE - (_uiAddr & (QSPI_PAGE_SIZE - 1));
+        if (len > _uiSize)
+        {
+            len = _uiSize;
+        }
+        QSPI_WriteBuffer((uint8_t *)_pBuf, _uiAddr, len);
+        _uiAddr += len;
+        _pBuf += len;
+        _uiSize -= len;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Verify
+*    功能说明: 读回Flash与数据比较
+*    形    参: _uiAddr : Flash地址
+*              _pBuf : 期望的数据，NULL表示比较是否全为0xFF
+*              _uiSize : 字节数
+*    返 回 值: 0:一致， -1：不一致
+*********************************************************************************************************
+*/
+static int FTL_Verify(uint32_t _uiAddr, const uint8_t *_pBuf, uint32_t _uiSize)
+{
+    uint32_t buf[QSPI_PAGE_SIZE / 4];
+    uint32_t i, len;
+
+    while (_uiSize)
+    {
+        len = (_uiSize > sizeof(buf)) ? sizeof(buf) : _uiSize;
+        QSPI_ReadBuffer((uint8_t *)buf, _uiAddr, len);
+        if (_pBuf != NULL)
+        {
+            if (memcmp(buf, _pBuf, len) != 0)
+            {
+                return -1;
+            }
+            _pBuf += len;
+        }
+        else
+        {
+            for (i = 0; i < len / 4; i++)
+            {
+                if (buf[i] != 0xFFFFFFFF)
+                {
+                    return -1;
+                }
+            }
+        }
+        _uiAddr += len;
+        _uiSize -= len;
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Apply
+*    功能说明: 把一条日志应用到RAM中的映射表
+*    形    参: _pEntry : 日志条目
+*    返 回 值: 0:成功， -1：条目内容与当前映射表矛盾
+*********************************************************************************************************
+*/
+static int FTL_Apply(const FTL_JOURNAL_T *_pEntry)
+{
+    uint16_t old;
+
+    if (_pEntry->phy >= FTL_PHY_NUM && _pEntry->type != FTL_JOURNAL_TRIM)
+    {
+        return -1;
+    }
+
+    switch (_pEntry->type)
+    {
+    case FTL_JOURNAL_MAP:
+        if (_pEntry->block >= FTL_BLOCK_NUM || FTL_BIT_GET(s_ucUsed, _pEntry->phy))
+        {
+            return -1;
+        }
+        old = s_usMap[_pEntry->block];
+        if (old != FTL_UNMAPPED)
+        {
+            FTL_BIT_CLR(s_ucUsed, old);
+        }
+        s_usMap[_pEntry->block] = _pEntry->phy;
+        FTL_BIT_SET(s_ucUsed, _pEntry->phy);
+        s_uiEraseCnt[_pEntry->phy] = _pEntry->erase_cnt;
+        s_uiWrites++;
+        break;
+
+    case FTL_JOURNAL_TRIM:
+        if (_pEntry->block >= FTL_BLOCK_NUM)
+        {
+            return -1;
+        }
+        old = s_usMap[_pEntry->block];
+        if (old != FTL_UNMAPPED)
+        {
+            FTL_BIT_CLR(s_ucUsed, old);
+        }
+        s_usMap[_pEntry->block] = FTL_UNMAPPED;
+        break;
+
+    case FTL_JOURNAL_BAD:
+        if (FTL_BIT_GET(s_ucUsed, _pEntry->phy))
+        {
+            return -1;
+        }
+        FTL_BIT_SET(s_ucBad, _pEntry->phy);
+        s_uiEraseCnt[_pEntry->phy] = _pEntry->erase_cnt;
+        break;
+
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_CkptCrc
+*    功能说明: 计算检查点CRC，校验头的后半部分和RAM中的映射表、擦除次数、坏块位图
+*    形    参: _pHead : 检查点头
+*    返 回 值: CRC32
+*********************************************************************************************************
+*/
+static uint32_t FTL_CkptCrc(const FTL_CKPT_HEAD_T *_pHead)
+{
+    uint32_t crc;
+
+    crc = CRC32_Update(0, (const uint8_t *)&_pHead->block_num, sizeof(FTL_CKPT_HEAD_T) - 12);
+    crc = CRC32_Update(crc, (const uint8_t *)s_usMap, sizeof(s_usMap));
+    crc = CRC32_Update(crc, (const uint8_t *)s_uiEraseCnt, sizeof(s_uiEraseCnt));
+    crc = CRC32_Update(crc, s_ucBad, sizeof(s_ucBad));
+
+    return crc;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_EraseJournal
+*    功能说明: 擦除日志区
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void FTL_EraseJournal(void)
+{
+    for (uint32_t i = 0; i < FTL_JOURNAL_SECTORS; i++)
+    {
+        QSPI_EraseSector(FTL_JOURNAL_ADDR + i * QSPI_SECTOR_SIZE);
+    }
+    QSPI_WaitBusy();
+    s_uiJournalPos = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Checkpoint
+*    功能说明: 把RAM中的映射表写入较旧的一份检查点，成功后擦除日志区。
+*              头最后写入，写入过程中掉电时上电仍使用另一份检查点和原有日志。
+*    形    参: 无
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+static int FTL_Checkpoint(void)
+{
+    FTL_CKPT_HEAD_T head;
+    uint32_t addr, i;
+
+    memset(&head, 0xFF, sizeof(head));
+    head.magic = FTL_CKPT_MAGIC;
+    head.seq = s_uiSeq + 1;
+    head.block_num = FTL_BLOCK_NUM;
+    head.phy_num = FTL_PHY_NUM;
+    head.writes = s_uiWrites;
+    head.crc = FTL_CkptCrc(&head);
+
+    addr = FTL_CKPT_ADDR(head.seq & 1);
+    for (i = 0; i < FTL_CKPT_SECTORS; i++)
+    {
+        QSPI_EraseSector(addr + i * QSPI_SECTOR_SIZE);
+    }
+
+    FTL_Program(addr + sizeof(head), (uint8_t *)s_usMap, sizeof(s_usMap));
+    FTL_Program(addr + sizeof(head) + sizeof(s_usMap), (uint8_t *)s_uiEraseCnt, sizeof(s_uiEraseCnt));
+    FTL_Program(addr + sizeof(head) + sizeof(s_usMap) + sizeof(s_uiEraseCnt), s_ucBad, sizeof(s_ucBad));
+    FTL_Program(addr, (uint8_t *)&head, sizeof(head));
+
+    if (FTL_Verify(addr, (uint8_t *)&head, sizeof(head)) != 0 ||
+        FTL_Verify(addr + sizeof(head), (uint8_t *)s_usMap, sizeof(s_usMap)) != 0 ||
+        FTL_Verify(addr + sizeof(head) + sizeof(s_usMap), (uint8_t *)s_uiEraseCnt, sizeof(s_uiEraseCnt)) != 0 ||
+        FTL_Verify(addr + sizeof(head) + sizeof(s_usMap) + sizeof(s_uiEraseCnt), s_ucBad, sizeof(s_ucBad)) != 0)
+    {
+        return -1;
+    }
+
+    s_uiSeq = head.seq;
+    FTL_EraseJournal();
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Journal
+*    功能说明: 追加一条日志并应用到映射表。日志区已满时先写检查点。
+*              先写seq之后的内容，再写seq，读回校验后才应用，返回0时日志已在Flash中。
+*    形    参: _usType : 日志类型
+*              _usBlock : 逻辑块号
+*              _usPhy : 物理块号
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+static int FTL_Journal(uint16_t _usType, uint16_t _usBlock, uint16_t _usPhy)
+{
+    FTL_JOURNAL_T entry;
+    uint32_t addr;
+
+    if (s_uiJournalPos >= FTL_JOURNAL_NUM)
+    {
+        if (FTL_Checkpoint() != 0)
+        {
+            return -1;
+        }
+    }
+
+    entry.seq = s_uiSeq;
+    entry.erase_cnt = (_usPhy < FTL_PHY_NUM) ? s_uiEraseCnt[_usPhy] : 0xFFFFFFFF;
+    entry.block = _usBlock;
+    entry.phy = _usPhy;
+    entry.type = _usType;
+    entry.crc = CRC16_Modbus((uint8_t *)&entry, sizeof(entry) - 2);
+
+    addr = FTL_JOURNAL_ADDR + s_uiJournalPos * sizeof(entry);
+    FTL_Program(addr + 4, (uint8_t *)&entry.erase_cnt, sizeof(entry) - 4);
+    QSPI_WaitBusy();
+    FTL_Program(addr, (uint8_t *)&entry.seq, 4);
+    QSPI_WaitBusy();
+    s_uiJournalPos++;
+
+    if (FTL_Verify(addr, (uint8_t *)&entry, sizeof(entry)) != 0)
+    {
+        /* 上电重放到这里停止，后面不能再追加，下次先写检查点 */
+        s_uiJournalPos = FTL_JOURNAL_NUM;
+        return -1;
+    }
+
+    return FTL_Apply(&entry);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Alloc
+*    功能说明: 分配一个空闲物理块并擦除。擦除校验失败的块记为坏块后重新分配。
+*    形    参: _ucMost : 0 选择擦除次数最少的块， 1 选择擦除次数最多的块(静态磨损均衡)
+*    返 回 值: 物理块号，FTL_UNMAPPED 表示没有可用的块
+*********************************************************************************************************
+*/
+static uint16_t FTL_Alloc(uint8_t _ucMost)
+{
+    uint16_t best, i;
+
+    for (;;)
+    {
+        best = FTL_UNMAPPED;
+        for (i = 0; i < FTL_PHY_NUM; i++)
+        {
+            if (FTL_BIT_GET(s_ucUsed, i) || FTL_BIT_GET(s_ucBad, i))
+            {
+                continue;
+            }
+            if (best == FTL_UNMAPPED ||
+                (_ucMost == 0 && s_uiEraseCnt[i] < s_uiEraseCnt[best]) ||
+                (_ucMost != 0 && s_uiEraseCnt[i] > s_uiEraseCnt[best]))
+            {
+                best = i;
+            }
+        }
+
+        if (best == FTL_UNMAPPED)
+        {
+            return FTL_UNMAPPED;
+        }
+
+        QSPI_EraseSector(FTL_PHY_ADDR(best));
+        s_uiEraseCnt[best]++;
+        if (FTL_Verify(FTL_PHY_ADDR(best), NULL, FTL_BLOCK_SIZE) == 0)
+        {
+            return best;
+        }
+
+        if (FTL_Journal(FTL_JOURNAL_BAD, FTL_UNMAPPED, best) != 0)
+        {
+            return FTL_UNMAPPED;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Commit
+*    功能说明: 把一个逻辑块写入新的物理块，校验后写日志提交。旧的物理块变为空闲。
+*    形    参: _usBlock : 逻辑块号
+*              _pBuf : 4KB数据
+*              _ucMost : 传给 FTL_Alloc
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+static int FTL_Commit(uint16_t _usBlock, const uint8_t *_pBuf, uint8_t _ucMost)
+{
+    uint16_t phy;
+
+    for (;;)
+    {
+        phy = FTL_Alloc(_ucMost);
+        if (phy == FTL_UNMAPPED)
+        {
+            return -1;
+        }
+
+        FTL_Program(FTL_PHY_ADDR(phy), _pBuf, FTL_BLOCK_SIZE);
+        if (FTL_Verify(FTL_PHY_ADDR(phy), _pBuf, FTL_BLOCK_SIZE) == 0)
+        {
+            return FTL_Journal(FTL_JOURNAL_MAP, _usBlock, phy);
+        }
+
+        if (FTL_Journal(FTL_JOURNAL_BAD, FTL_UNMAPPED, phy) != 0)
+        {
+            return -1;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_WearLevel
+*    功能说明: 静态磨损均衡。擦除次数最少的已用块与空闲块最大擦除次数相差超过阈值时，
+*              把该块的冷数据搬到擦除次数最多的空闲块，让磨损少的块回到空闲池。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void FTL_WearLevel(void)
+{
+    uint16_t cold = FTL_UNMAPPED;
+    uint32_t hot = 0;
+    uint16_t i, block;
+
+    for (i = 0; i < FTL_PHY_NUM; i++)
+    {
+        if (FTL_BIT_GET(s_ucBad, i))
+        {
+            continue;
+        }
+        if (FTL_BIT_GET(s_ucUsed, i))
+        {
+            if (cold == FTL_UNMAPPED || s_uiEraseCnt[i] < s_uiEraseCnt[cold])
+            {
+                cold = i;
+            }
+        }
+        else if (s_uiEraseCnt[i] > hot)
+        {
+            hot = s_uiEraseCnt[i];
+        }
+    }
+
+    if (cold == FTL_UNMAPPED || hot < s_uiEraseCnt[cold] + FTL_WL_THRESHOLD)
+    {
+        return;
+    }
+
+    for (block = 0; block < FTL_BLOCK_NUM; block++)
+    {
+        if (s_usMap[block] == cold)
+        {
+            QSPI_ReadBuffer(s_ucBuf, FTL_PHY_ADDR(cold), FTL_BLOCK_SIZE);
+            if (FTL_Commit(block, s_ucBuf, 1) == 0)
+            {
+                s_usWlMoves++;
+            }
+            break;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Load
+*    功能说明: 读取一份检查点到RAM并校验
+*    形    参: _ucSlot : 0 或 1
+*              _pHead : 已读取的检查点头
+*    返 回 值: 0:成功， -1：检查点无效
+*********************************************************************************************************
+*/
+static int FTL_Load(uint8_t _ucSlot, const FTL_CKPT_HEAD_T *_pHead)
+{
+    uint32_t addr = FTL_CKPT_ADDR(_ucSlot);
+    uint16_t i;
+
+    QSPI_ReadBuffer((uint8_t *)s_usMap, addr + sizeof(FTL_CKPT_HEAD_T), sizeof(s_usMap));
+    QSPI_ReadBuffer((uint8_t *)s_uiEraseCnt, addr + sizeof(FTL_CKPT_HEAD_T) + sizeof(s_usMap), sizeof(s_uiEraseCnt));
+    QSPI_ReadBuffer(s_ucBad, addr + sizeof(FTL_CKPT_HEAD_T) + sizeof(s_usMap) + sizeof(s_uiEraseCnt), sizeof(s_ucBad));
+
+    if (FTL_CkptCrc(_pHead) != _pHead->crc)
+    {
+        return -1;
+    }
+
+    /* 由映射表生成已用位图，同一物理块被映射两次说明数据不可信 */
+    memset(s_ucUsed, 0, sizeof(s_ucUsed));
+    for (i = 0; i < FTL_BLOCK_NUM; i++)
+    {
+        if (s_usMap[i] == FTL_UNMAPPED)
+        {
+            continue;
+        }
+        if (s_usMap[i] >= FTL_PHY_NUM || FTL_BIT_GET(s_ucUsed, s_usMap[i]))
+        {
+            return -1;
+        }
+        FTL_BIT_SET(s_ucUsed, s_usMap[i]);
+    }
+
+    s_uiSeq = _pHead->seq;
+    s_uiWrites = _pHead->writes;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitFTL
+*    功能说明: 加载最新的有效检查点并重放日志。日志中有残缺或过期的条目时(上次掉电)，
+*              立即写一次检查点，保证之后的日志从干净的日志区开始追加。没有有效检查点时格式化。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitFTL(void)
+{
+    FTL_CKPT_HEAD_T head[2];
+    FTL_JOURNAL_T entry[QSPI_PAGE_SIZE / sizeof(FTL_JOURNAL_T)];
+    uint8_t order[2] = {0, 1};
+    uint8_t dirty = 0;
+    uint32_t i, j, k;
+    uint8_t *p;
+
+    s_ucInit = 0;
+    s_usCacheBlock = FTL_UNMAPPED;
+    s_ucCacheDirty = 0;
+
+    for (i = 0; i < 2; i++)
+    {
+        QSPI_ReadBuffer((uint8_t *)&head[i], FTL_CKPT_ADDR(i), sizeof(head[i]));
+        if (head[i].magic != FTL_CKPT_MAGIC || head[i].block_num != FTL_BLOCK_NUM || head[i].phy_num != FTL_PHY_NUM)
+        {
+            head[i].seq = 0;
+        }
+    }
+    if (head[1].seq > head[0].seq)
+    {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        if (head[order[i]].seq != 0 && FTL_Load(order[i], &head[order[i]]) == 0)
+        {
+            break;
+        }
+    }
+    if (i == 2)
+    {
+        FTL_Format();
+        return;
+    }
+
+    /* 重放日志，遇到第一条空白、残缺或过期的条目时停止 */
+    s_uiJournalPos = FTL_JOURNAL_NUM;
+    for (i = 0; i < FTL_JOURNAL_NUM && s_uiJournalPos == FTL_JOURNAL_NUM; i += sizeof(entry) / sizeof(entry[0]))
+    {
+        QSPI_ReadBuffer((uint8_t *)entry, FTL_JOURNAL_ADDR + i * sizeof(FTL_JOURNAL_T), sizeof(entry));
+        for (j = 0; j < sizeof(entry) / sizeof(entry[0]); j++)
+        {
+            p = (uint8_t *)&entry[j];
+            for (k = 0; k < sizeof(FTL_JOURNAL_T) && p[k] == 0xFF; k++)
+                ;
+            if (k == sizeof(FTL_JOURNAL_T))
+            {
+                s_uiJournalPos = i + j;
+                break;
+            }
+            if (entry[j].seq != s_uiSeq || entry[j].crc != CRC16_Modbus(p, sizeof(FTL_JOURNAL_T) - 2) ||
+                FTL_Apply(&entry[j]) != 0)
+            {
+                s_uiJournalPos = i + j;
+                dirty = 1;
+                break;
+            }
+        }
+    }
+
+    if (dirty && FTL_Checkpoint() != 0)
+    {
+        return;
+    }
+
+    s_ucInit = 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Format
+*    功能说明: 清空所有映射。已知的擦除次数和坏块保留，数据区不擦除，分配时再擦除。
+*    形    参: 无
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_Format(void)
+{
+    FTL_CKPT_HEAD_T head;
+    uint32_t i;
+
+    if (s_ucInit == 0)
+    {
+        /* 没有有效的检查点，擦除次数和坏块未知 */
+        memset(s_uiEraseCnt, 0, sizeof(s_uiEraseCnt));
+        memset(s_ucBad, 0, sizeof(s_ucBad));
+        s_uiSeq = 0;
+        s_uiWrites = 0;
+        for (i = 0; i < 2; i++)
+        {
+            QSPI_ReadBuffer((uint8_t *)&head, FTL_CKPT_ADDR(i), sizeof(head));
+            if (head.magic == FTL_CKPT_MAGIC && head.seq > s_uiSeq)
+            {
+                s_uiSeq = head.seq;
+            }
+        }
+    }
+
+    s_ucInit = 0;
+    s_usCacheBlock = FTL_UNMAPPED;
+    s_ucCacheDirty = 0;
+    memset(s_usMap, 0xFF, sizeof(s_usMap));
+    memset(s_ucUsed, 0, sizeof(s_ucUsed));
+
+    if (FTL_Checkpoint() != 0)
+    {
+        return -1;
+    }
+
+    s_ucInit = 1;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_ReadBlock
+*    功能说明: 读取一个逻辑块，未写入过的块读出为0xFF
+*    形    参: _uiBlock : 逻辑块号
+*              _pBuf : 4KB缓冲区
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_ReadBlock(uint32_t _uiBlock, uint8_t *_pBuf)
+{
+    if (s_ucInit == 0 || _uiBlock >= FTL_BLOCK_NUM)
+    {
+        return -1;
+    }
+
+    if (_uiBlock == s_usCacheBlock)
+    {
+        memcpy(_pBuf, s_ucCache, FTL_BLOCK_SIZE);
+    }
+    else if (s_usMap[_uiBlock] == FTL_UNMAPPED)
+    {
+        memset(_pBuf, 0xFF, FTL_BLOCK_SIZE);
+    }
+    else
+    {
+        QSPI_ReadBuffer(_pBuf, FTL_PHY_ADDR(s_usMap[_uiBlock]), FTL_BLOCK_SIZE);
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_WriteBlock
+*    功能说明: 写入一个逻辑块，返回时数据已提交
+*    形    参: _uiBlock : 逻辑块号
+*              _pBuf : 4KB数据
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_WriteBlock(uint32_t _uiBlock, const uint8_t *_pBuf)
+{
+    if (s_ucInit == 0 || _uiBlock >= FTL_BLOCK_NUM)
+    {
+        return -1;
+    }
+
+    /* 整块覆盖，缓存中的旧数据作废 */
+    if (_uiBlock == s_usCacheBlock)
+    {
+        s_usCacheBlock = FTL_UNMAPPED;
+        s_ucCacheDirty = 0;
+    }
+
+    if (FTL_Commit(_uiBlock, _pBuf, 0) != 0)
+    {
+        return -1;
+    }
+
+    if (++s_usWlCnt >= FTL_WL_PERIOD)
+    {
+        s_usWlCnt = 0;
+        FTL_WearLevel();
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Trim
+*    功能说明: 解除逻辑块映射，之后读出为0xFF，物理块回到空闲池
+*    形    参: _uiBlock : 逻辑块号
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_Trim(uint32_t _uiBlock)
+{
+    if (s_ucInit == 0 || _uiBlock >= FTL_BLOCK_NUM)
+    {
+        return -1;
+    }
+
+    if (_uiBlock == s_usCacheBlock)
+    {
+        s_usCacheBlock = FTL_UNMAPPED;
+        s_ucCacheDirty = 0;
+    }
+
+    if (s_usMap[_uiBlock] == FTL_UNMAPPED)
+    {
+        return 0;
+    }
+
+    return FTL_Journal(FTL_JOURNAL_TRIM, _uiBlock, FTL_UNMAPPED);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Sync
+*    功能说明: 把写缓存中的数据写入Flash
+*    形    参: 无
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_Sync(void)
+{
+    uint16_t block = s_usCacheBlock;
+
+    if (s_ucCacheDirty == 0)
+    {
+        return 0;
+    }
+
+    /* FTL_WriteBlock 会作废缓存，写入后重新标记为有效 */
+    if (FTL_WriteBlock(block, s_ucCache) != 0)
+    {
+        return -1;
+    }
+    s_usCacheBlock = block;
+    s_ucCacheDirty = 0;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_CacheLoad
+*    功能说明: 把逻辑块读入写缓存，缓存中其它块的数据先写入Flash
+*    形    参: _usBlock : 逻辑块号
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+static int FTL_CacheLoad(uint16_t _usBlock)
+{
+    if (_usBlock == s_usCacheBlock)
+    {
+        return 0;
+    }
+
+    if (FTL_Sync() != 0)
+    {
+        return -1;
+    }
+
+    s_usCacheBlock = FTL_UNMAPPED;
+    if (FTL_ReadBlock(_usBlock, s_ucCache) != 0)
+    {
+        return -1;
+    }
+    s_usCacheBlock = _usBlock;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Read
+*    功能说明: 按512字节扇区读取
+*    形    参: _pBuf : 缓冲区
+*              _uiSector : 起始扇区号
+*              _uiCount : 扇区个数
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_Read(uint8_t *_pBuf, uint32_t _uiSector, uint32_t _uiCount)
+{
+    uint32_t block, offset, num;
+
+    if (s_ucInit == 0 || _uiSector + _uiCount > FTL_SECTOR_NUM)
+    {
+        return -1;
+    }
+
+    while (_uiCount)
+    {
+        block = _uiSector / FTL_SECTOR_PER_BLOCK;
+        offset = (_uiSector % FTL_SECTOR_PER_BLOCK) * FTL_SECTOR_SIZE;
+        num = FTL_SECTOR_PER_BLOCK - _uiSector % FTL_SECTOR_PER_BLOCK;
+        if (num > _uiCount)
+        {
+            num = _uiCount;
+        }
+
+        if (block == s_usCacheBlock)
+        {
+            memcpy(_pBuf, &s_ucCache[offset], num * FTL_SECTOR_SIZE);
+        }
+        else if (s_usMap[block] == FTL_UNMAPPED)
+        {
+            memset(_pBuf, 0xFF, num * FTL_SECTOR_SIZE);
+        }
+        else
+        {
+            QSPI_ReadBuffer(_pBuf, FTL_PHY_ADDR(s_usMap[block]) + offset, num * FTL_SECTOR_SIZE);
+        }
+
+        _pBuf += num * FTL_SECTOR_SIZE;
+        _uiSector += num;
+        _uiCount -= num;
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_Write
+*    功能说明: 按512字节扇区写入。整块写入直接提交，不足一块的写入先合并到写缓存。
+*    形    参: _pBuf : 数据
+*              _uiSector : 起始扇区号
+*              _uiCount : 扇区个数
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int FTL_Write(const uint8_t *_pBuf, uint32_t _uiSector, uint32_t _uiCount)
+{
+    uint32_t block, offset, num;
+
+    if (s_ucInit == 0 || _uiSector + _uiCount > FTL_SECTOR_NUM)
+    {
+        return -1;
+    }
+
+    while (_uiCount)
+    {
+        block = _uiSector / FTL_SECTOR_PER_BLOCK;
+        offset = (_uiSector % FTL_SECTOR_PER_BLOCK) * FTL_SECTOR_SIZE;
+        num = FTL_SECTOR_PER_BLOCK - _uiSector % FTL_SECTOR_PER_BLOCK;
+        if (num > _uiCount)
+        {
+            num = _uiCount;
+        }
+
+        if (num == FTL_SECTOR_PER_BLOCK)
+        {
+            if (FTL_WriteBlock(block, _pBuf) != 0)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            if (FTL_CacheLoad(block) != 0)
+            {
+                return -1;
+            }
+            memcpy(&s_ucCache[offset], _pBuf, num * FTL_SECTOR_SIZE);
+            s_ucCacheDirty = 1;
+        }
+
+        _pBuf += num * FTL_SECTOR_SIZE;
+        _uiSector += num;
+        _uiCount -= num;
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: FTL_GetStat
+*    功能说明: 读取统计信息
+*    形    参: _pStat : 统计信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void FTL_GetStat(FTL_STAT_T *_pStat)
+{
+    uint32_t sum = 0;
+    uint16_t good = 0;
+    uint16_t i;
+
+    memset(_pStat, 0, sizeof(FTL_STAT_T));
+    _pStat->blocks = FTL_BLOCK_NUM;
+    _pStat->erase_min = 0xFFFFFFFF;
+    _pStat->writes = s_uiWrites;
+    _pStat->ckpt_seq = s_uiSeq;
+    _pStat->journal = s_uiJournalPos;
+    _pStat->wl_moves = s_usWlMoves;
+
+    for (i = 0; i < FTL_BLOCK_NUM; i++)
+    {
+        if (s_usMap[i] != FTL_UNMAPPED)
+        {
+            _pStat->used++;
+        }
+    }
+
+    for (i = 0; i < FTL_PHY_NUM; i++)
+    {
+        if (FTL_BIT_GET(s_ucBad, i))
+        {
+            _pStat->bad++;
+            continue;
+        }
+        if (!FTL_BIT_GET(s_ucUsed, i))
+        {
+            _pStat->free++;
+        }
+        if (s_uiEraseCnt[i] < _pStat->erase_min)
+        {
+            _pStat->erase_min = s_uiEraseCnt[i];
+        }
+        if (s_uiEraseCnt[i] > _pStat->erase_max)
+        {
+            _pStat->erase_max = s_uiEraseCnt[i];
+        }
+        sum += s_uiEraseCnt[i];
+        good++;
+    }
+
+    _pStat->erase_avg = (good != 0) ? sum / good : 0;
+}
+
+#ifndef QSPI_SIM
+#include "bsp.h" /* ftl 命令使用 shell 和 printf */
+#endif
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 测试数据，由块号和轮次生成，便于校验 */
+static void ftl_test_fill(uint32_t *_pBuf, uint32_t _uiBlock, uint32_t _uiRound)
+{
+    uint32_t x = _uiBlock * 2654435761UL + _uiRound;
+
+    for (uint32_t i = 0; i < FTL_BLOCK_SIZE / 4; i++)
+    {
+        x = x * 1103515245UL + 12345;
+        _pBuf[i] = x;
+    }
+}
+
+/* 随机写入测试范围内的块，每块记录最后写入的轮次，最后全部读回校验 */
+static int ftl_test(uint32_t _uiCount, uint32_t _uiRange)
+{
+    uint32_t *buf = malloc(FTL_BLOCK_SIZE * 2);
+    uint16_t *round = malloc(_uiRange * 2);
+    uint32_t i, block, err = 0;
+    uint64_t ticks;
+
+    if (buf == NULL || round == NULL)
+    {
+        printf("Low memory!\r\n");
+        free(buf);
+        free(round);
+        return -1;
+    }
+    memset(round, 0, _uiRange * 2);
+
+    ticks = get_system_ticks();
+    for (i = 1; i <= _uiCount; i++)
+    {
+        block = rand() % _uiRange;
+        ftl_test_fill(buf, block, i);
+        if (FTL_WriteBlock(block, (uint8_t *)buf) != 0)
+        {
+            printf("write block %d error\r\n", block);
+            err++;
+            break;
+        }
+        round[block] = i;
+    }
+    ticks = get_system_ticks() - ticks;
+    printf("write %d blocks %d ms\r\n", i - 1, (uint32_t)(ticks / (SystemCoreClock / 1000)));
+
+    for (block = 0; block < _uiRange; block++)
+    {
+        if (round[block] == 0)
+        {
+            continue;
+        }
+        ftl_test_fill(buf, block, round[block]);
+        FTL_ReadBlock(block, (uint8_t *)&buf[FTL_BLOCK_SIZE / 4]);
+        if (memcmp(buf, &buf[FTL_BLOCK_SIZE / 4], FTL_BLOCK_SIZE) != 0)
+        {
+            printf("verify block %d error\r\n", block);
+            err++;
+        }
+    }
+    printf("verify %s\r\n", err ? "failed" : "OK");
+
+    free(buf);
+    free(round);
+
+    return err ? -1 : 0;
+}
+
+static int cmd_ftl(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "ftl stat",
+        "ftl read block [offset]",
+        "ftl write block byte",
+        "ftl trim block",
+        "ftl test count [range]",
+        "ftl format"};
+
+    if (argc < 2)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+    else
+    {
+        if (!strcmp(argv[1], "stat"))
+        {
+            FTL_STAT_T stat;
+
+            FTL_GetStat(&stat);
+            printf("blocks = %d used = %d free = %d bad = %d\r\n", stat.blocks, stat.used, stat.free, stat.bad);
+            printf("erase count min = %d max = %d avg = %d\r\n", stat.erase_min, stat.erase_max, stat.erase_avg);
+            printf("writes = %d checkpoint = %d journal = %d/%d wl moves = %d\r\n",
+                   stat.writes, stat.ckpt_seq, stat.journal, FTL_JOURNAL_NUM, stat.wl_moves);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "read"))
+        {
+            uint8_t *buf;
+            uint32_t offset = 0;
+
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[1]);
+                return -1;
+            }
+            if (argc > 3)
+            {
+                offset = strtol(argv[3], NULL, 0) & (FTL_BLOCK_SIZE - 1) & ~15UL;
+            }
+            buf = malloc(FTL_BLOCK_SIZE);
+            if (buf == NULL)
+            {
+                printf("Low memory!\r\n");
+                return -1;
+            }
+            if (FTL_ReadBlock(strtol(argv[2], NULL, 0), buf) != 0)
+            {
+                printf("FTL_ReadBlock Error.\r\n");
+                free(buf);
+                return -1;
+            }
+            for (uint32_t i = offset; i < offset + 64 && i < FTL_BLOCK_SIZE; i++)
+            {
+                printf("%02X%s", buf[i], ((i & 15) == 15) ? "\r\n" : " ");
+            }
+            free(buf);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "write"))
+        {
+            uint8_t *buf;
+            int ret;
+
+            if (argc < 4)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[2]);
+                return -1;
+            }
+            buf = malloc(FTL_BLOCK_SIZE);
+            if (buf == NULL)
+            {
+                printf("Low memory!\r\n");
+                return -1;
+            }
+            memset(buf, strtol(argv[3], NULL, 0), FTL_BLOCK_SIZE);
+            ret = FTL_WriteBlock(strtol(argv[2], NULL, 0), buf);
+            free(buf);
+
+            return ret;
+        }
+        else if (!strcmp(argv[1], "trim"))
+        {
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[3]);
+                return -1;
+            }
+
+            return FTL_Trim(strtol(argv[2], NULL, 0));
+        }
+        else if (!strcmp(argv[1], "test"))
+        {
+            uint32_t range = 64;
+
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[4]);
+                return -1;
+            }
+            if (argc > 3)
+            {
+                range = strtol(argv[3], NULL, 0);
+            }
+            if (range == 0 || range > FTL_BLOCK_NUM)
+            {
+                range = FTL_BLOCK_NUM;
+            }
+
+            return ftl_test(strtol(argv[2], NULL, 0), range);
+        }
+        else if (!strcmp(argv[1], "format"))
+        {
+            return FTL_Format();
+        }
+        else
+        {
+            printf("Error Command\r\nUsage:\r\n");
+            for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+            {
+                printf("%s\r\n", help_info[i]);
+            }
+            printf("\r\n");
+        }
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), ftl, cmd_ftl, ftl[stat read write trim test format]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
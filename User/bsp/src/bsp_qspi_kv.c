@@ -0,0 +1,1190 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash KV参数存储模块
+*    文件名称 : bsp_qspi_kv.c
+*    版    本 : V1.0
+*    说    明 : 在QSPI Flash末尾的保留区实现日志结构的键值存储，用于保存配置参数和计数器。
+*               1. 记录只追加写入，带CRC校验，修改和删除都是追加一条新记录
+*               2. 上电扫描所有扇区，在RAM中建立哈希索引，读取时按索引直接定位，O(1)
+*               3. 空闲扇区不足时回收最旧的扇区，把其中仍有效的记录搬到新扇区后擦除。回收启用的新扇区
+                  记下旧扇区的顺序号，回收中途掉电时上电擦除这个新扇区，保留扇区不会因掉电而耗尽
+*               4. 新扇区总是选择擦除次数最少的空闲扇区，扇区按日志顺序轮转，磨损均匀
+*               只使用 bsp_qspi.h 的读、页编程、扇区擦除接口，不包含 bsp.h 和HAL，
+*               在PC上用 Tools/qspi_sim 的文件模拟Flash测试。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include <string.h>
+#include "bsp_user_lib.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_kv.h"
+
+/*
+    扇区格式:
+    +--------------+-------------+--------+-----------+----------+----------+-----
+    | 扇区头 28字节 | 记录1       | 记录2  | ...       | 0xFF ...
+    +--------------+-------------+--------+-----------+----------+----------+-----
+    扇区头: magic + 擦除次数(原码和反码)在擦除后立即写入，seq + ~seq + src + ~src 在扇区启用时写入。
+    src 为垃圾回收启用本扇区时正在回收的扇区的 seq，普通启用时为 0xFFFFFFFF。
+
+    记录格式(4字节对齐):
+    | magic(2) | crc(2) | key_len(1) | type(1) | val_len(2) | key | value |
+    crc 校验 key_len 之后的全部内容。magic 在其余内容写完后最后写入，作为提交标记，
+    写入中掉电的记录 magic 不完整。记录头全为 0xFF 表示扇区已写到末尾。
+*/
+#define KV_SECTOR_MAGIC 0x3053564BUL /* "KVS0" */
+#define KV_RECORD_MAGIC 0x4B56       /* "VK" */
+#define KV_SEQ_FREE 0xFFFFFFFFUL     /* 扇区已擦除，尚未启用 */
+
+#define KV_TYPE_VALUE 0x01 /* 键值记录 */
+#define KV_TYPE_DELETE 0x00 /* 删除记录 */
+
+#define KV_RECORD_HEAD 8
+#define KV_RECORD_MAX (KV_RECORD_HEAD + KV_KEY_MAX + KV_VALUE_MAX)
+#define KV_RESERVE_NUM 1 /* 为垃圾回收保留的空闲扇区个数 */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t erase_cnt;
+    uint32_t erase_inv;
+    uint32_t seq;
+    uint32_t seq_inv;
+    uint32_t src;
+    uint32_t src_inv;
+} KV_SECTOR_HEAD_T;
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t crc;
+    uint8_t key_len;
+    uint8_t type;
+    uint16_t val_len;
+} KV_RECORD_HEAD_T;
+
+/* 扇区状态 */
+typedef struct
+{
+    uint32_t seq;       /* 日志顺序号，KV_SEQ_FREE 表示空闲 */
+    uint32_t erase_cnt; /* 擦除次数 */
+    uint16_t used;      /* 已写入字节数(含扇区头) */
+    uint16_t live;      /* 有效记录字节数 */
+} KV_SECTOR_T;
+
+/* 索引项，addr为0表示空 */
+typedef struct
+{
+    uint32_t hash;
+    uint32_t addr;
+} KV_INDEX_T;
+
+static KV_SECTOR_T s_tSector[KV_SECTOR_NUM];
+static KV_INDEX_T s_tIndex[KV_INDEX_SIZE];
+static uint8_t s_ucRecord[KV_RECORD_MAX] __attribute__((aligned(4))); /* 待写入的记录 */
+static uint8_t s_ucMove[KV_RECORD_MAX] __attribute__((aligned(4)));   /* 垃圾回收搬移的记录 */
+static uint16_t s_usKeys = 0;
+static uint8_t s_ucHead = 0;   /* 当前写入扇区 */
+static uint32_t s_uiSeq = 0;   /* 最大顺序号 */
+static uint32_t s_uiGcCnt = 0; /* 垃圾回收次数 */
+static uint32_t s_uiGcSrc = KV_SEQ_FREE; /* 正在回收的扇区的顺序号 */
+static uint8_t s_ucInit = 0;
+
+static int KV_NextSector(uint8_t _ucGc, uint32_t _uiNeed);
+
+/* 扇区号转换为Flash地址 */
+#define KV_SECTOR_ADDR(n) (KV_FLASH_ADDR + (uint32_t)(n)*KV_SECTOR_SIZE)
+/* 记录占用的字节数 */
+#define KV_RECORD_SIZE(klen, vlen) USER_ALIGN(KV_RECORD_HEAD + (klen) + (vlen), 4)
+
+/* FNV-1a 哈希 */
+static uint32_t KV_Hash(const char *_key, uint8_t _ucLen)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (_ucLen--)
+    {
+        hash ^= (uint8_t)*_key++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Program
+*    功能说明: 写入任意长度数据，按页边界拆分。目标区域必须已擦除。
+*    形    参: _uiAddr : Flash地址
+*              _pBuf : 数据
+*              _uiSize : 字节数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void KV_Program(uint32_t _uiAddr, const uint8_t *_pBuf, uint32_t _uiSize)
+{
+    uint32_t len;
+
+    while (_uiSize)
+    {
+        len = QSPI_PAGE_SIZE - (_uiAddr & (QSPI_PAGE_SIZE - 1));
+        if (len > _uiSize)
+        {
+            len = _uiSize;
+        }
+        QSPI_WriteBuffer((uint8_t *)_pBuf, _uiAddr, len);
+        _uiAddr += len;
+        _pBuf += len;
+        _uiSize -= len;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_EraseSector
+*    功能说明: 擦除扇区并写入扇区头(magic + 擦除次数)，扇区进入空闲状态
+*    形    参: _ucSector : 扇区号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void KV_EraseSector(uint8_t _ucSector)
+{
+    KV_SECTOR_HEAD_T head;
+
+    QSPI_EraseSector(KV_SECTOR_ADDR(_ucSector));
+
+    s_tSector[_ucSector].erase_cnt++;
+    s_tSector[_ucSector].seq = KV_SEQ_FREE;
+    s_tSector[_ucSector].used = sizeof(KV_SECTOR_HEAD_T);
+    s_tSector[_ucSector].live = 0;
+
+    head.magic = KV_SECTOR_MAGIC;
+    head.erase_cnt = s_tSector[_ucSector].erase_cnt;
+    head.erase_inv = ~head.erase_cnt;
+    KV_Program(KV_SECTOR_ADDR(_ucSector), (uint8_t *)&head, 12);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Find
+*    功能说明: 在索引中查找键
+*    形    参: _key : 键名
+*              _ucLen : 键名长度
+*              _uiHash : 键名哈希值
+*    返 回 值: 索引位置，没有找到时返回可以插入的空位置
+*********************************************************************************************************
+*/
+static uint32_t KV_Find(const char *_key, uint8_t _ucLen, uint32_t _uiHash)
+{
+    uint32_t i = _uiHash & (KV_INDEX_SIZE - 1);
+    uint8_t buf[KV_RECORD_HEAD + KV_KEY_MAX];
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)buf;
+
+    while (s_tIndex[i].addr != 0)
+    {
+        if (s_tIndex[i].hash == _uiHash)
+        {
+            /* 哈希相同时读出键名确认 */
+            QSPI_ReadBuffer(buf, s_tIndex[i].addr, KV_RECORD_HEAD + _ucLen);
+            if (rec->key_len == _ucLen && memcmp(&buf[KV_RECORD_HEAD], _key, _ucLen) == 0)
+            {
+                break;
+            }
+        }
+        i = (i + 1) & (KV_INDEX_SIZE - 1);
+    }
+
+    return i;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_IndexRemove
+*    功能说明: 删除索引项，线性探测表需要把后面的项往前移
+*    形    参: _uiPos : 索引位置
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void KV_IndexRemove(uint32_t _uiPos)
+{
+    uint32_t i = _uiPos;
+    uint32_t j = _uiPos;
+    uint32_t k;
+
+    s_tIndex[i].addr = 0;
+    s_usKeys--;
+
+    for (;;)
+    {
+        j = (j + 1) & (KV_INDEX_SIZE - 1);
+        if (s_tIndex[j].addr == 0)
+        {
+            break;
+        }
+
+        /* k 为第j项的理想位置，位于 (i, j] 之间的项不需要移动 */
+        k = s_tIndex[j].hash & (KV_INDEX_SIZE - 1);
+        if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+        {
+            continue;
+        }
+
+        s_tIndex[i] = s_tIndex[j];
+        s_tIndex[j].addr = 0;
+        i = j;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Apply
+*    功能说明: 按一条记录更新索引
+*    形    参: _pRec : 记录(记录头 + 键名)
+*              _uiAddr : 记录地址
+*    返 回 值: 0:成功， -1：索引已满
+*********************************************************************************************************
+*/
+static int KV_Apply(const uint8_t *_pRec, uint32_t _uiAddr)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)_pRec;
+    const char *key = (const char *)&_pRec[KV_RECORD_HEAD];
+    uint32_t hash = KV_Hash(key, rec->key_len);
+    uint32_t pos = KV_Find(key, rec->key_len, hash);
+    uint32_t size = KV_RECORD_SIZE(rec->key_len, rec->val_len);
+    uint32_t old = s_tIndex[pos].addr;
+
+    if (old != 0)
+    {
+        /* 旧记录失效 */
+        KV_RECORD_HEAD_T head;
+
+        QSPI_ReadBuffer((uint8_t *)&head, old, KV_RECORD_HEAD);
+        s_tSector[(old - KV_FLASH_ADDR) / KV_SECTOR_SIZE].live -= KV_RECORD_SIZE(head.key_len, head.val_len);
+    }
+
+    if (rec->type == KV_TYPE_DELETE)
+    {
+        if (old != 0)
+        {
+            KV_IndexRemove(pos);
+        }
+        return 0;
+    }
+
+    if (old == 0)
+    {
+        if (s_usKeys >= KV_INDEX_SIZE * 3 / 4)
+        {
+            return -1;
+        }
+        s_usKeys++;
+    }
+
+    s_tIndex[pos].hash = hash;
+    s_tIndex[pos].addr = _uiAddr;
+    s_tSector[(_uiAddr - KV_FLASH_ADDR) / KV_SECTOR_SIZE].live += size;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_ReadRecord
+*    功能说明: 读取并校验一条记录
+*    形    参: _pBuf : 记录缓冲区，KV_RECORD_MAX 字节
+*              _uiAddr : 记录地址
+*              _usLimit : 扇区内剩余字节数
+*    返 回 值: 记录占用字节数，0表示扇区结束，-1表示记录损坏
+*********************************************************************************************************
+*/
+static int KV_ReadRecord(uint8_t *_pBuf, uint32_t _uiAddr, uint32_t _uiLimit)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)_pBuf;
+    uint32_t size;
+
+    if (_uiLimit < KV_RECORD_HEAD)
+    {
+        return 0;
+    }
+
+    QSPI_ReadBuffer(_pBuf, _uiAddr, KV_RECORD_HEAD);
+    if (rec->magic == 0xFFFF)
+    {
+        /* 记录头全为0xFF才是空白区，否则是写入中掉电 */
+        return (rec->crc == 0xFFFF && rec->key_len == 0xFF && rec->type == 0xFF && rec->val_len == 0xFFFF) ? 0 : -1;
+    }
+
+    size = KV_RECORD_SIZE(rec->key_len, rec->val_len);
+    if (rec->magic != KV_RECORD_MAGIC || rec->key_len == 0 || rec->key_len > KV_KEY_MAX ||
+        rec->val_len > KV_VALUE_MAX || size > _uiLimit)
+    {
+        return -1;
+    }
+
+    QSPI_ReadBuffer(&_pBuf[KV_RECORD_HEAD], _uiAddr + KV_RECORD_HEAD, rec->key_len + rec->val_len);
+    if (CRC16_Modbus(&_pBuf[4], 4 + rec->key_len + rec->val_len) != rec->crc)
+    {
+        return -1;
+    }
+
+    return size;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_IsBlank
+*    功能说明: 检查Flash区域是否全为0xFF
+*    形    参: _uiAddr : Flash地址
+*              _uiSize : 字节数
+*    返 回 值: 1:空白， 0：有数据
+*********************************************************************************************************
+*/
+static uint8_t KV_IsBlank(uint32_t _uiAddr, uint32_t _uiSize)
+{
+    uint32_t buf[16];
+    uint32_t len;
+    uint32_t i;
+
+    while (_uiSize)
+    {
+        len = (_uiSize > sizeof(buf)) ? sizeof(buf) : _uiSize;
+        memset(buf, 0xFF, sizeof(buf));
+        QSPI_ReadBuffer((uint8_t *)buf, _uiAddr, len);
+        for (i = 0; i < sizeof(buf) / 4; i++)
+        {
+            if (buf[i] != 0xFFFFFFFF)
+            {
+                return 0;
+            }
+        }
+        _uiAddr += len;
+        _uiSize -= len;
+    }
+
+    return 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_ScanSector
+*    功能说明: 扫描扇区中的全部记录，更新索引和写入位置
+*    形    参: _ucSector : 扇区号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void KV_ScanSector(uint8_t _ucSector)
+{
+    uint32_t base = KV_SECTOR_ADDR(_ucSector);
+    uint16_t off = sizeof(KV_SECTOR_HEAD_T);
+    int size;
+
+    while (1)
+    {
+        size = KV_ReadRecord(s_ucRecord, base + off, KV_SECTOR_SIZE - off);
+        if (size == 0 && KV_IsBlank(base + off, KV_SECTOR_SIZE - off))
+        {
+            break;
+        }
+        if (size <= 0)
+        {
+            /* 掉电导致的半条记录(记录头可能仍为0xFF)，后面的空间不能再写，扇区封闭 */
+            off = KV_SECTOR_SIZE;
+            break;
+        }
+        KV_Apply(s_ucRecord, base + off);
+        off += size;
+    }
+    s_tSector[_ucSector].used = off;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Append
+*    功能说明: 把一条记录追加到当前扇区并更新索引。先写magic之后的内容，编程完成后再写magic，
+*              掉电残缺的记录没有magic，不依赖CRC识别。返回0时记录已写入Flash。
+*    形    参: _pBuf : 记录
+*              _ucGc : 1表示垃圾回收搬移记录，可以使用保留扇区
+*    返 回 值: 0:成功， -1：空间不足
+*********************************************************************************************************
+*/
+static int KV_Append(const uint8_t *_pBuf, uint8_t _ucGc)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)_pBuf;
+    uint32_t size = KV_RECORD_SIZE(rec->key_len, rec->val_len);
+    uint32_t addr;
+
+    if (s_tSector[s_ucHead].used + size > KV_SECTOR_SIZE)
+    {
+        if (KV_NextSector(_ucGc, size) != 0)
+        {
+            return -1;
+        }
+    }
+
+    addr = KV_SECTOR_ADDR(s_ucHead) + s_tSector[s_ucHead].used;
+    KV_Program(addr + 2, &_pBuf[2], KV_RECORD_HEAD - 2 + rec->key_len + rec->val_len);
+    QSPI_WaitBusy();
+    KV_Program(addr, _pBuf, 2);
+    QSPI_WaitBusy(); /* 编程完成后才返回，之后掉电不会丢失 */
+    s_tSector[s_ucHead].used += size;
+
+    return KV_Apply(_pBuf, addr);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_CollectSector
+*    功能说明: 回收最旧的扇区：有效记录搬到当前扇区，然后擦除。当前扇区写满时启用保留扇区，
+*              扇区头记下 victim 的顺序号，见 bsp_InitKV。
+*    形    参: 无
+*    返 回 值: 0:成功， -1：没有可回收的扇区
+*********************************************************************************************************
+*/
+static int KV_CollectSector(void)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)s_ucMove;
+    uint8_t victim = KV_SECTOR_NUM;
+    uint32_t base;
+    uint16_t off;
+    uint32_t pos;
+    int size;
+
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        if (i != s_ucHead && s_tSector[i].seq != KV_SEQ_FREE &&
+            (victim == KV_SECTOR_NUM || s_tSector[i].seq < s_tSector[victim].seq))
+        {
+            victim = i;
+        }
+    }
+
+    if (victim == KV_SECTOR_NUM)
+    {
+        return -1;
+    }
+
+    base = KV_SECTOR_ADDR(victim);
+    off = sizeof(KV_SECTOR_HEAD_T);
+    s_uiGcSrc = s_tSector[victim].seq;
+    while (s_tSector[victim].live != 0)
+    {
+        size = KV_ReadRecord(s_ucMove, base + off, KV_SECTOR_SIZE - off);
+        if (size <= 0)
+        {
+            break;
+        }
+
+        /* 删除记录不需要搬移：比它更旧的扇区都已经回收 */
+        if (rec->type == KV_TYPE_VALUE)
+        {
+            pos = KV_Find((char *)&s_ucMove[KV_RECORD_HEAD], rec->key_len,
+                          KV_Hash((char *)&s_ucMove[KV_RECORD_HEAD], rec->key_len));
+            if (s_tIndex[pos].addr == base + off)
+            {
+                if (KV_Append(s_ucMove, 1) != 0)
+                {
+                    s_uiGcSrc = KV_SEQ_FREE;
+                    return -1;
+                }
+            }
+        }
+        off += size;
+    }
+
+    KV_EraseSector(victim);
+    s_uiGcSrc = KV_SEQ_FREE;
+    s_uiGcCnt++;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_FreeNum
+*    功能说明: 统计空闲扇区个数
+*    形    参: 无
+*    返 回 值: 空闲扇区个数
+*********************************************************************************************************
+*/
+static uint8_t KV_FreeNum(void)
+{
+    uint8_t num = 0;
+
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        if (s_tSector[i].seq == KV_SEQ_FREE)
+        {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_NextSector
+*    功能说明: 当前扇区写满，启用擦除次数最少的空闲扇区。普通写入不能占用保留扇区，空闲扇区不足时先回收。
+*    形    参: _ucGc : 1表示垃圾回收过程中调用
+*              _uiNeed : 需要写入的字节数
+*    返 回 值: 0:成功， -1：空间不足
+*********************************************************************************************************
+*/
+static int KV_NextSector(uint8_t _ucGc, uint32_t _uiNeed)
+{
+    KV_SECTOR_HEAD_T head;
+    uint8_t next = KV_SECTOR_NUM;
+    uint32_t live = _uiNeed;
+
+    if (!_ucGc)
+    {
+        /* 有效数据超出容量时回收也腾不出空间 */
+        for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+        {
+            live += s_tSector[i].live;
+        }
+        if (live > (KV_SECTOR_NUM - KV_RESERVE_NUM - 1) * (KV_SECTOR_SIZE - sizeof(KV_SECTOR_HEAD_T)))
+        {
+            return -1;
+        }
+
+        for (uint8_t n = 0; n < KV_SECTOR_NUM && KV_FreeNum() <= KV_RESERVE_NUM; n++)
+        {
+            if (KV_CollectSector() != 0)
+            {
+                return -1;
+            }
+
+            /* 搬移时换了新扇区，空位集中到了当前扇区。扇区接近写满时回收不会增加空闲扇区，只能这样腾出空间 */
+            if (s_tSector[s_ucHead].used + _uiNeed <= KV_SECTOR_SIZE)
+            {
+                return 0;
+            }
+        }
+
+        if (KV_FreeNum() <= KV_RESERVE_NUM)
+        {
+            return -1;
+        }
+    }
+
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        if (s_tSector[i].seq == KV_SEQ_FREE &&
+            (next == KV_SECTOR_NUM || s_tSector[i].erase_cnt < s_tSector[next].erase_cnt))
+        {
+            next = i;
+        }
+    }
+
+    if (next == KV_SECTOR_NUM)
+    {
+        return -1;
+    }
+
+    head.seq = ++s_uiSeq;
+    head.seq_inv = ~head.seq;
+    head.src = s_uiGcSrc;
+    head.src_inv = ~head.src;
+    KV_Program(KV_SECTOR_ADDR(next) + 12, (uint8_t *)&head.seq, 16);
+    s_tSector[next].seq = head.seq;
+    s_tSector[next].used = sizeof(KV_SECTOR_HEAD_T);
+    s_tSector[next].live = 0;
+    s_ucHead = next;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: bsp_InitKV
+*    功能说明: 扫描KV参数区，重建RAM索引。扇区头损坏的扇区重新擦除，没有有效扇区时格式化。
+*              垃圾回收中途掉电时擦除回收启用的扇区，其中只有搬移的记录，原记录仍在旧扇区。
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void bsp_InitKV(void)
+{
+    KV_SECTOR_HEAD_T head;
+    uint8_t order[KV_SECTOR_NUM];
+    uint8_t num = 0;
+    uint32_t ec_max = 0;
+    uint32_t src = KV_SEQ_FREE;
+    uint8_t i, j, t;
+
+    memset(s_tIndex, 0, sizeof(s_tIndex));
+    s_usKeys = 0;
+    s_uiSeq = 0;
+    s_ucInit = 0;
+
+    for (i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        QSPI_ReadBuffer((uint8_t *)&head, KV_SECTOR_ADDR(i), sizeof(head));
+
+        s_tSector[i].used = sizeof(KV_SECTOR_HEAD_T);
+        s_tSector[i].live = 0;
+        if (head.magic != KV_SECTOR_MAGIC || head.erase_cnt != ~head.erase_inv)
+        {
+            /* 新Flash或擦除过程中掉电，擦除次数未知 */
+            s_tSector[i].seq = 0;
+            s_tSector[i].erase_cnt = 0xFFFFFFFF;
+            continue;
+        }
+
+        s_tSector[i].erase_cnt = head.erase_cnt;
+        if (head.erase_cnt > ec_max)
+        {
+            ec_max = head.erase_cnt;
+        }
+
+        if (head.seq == KV_SEQ_FREE && head.seq_inv == KV_SEQ_FREE &&
+            head.src == KV_SEQ_FREE && head.src_inv == KV_SEQ_FREE)
+        {
+            s_tSector[i].seq = KV_SEQ_FREE;
+        }
+        else if (head.seq == ~head.seq_inv && head.seq != KV_SEQ_FREE && head.src == ~head.src_inv)
+        {
+            s_tSector[i].seq = head.seq;
+            order[num++] = i;
+            if (head.seq > s_uiSeq)
+            {
+                s_uiSeq = head.seq;
+                src = head.src;
+            }
+        }
+        else
+        {
+            /* 启用扇区时掉电 */
+            s_tSector[i].seq = 0;
+        }
+    }
+
+    /* 扇区头无效的扇区重新擦除，擦除次数取已知最大值 */
+    for (i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        if (s_tSector[i].seq == 0)
+        {
+            if (s_tSector[i].erase_cnt == 0xFFFFFFFF)
+            {
+                s_tSector[i].erase_cnt = ec_max;
+            }
+            KV_EraseSector(i);
+        }
+    }
+
+    /* 按日志顺序扫描，后写入的记录覆盖先写入的 */
+    for (i = 1; i < num; i++)
+    {
+        for (j = i; j > 0 && s_tSector[order[j - 1]].seq > s_tSector[order[j]].seq; j--)
+        {
+            t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+
+    /* 最新的扇区由垃圾回收启用，且被回收的扇区还在：回收没有完成。擦除新扇区，恢复保留扇区，
+       回收过程中掉电多少次都不会占用更多扇区。下次写满时重新回收 */
+    if (num > 0 && src != KV_SEQ_FREE)
+    {
+        for (i = 0; i < num - 1; i++)
+        {
+            if (s_tSector[order[i]].seq == src)
+            {
+                KV_EraseSector(order[--num]);
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        KV_ScanSector(order[i]);
+    }
+
+    if (num > 0)
+    {
+        s_ucHead = order[num - 1];
+    }
+    else
+    {
+        /* 空的参数区，启用第一个扇区 */
+        s_ucHead = 0;
+        if (KV_NextSector(1, 0) != 0)
+        {
+            return;
+        }
+    }
+
+    s_ucInit = 1;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Format
+*    功能说明: 擦除整个KV参数区，擦除次数保留
+*    形    参: 无
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int KV_Format(void)
+{
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        KV_EraseSector(i);
+    }
+
+    memset(s_tIndex, 0, sizeof(s_tIndex));
+    s_usKeys = 0;
+    s_ucHead = 0;
+    s_ucInit = 0;
+    if (KV_NextSector(1, 0) != 0)
+    {
+        return -1;
+    }
+    s_ucInit = 1;
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Set
+*    功能说明: 写入键值。新值与旧值相同时不写Flash。
+*    形    参: _key : 键名，字符串，长度 1 - KV_KEY_MAX
+*              _pVal : 键值
+*              _usLen : 键值长度，0 - KV_VALUE_MAX
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int KV_Set(const char *_key, const void *_pVal, uint16_t _usLen)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)s_ucRecord;
+    size_t klen = strlen(_key);
+    uint32_t pos;
+
+    if (!s_ucInit || klen == 0 || klen > KV_KEY_MAX || _usLen > KV_VALUE_MAX)
+    {
+        return -1;
+    }
+
+    pos = KV_Find(_key, klen, KV_Hash(_key, klen));
+    if (s_tIndex[pos].addr != 0)
+    {
+        /* 值未变化，减少擦写 */
+        if (KV_ReadRecord(s_ucRecord, s_tIndex[pos].addr, KV_RECORD_MAX) > 0 && rec->val_len == _usLen &&
+            (_usLen == 0 || memcmp(&s_ucRecord[KV_RECORD_HEAD + klen], _pVal, _usLen) == 0))
+        {
+            return 0;
+        }
+    }
+    else if (s_usKeys >= KV_INDEX_SIZE * 3 / 4)
+    {
+        return -1;
+    }
+
+    rec->magic = KV_RECORD_MAGIC;
+    rec->key_len = klen;
+    rec->type = KV_TYPE_VALUE;
+    rec->val_len = _usLen;
+    memcpy(&s_ucRecord[KV_RECORD_HEAD], _key, klen);
+    if (_usLen != 0) /* 空值时 _pVal 可以为NULL */
+    {
+        memcpy(&s_ucRecord[KV_RECORD_HEAD + klen], _pVal, _usLen);
+    }
+    rec->crc = CRC16_Modbus(&s_ucRecord[4], 4 + klen + _usLen);
+
+    return KV_Append(s_ucRecord, 0);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Get
+*    功能说明: 读取键值
+*    形    参: _key : 键名
+*              _pVal : 键值缓冲区，可以为NULL，只获取长度
+*              _usSize : 缓冲区大小，键值超出部分丢弃
+*    返 回 值: 键值长度，-1表示不存在
+*********************************************************************************************************
+*/
+int KV_Get(const char *_key, void *_pVal, uint16_t _usSize)
+{
+    KV_RECORD_HEAD_T head;
+    size_t klen = strlen(_key);
+    uint32_t pos;
+
+    if (!s_ucInit || klen == 0 || klen > KV_KEY_MAX)
+    {
+        return -1;
+    }
+
+    pos = KV_Find(_key, klen, KV_Hash(_key, klen));
+    if (s_tIndex[pos].addr == 0)
+    {
+        return -1;
+    }
+
+    QSPI_ReadBuffer((uint8_t *)&head, s_tIndex[pos].addr, KV_RECORD_HEAD);
+    if (_pVal != NULL && _usSize != 0 && head.val_len != 0)
+    {
+        QSPI_ReadBuffer(_pVal, s_tIndex[pos].addr + KV_RECORD_HEAD + klen,
+                        (head.val_len < _usSize) ? head.val_len : _usSize);
+    }
+
+    return head.val_len;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Delete
+*    功能说明: 删除键
+*    形    参: _key : 键名
+*    返 回 值: 0:成功， -1：不存在或失败
+*********************************************************************************************************
+*/
+int KV_Delete(const char *_key)
+{
+    KV_RECORD_HEAD_T *rec = (KV_RECORD_HEAD_T *)s_ucRecord;
+    size_t klen = strlen(_key);
+    uint32_t pos;
+
+    if (!s_ucInit || klen == 0 || klen > KV_KEY_MAX)
+    {
+        return -1;
+    }
+
+    pos = KV_Find(_key, klen, KV_Hash(_key, klen));
+    if (s_tIndex[pos].addr == 0)
+    {
+        return -1;
+    }
+
+    rec->magic = KV_RECORD_MAGIC;
+    rec->key_len = klen;
+    rec->type = KV_TYPE_DELETE;
+    rec->val_len = 0;
+    memcpy(&s_ucRecord[KV_RECORD_HEAD], _key, klen);
+    rec->crc = CRC16_Modbus(&s_ucRecord[4], 4 + klen);
+
+    return KV_Append(s_ucRecord, 0);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_SetU32
+*    功能说明: 写入32位整数
+*    形    参: _key : 键名
+*              _uiVal : 数值
+*    返 回 值: 0:成功， -1：失败
+*********************************************************************************************************
+*/
+int KV_SetU32(const char *_key, uint32_t _uiVal)
+{
+    return KV_Set(_key, &_uiVal, sizeof(_uiVal));
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_GetU32
+*    功能说明: 读取32位整数
+*    形    参: _key : 键名
+*              _uiDefault : 键不存在或长度不符时返回的缺省值
+*    返 回 值: 数值
+*********************************************************************************************************
+*/
+uint32_t KV_GetU32(const char *_key, uint32_t _uiDefault)
+{
+    uint32_t val;
+
+    if (KV_Get(_key, &val, sizeof(val)) != sizeof(val))
+    {
+        return _uiDefault;
+    }
+
+    return val;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_AddU32
+*    功能说明: 计数器加减，键不存在时从0开始
+*    形    参: _key : 键名
+*              _iDelta : 增量
+*    返 回 值: 新的数值
+*********************************************************************************************************
+*/
+uint32_t KV_AddU32(const char *_key, int32_t _iDelta)
+{
+    uint32_t val = KV_GetU32(_key, 0) + _iDelta;
+
+    KV_SetU32(_key, val);
+
+    return val;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Collect
+*    功能说明: 手动垃圾回收，回收所有有失效记录的扇区
+*    形    参: 无
+*    返 回 值: 回收的扇区个数
+*********************************************************************************************************
+*/
+int KV_Collect(void)
+{
+    int num = 0;
+
+    if (!s_ucInit)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        uint8_t victim = KV_SECTOR_NUM;
+
+        for (uint8_t j = 0; j < KV_SECTOR_NUM; j++)
+        {
+            if (j != s_ucHead && s_tSector[j].seq != KV_SEQ_FREE &&
+                (victim == KV_SECTOR_NUM || s_tSector[j].seq < s_tSector[victim].seq))
+            {
+                victim = j;
+            }
+        }
+
+        /* 只回收最旧扇区，它没有垃圾时停止 */
+        if (victim == KV_SECTOR_NUM || s_tSector[victim].live + sizeof(KV_SECTOR_HEAD_T) >= s_tSector[victim].used)
+        {
+            break;
+        }
+
+        if (KV_CollectSector() != 0)
+        {
+            break;
+        }
+        num++;
+    }
+
+    return num;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_Foreach
+*    功能说明: 遍历所有键
+*    形    参: _cb : 回调函数，返回非0停止
+*              _pArg : 回调参数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void KV_Foreach(KV_FOREACH_CB _cb, void *_pArg)
+{
+    KV_RECORD_HEAD_T head;
+    char key[KV_KEY_MAX + 1];
+
+    for (uint32_t i = 0; i < KV_INDEX_SIZE; i++)
+    {
+        if (s_tIndex[i].addr == 0)
+        {
+            continue;
+        }
+
+        QSPI_ReadBuffer((uint8_t *)&head, s_tIndex[i].addr, KV_RECORD_HEAD);
+        QSPI_ReadBuffer((uint8_t *)key, s_tIndex[i].addr + KV_RECORD_HEAD, head.key_len);
+        key[head.key_len] = '\0';
+        if (_cb(key, head.val_len, _pArg) != 0)
+        {
+            break;
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: KV_GetStat
+*    功能说明: 获取统计信息
+*    形    参: _pStat : 统计信息
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void KV_GetStat(KV_STAT_T *_pStat)
+{
+    memset(_pStat, 0, sizeof(KV_STAT_T));
+    _pStat->keys = s_usKeys;
+    _pStat->erase_min = 0xFFFFFFFF;
+    _pStat->gc_count = s_uiGcCnt;
+
+    for (uint8_t i = 0; i < KV_SECTOR_NUM; i++)
+    {
+        if (s_tSector[i].seq == KV_SEQ_FREE)
+        {
+            _pStat->free++;
+        }
+        else
+        {
+            _pStat->used += s_tSector[i].used - sizeof(KV_SECTOR_HEAD_T);
+            _pStat->live += s_tSector[i].live;
+        }
+
+        if (s_tSector[i].erase_cnt < _pStat->erase_min)
+        {
+            _pStat->erase_min = s_tSector[i].erase_cnt;
+        }
+        if (s_tSector[i].erase_cnt > _pStat->erase_max)
+        {
+            _pStat->erase_max = s_tSector[i].erase_cnt;
+        }
+    }
+}
+
+#ifndef QSPI_SIM
+#include "bsp.h" /* kv 命令使用 shell 和 printf */
+#endif
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+static int kv_list_cb(const char *_key, uint16_t _usLen, void *_pArg)
+{
+    uint8_t buf[16];
+    int len = KV_Get(_key, buf, sizeof(buf));
+
+    printf("%-32s %4d :", _key, _usLen);
+    for (int i = 0; i < len && i < sizeof(buf); i++)
+    {
+        printf(" %02X", buf[i]);
+    }
+    printf("%s\r\n", (len > sizeof(buf)) ? " ..." : "");
+
+    return 0;
+}
+
+static int cmd_kv(int argc, char *argv[])
+{
+    const char *help_info[] = {
+        "kv list",
+        "kv get key",
+        "kv set key str",
+        "kv del key",
+        "kv inc key",
+        "kv gc",
+        "kv stat",
+        "kv format"};
+
+    if (argc < 2)
+    {
+        printf("Error Command.\r\nUsage:\r\n");
+        for (uint8_t i = 0; i < sizeof(help_info) / sizeof(help_info[0]); i++)
+        {
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+    }
+    else
+    {
+        if (!strcmp(argv[1], "list"))
+        {
+            KV_Foreach(kv_list_cb, NULL);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "get"))
+        {
+            char buf[65];
+            int len;
+
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[1]);
+                return -1;
+            }
+            len = KV_Get(argv[2], buf, sizeof(buf) - 1);
+            if (len < 0)
+            {
+                printf("%s not found.\r\n", argv[2]);
+                return -1;
+            }
+            buf[(len < sizeof(buf) - 1) ? len : sizeof(buf) - 1] = '\0';
+            printf("%s = %s (%d bytes)\r\n", argv[2], buf, len);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "set"))
+        {
+            if (argc < 4)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[2]);
+                return -1;
+            }
+            if (KV_Set(argv[2], argv[3], strlen(argv[3])) != 0)
+            {
+                printf("KV_Set Error.\r\n");
+                return -1;
+            }
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "del"))
+        {
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[3]);
+                return -1;
+            }
+
+            return KV_Delete(argv[2]);
+        }
+        else if (!strcmp(argv[1], "inc"))
+        {
+            if (argc < 3)
+            {
+                printf("Error Command.\r\n%s\r\n", help_info[4]);
+                return -1;
+            }
+            printf("%s = %d\r\n", argv[2], KV_AddU32(argv[2], 1));
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "gc"))
+        {
+            printf("collect %d sectors\r\n", KV_Collect());
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "stat"))
+        {
+            KV_STAT_T stat;
+
+            KV_GetStat(&stat);
+            printf("keys = %d free sectors = %d/%d\r\n", stat.keys, stat.free, KV_SECTOR_NUM);
+            printf("used = %d live = %d bytes\r\n", stat.used, stat.live);
+            printf("erase count min = %d max = %d gc = %d\r\n", stat.erase_min, stat.erase_max, stat.gc_count);
+
+            return 0;
+        }
+        else if (!strcmp(argv[1], "format"))
+        {
+            return KV_Format();
+        }
+        else
+        {
+            printf("Error Command\r\nUsage:\r\n");
+            for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+            {
+                printf("%s\r\n", help_info[i]);
+            }
+            printf("\r\n");
+        }
+    }
+
+    return -1;
+}
+// 导出到命令列表里
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), kv, cmd_kv, kv[list get set del inc gc stat format]);
+#endif // #ifdef DEBUG_MODE
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
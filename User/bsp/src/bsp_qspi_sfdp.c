@@ -0,0 +1,389 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : QSPI Flash SFDP参数解析模块
+*    文件名称 : bsp_qspi_sfdp.c
+*    版    本 : V1.0
+*    说    明 : 解析JEDEC JESD216 SFDP参数表，生成 QSPI_FLASH_T 描述符，驱动据此选择指令和线宽。
+*               1. BFPT: 容量、地址字节数、擦除类型、页大小、各快速读取方式的指令和空周期、QE位和QPI进入方法
+*               2. 4BAIT: 容量大于16MB时使用4字节地址专用指令，没有该表时进入4字节地址模式
+*               3. 读取方式按 1-4-4 > 1-1-4 > 1-2-2 > 1-1-2 > 1-1-1 自动选择最快的一种
+*               读不到SFDP时按JEDEC ID生成默认参数。只通过回调函数读取SFDP，可在PC上用数据文件测试。
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_qspi.h"
+#include "bsp_qspi_sfdp.h"
+
+/* 厂商ID */
+#define SFDP_MFR_WINBOND 0xEF
+#define SFDP_MFR_GIGADEVICE 0xC8
+#define SFDP_MFR_MACRONIX 0xC2
+
+#define SFDP_SIZE_16M (16 * 1024 * 1024)
+
+/* 读取方式，按优先级排列。bfpt_bit 为BFPT DWORD1支持位，bait_bit 为4BAIT DWORD1对应4字节指令的支持位 */
+typedef struct
+{
+    uint8_t mode;     /* QSPI_MODE_E */
+    uint8_t bfpt_bit; /* 0xFF表示总是支持 */
+    uint8_t dword;    /* 指令参数所在的BFPT DWORD(从0开始) */
+    uint8_t shift;    /* 指令参数在DWORD中的位置 */
+    uint8_t bait_bit; /* 4BAIT支持位 */
+    uint8_t cmd4;     /* 4字节地址指令 */
+} SFDP_READ_T;
+
+static const SFDP_READ_T s_tReadList[] = {
+    {QSPI_MODE_1_4_4, 21, 2, 0, 5, 0xEC},
+    {QSPI_MODE_1_1_4, 22, 2, 16, 4, 0x6C},
+    {QSPI_MODE_1_2_2, 20, 3, 16, 3, 0xBC},
+    {QSPI_MODE_1_1_2, 16, 3, 0, 2, 0x3C},
+    {QSPI_MODE_1_1_1, 0xFF, 0, 0, 1, 0x0C},
+};
+
+static uint8_t SFDP_QeDefault(uint32_t _uiId);
+
+/*
+*********************************************************************************************************
+*    函 数 名: SFDP_ReadOp
+*    功能说明: 解析BFPT中16位的快速读取参数: [4:0]空周期 [7:5]模式位时钟数 [15:8]指令
+*    形    参: _pOp : 读取方式
+*              _usParam : 16位参数
+*              _ucMode : 线宽
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void SFDP_ReadOp(QSPI_READ_OP_T *_pOp, uint16_t _usParam, uint8_t _ucMode)
+{
+    _pOp->cmd = (uint8_t)(_usParam >> 8);
+    _pOp->mode = _ucMode;
+    _pOp->mode_clocks = (_usParam >> 5) & 0x07;
+    _pOp->dummy = _usParam & 0x1F;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SFDP_Parse
+*    功能说明: 读取并解析SFDP参数表
+*    形    参: _pRead : 读取SFDP区域的函数
+*              _uiId : JEDEC ID
+*              _pFlash : 输出的描述符
+*    返 回 值: 0:成功， -1：没有SFDP或参数不可用
+*********************************************************************************************************
+*/
+int SFDP_Parse(SFDP_READ_FN _pRead, uint32_t _uiId, QSPI_FLASH_T *_pFlash)
+{
+    uint32_t head[2];
+    uint32_t param[2];
+    uint32_t bfpt[SFDP_BFPT_DWORDS];
+    uint32_t bait[2] = {0, 0};
+    uint32_t bfpt_addr = 0, bfpt_len = 0, bait_addr = 0;
+    uint32_t i, num, id, len, dw;
+    uint8_t quad;
+    const SFDP_READ_T *p;
+
+    /* SFDP头: 签名、版本、参数头个数(从0开始) */
+    if (_pRead(0, head, sizeof(head)) != 0 || head[0] != SFDP_SIGNATURE)
+    {
+        return -1;
+    }
+
+    num = ((head[1] >> 16) & 0xFF) + 1;
+    if (num > SFDP_PARAM_MAX)
+    {
+        num = SFDP_PARAM_MAX;
+    }
+
+    /* 参数头: ID低8位、版本、长度(DWORD)、24位表地址、ID高8位 */
+    for (i = 0; i < num; i++)
+    {
+        if (_pRead(8 + i * 8, param, sizeof(param)) != 0)
+        {
+            return -1;
+        }
+        id = ((param[1] >> 16) & 0xFF00) | (param[0] & 0xFF);
+        len = param[0] >> 24;
+        if (id == SFDP_BFPT_ID && bfpt_addr == 0)
+        {
+            bfpt_addr = param[1] & 0x00FFFFFF;
+            bfpt_len = (len > SFDP_BFPT_DWORDS) ? SFDP_BFPT_DWORDS : len;
+        }
+        else if (id == SFDP_4BAIT_ID && bait_addr == 0 && len >= 2)
+        {
+            bait_addr = param[1] & 0x00FFFFFF;
+        }
+    }
+
+    /* JESD216 最初版本BFPT有9个DWORD */
+    if (bfpt_addr == 0 || bfpt_len < 9)
+    {
+        return -1;
+    }
+
+    memset(bfpt, 0, sizeof(bfpt));
+    if (_pRead(bfpt_addr, bfpt, bfpt_len * 4) != 0)
+    {
+        return -1;
+    }
+    if (bait_addr != 0 && _pRead(bait_addr, bait, sizeof(bait)) != 0)
+    {
+        return -1;
+    }
+
+    memset(_pFlash, 0, sizeof(QSPI_FLASH_T));
+    _pFlash->id = _uiId;
+    _pFlash->sfdp = (uint8_t)(((head[1] >> 8) & 0x0F) << 4 | (head[1] & 0x0F));
+
+    /* DWORD2: 容量，bit31为1时为 2^N 位，否则为 N+1 位 */
+    dw = bfpt[1];
+    if (dw & 0x80000000UL)
+    {
+        dw &= 0x7FFFFFFFUL;
+        if (dw < 3 || dw > 34)
+        {
+            return -1;
+        }
+        _pFlash->size = 1UL << (dw - 3);
+    }
+    else
+    {
+        _pFlash->size = (dw >> 3) + 1;
+    }
+
+    /* DWORD11: 页大小 2^N */
+    _pFlash->page_size = (bfpt_len >= 11) ? (1 << ((bfpt[10] >> 4) & 0x0F)) : 256;
+
+    /* DWORD1[18:17]: 地址字节数。超过16MB时优先使用4字节地址专用指令 */
+    if (((bfpt[0] >> 17) & 0x03) != 0 && _pFlash->size > SFDP_SIZE_16M)
+    {
+        _pFlash->addr4 = bait_addr ? 1 : 2;
+    }
+
+    /* DWORD8-9: 擦除类型1-4，大小 2^N 和指令。4BAIT DWORD2 为对应的4字节地址指令 */
+    for (i = 0; i < 4; i++)
+    {
+        dw = bfpt[7 + i / 2] >> ((i & 1) * 16);
+        if ((dw & 0xFF) == 0)
+        {
+            continue;
+        }
+        if (_pFlash->addr4 == 1)
+        {
+            if ((bait[0] & (1UL << (9 + i))) == 0)
+            {
+                continue;
+            }
+            _pFlash->erase_cmd[i] = (uint8_t)(bait[1] >> (i * 8));
+        }
+        else
+        {
+            _pFlash->erase_cmd[i] = (uint8_t)(dw >> 8);
+        }
+        _pFlash->erase_shift[i] = (uint8_t)dw;
+
+        if (_pFlash->erase_shift[i] == 12 && _pFlash->erase_4k_cmd == 0)
+        {
+            _pFlash->erase_4k_cmd = _pFlash->erase_cmd[i];
+        }
+        else if (_pFlash->erase_shift[i] == 16 && _pFlash->erase_64k_cmd == 0)
+        {
+            _pFlash->erase_64k_cmd = _pFlash->erase_cmd[i];
+        }
+    }
+
+    /* 分区按4KB扇区规划，不支持4KB擦除的型号不能使用 */
+    if (_pFlash->erase_4k_cmd == 0)
+    {
+        return -1;
+    }
+
+    /* 选择最快的读取方式 */
+    for (p = s_tReadList; p < s_tReadList + sizeof(s_tReadList) / sizeof(s_tReadList[0]); p++)
+    {
+        if (p->bfpt_bit != 0xFF && (bfpt[0] & (1UL << p->bfpt_bit)) == 0)
+        {
+            continue;
+        }
+        if (_pFlash->addr4 == 1 && (bait[0] & (1UL << p->bait_bit)) == 0)
+        {
+            continue;
+        }
+
+        if (p->mode == QSPI_MODE_1_1_1)
+        {
+            /* 1-1-1 快速读取不在BFPT中描述，固定 0Bh + 8个空周期 */
+            SFDP_ReadOp(&_pFlash->read, (0x0B << 8) | 8, QSPI_MODE_1_1_1);
+        }
+        else
+        {
+            SFDP_ReadOp(&_pFlash->read, (uint16_t)(bfpt[p->dword] >> p->shift), p->mode);
+        }
+        if (_pFlash->addr4 == 1)
+        {
+            _pFlash->read.cmd = p->cmd4;
+        }
+        if (_pFlash->read.cmd != 0)
+        {
+            break;
+        }
+    }
+    if (_pFlash->read.cmd == 0)
+    {
+        return -1;
+    }
+    quad = (_pFlash->read.mode == QSPI_MODE_1_1_4 || _pFlash->read.mode == QSPI_MODE_1_4_4);
+
+    /* DWORD15[22:20]: QE位设置方法，JESD216A之前的版本没有该字段，按厂商给出 */
+    if (quad)
+    {
+        _pFlash->qe_method = (bfpt_len >= 15) ? (uint8_t)((bfpt[14] >> 20) & 0x07) : SFDP_QeDefault(_uiId);
+    }
+
+    /* 页编程，4BAIT 给出4字节地址的 1-1-4 编程指令，3字节地址的 32h 只有部分厂商支持 */
+    _pFlash->prog_cmd = (_pFlash->addr4 == 1) ? 0x12 : 0x02;
+    _pFlash->prog_mode = QSPI_MODE_1_1_1;
+    if (_pFlash->addr4 == 1)
+    {
+        if (quad && (bait[0] & (1UL << 7)))
+        {
+            _pFlash->prog_cmd = 0x34;
+            _pFlash->prog_mode = QSPI_MODE_1_1_4;
+        }
+        else if ((bait[0] & (1UL << 6)) == 0)
+        {
+            return -1;
+        }
+    }
+    else if (quad && ((_uiId >> 16) == SFDP_MFR_WINBOND || (_uiId >> 16) == SFDP_MFR_GIGADEVICE))
+    {
+        _pFlash->prog_cmd = 0x32;
+        _pFlash->prog_mode = QSPI_MODE_1_1_4;
+    }
+
+    /* DWORD5[4]: 支持4-4-4，DWORD7为其读取参数，DWORD15[8:4]/[3:0]为进入/退出方法 */
+    if (quad && bfpt_len >= 15 && (bfpt[4] & (1UL << 4)))
+    {
+        dw = (bfpt[14] >> 4) & 0x1F;
+        if (dw & 0x03)
+        {
+            _pFlash->qpi_enter = 0x38;
+        }
+        else if (dw & 0x04)
+        {
+            _pFlash->qpi_enter = 0x35;
+        }
+
+        dw = bfpt[14] & 0x0F;
+        _pFlash->qpi_exit = (dw & 0x01) ? 0xFF : ((dw & 0x02) ? 0xF5 : 0);
+
+        SFDP_ReadOp(&_pFlash->qpi, (uint16_t)(bfpt[6] >> 16), QSPI_MODE_4_4_4);
+        if (_pFlash->addr4 == 1)
+        {
+            _pFlash->qpi.cmd = (bait[0] & (1UL << 5)) ? 0xEC : 0;
+        }
+
+        if (_pFlash->qpi_exit == 0 || _pFlash->qpi.cmd == 0)
+        {
+            _pFlash->qpi_enter = 0;
+        }
+    }
+
+    /* DWORD1[19]: 支持DTR，DTR读取的空周期不在BFPT中描述，由 QSPI_SetReadCfg 给出 */
+    if (quad && (bfpt[0] & (1UL << 19)))
+    {
+        if (_pFlash->addr4 != 1)
+        {
+            _pFlash->dtr_cmd = 0xED;
+        }
+        else if (bait[0] & (1UL << 15))
+        {
+            _pFlash->dtr_cmd = 0xEE;
+        }
+    }
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SFDP_QeDefault
+*    功能说明: 没有QE方法字段时按厂商给出
+*    形    参: _uiId : JEDEC ID
+*    返 回 值: BFPT DWORD15[22:20] 定义的方法
+*********************************************************************************************************
+*/
+static uint8_t SFDP_QeDefault(uint32_t _uiId)
+{
+    switch (_uiId >> 16)
+    {
+    case SFDP_MFR_WINBOND:
+    case SFDP_MFR_GIGADEVICE:
+        return 4; /* SR2 bit1，01h 写 SR1 + SR2 */
+
+    case SFDP_MFR_MACRONIX:
+        return 2; /* SR1 bit6 */
+
+    default:
+        return 0; /* 没有QE位，如Micron */
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: SFDP_Default
+*    功能说明: 没有SFDP时的默认参数。容量取JEDEC ID第3字节 2^N，Winbond按W25Q256JV配置，其他型号使用1-1-1读取。
+*    形    参: _uiId : JEDEC ID
+*              _pFlash : 输出的描述符
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void SFDP_Default(uint32_t _uiId, QSPI_FLASH_T *_pFlash)
+{
+    uint8_t cap = _uiId & 0xFF;
+    uint8_t addr4;
+
+    memset(_pFlash, 0, sizeof(QSPI_FLASH_T));
+    _pFlash->id = _uiId;
+    _pFlash->size = (cap >= 0x10 && cap <= 0x20) ? (1UL << cap) : QSPI_FLASH_SIZES;
+    _pFlash->page_size = 256;
+    addr4 = (_pFlash->size > SFDP_SIZE_16M);
+
+    if ((_uiId >> 16) == SFDP_MFR_WINBOND)
+    {
+        /* W25Q 系列: 4字节地址专用指令，1-4-4 读取 M7-0 + 4个空周期，支持QPI */
+        _pFlash->addr4 = addr4 ? 1 : 0;
+        _pFlash->erase_cmd[0] = addr4 ? 0x21 : 0x20;
+        _pFlash->erase_shift[0] = 12;
+        _pFlash->erase_cmd[1] = addr4 ? 0xDC : 0xD8;
+        _pFlash->erase_shift[1] = 16;
+        _pFlash->prog_cmd = addr4 ? 0x34 : 0x32;
+        _pFlash->prog_mode = QSPI_MODE_1_1_4;
+        _pFlash->qe_method = 4;
+        _pFlash->qpi_enter = 0x38;
+        _pFlash->qpi_exit = 0xFF;
+        SFDP_ReadOp(&_pFlash->read, ((addr4 ? 0xEC : 0xEB) << 8) | (2 << 5) | 4, QSPI_MODE_1_4_4);
+        SFDP_ReadOp(&_pFlash->qpi, ((addr4 ? 0xEC : 0xEB) << 8) | (2 << 5), QSPI_MODE_4_4_4);
+    }
+    else
+    {
+        /* 未知型号使用所有厂商都支持的指令，超过16MB时进入4字节地址模式 */
+        _pFlash->addr4 = addr4 ? 2 : 0;
+        _pFlash->erase_cmd[0] = 0x20;
+        _pFlash->erase_shift[0] = 12;
+        _pFlash->erase_cmd[1] = 0xD8;
+        _pFlash->erase_shift[1] = 16;
+        _pFlash->prog_cmd = 0x02;
+        _pFlash->prog_mode = QSPI_MODE_1_1_1;
+        SFDP_ReadOp(&_pFlash->read, (0x0B << 8) | 8, QSPI_MODE_1_1_1);
+    }
+
+    _pFlash->erase_4k_cmd = _pFlash->erase_cmd[0];
+    _pFlash->erase_64k_cmd = _pFlash->erase_cmd[1];
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -0,0 +1,265 @@
+/*
+*********************************************************************************************************
+*
+*    模块名称 : 屏幕截图模块
+*    文件名称 : bsp_tft_capture.c
+*    版    本 : V1.0
+*    说    明 : 把正在显示的画面通过串口发送给电脑，Tools/tft_capture.py 接收后保存为PNG，调试界面不用拍屏。
+*               1. DMA2D把两层合成到SDRAM中的临时图像(RGB565)，LTDC继续显示，不影响刷新
+*               2. 可按整数倍缩小(取样)，RLE压缩后边压缩边发送，界面图像一般能压缩到 1/5 以下
+*               3. 与OTA相同，可临时切换到更高的波特率，发送完毕切回shell的波特率
+*
+*    修改记录 :
+*        版本号  日期        作者     说明
+*        V1.0    2026-10-19  cctv180  正式发布
+*
+*********************************************************************************************************
+*/
+#include "bsp.h"
+#include "bsp_tft_capture.h"
+
+typedef struct
+{
+    uint8_t buf[CAP_CHUNK]; /* 待写入发送缓冲区的数据 */
+    uint16_t len;
+    uint32_t size; /* 压缩数据的字节数 */
+    uint32_t crc;  /* 压缩数据的CRC32 */
+    int ret;       /* -1 表示发送超时 */
+} CAP_OUT_T;
+
+static CAP_OUT_T s_tOut;
+
+/*
+*********************************************************************************************************
+*    函 数 名: CAP_WaitTx
+*    功能说明: 等待串口发送完毕，切换波特率前调用
+*    形    参: 无
+*    返 回 值: 0 表示发送完毕，-1 表示超时
+*********************************************************************************************************
+*/
+static int CAP_WaitTx(void)
+{
+    uint32_t tick = HAL_GetTick();
+
+    /* gState 就绪时发送缓冲区已空，DMA不再读取 */
+    while (CAP_HUART.gState != HAL_UART_STATE_READY)
+    {
+        if (HAL_GetTick() - tick > CAP_TX_TIMEOUT)
+        {
+            return -1;
+        }
+        OTA_Poll();
+    }
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: CAP_Flush
+*    功能说明: 等待上一块发送完毕后把缓存的数据写入串口发送缓冲区。发送缓冲区中DMA正在读取的部分也算作
+*              空闲，只在串口空闲时写入，避免覆盖正在发送的数据
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CAP_Flush(void)
+{
+    if (s_tOut.len == 0)
+    {
+        return;
+    }
+    if (s_tOut.ret == 0 && CAP_WaitTx() != 0)
+    {
+        s_tOut.ret = -1;
+    }
+    if (s_tOut.ret == 0)
+    {
+        comSendBuf(CAP_COM, s_tOut.buf, s_tOut.len);
+    }
+    s_tOut.len = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: CAP_Put
+*    功能说明: 写入数据，缓存满 CAP_CHUNK 字节发送一次
+*    形    参: _pBuf : 数据
+*              _usLen : 字节数，不大于 CAP_CHUNK
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CAP_Put(const void *_pBuf, uint16_t _usLen)
+{
+    if (s_tOut.len + _usLen > CAP_CHUNK)
+    {
+        CAP_Flush();
+    }
+    memcpy(&s_tOut.buf[s_tOut.len], _pBuf, _usLen);
+    s_tOut.len += _usLen;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: CAP_Packet
+*    功能说明: 写入一个RLE包，同时累计压缩数据的字节数和CRC32
+*    形    参: _ucHead : 包头
+*              _pPix : 像素
+*              _usNum : 像素个数，1 - 128
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CAP_Packet(uint8_t _ucHead, const uint16_t *_pPix, uint16_t _usNum)
+{
+    CAP_Put(&_ucHead, 1);
+    CAP_Put(_pPix, _usNum * 2);
+    s_tOut.crc = CRC32_Update(s_tOut.crc, &_ucHead, 1);
+    s_tOut.crc = CRC32_Update(s_tOut.crc, (const uint8_t *)_pPix, _usNum * 2);
+    s_tOut.size += 1 + _usNum * 2;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: CAP_EncodeLine
+*    功能说明: RLE压缩一行像素。2个以上相同的像素编码为重复包，其余的连续像素编码为原样包
+*    形    参: _pPix : 像素
+*              _usNum : 像素个数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void CAP_EncodeLine(const uint16_t *_pPix, uint16_t _usNum)
+{
+    uint16_t i = 0, n;
+
+    while (i < _usNum)
+    {
+        n = 1;
+        while (i + n < _usNum && n < 128 && _pPix[i + n] == _pPix[i])
+        {
+            n++;
+        }
+        if (n >= 2)
+        {
+            CAP_Packet(0x80 | (n - 1), &_pPix[i], 1);
+            i += n;
+            continue;
+        }
+
+        /* 原样包到下一段重复像素之前结束 */
+        while (i + n < _usNum && n < 128 && !(i + n + 1 < _usNum && _pPix[i + n] == _pPix[i + n + 1]))
+        {
+            n++;
+        }
+        CAP_Packet(n - 1, &_pPix[i], n);
+        i += n;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_Capture
+*    功能说明: 截取正在显示的画面，缩小、压缩后从 CAP_COM 发送。先以当前波特率回复
+*              "CAPTURE READY <baud> <w> <h>"，切换波特率 CAP_SWITCH_TIME 后发送头部、压缩数据和尾部，
+*              切回原来的波特率后回复 "CAPTURE OK" 或 "CAPTURE ERROR"
+*    形    参: _scale : 缩小倍数，1 - 8
+*              _baud : 发送的波特率，0 表示不切换
+*    返 回 值: 0 表示成功，其它表示失败
+*********************************************************************************************************
+*/
+int TFT_Capture(uint8_t _scale, uint32_t _baud)
+{
+    CAP_HEAD_T head;
+    CAP_TAIL_T tail;
+    GFX_SURFACE_T lcd, shot;
+    uint32_t baud = CAP_HUART.Init.BaudRate;
+    uint32_t size, start;
+    uint16_t *buf, *p;
+    uint16_t x, y;
+
+    if (_scale == 0 || _scale > 8)
+    {
+        printf("CAPTURE ERROR scale\r\n");
+        return -1;
+    }
+    if (_baud == 0)
+    {
+        _baud = baud;
+    }
+
+    /* 第1层的画布就是整个面板 */
+    TFT_GetLayer(0, &lcd);
+    size = ((uint32_t)lcd.width * lcd.height * 2 + 31) & ~31UL;
+    buf = Mem_AllocAlign(MEM_SDRAM, size, 32);
+    if (buf == NULL)
+    {
+        printf("CAPTURE ERROR memory\r\n");
+        return -1;
+    }
+    GFX_InitSurface(&shot, (uint32_t)buf, lcd.width, lcd.height, GFX_RGB565);
+    start = HAL_GetTick();
+    if (TFT_Snapshot(&shot) != 0)
+    {
+        Mem_Free(buf);
+        printf("CAPTURE ERROR lcd\r\n");
+        return -1;
+    }
+
+    memset(&head, 0, sizeof(head));
+    head.magic = CAP_MAGIC;
+    head.width = lcd.width / _scale;
+    head.height = lcd.height / _scale;
+    head.format = GFX_RGB565;
+    head.scale = _scale;
+    head.panel_w = lcd.width;
+    head.panel_h = lcd.height;
+
+    printf("CAPTURE READY %u %d %d\r\n", (unsigned)_baud, head.width, head.height);
+    if (CAP_WaitTx() != 0)
+    {
+        /* 回复没有发完，不能切换波特率 */
+        Mem_Free(buf);
+        printf("CAPTURE ERROR uart\r\n");
+        return -1;
+    }
+    if (_baud != baud)
+    {
+        comSetBaud(CAP_COM, _baud);
+        HAL_Delay(CAP_SWITCH_TIME);
+    }
+
+    memset(&s_tOut, 0, sizeof(s_tOut));
+    CAP_Put(&head, sizeof(head));
+    for (y = 0; y < head.height && s_tOut.ret == 0; y++)
+    {
+        /* 缩小时就地取样，临时图像不再使用 */
+        p = buf + (uint32_t)y * _scale * lcd.width;
+        for (x = 1; x < head.width && _scale > 1; x++)
+        {
+            p[x] = p[x * _scale];
+        }
+        CAP_EncodeLine(p, head.width);
+    }
+    tail.size = s_tOut.size;
+    tail.crc = s_tOut.crc;
+    CAP_Put(&tail, sizeof(tail));
+    CAP_Flush();
+    Mem_Free(buf);
+
+    CAP_WaitTx();
+    if (_baud != baud)
+    {
+        comSetBaud(CAP_COM, baud);
+        HAL_Delay(CAP_SWITCH_TIME);
+    }
+
+    if (s_tOut.ret != 0)
+    {
+        printf("CAPTURE ERROR timeout\r\n");
+        return -1;
+    }
+    printf("CAPTURE OK %u bytes (%u%%) %u ms\r\n", (unsigned)(sizeof(head) + tail.size + sizeof(tail)),
+           (unsigned)(tail.size * 100 / (head.width * head.height * 2)), (unsigned)(HAL_GetTick() - start));
+
+    return 0;
+}
+
+/***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
@@ -76,6 +76,70 @@
 #include "bsp_fmc_sdram.h"
 
 /* 私有类型定义 --------------------------------------------------------------*/
+/*
+    每层的交换链。显存按 front、已提交的 queued 帧、后台缓冲区 的顺序循环使用:
+    正在显示 buf[front]，绘图用 buf[(front + queued + 1) % num]
+*/
+typedef struct
+{
+    uint32_t buf[TFT_BUF_MAX];   /* 显存地址，buf[0]是该层固定的显存，其余从SDRAM堆分配 */
+    uint16_t fence[TFT_BUF_MAX]; /* 提交时的DMA2D栅栏，绘图命令完成后才显示 */
+    uint32_t offset;             /* 显示窗口第一个像素相对显存首地址的偏移，字节 */
+    uint8_t num;                 /* 显存个数，1表示不使用交换链 */
+    volatile uint8_t front;      /* 正在显示的显存 */
+    volatile uint8_t queued;     /* 已提交还未显示的帧数 */
+    volatile uint8_t flip;       /* 1表示新地址已写入影子寄存器，等待垂直消隐期重载 */
+
+    /* 帧间隔统计，单位us */
+    volatile uint32_t frames; /* 已显示的帧数 */
+    volatile int64_t last;    /* 上一次翻转的时刻，ticks，0表示重新开始统计 */
+    volatile uint32_t min;
+    volatile uint32_t max;
+    volatile uint64_t sum;
+    volatile uint64_t sum2; /* 平方和，用于计算抖动(标准差) */
+} TFT_CHAIN_T;
+
+/*
+    每层的画布。绘图按画布进行，LTDC窗口可以缩小到画布中有内容的部分，只读取窗口内的像素，
+    每行像素数(ImageWidth)不变
+*/
+typedef struct
+{
+    uint16_t x, y;       /* 画布在面板上的位置 */
+    uint16_t w, h;       /* 画布的宽度和高度 */
+    uint32_t clut[256];  /* L8 / AL44 / AL88 的颜色表 */
+    uint16_t clut_num;   /* 颜色表项数，0表示没有设置 */
+} TFT_LAYER_T;
+
+/* 合并后的矩形列表，坐标为 [x0, x1) x [y0, y1) */
+typedef struct
+{
+    int16_t x0, y0, x1, y1;
+} TFT_BOX_T;
+
+typedef struct
+{
+    TFT_BOX_T box[TFT_DIRTY_MAX];
+    uint8_t num;
+} TFT_REGION_T;
+
+/*
+    每层的脏区域。dirty 是本帧重画的区域，stale[i] 是 buf[i] 与最新一帧内容不同的区域。
+    取后台缓冲区时用DMA2D从最新一帧拷贝 stale 中本帧不重画的部分，提交时 dirty 并入其它显存的 stale
+*/
+typedef struct
+{
+    TFT_REGION_T dirty;
+    TFT_REGION_T stale[TFT_BUF_MAX];
+    uint8_t synced; /* 本帧的后台缓冲区已同步 */
+
+    /* 统计，单位像素 */
+    uint32_t frames;
+    uint64_t drawn;  /* 重画的像素 */
+    uint64_t copied; /* 同步拷贝的像素 */
+    uint32_t last_drawn;
+    uint32_t last_copied;
+} TFT_DIRTY_T;
 
 /* 私有宏定义 ----------------------------------------------------------------*/
 #undef THIS
@@ -88,22 +152,45 @@
 
 #define LCD_FRAME_BUFFER SDRAM_LCD_BUF1
 
+/* 在有效显示区结束前多少行检查是否翻转。中断延迟超过这个时间时推迟一帧翻转，不会撕裂 */
+#define TFT_LINE_MARGIN 16
+
+#define TFT_PANEL_NUM (sizeof(lcd_cfg_list) / sizeof(lcd_cfg_list[0]))
+#define TFT_PANEL_KEY "tft.panel" /* KV参数区保存面板序号的键名 */
+
+/* PLL3: HSE / 5 = 5MHz 输入(4-8MHz)，VCO 宽范围 192-960MHz，LTDC时钟 = VCO / R */
+#define TFT_PLL3_M 5
+#define TFT_VCO_MIN 192000 /* kHz */
+#define TFT_VCO_MAX 960000
+
 /* 私有变量 ------------------------------------------------------------------*/
 static LTDC_HandleTypeDef hltdc = {0};
 static uint8_t lcd_type = 0;
+static const uint32_t s_uiLayerBuf[2] = {SDRAM_LCD_BUF1, SDRAM_LCD_BUF2};
+FAST_BSS static TFT_CHAIN_T s_tChain[2];
+FAST_BSS static volatile uint32_t s_uiVSync;    /* 帧计数，每帧行中断加1 */
+FAST_BSS static volatile uint32_t s_uiUnderrun; /* 发生FIFO下溢的帧数，SDRAM带宽不足 */
+FAST_BSS static volatile uint8_t s_ucUnderrun;
+FAST_BSS static TFT_FRAME_CB s_pFrameCb;
+static TFT_DIRTY_T s_tDirty[2];
+static TFT_LAYER_T s_tLayer[2];
 const tft_cfg_t lcd_cfg_list[] = {
-    {"LCD7.0 1024X600 48MHz", 1024, 600, 20, 3, 140, 20, 160, 12}, // PLL3 M5 N192 P*2 Q20 R20 =48M
-    {"LCD4.3 480X272 10MHz", 480, 272, 1, 1, 40, 8, 5, 8},         // PLL3 M5 N192 P*2 Q20 R96 =10M
-    {"LCD7.0 800X480 20MHz", 800, 480, 1, 1, 46, 23, 210, 22},     // PLL3 M5 N192 P*2 Q20 R48 =20M
-    {"LCD7.0 800X480 30MHz", 800, 480, 88, 40, 48, 32, 13, 3},     // PLL3 M5 N192 P*2 Q20 R32 =30M
-    {"LCD10.0 1280X800 48MHz", 1280, 800, 140, 10, 10, 10, 10, 3}  // PLL3 M5 N192 P*2 Q20 R20 =48M
+    {"LCD7.0 1024X600 48MHz", 1024, 600, 20, 3, 140, 20, 160, 12, 48000},
+    {"LCD4.3 480X272 10MHz", 480, 272, 1, 1, 40, 8, 5, 8, 10000},
+    {"LCD7.0 800X480 20MHz", 800, 480, 1, 1, 46, 23, 210, 22, 20000},
+    {"LCD7.0 800X480 30MHz", 800, 480, 88, 40, 48, 32, 13, 3, 30000},
+    {"LCD10.0 1280X800 48MHz", 1280, 800, 140, 10, 10, 10, 10, 3, 48000}
 
 };
+static RCC_PLL3InitTypeDef s_tPll3; /* 当前的PLL3分频系数 */
+static uint32_t s_uiPclk;           /* 实际的像素时钟，kHz */
 
 /* 扩展变量 ------------------------------------------------------------------*/
 
 /* 私有函数原形 --------------------------------------------------------------*/
 static void MX_LTDC_Init(void);
+static void TFT_FreeBuffers(TFT_CHAIN_T *_pChain);
+static void TFT_ResetDirty(uint8_t _layer);
 
 /* 函数体 --------------------------------------------------------------------*/
 
@@ -116,7 +203,6 @@ static void MX_LTDC_Init(void);
 void HAL_LTDC_MspInit(LTDC_HandleTypeDef *hltdc)
 {
     GPIO_InitTypeDef GPIO_InitStruct = {0};
-    RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
     if (hltdc->Instance == LTDC)
     {
         /* USER CODE BEGIN LTDC_MspInit 0 */
@@ -125,19 +211,7 @@ void HAL_LTDC_MspInit(LTDC_HandleTypeDef *hltdc)
 
         /** Initializes the peripherals clock
          */
-        PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_LTDC;
-        PeriphClkInitStruct.PLL3.PLL3M = 5;
-        PeriphClkInitStruct.PLL3.PLL3N = 192;
-        PeriphClkInitStruct.PLL3.PLL3P = 2;
-        PeriphClkInitStruct.PLL3.PLL3Q = 20;
-        PeriphClkInitStruct.PLL3.PLL3R = 20;
-        PeriphClkInitStruct.PLL3.PLL3RGE = RCC_PLL3VCIRANGE_2;
-        PeriphClkInitStruct.PLL3.PLL3VCOSEL = RCC_PLL3VCOWIDE;
-        PeriphClkInitStruct.PLL3.PLL3FRACN = 0;
-        if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK)
-        {
-            ERROR_HANDLER();
-        }
+        bsp_ltdc_clk(THIS.pclk);
 
         /* Peripheral clock enable */
         __HAL_RCC_LTDC_CLK_ENABLE();
@@ -301,18 +375,19 @@ static void MX_LTDC_Init(void)
         ERROR_HANDLER();
     }
 
+    /* 第0层全屏，每行像素数等于面板宽度，交换链的每个显存不超过 2MB */
     pLayerCfg.WindowX0 = 0;
-    pLayerCfg.WindowX1 = 300;
+    pLayerCfg.WindowX1 = THIS.pwidth;
     pLayerCfg.WindowY0 = 0;
-    pLayerCfg.WindowY1 = 200;
+    pLayerCfg.WindowY1 = THIS.pheight;
     pLayerCfg.PixelFormat = LTDC_PIXEL_FORMAT_RGB565;
     pLayerCfg.Alpha = 255;
     pLayerCfg.Alpha0 = 0;
     pLayerCfg.BlendingFactor1 = LTDC_BLENDING_FACTOR1_PAxCA;
     pLayerCfg.BlendingFactor2 = LTDC_BLENDING_FACTOR2_PAxCA;
     pLayerCfg.FBStartAdress = SDRAM_LCD_BUF1;
-    pLayerCfg.ImageWidth = 1024;
-    pLayerCfg.ImageHeight = 600;
+    pLayerCfg.ImageWidth = THIS.pwidth;
+    pLayerCfg.ImageHeight = THIS.pheight;
     pLayerCfg.Backcolor.Blue = 0;
     pLayerCfg.Backcolor.Green = 0;
     pLayerCfg.Backcolor.Red = 0;
@@ -321,18 +396,19 @@ static void MX_LTDC_Init(void)
         ERROR_HANDLER();
     }
 
-    pLayerCfg1.WindowX0 = 200;
-    pLayerCfg1.WindowX1 = 600;
-    pLayerCfg1.WindowY0 = 200;
-    pLayerCfg1.WindowY1 = 600;
+    /* 第1层居中，宽高为面板的一半，每行像素数等于窗口宽度 */
+    pLayerCfg1.WindowX0 = THIS.pwidth / 4;
+    pLayerCfg1.WindowX1 = THIS.pwidth / 4 + THIS.pwidth / 2;
+    pLayerCfg1.WindowY0 = THIS.pheight / 4;
+    pLayerCfg1.WindowY1 = THIS.pheight / 4 + THIS.pheight / 2;
     pLayerCfg1.PixelFormat = LTDC_PIXEL_FORMAT_RGB565;
     pLayerCfg1.Alpha = 255;
     pLayerCfg1.Alpha0 = 0;
     pLayerCfg1.BlendingFactor1 = LTDC_BLENDING_FACTOR1_PAxCA;
     pLayerCfg1.BlendingFactor2 = LTDC_BLENDING_FACTOR2_PAxCA;
     pLayerCfg1.FBStartAdress = SDRAM_LCD_BUF2;
-    pLayerCfg1.ImageWidth = 1024;
-    pLayerCfg1.ImageHeight = 600;
+    pLayerCfg1.ImageWidth = THIS.pwidth / 2;
+    pLayerCfg1.ImageHeight = THIS.pheight / 2;
     pLayerCfg1.Backcolor.Blue = 0;
     pLayerCfg1.Backcolor.Green = 0;
     pLayerCfg1.Backcolor.Red = 0;
@@ -349,34 +425,51 @@ static void MX_LTDC_Init(void)
 /*
 *********************************************************************************************************
 *    函 数 名: bsp_ltdc_clk
-*    功能说明: 设置 LTDC 时钟
-*    形    参: 无
-*    返 回 值: 无
+*    功能说明: 设置 LTDC 时钟。PLL3输入固定为5MHz，搜索 N 和 R 使输出最接近需要的像素时钟，
+*              相同误差时用较低的VCO频率。PLL3Q 尽量保持 48MHz
+*    形    参: _khz : 像素时钟，kHz
+*    返 回 值: 实际的像素时钟，kHz
 *********************************************************************************************************
 */
-void bsp_ltdc_clk(uint16_t _clk)
+uint32_t bsp_ltdc_clk(uint32_t _khz)
 {
-    /* LCD 时钟配置 */
-    /* PLL3_VCO Input       = HSE_VALUE / PLL3M         = 25MHz / 5 = 5MHz */
-    /* PLL3_VCO Output      = PLL3_VCO Input * PLL3N    = 5MHz * 192 = 960MHz */
-    /* PLLLCDCLK            = PLL3_VCO Output / PLL3R   = 960MHz / 20 = 48MHz */
-    /* LTDC clock frequency = PLLLCDCLK                 = 48MHz */
-    /* 当前这个配置方便用户使用 PLL3Q 输出的 48MHz 时钟供 USB使用 */
     RCC_PeriphCLKInitTypeDef PeriphClkInitStruct = {0};
-    /* Initializes the peripherals clock */
+    uint32_t ref = HSE_VALUE / 1000 / TFT_PLL3_M;
+    uint32_t n, q, r, vco, out, err, best_err = 0xFFFFFFFF;
+
+    for (n = (TFT_VCO_MIN + ref - 1) / ref; n * ref <= TFT_VCO_MAX && best_err != 0; n++)
+    {
+        vco = n * ref;
+        r = (vco + _khz / 2) / _khz;
+        r = (r < 1) ? 1 : ((r > 128) ? 128 : r);
+        out = vco / r;
+        err = (out > _khz) ? out - _khz : _khz - out;
+        if (err < best_err)
+        {
+            best_err = err;
+            s_uiPclk = out;
+            s_tPll3.PLL3N = n;
+            s_tPll3.PLL3R = r;
+        }
+    }
+
+    vco = s_tPll3.PLL3N * ref;
+    s_tPll3.PLL3M = TFT_PLL3_M;
+    s_tPll3.PLL3P = 2;
+    q = (vco + 24000) / 48000;
+    s_tPll3.PLL3Q = (q < 1) ? 1 : ((q > 128) ? 128 : q);
+    s_tPll3.PLL3RGE = RCC_PLL3VCIRANGE_2;
+    s_tPll3.PLL3VCOSEL = RCC_PLL3VCOWIDE;
+    s_tPll3.PLL3FRACN = 0;
+
     PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_LTDC;
-    PeriphClkInitStruct.PLL3.PLL3M = 5;
-    PeriphClkInitStruct.PLL3.PLL3N = 192;
-    PeriphClkInitStruct.PLL3.PLL3P = 2;
-    PeriphClkInitStruct.PLL3.PLL3Q = 20;
-    PeriphClkInitStruct.PLL3.PLL3R = 20;
-    PeriphClkInitStruct.PLL3.PLL3RGE = RCC_PLL3VCIRANGE_2;
-    PeriphClkInitStruct.PLL3.PLL3VCOSEL = RCC_PLL3VCOWIDE;
-    PeriphClkInitStruct.PLL3.PLL3FRACN = 0;
+    PeriphClkInitStruct.PLL3 = s_tPll3;
     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK)
     {
         ERROR_HANDLER();
     }
+
+    return s_uiPclk;
 }
 
 /*
@@ -389,7 +482,35 @@ void bsp_ltdc_clk(uint16_t _clk)
 */
 void bsp_InitTFT(void)
 {
+    uint8_t i;
+
+    /* 重新初始化时释放交换链的显存 */
+    for (i = 0; i < 2; i++)
+    {
+        TFT_FreeBuffers(&s_tChain[i]);
+        s_tChain[i].buf[0] = s_uiLayerBuf[i];
+    }
+
     MX_LTDC_Init();
+    for (i = 0; i < 2; i++)
+    {
+        s_tLayer[i].x = hltdc.LayerCfg[i].WindowX0;
+        s_tLayer[i].y = hltdc.LayerCfg[i].WindowY0;
+        s_tLayer[i].w = hltdc.LayerCfg[i].WindowX1 - hltdc.LayerCfg[i].WindowX0;
+        s_tLayer[i].h = hltdc.LayerCfg[i].WindowY1 - hltdc.LayerCfg[i].WindowY0;
+        s_tLayer[i].clut_num = 0;
+        s_tChain[i].offset = 0;
+        TFT_ResetDirty(i);
+    }
+
+    /* 行中断用于翻转和统计帧率，FIFO下溢和传输错误中断用于统计 */
+    HAL_NVIC_SetPriority(LTDC_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(LTDC_IRQn);
+    HAL_NVIC_SetPriority(LTDC_ER_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(LTDC_ER_IRQn);
+    __HAL_LTDC_ENABLE_IT(&hltdc, LTDC_IT_FU | LTDC_IT_TE);
+    HAL_LTDC_ProgramLineEvent(&hltdc, hltdc.Init.AccumulatedActiveH - TFT_LINE_MARGIN);
+
     bsp_SetTIMOutPWM(GPIOA, GPIO_PIN_8, TIM1, 1, 20000, (50 * 10000) / 255);
 }
 
@@ -406,6 +527,76 @@ char *TFT_GetDescribe(void)
     return THIS.name;
 }
 
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetPanel
+*    功能说明: 选择面板并重新初始化LTDC，按面板计算PLL3分频和层的大小，交换链恢复为单缓冲
+*    形    参: _type : lcd_cfg_list 的序号
+*    返 回 值: 0 表示成功，-1 表示序号错误
+*********************************************************************************************************
+*/
+int TFT_SetPanel(uint8_t _type)
+{
+    if (_type >= TFT_PANEL_NUM)
+    {
+        return -1;
+    }
+
+    if (hltdc.State != HAL_LTDC_STATE_RESET)
+    {
+        while (s_tChain[0].queued || s_tChain[1].queued)
+        {
+        }
+        HAL_LTDC_DeInit(&hltdc); /* 下次初始化时在 HAL_LTDC_MspInit 中重新设置时钟 */
+    }
+
+    lcd_type = _type;
+    bsp_InitTFT();
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_GetPanel
+*    功能说明: 读取当前面板的序号
+*    形    参: 无
+*    返 回 值: lcd_cfg_list 的序号
+*********************************************************************************************************
+*/
+uint8_t TFT_GetPanel(void)
+{
+    return lcd_type;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SavePanel
+*    功能说明: 当前面板序号保存到KV参数区，下次上电由 TFT_LoadPanel 加载
+*    形    参: 无
+*    返 回 值: 0 表示成功
+*********************************************************************************************************
+*/
+int TFT_SavePanel(void)
+{
+    return KV_SetU32(TFT_PANEL_KEY, lcd_type);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_LoadPanel
+*    功能说明: 加载KV参数区保存的面板序号，没有保存或序号无效时使用第0个面板。
+*              需在 bsp_InitKV 之后、bsp_InitTFT 之前调用
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_LoadPanel(void)
+{
+    uint32_t type = KV_GetU32(TFT_PANEL_KEY, 0);
+
+    lcd_type = (type < TFT_PANEL_NUM) ? type : 0;
+}
+
 /*
 *********************************************************************************************************
 *    函 数 名: TFT_DispOn
@@ -430,68 +621,1377 @@ void TFT_DispOff(void)
 {
 }
 
-#if defined(__SHELL_H__) && defined(DEBUG_MODE)
-static int _cmd(int argc, char *argv[])
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_GetLayer
+*    功能说明: 读取LTDC层的显存描述，用于 bsp_gfx.c 的绘图函数
+*    形    参: _layer : 0 或 1
+*              _pSurf : 返回画布的地址、大小、每行像素数、像素格式和颜色表
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_GetLayer(uint8_t _layer, GFX_SURFACE_T *_pSurf)
 {
-    const char *help_info[] = {"set init/deinit",
-                               "test 1/2"};
-    if (argc < 2)
+    LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[_layer & 1];
+    TFT_LAYER_T *l = &s_tLayer[_layer & 1];
+
+    /* LTDC与DMA2D的像素格式编码相同。窗口缩小时显存地址减去偏移即为画布的首地址 */
+    GFX_InitSurface(_pSurf, cfg->FBStartAdress - s_tChain[_layer & 1].offset, l->w, l->h,
+                    (GFX_FMT_E)cfg->PixelFormat);
+    _pSurf->pitch = cfg->ImageWidth;
+    if (cfg->PixelFormat == LTDC_PIXEL_FORMAT_L8 || cfg->PixelFormat == LTDC_PIXEL_FORMAT_AL44 ||
+        cfg->PixelFormat == LTDC_PIXEL_FORMAT_AL88)
     {
-        printf("Error:Missing command parameters.\r\nUsage:\r\n");
-        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        _pSurf->clut = l->clut;
+        _pSurf->clut_num = l->clut_num;
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_FreeBuffers
+*    功能说明: 释放交换链从SDRAM堆分配的显存，只保留 buf[0]
+*    形    参: _pChain : 交换链
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void TFT_FreeBuffers(TFT_CHAIN_T *_pChain)
+{
+    uint8_t i;
+
+    for (i = 1; i < _pChain->num; i++)
+    {
+        Mem_Free((void *)_pChain->buf[i]);
+        _pChain->buf[i] = 0;
+    }
+    _pChain->num = 1;
+    _pChain->front = 0;
+    _pChain->queued = 0;
+    _pChain->flip = 0;
+}
+
+/* 矩形面积，空矩形为0 */
+static uint32_t TFT_BoxArea(const TFT_BOX_T *_pBox)
+{
+    return (uint32_t)(_pBox->x1 - _pBox->x0) * (uint32_t)(_pBox->y1 - _pBox->y0);
+}
+
+/* _pIn 是否完全在 _pOut 内 */
+static uint8_t TFT_BoxInside(const TFT_BOX_T *_pIn, const TFT_BOX_T *_pOut)
+{
+    return _pIn->x0 >= _pOut->x0 && _pIn->y0 >= _pOut->y0 && _pIn->x1 <= _pOut->x1 && _pIn->y1 <= _pOut->y1;
+}
+
+/* 包含两个矩形的最小矩形 */
+static TFT_BOX_T TFT_BoxUnion(const TFT_BOX_T *_pA, const TFT_BOX_T *_pB)
+{
+    TFT_BOX_T u;
+
+    u.x0 = (_pA->x0 < _pB->x0) ? _pA->x0 : _pB->x0;
+    u.y0 = (_pA->y0 < _pB->y0) ? _pA->y0 : _pB->y0;
+    u.x1 = (_pA->x1 > _pB->x1) ? _pA->x1 : _pB->x1;
+    u.y1 = (_pA->y1 > _pB->y1) ? _pA->y1 : _pB->y1;
+    return u;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_RegionAdd
+*    功能说明: 矩形加入区域。合并后的外接矩形不大于两者面积之和(相交或相邻)时合并，
+*              列表满时与外接矩形增加面积最少的一个合并，合并后的矩形再与其它矩形比较
+*    形    参: _pRgn : 区域
+*              _box : 矩形，不能为空
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void TFT_RegionAdd(TFT_REGION_T *_pRgn, TFT_BOX_T _box)
+{
+    TFT_BOX_T u;
+    uint32_t cost, best_cost;
+    uint8_t i, best;
+
+    for (;;)
+    {
+        best = _pRgn->num;
+        best_cost = 0xFFFFFFFF;
+        for (i = 0; i < _pRgn->num; i++)
         {
-            printf("%s ", argv[0]);
-            printf("%s\r\n", help_info[i]);
+            if (TFT_BoxInside(&_box, &_pRgn->box[i]))
+            {
+                return;
+            }
+
+            u = TFT_BoxUnion(&_box, &_pRgn->box[i]);
+            cost = TFT_BoxArea(&u);
+            cost = (cost > TFT_BoxArea(&_box) + TFT_BoxArea(&_pRgn->box[i])) ? cost - TFT_BoxArea(&_box) - TFT_BoxArea(&_pRgn->box[i]) : 0;
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best = i;
+            }
         }
-        printf("\r\n");
-        return -1;
+
+        if (best == _pRgn->num || (best_cost > 0 && _pRgn->num < TFT_DIRTY_MAX))
+        {
+            _pRgn->box[_pRgn->num++] = _box;
+            return;
+        }
+
+        /* 合并后从列表中取出，重新加入 */
+        _box = TFT_BoxUnion(&_box, &_pRgn->box[best]);
+        _pRgn->box[best] = _pRgn->box[--_pRgn->num];
     }
+}
 
-    if (strcmp(argv[1], "set") == 0)
+/* 整个画布 */
+static TFT_BOX_T TFT_LayerBox(uint8_t _layer)
+{
+    TFT_BOX_T box = {0, 0, 0, 0};
+
+    box.x1 = s_tLayer[_layer].w;
+    box.y1 = s_tLayer[_layer].h;
+    return box;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_ResetDirty
+*    功能说明: 清除脏区域和统计，buf[1]以后的显存全部标记为过时
+*    形    参: _layer : 0 或 1
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void TFT_ResetDirty(uint8_t _layer)
+{
+    TFT_DIRTY_T *d = &s_tDirty[_layer];
+    uint8_t i;
+
+    memset(d, 0, sizeof(TFT_DIRTY_T));
+    for (i = 1; i < s_tChain[_layer].num; i++)
     {
-        if (argc < 3)
+        TFT_RegionAdd(&d->stale[i], TFT_LayerBox(_layer));
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SyncBackBuffer
+*    功能说明: 从最新一帧拷贝后台缓冲区过时的区域，本帧重画的区域不拷贝。DMA2D按顺序执行命令，
+*              最新一帧的绘图命令完成后才拷贝，不用等待
+*    形    参: _layer : 0 或 1
+*              _pSurf : 后台缓冲区
+*              _back : 后台缓冲区序号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void TFT_SyncBackBuffer(uint8_t _layer, const GFX_SURFACE_T *_pSurf, uint8_t _back)
+{
+    TFT_CHAIN_T *c = &s_tChain[_layer];
+    TFT_DIRTY_T *d = &s_tDirty[_layer];
+    TFT_REGION_T *st = &d->stale[_back];
+    GFX_SURFACE_T src = *_pSurf;
+    TFT_BOX_T *b;
+    uint8_t i, k;
+
+    if (c->num == 1 || d->synced)
+    {
+        return;
+    }
+    d->synced = 1;
+
+    src.addr = c->buf[(_back + c->num - 1) % c->num];
+    for (i = 0; i < st->num; i++)
+    {
+        b = &st->box[i];
+        for (k = 0; k < d->dirty.num; k++)
         {
-            printf("Missing 'set' command parameters.\r\n");
-            printf("%s ", argv[0]);
-            printf("%s\r\n", help_info[0]);
-            return -1;
+            if (TFT_BoxInside(b, &d->dirty.box[k]))
+            {
+                break;
+            }
         }
-
-        if (strcmp(argv[2], "init") == 0)
+        if (k == d->dirty.num)
         {
-            bsp_InitTFT();
-            return 0;
+            GFX_Blit(_pSurf, b->x0, b->y0, &src, b->x0, b->y0, b->x1 - b->x0, b->y1 - b->y0);
+            d->last_copied += TFT_BoxArea(b);
         }
-        else if (strcmp(argv[2], "deinit") == 0)
+    }
+    st->num = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_CommitDirty
+*    功能说明: 提交时统计本帧重画和拷贝的像素，本帧的脏区域并入其它显存的过时区域
+*    形    参: _layer : 0 或 1
+*              _back : 提交的显存序号
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+static void TFT_CommitDirty(uint8_t _layer, uint8_t _back)
+{
+    TFT_DIRTY_T *d = &s_tDirty[_layer];
+    uint8_t i, k;
+
+    d->last_drawn = 0;
+    for (k = 0; k < d->dirty.num; k++)
+    {
+        d->last_drawn += TFT_BoxArea(&d->dirty.box[k]);
+        for (i = 0; i < s_tChain[_layer].num; i++)
         {
-            if (hltdc.State == HAL_LTDC_STATE_RESET)
+            if (i != _back)
             {
-                printf("Error:Do not repeatedly deinit LTDC.\r\n");
-                return -1;
+                TFT_RegionAdd(&d->stale[i], d->dirty.box[k]);
             }
+        }
+    }
 
-            return HAL_LTDC_DeInit(&hltdc);
+    d->frames++;
+    d->drawn += d->last_drawn;
+    d->copied += d->last_copied;
+    d->last_copied = 0;
+    d->dirty.num = 0;
+    d->synced = 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_Invalidate
+*    功能说明: 标记本帧要重画的区域，超出层的部分被裁掉。相交或相邻的矩形自动合并
+*    形    参: _layer : 0 或 1
+*              _x, _y, _w, _h : 矩形
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_Invalidate(uint8_t _layer, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h)
+{
+    TFT_BOX_T lay = TFT_LayerBox(_layer & 1);
+    TFT_BOX_T box;
+
+    box.x0 = (_x > 0) ? _x : 0;
+    box.y0 = (_y > 0) ? _y : 0;
+    box.x1 = (_x + _w < lay.x1) ? _x + _w : lay.x1;
+    box.y1 = (_y + _h < lay.y1) ? _y + _h : lay.y1;
+    if (box.x0 < box.x1 && box.y0 < box.y1)
+    {
+        TFT_RegionAdd(&s_tDirty[_layer & 1].dirty, box);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_GetDirty
+*    功能说明: 读取本帧合并后的脏区域，只在这些矩形内合成和绘图
+*    形    参: _layer : 0 或 1
+*              _pRect : 返回矩形
+*              _ucMax : _pRect 的个数，不超过 TFT_DIRTY_MAX 时可能读不全
+*    返 回 值: 矩形个数
+*********************************************************************************************************
+*/
+uint8_t TFT_GetDirty(uint8_t _layer, TFT_RECT_T *_pRect, uint8_t _ucMax)
+{
+    TFT_REGION_T *r = &s_tDirty[_layer & 1].dirty;
+    uint8_t i;
+
+    for (i = 0; i < r->num && i < _ucMax; i++)
+    {
+        _pRect[i].x = r->box[i].x0;
+        _pRect[i].y = r->box[i].y0;
+        _pRect[i].w = r->box[i].x1 - r->box[i].x0;
+        _pRect[i].h = r->box[i].y1 - r->box[i].y0;
+    }
+    return i;
+}
+
+/* 层是否使用颜色表 */
+static uint8_t TFT_IsClut(uint32_t _fmt)
+{
+    return _fmt == LTDC_PIXEL_FORMAT_L8 || _fmt == LTDC_PIXEL_FORMAT_AL44 || _fmt == LTDC_PIXEL_FORMAT_AL88;
+}
+
+/* 颜色表写入LTDC。在垂直消隐期写入，不会出现半帧旧颜色 */
+static void TFT_LoadClut(uint8_t _layer)
+{
+    TFT_LAYER_T *l = &s_tLayer[_layer];
+
+    TFT_WaitVSync();
+    HAL_LTDC_ConfigCLUT(&hltdc, l->clut, l->clut_num, _layer);
+    HAL_LTDC_EnableCLUT(&hltdc, _layer);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetLayerFormat
+*    功能说明: 修改层的像素格式，画布大小和位置不变，窗口恢复为整个画布，交换链恢复为单缓冲。
+*              L8 每像素1字节，AL44 为4位透明度+16色，用于界面叠加层时LTDC读取的数据量是RGB565的一半，
+*              ARGB4444 为16位带透明度。没有设置颜色表时 L8 / AL88 使用 RGB332 颜色表，AL44 使用16级灰度
+*    形    参: _layer : 0 或 1
+*              _fmt : GFX_ARGB8888 - GFX_AL88，LTDC支持的格式
+*    返 回 值: 0 表示成功，-1 表示格式错误或显存不够
+*********************************************************************************************************
+*/
+int TFT_SetLayerFormat(uint8_t _layer, GFX_FMT_E _fmt)
+{
+    LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[_layer & 1];
+    TFT_LAYER_T *l = &s_tLayer[_layer & 1];
+    uint16_t i;
+
+    if (_fmt > GFX_AL88 || hltdc.State == HAL_LTDC_STATE_RESET ||
+        (uint32_t)cfg->ImageWidth * l->h * GFX_BitsPerPixel(_fmt) / 8 > SDRAM_LCD_SIZE)
+    {
+        return -1;
+    }
+
+    TFT_SetBuffers(_layer & 1, 1);
+    TFT_SetLayerWindow(_layer & 1, 0, 0, l->w, l->h);
+    TFT_WaitVSync();
+
+    cfg->PixelFormat = _fmt;
+    HAL_LTDC_ConfigLayer(&hltdc, cfg, _layer & 1);
+    if (!TFT_IsClut(_fmt))
+    {
+        HAL_LTDC_DisableCLUT(&hltdc, _layer & 1);
+        return 0;
+    }
+
+    if (l->clut_num == 0)
+    {
+        if (_fmt == GFX_AL44)
+        {
+            for (i = 0; i < 16; i++)
+            {
+                l->clut[i] = GFX_RGB(i * 17, i * 17, i * 17);
+            }
+            l->clut_num = 16;
         }
         else
         {
-            printf("Invalid 'set' command parameter.\r\n");
-            printf("%s ", argv[0]);
-            printf("%s\r\n", help_info[0]);
-            return -1;
+            for (i = 0; i < 256; i++)
+            {
+                l->clut[i] = GFX_RGB((i >> 5) * 255 / 7, ((i >> 2) & 7) * 255 / 7, (i & 3) * 85);
+            }
+            l->clut_num = 256;
         }
     }
-    else if (strcmp(argv[1], "test") == 0)
-    {
-#if 0
-        if (argc < 3)
-        {
+    TFT_LoadClut(_layer & 1);
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetPalette
+*    功能说明: 设置层的颜色表，在下一个垂直消隐期写入LTDC。颜色表的透明度不使用，
+*              AL44 / AL88 的透明度来自像素
+*    形    参: _layer : 0 或 1
+*              _pArgb : ARGB8888颜色
+*              _usNum : 颜色个数，1-256，AL44只用前16个
+*    返 回 值: 0 表示成功，-1 表示参数错误
+*********************************************************************************************************
+*/
+int TFT_SetPalette(uint8_t _layer, const uint32_t *_pArgb, uint16_t _usNum)
+{
+    TFT_LAYER_T *l = &s_tLayer[_layer & 1];
+
+    if (_usNum == 0 || _usNum > 256)
+    {
+        return -1;
+    }
+
+    memcpy(l->clut, _pArgb, _usNum * 4);
+    l->clut_num = _usNum;
+    if (hltdc.State != HAL_LTDC_STATE_RESET && TFT_IsClut(hltdc.LayerCfg[_layer & 1].PixelFormat))
+    {
+        TFT_LoadClut(_layer & 1);
+    }
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetLayerWindow
+*    功能说明: LTDC窗口缩小到画布中有内容的矩形，窗口外显示下面的层或背景色，LTDC只读取窗口内的像素。
+*              每行像素数不变，显存地址加上矩形左上角的偏移，绘图仍按整个画布进行。
+*              在下一个垂直消隐期生效，交换链翻转时保持该偏移
+*    形    参: _layer : 0 或 1
+*              _x, _y, _w, _h : 相对画布的矩形，超出画布的部分被裁掉，宽或高为0时关闭该层
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_SetLayerWindow(uint8_t _layer, int16_t _x, int16_t _y, uint16_t _w, uint16_t _h)
+{
+    LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[_layer & 1];
+    TFT_LAYER_T *l = &s_tLayer[_layer & 1];
+    TFT_CHAIN_T *c = &s_tChain[_layer & 1];
+    int32_t x0 = _x, y0 = _y, x1 = _x + _w, y1 = _y + _h;
+    uint32_t primask, base;
+
+    if (hltdc.State == HAL_LTDC_STATE_RESET)
+    {
+        return;
+    }
+
+    x0 = (x0 > 0) ? x0 : 0;
+    y0 = (y0 > 0) ? y0 : 0;
+    x1 = (x1 < l->w) ? x1 : l->w;
+    y1 = (y1 < l->h) ? y1 : l->h;
+
+    /* 与翻转中断互斥，base 是正在显示或等待重载的显存 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (x0 >= x1 || y0 >= y1)
+    {
+        __HAL_LTDC_LAYER_DISABLE(&hltdc, _layer & 1);
+    }
+    else
+    {
+        base = cfg->FBStartAdress - c->offset;
+        c->offset = ((uint32_t)y0 * cfg->ImageWidth + x0) * GFX_BitsPerPixel((GFX_FMT_E)cfg->PixelFormat) / 8;
+        cfg->FBStartAdress = base + c->offset;
+        cfg->WindowX0 = l->x + x0;
+        cfg->WindowX1 = l->x + x1;
+        cfg->WindowY0 = l->y + y0;
+        cfg->WindowY1 = l->y + y1;
+        cfg->ImageHeight = y1 - y0;
+        HAL_LTDC_ConfigLayer_NoReload(&hltdc, cfg, _layer & 1);
+    }
+    HAL_LTDC_Reload(&hltdc, LTDC_RELOAD_VERTICAL_BLANKING);
+    __set_PRIMASK(primask);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_FitLayerWindow
+*    功能说明: CPU扫描正在显示的画布，窗口缩小到透明度不为0的像素的外接矩形，没有内容时关闭该层。
+*              没有透明度的格式使用整个画布。扫描半屏 AL44 画布约需1ms，画面改变后调用一次
+*    形    参: _layer : 0 或 1
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_FitLayerWindow(uint8_t _layer)
+{
+    LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[_layer & 1];
+    GFX_SURFACE_T lcd;
+    uint32_t mask, pix = 0;
+    int32_t x, y, x0, y0, x1 = -1, y1 = -1;
+    uint8_t bits;
+
+    switch (cfg->PixelFormat)
+    {
+    case LTDC_PIXEL_FORMAT_ARGB8888:
+        mask = 0xFF000000;
+        break;
+    case LTDC_PIXEL_FORMAT_ARGB1555:
+        mask = 0x8000;
+        break;
+    case LTDC_PIXEL_FORMAT_ARGB4444:
+        mask = 0xF000;
+        break;
+    case LTDC_PIXEL_FORMAT_AL44:
+        mask = 0xF0;
+        break;
+    case LTDC_PIXEL_FORMAT_AL88:
+        mask = 0xFF00;
+        break;
+    default:
+        TFT_SetLayerWindow(_layer, 0, 0, s_tLayer[_layer & 1].w, s_tLayer[_layer & 1].h);
+        return;
+    }
+
+    TFT_GetLayer(_layer, &lcd);
+    bits = GFX_BitsPerPixel((GFX_FMT_E)lcd.format);
+    x0 = lcd.width;
+    y0 = lcd.height;
+
+    /* DMA2D写入的数据可能还在Cache中有旧的副本 */
+    GFX_Wait();
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)(lcd.addr & ~31UL), (uint32_t)lcd.pitch * lcd.height * bits / 8 + 32);
+
+    for (y = 0; y < lcd.height; y++)
+    {
+        for (x = 0; x < lcd.width; x++)
+        {
+            switch (bits)
+            {
+            case 32:
+                pix = ((uint32_t *)lcd.addr)[y * lcd.pitch + x];
+                break;
+            case 16:
+                pix = ((uint16_t *)lcd.addr)[y * lcd.pitch + x];
+                break;
+            default:
+                pix = ((uint8_t *)lcd.addr)[y * lcd.pitch + x];
+                break;
+            }
+            if (pix & mask)
+            {
+                x0 = (x < x0) ? x : x0;
+                x1 = (x > x1) ? x : x1;
+                y0 = (y < y0) ? y : y0;
+                y1 = y;
+            }
+        }
+    }
+
+    if (y1 < 0)
+    {
+        TFT_SetLayerWindow(_layer, 0, 0, 0, 0);
+    }
+    else
+    {
+        TFT_SetLayerWindow(_layer, x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetBuffers
+*    功能说明: 设置层的显存个数。2为双缓冲，3为三缓冲，可以提前画一帧。buf[0]是该层固定的
+*              LCD显存(MPU写通)，其余按 ImageWidth x 画布高度 从SDRAM堆分配(写回Cache)，
+*              TFT_Present 时Clean D-Cache。
+*              等待已提交的帧显示完成后再修改，修改后显示 buf[0]
+*    形    参: _layer : 0 或 1
+*              _num : 显存个数，1 - TFT_BUF_MAX，1表示不使用交换链
+*    返 回 值: 0 表示成功，-1 表示参数错误或内存不足(保持单缓冲)
+*********************************************************************************************************
+*/
+int TFT_SetBuffers(uint8_t _layer, uint8_t _num)
+{
+    TFT_CHAIN_T *c = &s_tChain[_layer & 1];
+    LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[_layer & 1];
+    uint32_t size;
+    uint8_t i;
+
+    if (_num == 0 || _num > TFT_BUF_MAX || hltdc.State == HAL_LTDC_STATE_RESET)
+    {
+        return -1;
+    }
+
+    while (c->queued)
+    {
+    }
+
+    HAL_LTDC_SetAddress(&hltdc, c->buf[0] + c->offset, _layer & 1);
+    TFT_FreeBuffers(c);
+
+    size = (uint32_t)cfg->ImageWidth * s_tLayer[_layer & 1].h * GFX_BitsPerPixel((GFX_FMT_E)cfg->PixelFormat) / 8;
+    for (i = 1; i < _num; i++)
+    {
+        c->buf[i] = (uint32_t)Mem_AllocAlign(MEM_SDRAM, size, 64);
+        if (c->buf[i] == 0)
+        {
+            TFT_FreeBuffers(c);
+            return -1;
+        }
+        c->num = i + 1;
+    }
+
+    /* 新分配的显存内容不确定，第一次使用时从 buf[0] 拷贝 */
+    TFT_ResetDirty(_layer & 1);
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_BackBufferFree
+*    功能说明: 查询是否有空闲的后台缓冲区，不等待
+*    形    参: _layer : 0 或 1
+*    返 回 值: 1 表示 TFT_GetBackBuffer 不会等待
+*********************************************************************************************************
+*/
+uint8_t TFT_BackBufferFree(uint8_t _layer)
+{
+    TFT_CHAIN_T *c = &s_tChain[_layer & 1];
+
+    return (c->num == 1) || (c->queued + 1 < c->num);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_GetBackBuffer
+*    功能说明: 读取后台缓冲区，没有空闲的缓冲区时等待翻转(最长一帧)。
+*              单缓冲时返回正在显示的显存，与 TFT_GetLayer 相同。
+*              第一次调用时用DMA2D从最新一帧拷贝后台缓冲区过时的区域，已用 TFT_Invalidate
+*              标记为本帧重画的部分不拷贝，所以应先标记再读取后台缓冲区
+*    形    参: _layer : 0 或 1
+*              _pSurf : 返回后台缓冲区的描述
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_GetBackBuffer(uint8_t _layer, GFX_SURFACE_T *_pSurf)
+{
+    TFT_CHAIN_T *c = &s_tChain[_layer & 1];
+    uint32_t primask;
+    uint8_t back;
+
+    while (!TFT_BackBufferFree(_layer))
+    {
+    }
+
+    TFT_GetLayer(_layer, _pSurf);
+
+    /* 中断中 front 和 queued 同时修改，一起读取 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    back = (c->front + c->queued + 1) % c->num;
+    __set_PRIMASK(primask);
+
+    _pSurf->addr = c->buf[back];
+    TFT_SyncBackBuffer(_layer & 1, _pSurf, back);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_Present
+*    功能说明: 提交后台缓冲区，立即返回。之前提交的DMA2D绘图命令执行完后，在下一个垂直消隐期
+*              显示该帧，原来显示的缓冲区变为空闲，调用 TFT_SetFrameCallback 设置的回调函数。
+*              本帧 TFT_Invalidate 标记的区域并入其它显存的过时区域。单缓冲时只做统计
+*    形    参: _layer : 0 或 1
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_Present(uint8_t _layer)
+{
+    TFT_CHAIN_T *c = &s_tChain[_layer & 1];
+    uint32_t primask;
+    uint8_t back;
+
+    if (c->num == 1)
+    {
+        TFT_CommitDirty(_layer & 1, 0);
+        return;
+    }
+
+    /* 没有先调用 TFT_GetBackBuffer 时等待 */
+    while (!TFT_BackBufferFree(_layer))
+    {
+    }
+
+    /* CPU画在写回Cache的SDRAM中，全部Clean比按地址Clean一帧(几万行)快 */
+    SCB_CleanDCache();
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    back = (c->front + c->queued + 1) % c->num;
+    c->fence[back] = GFX_GetFence();
+    c->queued++;
+    __set_PRIMASK(primask);
+
+    TFT_CommitDirty(_layer & 1, back);
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_WaitVSync
+*    功能说明: 等待下一帧的垂直消隐期
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_WaitVSync(void)
+{
+    uint32_t vs = s_uiVSync;
+
+    while (vs == s_uiVSync)
+    {
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_GetStat
+*    功能说明: 读取累计的计数，两次读取的差值除以间隔即为帧率。tft fps 测试时会清零显示的帧数
+*    形    参: _layer : 0 或 1
+*              _pFrames : 该层交换链已显示的帧数
+*              _pVSync : 面板刷新的帧数
+*              _pUnderrun : 发生FIFO下溢的帧数
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_GetStat(uint8_t _layer, uint32_t *_pFrames, uint32_t *_pVSync, uint32_t *_pUnderrun)
+{
+    *_pFrames = s_tChain[_layer & 1].frames;
+    *_pVSync = s_uiVSync;
+    *_pUnderrun = s_uiUnderrun;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_Snapshot
+*    功能说明: 用DMA2D把正在显示的画面按LTDC的方式合成到 _pDst，不影响显示。先填充背景色，再依次混合
+*              两层窗口内的像素，整体透明度与LTDC相同。返回时DMA2D已完成，_pDst 的数据高速缓存已无效化
+*    形    参: _pDst : 目标图像，不小于面板分辨率，格式为 ARGB8888 / RGB888 / RGB565。
+*                      地址和大小按32字节对齐
+*    返 回 值: 0 表示成功，-1 表示LCD未初始化或目标图像太小
+*********************************************************************************************************
+*/
+int TFT_Snapshot(const GFX_SURFACE_T *_pDst)
+{
+    LTDC_LayerCfgTypeDef cfg[2];
+    GFX_SURFACE_T src;
+    uint32_t primask;
+    uint8_t on[2], i;
+
+    if (hltdc.State == HAL_LTDC_STATE_RESET || _pDst->width < THIS.pwidth || _pDst->height < THIS.pheight)
+    {
+        return -1;
+    }
+
+    /* 与翻转中断互斥，取同一时刻的显存地址和窗口 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (i = 0; i < 2; i++)
+    {
+        cfg[i] = hltdc.LayerCfg[i];
+        on[i] = (LTDC_LAYER(&hltdc, i)->CR & LTDC_LxCR_LEN) != 0;
+    }
+    __set_PRIMASK(primask);
+
+    GFX_FillRect(_pDst, 0, 0, THIS.pwidth, THIS.pheight,
+                 GFX_RGB(hltdc.Init.Backcolor.Red, hltdc.Init.Backcolor.Green, hltdc.Init.Backcolor.Blue));
+    for (i = 0; i < 2; i++)
+    {
+        if (!on[i])
+        {
+            continue;
+        }
+
+        /* FBStartAdress 是窗口左上角的像素 */
+        GFX_InitSurface(&src, cfg[i].FBStartAdress, cfg[i].WindowX1 - cfg[i].WindowX0,
+                        cfg[i].WindowY1 - cfg[i].WindowY0, (GFX_FMT_E)cfg[i].PixelFormat);
+        src.pitch = cfg[i].ImageWidth;
+        if (cfg[i].PixelFormat == LTDC_PIXEL_FORMAT_L8 || cfg[i].PixelFormat == LTDC_PIXEL_FORMAT_AL44 ||
+            cfg[i].PixelFormat == LTDC_PIXEL_FORMAT_AL88)
+        {
+            src.clut = s_tLayer[i].clut;
+            src.clut_num = s_tLayer[i].clut_num;
+        }
+        GFX_Blend(_pDst, cfg[i].WindowX0, cfg[i].WindowY0, &src, 0, 0, src.width, src.height, cfg[i].Alpha);
+    }
+    GFX_Wait();
+    SCB_InvalidateDCache_by_Addr((uint32_t *)_pDst->addr,
+                                 _pDst->pitch * _pDst->height * GFX_BitsPerPixel((GFX_FMT_E)_pDst->format) / 8);
+
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: TFT_SetFrameCallback
+*    功能说明: 设置翻转完成的回调函数，在LTDC中断中调用，参数为层号。此时上一帧的显存已空闲
+*    形    参: _cb : 回调函数，NULL表示不使用
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+void TFT_SetFrameCallback(TFT_FRAME_CB _cb)
+{
+    s_pFrameCb = _cb;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_LTDC_LineEventCallback
+*    功能说明: 有效显示区结束前的行中断。已提交的帧绘图完成时写入影子寄存器，垂直消隐期重载，
+*              本帧的剩余部分仍显示原来的显存，不会撕裂
+*    形    参: _hltdc : LTDC句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void HAL_LTDC_LineEventCallback(LTDC_HandleTypeDef *_hltdc)
+{
+    TFT_CHAIN_T *c;
+    uint8_t i, next, reload = 0;
+
+    s_uiVSync++;
+
+    for (i = 0; i < 2; i++)
+    {
+        c = &s_tChain[i];
+        if (c->num > 1 && c->queued && !c->flip)
+        {
+            next = (c->front + 1) % c->num;
+            if (GFX_FenceDone(c->fence[next]) &&
+                HAL_LTDC_SetAddress_NoReload(_hltdc, c->buf[next] + c->offset, i) == HAL_OK)
+            {
+                c->flip = 1;
+                reload = 1;
+            }
+        }
+    }
+
+    if (reload)
+    {
+        HAL_LTDC_Reload(_hltdc, LTDC_RELOAD_VERTICAL_BLANKING);
+    }
+
+    /* HAL在中断中关闭了行中断，每帧重新打开 */
+    HAL_LTDC_ProgramLineEvent(_hltdc, _hltdc->Init.AccumulatedActiveH - TFT_LINE_MARGIN);
+
+    /* FIFO下溢每帧最多统计一次 */
+    if (s_ucUnderrun)
+    {
+        s_ucUnderrun = 0;
+        __HAL_LTDC_ENABLE_IT(_hltdc, LTDC_IT_FU | LTDC_IT_TE);
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_LTDC_ReloadEventCallback
+*    功能说明: 垂直消隐期重载完成，新的帧开始显示，上一帧的显存空闲。统计帧间隔
+*    形    参: _hltdc : LTDC句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void HAL_LTDC_ReloadEventCallback(LTDC_HandleTypeDef *_hltdc)
+{
+    TFT_CHAIN_T *c;
+    int64_t now = get_system_ticks();
+    uint32_t us;
+    uint8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        c = &s_tChain[i];
+        if (!c->flip)
+        {
+            continue;
+        }
+
+        c->front = (c->front + 1) % c->num;
+        c->queued--;
+        c->flip = 0;
+        c->frames++;
+
+        if (c->last != 0)
+        {
+            us = (uint32_t)((now - c->last) / (SystemCoreClock / 1000000ul));
+            c->min = (us < c->min) ? us : c->min;
+            c->max = (us > c->max) ? us : c->max;
+            c->sum += us;
+            c->sum2 += (uint64_t)us * us;
+        }
+        c->last = now;
+
+        if (s_pFrameCb != NULL)
+        {
+            s_pFrameCb(i);
+        }
+    }
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: HAL_LTDC_ErrorCallback
+*    功能说明: FIFO下溢或传输错误，HAL已关闭该中断，下一次行中断时重新打开
+*    形    参: _hltdc : LTDC句柄
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void HAL_LTDC_ErrorCallback(LTDC_HandleTypeDef *_hltdc)
+{
+    if (!s_ucUnderrun)
+    {
+        s_ucUnderrun = 1;
+        s_uiUnderrun++;
+    }
+    _hltdc->ErrorCode = HAL_LTDC_ERROR_NONE;
+}
+
+/*
+*********************************************************************************************************
+*    函 数 名: LTDC_IRQHandler / LTDC_ER_IRQHandler
+*    功能说明: LTDC中断服务程序
+*    形    参: 无
+*    返 回 值: 无
+*********************************************************************************************************
+*/
+RAM_FUNC void LTDC_IRQHandler(void)
+{
+    HAL_LTDC_IRQHandler(&hltdc);
+}
+
+RAM_FUNC void LTDC_ER_IRQHandler(void)
+{
+    HAL_LTDC_IRQHandler(&hltdc);
+}
+
+#if defined(__SHELL_H__) && defined(DEBUG_MODE)
+/* 第0层画8条彩条 */
+static void tft_test_bars(void)
+{
+    static const uint32_t s_color[8] = {
+        GFX_RGB(255, 255, 255), GFX_RGB(255, 255, 0), GFX_RGB(0, 255, 255), GFX_RGB(0, 255, 0),
+        GFX_RGB(255, 0, 255), GFX_RGB(255, 0, 0), GFX_RGB(0, 0, 255), GFX_RGB(0, 0, 0)};
+    GFX_SURFACE_T lcd;
+    uint8_t i;
+
+    TFT_GetLayer(0, &lcd);
+    for (i = 0; i < 8; i++)
+    {
+        GFX_FillRect(&lcd, lcd.width * i / 8, 0, lcd.width * (i + 1) / 8 - lcd.width * i / 8, lcd.height, s_color[i]);
+    }
+    GFX_Wait();
+}
+
+/* 第0层彩条上叠加半透明的ARGB8888方块 */
+static void tft_test_blend(void)
+{
+    GFX_SURFACE_T lcd, img;
+    uint8_t i;
+
+    tft_test_bars();
+
+    TFT_GetLayer(0, &lcd);
+    GFX_InitSurface(&img, (uint32_t)Mem_AllocAlign(MEM_SDRAM, 64 * 64 * 4, 32), 64, 64, GFX_ARGB8888);
+    if (img.addr == 0)
+    {
+        printf("Low memory!\r\n");
+        return;
+    }
+
+    GFX_FillRect(&img, 0, 0, 64, 64, GFX_ARGB(0x80, 0, 0, 0));
+    GFX_FillRect(&img, 16, 16, 32, 32, GFX_ARGB(0xC0, 255, 255, 255));
+    for (i = 0; i < 4; i++)
+    {
+        GFX_Blend(&lcd, 20 + i * 70, 20 + i * 30, &img, 0, 0, 64, 64, 255 - i * 60);
+    }
+    GFX_Wait();
+    Mem_Free((void *)img.addr);
+}
+
+static uint32_t tft_sqrt(uint64_t _val)
+{
+    uint64_t x = 0, bit = (uint64_t)1 << 62;
+
+    while (bit > _val)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (_val >= x + bit)
+        {
+            _val -= x + bit;
+            x = (x >> 1) + bit;
+        }
+        else
+        {
+            x >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)x;
+}
+
+/* 第0层交换链动画，统计帧率和帧间隔抖动 */
+static int tft_fps(uint32_t _sec, uint8_t _num)
+{
+    TFT_CHAIN_T *c = &s_tChain[0];
+    GFX_SURFACE_T lcd;
+    uint32_t presented = 0, vs, fu, us, frames, avg, jitter;
+    int64_t ticks;
+    uint16_t x = 0;
+
+    if (TFT_SetBuffers(0, _num) != 0)
+    {
+        printf("Low memory!\r\n");
+        return -1;
+    }
+
+    __disable_irq();
+    c->frames = 0;
+    c->last = 0;
+    c->min = 0xFFFFFFFF;
+    c->max = 0;
+    c->sum = 0;
+    c->sum2 = 0;
+    __enable_irq();
+
+    vs = s_uiVSync;
+    fu = s_uiUnderrun;
+    ticks = get_system_ticks();
+    do
+    {
+        TFT_Invalidate(0, 0, 0, THIS.pwidth, THIS.pheight);
+        TFT_GetBackBuffer(0, &lcd);
+        GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_RGB(0, 0, 64));
+        GFX_FillRect(&lcd, x, lcd.height / 4, 64, lcd.height / 2, GFX_RGB(255, 255, 255));
+        TFT_Present(0);
+        presented++;
+        x = (x + 8) % (lcd.width - 64);
+        us = (uint32_t)((get_system_ticks() - ticks) / (SystemCoreClock / 1000000ul));
+    } while (us < _sec * 1000000ul);
+
+    while (c->queued)
+    {
+    }
+    us = (uint32_t)((get_system_ticks() - ticks) / (SystemCoreClock / 1000000ul));
+    vs = s_uiVSync - vs;
+    fu = s_uiUnderrun - fu;
+    frames = c->frames;
+
+    printf("%s, %d buffers, %dx%d RGB565\r\n", THIS.name, _num, lcd.width, lcd.height);
+    printf("refresh   : %d.%02d Hz\r\n", (int)((uint64_t)vs * 100000000ul / us / 100), (int)((uint64_t)vs * 100000000ul / us % 100));
+    printf("fps       : %d.%02d (%d presented, %d shown)\r\n", (int)((uint64_t)frames * 100000000ul / us / 100),
+           (int)((uint64_t)frames * 100000000ul / us % 100), presented, frames);
+    if (frames > 1)
+    {
+        avg = (uint32_t)(c->sum / (frames - 1));
+        jitter = tft_sqrt(c->sum2 / (frames - 1) - (uint64_t)avg * avg);
+        printf("interval  : avg %d us, min %d us, max %d us, jitter %d us\r\n", avg, c->min, c->max, jitter);
+    }
+    printf("underrun  : %d frames\r\n", fu);
+
+    TFT_SetBuffers(0, 1);
+    return 0;
+}
+
+/* 第0层只重画移动的方块和进度条，统计每帧访问的像素 */
+static int tft_dirty(uint32_t _sec, uint8_t _num)
+{
+    TFT_DIRTY_T *d = &s_tDirty[0];
+    TFT_RECT_T rect[TFT_DIRTY_MAX];
+    GFX_SURFACE_T lcd;
+    uint32_t us, full, frames, n, i;
+    int16_t x = 0, y = 0, dx = 5, dy = 3, ox = 0, oy = 0, bar = 0;
+    int64_t ticks;
+
+    if (TFT_SetBuffers(0, _num) != 0)
+    {
+        printf("Low memory!\r\n");
+        return -1;
+    }
+
+    /* 第一帧全屏画背景 */
+    TFT_Invalidate(0, 0, 0, THIS.pwidth, THIS.pheight);
+    TFT_GetBackBuffer(0, &lcd);
+    GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_RGB(0, 0, 64));
+    TFT_Present(0);
+    full = (uint32_t)lcd.width * lcd.height;
+    d->frames = 0;
+    d->drawn = 0;
+    d->copied = 0;
+
+    ticks = get_system_ticks();
+    do
+    {
+        /* 方块的旧位置和新位置、进度条 */
+        x += dx;
+        y += dy;
+        if (x < 0 || x + 64 > lcd.width)
+        {
+            dx = -dx;
+            x += 2 * dx;
+        }
+        if (y < 0 || y + 64 > lcd.height - 16)
+        {
+            dy = -dy;
+            y += 2 * dy;
+        }
+        bar = (bar + 4) % lcd.width;
+        TFT_Invalidate(0, ox, oy, 64, 64);
+        TFT_Invalidate(0, x, y, 64, 64);
+        TFT_Invalidate(0, 0, lcd.height - 16, lcd.width, 16);
+
+        TFT_GetBackBuffer(0, &lcd);
+        n = TFT_GetDirty(0, rect, TFT_DIRTY_MAX);
+        for (i = 0; i < n; i++)
+        {
+            GFX_FillRect(&lcd, rect[i].x, rect[i].y, rect[i].w, rect[i].h, GFX_RGB(0, 0, 64));
+        }
+        GFX_FillRect(&lcd, x, y, 64, 64, GFX_RGB(255, 255, 0));
+        GFX_FillRect(&lcd, 0, lcd.height - 16, bar, 16, GFX_RGB(0, 255, 0));
+        TFT_Present(0);
+        ox = x;
+        oy = y;
+        us = (uint32_t)((get_system_ticks() - ticks) / (SystemCoreClock / 1000000ul));
+    } while (us < _sec * 1000000ul);
+
+    while (s_tChain[0].queued)
+    {
+    }
+    us = (uint32_t)((get_system_ticks() - ticks) / (SystemCoreClock / 1000000ul));
+    frames = d->frames;
+
+    printf("%s, %d buffers, %dx%d RGB565\r\n", THIS.name, _num, lcd.width, lcd.height);
+    printf("fps       : %d\r\n", (int)((uint64_t)frames * 1000000ul / us));
+    printf("drawn     : %d px/frame\r\n", (int)(d->drawn / frames));
+    printf("copied    : %d px/frame\r\n", (int)(d->copied / frames));
+    printf("touched   : %d.%02d%% of %d px\r\n", (int)((d->drawn + d->copied) * 100 / frames / full),
+           (int)((d->drawn + d->copied) * 10000 / frames / full % 100), full);
+    printf("FMC bytes : %d KB/frame (full redraw %d KB)\r\n", (int)((d->drawn * 2 + d->copied * 4) / frames / 1024),
+           full * 2 / 1024);
+
+    TFT_SetBuffers(0, 1);
+    return 0;
+}
+
+/* 列出面板，*为当前面板 */
+static void tft_panel_list(void)
+{
+    const tft_cfg_t *p;
+    uint32_t total;
+    uint8_t i;
+
+    for (i = 0; i < TFT_PANEL_NUM; i++)
+    {
+        p = &lcd_cfg_list[i];
+        total = (uint32_t)(p->hsw + p->hbp + p->pwidth + p->hfp) * (p->vsw + p->vbp + p->pheight + p->vfp);
+        printf("%c%d %-24s %4dx%-4d %2d Hz\r\n", (i == lcd_type) ? '*' : ' ', i, p->name,
+               p->pwidth, p->pheight, (int)(p->pclk * 1000 / total));
+    }
+    printf("PLL3 M%d N%d Q%d R%d, pixel clock %d kHz\r\n", s_tPll3.PLL3M, s_tPll3.PLL3N,
+           s_tPll3.PLL3Q, s_tPll3.PLL3R, s_uiPclk);
+}
+
+static const char *s_fmt_name[] = {"8888", "888", "565", "1555", "4444", "l8", "al44", "al88"};
+
+/* 打印各层的格式、画布、窗口和LTDC读取的带宽 */
+static void tft_layer_info(void)
+{
+    LTDC_LayerCfgTypeDef *cfg;
+    uint32_t frame, hz100, bytes;
+    uint8_t i;
+
+    frame = (hltdc.Init.TotalWidth + 1) * (hltdc.Init.TotalHeigh + 1);
+    hz100 = (uint32_t)((uint64_t)s_uiPclk * 100000 / frame);
+    printf("layer fmt  canvas             window             KB/frame  MB/s\r\n");
+    for (i = 0; i < 2; i++)
+    {
+        cfg = &hltdc.LayerCfg[i];
+        bytes = (LTDC_LAYER(&hltdc, i)->CR & LTDC_LxCR_LEN) ? (cfg->WindowX1 - cfg->WindowX0) * (cfg->WindowY1 - cfg->WindowY0) *
+                                                                    GFX_BitsPerPixel((GFX_FMT_E)cfg->PixelFormat) / 8
+                                                              : 0;
+        printf("%-5d %-4s %4d,%-4d %4dx%-4d %4d,%-4d %4dx%-4d %8d %5d\r\n", i, s_fmt_name[cfg->PixelFormat],
+               s_tLayer[i].x, s_tLayer[i].y, s_tLayer[i].w, s_tLayer[i].h,
+               cfg->WindowX0, cfg->WindowY0, cfg->WindowX1 - cfg->WindowX0, cfg->WindowY1 - cfg->WindowY0,
+               bytes / 1024, (int)((uint64_t)bytes * hz100 / 100 / 1000000));
+    }
+}
+
+/* 第1层改为AL44，在透明背景上画两个半透明方块，窗口缩小到方块 */
+static int tft_layer_demo(void)
+{
+    GFX_SURFACE_T lcd;
+
+    if (TFT_SetLayerFormat(1, GFX_AL44) != 0)
+    {
+        return -1;
+    }
+    TFT_GetLayer(1, &lcd);
+    GFX_FillRect(&lcd, 0, 0, lcd.width, lcd.height, GFX_ARGB(0, 0, 0, 0));
+    GFX_FillRect(&lcd, lcd.width / 8, lcd.height / 8, lcd.width / 4, lcd.height / 4, GFX_ARGB(0xC0, 0, 0, 15));
+    GFX_FillRect(&lcd, lcd.width / 4, lcd.height / 4, lcd.width / 4, lcd.height / 8, GFX_ARGB(0x80, 0, 0, 8));
+    printf("before fit:\r\n");
+    tft_layer_info();
+    TFT_FitLayerWindow(1);
+    printf("after fit:\r\n");
+    tft_layer_info();
+    return 0;
+}
+
+static int tft_layer(int argc, char *argv[])
+{
+    uint8_t layer, i;
+
+    if (argc < 3)
+    {
+        tft_layer_info();
+        return 0;
+    }
+
+    layer = strtoul(argv[2], NULL, 0) & 1;
+    if (argc > 4 && strcmp(argv[3], "fmt") == 0)
+    {
+        for (i = 0; i < sizeof(s_fmt_name) / sizeof(s_fmt_name[0]); i++)
+        {
+            if (strcmp(argv[4], s_fmt_name[i]) == 0)
+            {
+                break;
+            }
+        }
+        if (i == sizeof(s_fmt_name) / sizeof(s_fmt_name[0]) || TFT_SetLayerFormat(layer, (GFX_FMT_E)i) != 0)
+        {
+            printf("Invalid format, 8888/888/565/1555/4444/l8/al44/al88.\r\n");
+            return -1;
+        }
+    }
+    else if (argc > 7 && strcmp(argv[3], "win") == 0)
+    {
+        TFT_SetLayerWindow(layer, strtol(argv[4], NULL, 0), strtol(argv[5], NULL, 0),
+                           strtoul(argv[6], NULL, 0), strtoul(argv[7], NULL, 0));
+    }
+    else if (argc > 3 && strcmp(argv[3], "fit") == 0)
+    {
+        TFT_FitLayerWindow(layer);
+    }
+    else if (argc > 3 && strcmp(argv[3], "demo") == 0)
+    {
+        return tft_layer_demo();
+    }
+    else
+    {
+        return -1;
+    }
+
+    tft_layer_info();
+    return 0;
+}
+
+static int _cmd(int argc, char *argv[])
+{
+    const char *help_info[] = {"set init/deinit",
+                               "test 1/2",
+                               "fps [seconds] [buffers]",
+                               "dirty [seconds] [buffers]",
+                               "panel [n/save/clear]",
+                               "layer [0/1 fmt 565/4444/l8/al44.. | win x y w h | fit | demo]",
+                               "capture [scale 1-8] [baud], use Tools/tft_capture.py"};
+    if (argc < 2)
+    {
+        printf("Error:Missing command parameters.\r\nUsage:\r\n");
+        for (uint32_t i = 0; i < sizeof(help_info) / sizeof(char *); i++)
+        {
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[i]);
+        }
+        printf("\r\n");
+        return -1;
+    }
+
+    if (strcmp(argv[1], "set") == 0)
+    {
+        if (argc < 3)
+        {
+            printf("Missing 'set' command parameters.\r\n");
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[0]);
+            return -1;
+        }
+
+        if (strcmp(argv[2], "init") == 0)
+        {
+            bsp_InitTFT();
+            return 0;
+        }
+        else if (strcmp(argv[2], "deinit") == 0)
+        {
+            if (hltdc.State == HAL_LTDC_STATE_RESET)
+            {
+                printf("Error:Do not repeatedly deinit LTDC.\r\n");
+                return -1;
+            }
+
+            return HAL_LTDC_DeInit(&hltdc);
+        }
+        else
+        {
+            printf("Invalid 'set' command parameter.\r\n");
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[0]);
+            return -1;
+        }
+    }
+    else if (strcmp(argv[1], "test") == 0)
+    {
+        if (argc < 3)
+        {
             printf("Missing 'test' command parameters.\r\n");
             printf("%s ", argv[0]);
             printf("%s\r\n", help_info[1]);
             return -1;
         }
-#endif
-        printf("Error:Unrealized function.\r\n");
+
+        if (strcmp(argv[2], "1") == 0)
+        {
+            tft_test_bars();
+            return 0;
+        }
+        else if (strcmp(argv[2], "2") == 0)
+        {
+            tft_test_blend();
+            return 0;
+        }
+        else
+        {
+            printf("Invalid 'test' command parameter.\r\n");
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[1]);
+            return -1;
+        }
+    }
+    else if (strcmp(argv[1], "fps") == 0)
+    {
+        uint32_t sec = (argc > 2) ? strtoul(argv[2], NULL, 0) : 5;
+        uint32_t num = (argc > 3) ? strtoul(argv[3], NULL, 0) : 2;
+
+        if (sec == 0 || num < 2 || num > TFT_BUF_MAX)
+        {
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[2]);
+            return -1;
+        }
+        return tft_fps(sec, num);
+    }
+    else if (strcmp(argv[1], "dirty") == 0)
+    {
+        uint32_t sec = (argc > 2) ? strtoul(argv[2], NULL, 0) : 5;
+        uint32_t num = (argc > 3) ? strtoul(argv[3], NULL, 0) : 2;
+
+        if (sec == 0 || num < 1 || num > TFT_BUF_MAX)
+        {
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[3]);
+            return -1;
+        }
+        return tft_dirty(sec, num);
+    }
+    else if (strcmp(argv[1], "layer") == 0)
+    {
+        if (tft_layer(argc, argv) != 0)
+        {
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[5]);
+            return -1;
+        }
+        return 0;
+    }
+    else if (strcmp(argv[1], "capture") == 0)
+    {
+        uint32_t scale = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+        uint32_t baud = (argc > 3) ? strtoul(argv[3], NULL, 0) : 0;
+
+        if (scale == 0 || scale > 8)
+        {
+            printf("%s ", argv[0]);
+            printf("%s\r\n", help_info[6]);
+            return -1;
+        }
+        return TFT_Capture(scale, baud);
+    }
+    else if (strcmp(argv[1], "panel") == 0)
+    {
+        if (argc < 3)
+        {
+            tft_panel_list();
+            return 0;
+        }
+        else if (strcmp(argv[2], "save") == 0)
+        {
+            return TFT_SavePanel();
+        }
+        else if (strcmp(argv[2], "clear") == 0)
+        {
+            return KV_Delete(TFT_PANEL_KEY);
+        }
+        else if (TFT_SetPanel(strtoul(argv[2], NULL, 0)) != 0)
+        {
+            printf("Invalid panel.\r\n");
+            tft_panel_list();
+            return -1;
+        }
+        tft_panel_list();
         return 0;
     }
     else
@@ -510,7 +2010,7 @@ static int _cmd(int argc, char *argv[])
 }
 
 // 导出到命令列表里
-SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), tft, _cmd, tft[set test read write]);
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN), tft, _cmd, tft[set test fps dirty panel layer capture]);
 #endif // #ifdef DEBUG_MODE
 
 /***************************** 安富莱电子 www.armfly.com (END OF FILE) *********************************/
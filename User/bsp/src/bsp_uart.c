@@ -48,74 +48,74 @@ static void RS485_SendOver(void);           /* 串口发送后 */
 static void RS485_ReciveNew(uint8_t _byte); /* 串口收到新数据 */
 
 #if UART1_FIFO_EN == 1
-UART_T g_tUart1 = {0};
+FAST_BSS UART_T g_tUart1 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf1[UART1_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf1[UART1_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart1;
-DMA_HandleTypeDef hdma_usart1_tx;
+FAST_BSS UART_HandleTypeDef huart1;
+FAST_BSS DMA_HandleTypeDef hdma_usart1_tx;
 DMA_HandleTypeDef hdma_usart1_rx;
 #endif
 
 #if UART2_FIFO_EN == 1
-UART_T g_tUart2 = {0};
+FAST_BSS UART_T g_tUart2 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf2[UART2_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf2[UART2_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart2;
-DMA_HandleTypeDef hdma_usart2_tx;
+FAST_BSS UART_HandleTypeDef huart2;
+FAST_BSS DMA_HandleTypeDef hdma_usart2_tx;
 DMA_HandleTypeDef hdma_usart2_rx;
 #endif
 
 #if UART3_FIFO_EN == 1
-UART_T g_tUart3 = {0};
+FAST_BSS UART_T g_tUart3 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf3[UART3_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf3[UART3_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart3;
-DMA_HandleTypeDef hdma_usart3_tx;
+FAST_BSS UART_HandleTypeDef huart3;
+FAST_BSS DMA_HandleTypeDef hdma_usart3_tx;
 DMA_HandleTypeDef hdma_usart3_rx;
 #endif
 
 #if UART4_FIFO_EN == 1
-UART_T g_tUart4 = {0};
+FAST_BSS UART_T g_tUart4 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf4[UART4_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf4[UART4_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart4;
-DMA_HandleTypeDef hdma_usart4_tx;
+FAST_BSS UART_HandleTypeDef huart4;
+FAST_BSS DMA_HandleTypeDef hdma_usart4_tx;
 DMA_HandleTypeDef hdma_usart4_rx;
 #endif
 
 #if UART5_FIFO_EN == 1
-UART_T g_tUart5 = {0};
+FAST_BSS UART_T g_tUart5 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf5[UART5_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf5[UART5_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart5;
-DMA_HandleTypeDef hdma_usart5_tx;
+FAST_BSS UART_HandleTypeDef huart5;
+FAST_BSS DMA_HandleTypeDef hdma_usart5_tx;
 DMA_HandleTypeDef hdma_usart5_rx;
 #endif
 
 #if UART6_FIFO_EN == 1
-UART_T g_tUart6 = {0};
+FAST_BSS UART_T g_tUart6 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf6[UART6_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf6[UART6_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart6;
-DMA_HandleTypeDef hdma_usart6_tx;
+FAST_BSS UART_HandleTypeDef huart6;
+FAST_BSS DMA_HandleTypeDef hdma_usart6_tx;
 DMA_HandleTypeDef hdma_usart6_rx;
 #endif
 
 #if UART7_FIFO_EN == 1
-UART_T g_tUart7 = {0};
+FAST_BSS UART_T g_tUart7 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf7[UART7_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf7[UART7_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart7;
-DMA_HandleTypeDef hdma_usart7_tx;
+FAST_BSS UART_HandleTypeDef huart7;
+FAST_BSS DMA_HandleTypeDef hdma_usart7_tx;
 DMA_HandleTypeDef hdma_usart7_rx;
 #endif
 
 #if UART8_FIFO_EN == 1
-UART_T g_tUart8 = {0};
+FAST_BSS UART_T g_tUart8 = {0};
 __attribute__((aligned(32))) uint8_t s_tx_buf8[UART8_TX_BUF_SIZE]; /* 发送缓冲区 */
 __attribute__((aligned(32))) uint8_t s_rx_buf8[UART8_RX_BUF_SIZE]; /* 接收缓冲区 */
-UART_HandleTypeDef huart8;
-DMA_HandleTypeDef hdma_usart8_tx;
+FAST_BSS UART_HandleTypeDef huart8;
+FAST_BSS DMA_HandleTypeDef hdma_usart8_tx;
 DMA_HandleTypeDef hdma_usart8_rx;
 #endif
 
@@ -546,7 +546,7 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef *huart)
  *
  * @return  void    [return description]
  */
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+RAM_FUNC void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
     UART_T *pUart = BaseToUart(huart->Instance);
 
@@ -569,6 +569,7 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
             pUart->rx_kfifo.read_index = index_new;
         }
         pUart->rx_kfifo.write_index = index_new;
+        pUart->rx_bytes += length;
 
         if (pUart->ReciveNew)
         {
@@ -582,12 +583,13 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
  *
  * @return  void    [return description]
  */
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+RAM_FUNC void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     UART_T *pUart = BaseToUart(huart->Instance);
     uint16_t len;
     if (pUart != 0)
     {
+        pUart->tx_bytes += huart->TxXferSize; /* 本次DMA发送完成的字节数 */
         len = ringbuffer_data_len(&pUart->tx_kfifo);
         if (len == 0)
         {
@@ -621,7 +623,7 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
  * @brief This function handles USART1 global interrupt.
  */
 #if UART1_FIFO_EN == 1
-void USART1_IRQHandler(void)
+RAM_FUNC void USART1_IRQHandler(void)
 {
     HAL_UART_IRQHandler(&huart1);
 }
@@ -631,7 +633,7 @@ void USART1_IRQHandler(void)
  * @brief This function handles USART3 global interrupt.
  */
 #if UART3_FIFO_EN == 1
-void USART3_IRQHandler(void)
+RAM_FUNC void USART3_IRQHandler(void)
 {
     HAL_UART_IRQHandler(&huart3);
 }
@@ -641,7 +643,7 @@ void USART3_IRQHandler(void)
  * @brief This function handles USART6 global interrupt.
  */
 #if UART6_FIFO_EN == 1
-void USART6_IRQHandler(void)
+RAM_FUNC void USART6_IRQHandler(void)
 {
     HAL_UART_IRQHandler(&huart6);
 }
@@ -1188,6 +1190,121 @@ uint16_t comGetLen(COM_PORT_E _ucPort)
     return ringbuffer_data_len(&pUart->rx_kfifo);
 }
 
+/*
+*********************************************************************************************************
+*   函 数 名: comGetStat
+*   功能说明: 读取串口累计收发的字节数，两次读取的差值除以间隔即为吞吐量
+*   形    参: _ucPort: 端口号(COM1 - COM8)
+*             _pTxBytes: 已发送完成的字节数
+*             _pRxBytes: 已接收的字节数
+*   返 回 值: 0 成功，-1 端口未使能
+*********************************************************************************************************
+*/
+int comGetStat(COM_PORT_E _ucPort, uint32_t *_pTxBytes, uint32_t *_pRxBytes)
+{
+    UART_T *pUart;
+
+    pUart = ComToUart(_ucPort);
+    if (pUart == 0)
+    {
+        return -1;
+    }
+    *_pTxBytes = pUart->tx_bytes;
+    *_pRxBytes = pUart->rx_bytes;
+    return 0;
+}
+
+/*
+*********************************************************************************************************
+*   函 数 名: comSetRxBuf
+*   功能说明: 更换串口DMA接收缓冲区。大数据量连续接收(比如固件升级)时临时换成大缓冲区，缓冲区中未读的数据被丢弃
+*   形    参: _ucPort: 端口号(COM1 - COM8)
+*             _pBuf: 新缓冲区，32字节对齐，DMA可以访问(AXI SRAM或SDRAM)。NULL 表示恢复默认缓冲区
+*             _usSize: 缓冲区大小，2的整数次幂，最大32KB
+*   返 回 值: 0 成功，-1 失败
+*********************************************************************************************************
+*/
+int comSetRxBuf(COM_PORT_E _ucPort, uint8_t *_pBuf, uint16_t _usSize)
+{
+    UART_T *pUart;
+
+    pUart = ComToUart(_ucPort);
+    if (pUart == 0)
+    {
+        return -1;
+    }
+
+    if (_pBuf == NULL)
+    {
+        switch (_ucPort)
+        {
+#if UART1_FIFO_EN == 1
+        case COM1:
+            _pBuf = s_rx_buf1;
+            _usSize = roundup_pow_of_two(UART1_RX_BUF_SIZE);
+            break;
+#endif
+#if UART2_FIFO_EN == 1
+        case COM2:
+            _pBuf = s_rx_buf2;
+            _usSize = roundup_pow_of_two(UART2_RX_BUF_SIZE);
+            break;
+#endif
+#if UART3_FIFO_EN == 1
+        case COM3:
+            _pBuf = s_rx_buf3;
+            _usSize = roundup_pow_of_two(UART3_RX_BUF_SIZE);
+            break;
+#endif
+#if UART4_FIFO_EN == 1
+        case COM4:
+            _pBuf = s_rx_buf4;
+            _usSize = roundup_pow_of_two(UART4_RX_BUF_SIZE);
+            break;
+#endif
+#if UART5_FIFO_EN == 1
+        case COM5:
+            _pBuf = s_rx_buf5;
+            _usSize = roundup_pow_of_two(UART5_RX_BUF_SIZE);
+            break;
+#endif
+#if UART6_FIFO_EN == 1
+        case COM6:
+            _pBuf = s_rx_buf6;
+            _usSize = roundup_pow_of_two(UART6_RX_BUF_SIZE);
+            break;
+#endif
+#if UART7_FIFO_EN == 1
+        case COM7:
+            _pBuf = s_rx_buf7;
+            _usSize = roundup_pow_of_two(UART7_RX_BUF_SIZE);
+            break;
+#endif
+#if UART8_FIFO_EN == 1
+        case COM8:
+            _pBuf = s_rx_buf8;
+            _usSize = roundup_pow_of_two(UART8_RX_BUF_SIZE);
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+
+    if (_pBuf == NULL || _usSize < 32 || _usSize > 0x8000 || (_usSize & (_usSize - 1)) != 0)
+    {
+        return -1;
+    }
+
+    HAL_UART_AbortReceive(pUart->huart);
+    ringbuffer_init(&pUart->rx_kfifo, _pBuf, _usSize);
+    if (HAL_UARTEx_ReceiveToIdle_DMA(pUart->huart, _pBuf, _usSize) != HAL_OK)
+    {
+        return -1;
+    }
+    return 0;
+}
+
 /* 如果是RS485通信，请按如下格式编写函数， 我们仅举了 USART3作为RS485的例子 */
 
 /*
@@ -1510,7 +1627,7 @@ static int com_uart(int argc, char *argv[])
                 {
 
                     length = atoi(argv[3]);
-                    buff = malloc(length);
+                    buff = Pool_Alloc(length);
                     if (buff)
                     {
                         size = comGetBuf((COM_PORT_E)com_num, buff, length);
@@ -1603,7 +1720,7 @@ static int com_uart(int argc, char *argv[])
 
     if (buff != NULL)
     {
-        free(buff);
+        Pool_Free(buff);
     }
     return result;
 }
@@ -11,6 +11,7 @@
 *               V1.2  2015-04-06  增加 BEBufToUint32()和 LEBufToUint32()
 *               V1.3  2015-10-09  增加 BcdToChar(), HexToAscll()和 AsciiToUint32()
 *               V1.3a 2015-10-09  解决 HexToAscll() 函数末尾补0的BUG
+*               V1.4  2026-10-19  增加 CRC32_Update()
 *
 *********************************************************************************************************
 */
@@ -336,6 +337,33 @@ uint16_t CRC16_Modbus(uint8_t *_pBuf, uint16_t _usLen)
     return ((uint16_t)ucCRCHi << 8 | ucCRCLo);
 }
 
+/*
+*********************************************************************************************************
+*    函 数 名: CRC32_Update
+*    功能说明: 计算CRC32(多项式0x04C11DB7反向，与zlib、以太网相同)，可分段连续计算。
+*              首次调用 _crc 传入0，后续传入上一次的返回值。使用16项半字节表，节省Flash。
+*    形    参: _crc : 上一段的CRC值
+*              _pBuf : 参与校验的数据
+*              _uiLen : 数据长度
+*    返 回 值: CRC32值
+*********************************************************************************************************
+*/
+RAM_FUNC uint32_t CRC32_Update(uint32_t _crc, const uint8_t *_pBuf, uint32_t _uiLen)
+{
+    static const uint32_t s_CRC32[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+    _crc = ~_crc;
+    while (_uiLen--)
+    {
+        _crc ^= *_pBuf++;
+        _crc = (_crc >> 4) ^ s_CRC32[_crc & 0x0F];
+        _crc = (_crc >> 4) ^ s_CRC32[_crc & 0x0F];
+    }
+    return ~_crc;
+}
+
 /*
 *********************************************************************************************************
 *    函 数 名: CaculTwoPoint
@@ -46,6 +46,7 @@ int main(void)
     {
         MultiTimerYield(); // 执行定时器调度
         shellTask(&shell); // shell任务
+        CPU_IDLE();        // 喂狗等空闲处理
 
         extern void bsp_key_test(void);
         bsp_key_test();